@@ -0,0 +1,273 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include <perfnp/base64.h>
+#include <perfnp/combin.hpp>
+#include <perfnp/config.hpp>
+#include <perfnp/dataset.hpp>
+#include <perfnp/exec.hpp>
+#include <perfnp/sql_database.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Temporary database of the insert benchmark
+    const char* BENCH_DATABASE_FILENAME = "perfnp_bench.sqlite";
+
+    //! Seed of all generated data, so that runs are comparable
+    const unsigned BENCH_SEED = 20190101;
+
+
+
+    //! Settings given on the command-line
+    struct BenchSettings {
+        //! The largest number of jobs of combine_command_lines
+        unsigned long long max_jobs;
+        //! Fewer repetitions and smaller inputs
+        bool quick;
+        //! Output file, stdout if empty
+        std::string output;
+
+        BenchSettings()
+        : max_jobs(1000000)
+        , quick(false)
+        {}
+    };
+
+
+
+    /*!
+     * Times the function several times.
+     *
+     * @param items number of processed items in one call,
+     *        the throughput is items per second of the median call
+     * @param unit unit of the throughput, e.g. "jobs/s"
+     */
+    template<typename Function>
+    nlohmann::json run_benchmark(const std::string& name,
+        unsigned long long size, double items, const std::string& unit,
+        unsigned repetitions, Function function)
+    {
+        std::vector<double> seconds;
+        for (unsigned r = 0; r < repetitions; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            seconds.push_back(std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds[seconds.size() / 2];
+        if (seconds.size() % 2 == 0) {
+            median = (median + seconds[seconds.size() / 2 - 1]) / 2;
+        }
+
+        std::cerr << name << " (" << size << "): " << median << "s" << std::endl;
+        return {
+            { "name", name },
+            { "size", size },
+            { "repetitions", repetitions },
+            { "median_seconds", median },
+            { "min_seconds", seconds.front() },
+            { "max_seconds", seconds.back() },
+            { "throughput", median > 0 ? items / median : 0.0 },
+            { "unit", unit },
+        };
+    } // run_benchmark
+
+
+
+    //! Configuration with `digits` parameters of 10 values each
+    Config make_config(unsigned digits)
+    {
+        nlohmann::json parameters = nlohmann::json::array();
+        std::vector<std::string> arguments;
+        for (unsigned d = 0; d < digits; ++d) {
+            std::string name = "p" + std::to_string(d);
+            parameters.push_back({
+                { "name", name },
+                { "values", { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" } },
+            });
+            arguments.push_back("--" + name + "=%" + name + "%");
+        }
+        return Config(nlohmann::json{
+            { "timeout", 60 },
+            { "command", "solver" },
+            { "arguments", arguments },
+            { "parameters", parameters },
+        });
+    } // make_config
+
+
+
+    //! Random results with 10% of failures, runtimes up to the timeout
+    std::vector<ExecResult> make_results(size_t count, unsigned timeout)
+    {
+        std::mt19937 random(BENCH_SEED);
+        std::uniform_int_distribution<unsigned> runtime(1, timeout);
+        std::vector<ExecResult> out;
+        out.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            out.emplace_back(random() % 10 == 0 ? 1 : 0, runtime(random));
+        }
+        return out;
+    } // make_results
+
+
+
+    void bench_exec(const BenchSettings& settings, nlohmann::json& out)
+    {
+#if defined(_WIN32)
+        ExecBin exec("cmd", { "/C", "exit 0" }, 10);
+#else
+        ExecBin exec("/bin/true", {}, 10);
+#endif
+        out.push_back(run_benchmark("exec_spawn_reap", 1, 1, "spawns/s",
+            settings.quick ? 20 : 200, [&]() { exec.execute(); }));
+    } // bench_exec
+
+
+
+    void bench_combine(const BenchSettings& settings, nlohmann::json& out)
+    {
+        unsigned long long jobs = 1000;
+        for (unsigned digits = 3; jobs <= settings.max_jobs; ++digits, jobs *= 10) {
+            auto config = make_config(digits);
+            out.push_back(run_benchmark("combine_command_lines", jobs,
+                static_cast<double>(jobs), "jobs/s", settings.quick ? 1 : 3,
+                [&]() {
+                    auto commands = combine_command_lines(config);
+                    if (commands.size() != jobs) {
+                        throw std::runtime_error("Unexpected number of jobs.");
+                    }
+                }));
+        }
+    } // bench_combine
+
+
+
+    void bench_sql(const BenchSettings& settings, nlohmann::json& out)
+    {
+        const unsigned inserts = settings.quick ? 100 : 500;
+        std::remove(BENCH_DATABASE_FILENAME);
+        {
+            sql_database db(BENCH_DATABASE_FILENAME);
+            CmdWithArgs cwa(0, "solver", { "--instance=graph.txt", "--seed=1" });
+            ExecResult result(0, 7, { MetricValue("objective", 42) });
+            out.push_back(run_benchmark("sql_on_job_finished", inserts,
+                inserts, "inserts/s", 3, [&]() {
+                    auto run_id = db.new_run_started();
+                    for (unsigned i = 0; i < inserts; ++i) {
+                        db.on_job_finished(run_id, cwa, 60, result);
+                    }
+                }));
+        }
+        std::remove(BENCH_DATABASE_FILENAME);
+    } // bench_sql
+
+
+
+    void bench_dataset(const BenchSettings& settings, nlohmann::json& out)
+    {
+        const size_t count = settings.quick ? 100000 : 1000000;
+        const unsigned timeout = 600;
+        const unsigned repetitions = settings.quick ? 1 : 3;
+        Dataset dataset(timeout, make_results(count, timeout));
+
+        out.push_back(run_benchmark("dataset_median", count, count, "results/s",
+            repetitions, [&]() { dataset.median_runtime_of_all_runs(); }));
+        out.push_back(run_benchmark("dataset_mad", count, count, "results/s",
+            repetitions, [&]() { dataset.mad_runtime_of_all_runs(); }));
+        out.push_back(run_benchmark("dataset_score", count, count, "results/s",
+            repetitions, [&]() { dataset.score(2); }));
+        out.push_back(run_benchmark("dataset_survival", count, count, "results/s",
+            repetitions, [&]() { dataset.runtime_survival(); }));
+        out.push_back(run_benchmark("dataset_bootstrap_1000", count, count, "results/s",
+            repetitions, [&]() { dataset.bootstrap(2, 0.95, 1000); }));
+    } // bench_dataset
+
+
+
+    void bench_base64(const BenchSettings& settings, nlohmann::json& out)
+    {
+        const size_t bytes = (settings.quick ? 1 : 16) * 1024 * 1024;
+        std::mt19937 random(BENCH_SEED);
+        std::vector<unsigned char> data(bytes);
+        for (auto& byte : data) {
+            byte = static_cast<unsigned char>(random());
+        }
+        const double megabytes = bytes / (1024.0 * 1024.0);
+
+        std::string encoded;
+        out.push_back(run_benchmark("base64_encode", bytes, megabytes, "MB/s",
+            3, [&]() { encoded = base64_encode(data.data(), static_cast<unsigned>(bytes)); }));
+        out.push_back(run_benchmark("base64_decode", bytes, megabytes, "MB/s",
+            3, [&]() { base64_decode(encoded); }));
+    } // bench_base64
+
+
+
+    BenchSettings parse_arguments(const std::vector<std::string>& args)
+    {
+        BenchSettings settings;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--quick") {
+                settings.quick = true;
+                settings.max_jobs = 10000;
+            } else if (args[i] == "--max-jobs" && i + 1 < args.size()) {
+                settings.max_jobs = std::stoull(args[++i]);
+            } else if (args[i] == "--output" && i + 1 < args.size()) {
+                settings.output = args[++i];
+            } else {
+                throw std::runtime_error("Usage: perfnp_bench [--quick]"
+                    " [--max-jobs N] [--output results.json]");
+            }
+        }
+        return settings;
+    } // parse_arguments
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) try {
+
+    auto settings = parse_arguments(std::vector<std::string>(argv + 1, argv + argc));
+
+    nlohmann::json results = nlohmann::json::array();
+    bench_exec(settings, results);
+    bench_combine(settings, results);
+    bench_sql(settings, results);
+    bench_dataset(settings, results);
+    bench_base64(settings, results);
+
+    nlohmann::json report = {
+        { "hardware_threads", std::thread::hardware_concurrency() },
+        { "quick", settings.quick },
+        { "benchmarks", results },
+    };
+
+    if (settings.output.empty()) {
+        std::cout << report.dump(4) << std::endl;
+    } else {
+        std::ofstream output(settings.output);
+        output << report.dump(4) << std::endl;
+    }
+    return 0;
+
+} catch (const std::exception& ex) {
+    std::cerr << "ERROR: " << ex.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+/*!
+ * Synthetic solver for load tests of perfnp.
+ *
+ * Consumes CPU, allocates memory, forks children, prints incumbents
+ * and exits with a chosen code, all driven by the command-line.
+ * It also checks which file descriptors it inherited from perfnp.
+ * Every job takes milliseconds, so millions of jobs are feasible.
+ */
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    //! What the stub should do
+    struct StubSettings {
+        //! Busy CPU time, in milliseconds
+        unsigned cpu_ms;
+        //! Sleep after the CPU work, in milliseconds
+        unsigned sleep_ms;
+        //! Random extra CPU time up to this many milliseconds
+        unsigned jitter_ms;
+        //! Seed of the jitter
+        std::uint64_t seed;
+        //! Allocated and touched memory, in MiB
+        unsigned memory_mb;
+        //! Number of children doing the same CPU work and sleep
+        unsigned children;
+        //! Number of improving incumbents printed during the CPU work
+        unsigned incumbents;
+        //! Prefix of the incumbent lines
+        std::string incumbent_prefix;
+        //! Exit code of the stub
+        int exit_code;
+        //! Signal raised at the end instead of exiting, 0 for none
+        int signal;
+        //! Descriptors, which must not be inherited (exit code 3 if open)
+        std::vector<int> closed_fds;
+
+        StubSettings()
+        : cpu_ms(0)
+        , sleep_ms(0)
+        , jitter_ms(0)
+        , seed(0)
+        , memory_mb(0)
+        , children(0)
+        , incumbents(0)
+        , incumbent_prefix("objective=")
+        , exit_code(0)
+        , signal(0)
+        {}
+    };
+
+    //! The result of the busy loop is stored here, so it is not optimized out
+    volatile std::uint64_t busy_sink;
+
+    std::uint64_t splitmix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    } // splitmix64
+
+    //! Busy loop until the deadline
+    void burn_cpu_until(std::chrono::steady_clock::time_point deadline)
+    {
+        std::uint64_t state = 0;
+        while (std::chrono::steady_clock::now() < deadline) {
+            for (int i = 0; i < 1000; ++i) {
+                busy_sink = splitmix64(state);
+            }
+        }
+    } // burn_cpu_until
+
+    /*!
+     * Burns the CPU time and prints the incumbents evenly over it.
+     *
+     * Incumbents decrease from the number of incumbents to 1.
+     */
+    void work(const StubSettings& settings, unsigned cpu_ms, bool print)
+    {
+        using namespace std::chrono;
+        const auto start = steady_clock::now();
+        const unsigned steps = print ? settings.incumbents : 0;
+        for (unsigned i = 0; i < steps; ++i) {
+            burn_cpu_until(start + microseconds(1000ull * cpu_ms * i / steps));
+            std::cout << settings.incumbent_prefix << (steps - i) << std::endl;
+        }
+        burn_cpu_until(start + milliseconds(cpu_ms));
+
+        if (settings.sleep_ms > 0) {
+            std::this_thread::sleep_for(milliseconds(settings.sleep_ms));
+        }
+    } // work
+
+    unsigned parse_unsigned(const std::string& name, const std::string& value)
+    {
+        size_t parsed = 0;
+        unsigned long out = 0;
+        try {
+            out = std::stoul(value, &parsed);
+        } catch (const std::logic_error&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != value.size()) {
+            throw std::runtime_error(name + " expects a non-negative integer, not '"
+                + value + "'.");
+        }
+        return static_cast<unsigned>(out);
+    } // parse_unsigned
+
+    StubSettings parse_arguments(int argc, char* argv[])
+    {
+        StubSettings settings;
+        for (int i = 1; i < argc; ++i) {
+            const std::string name = argv[i];
+            if (name == "--help" || i + 1 >= argc) {
+                throw std::runtime_error("Usage: perfnp_stub [--cpu-ms N]"
+                    " [--sleep-ms N] [--jitter-ms N] [--seed N] [--memory-mb N]"
+                    " [--children N] [--incumbents N] [--incumbent-prefix TEXT]"
+                    " [--exit-code N] [--signal N] [--closed-fd N]...");
+            }
+            const std::string value = argv[++i];
+
+            if (name == "--cpu-ms") {
+                settings.cpu_ms = parse_unsigned(name, value);
+            } else if (name == "--sleep-ms") {
+                settings.sleep_ms = parse_unsigned(name, value);
+            } else if (name == "--jitter-ms") {
+                settings.jitter_ms = parse_unsigned(name, value);
+            } else if (name == "--seed") {
+                settings.seed = parse_unsigned(name, value);
+            } else if (name == "--memory-mb") {
+                settings.memory_mb = parse_unsigned(name, value);
+            } else if (name == "--children") {
+                settings.children = parse_unsigned(name, value);
+            } else if (name == "--incumbents") {
+                settings.incumbents = parse_unsigned(name, value);
+            } else if (name == "--incumbent-prefix") {
+                settings.incumbent_prefix = value;
+            } else if (name == "--exit-code") {
+                settings.exit_code = static_cast<int>(parse_unsigned(name, value));
+            } else if (name == "--signal") {
+                settings.signal = static_cast<int>(parse_unsigned(name, value));
+            } else if (name == "--closed-fd") {
+                settings.closed_fds.push_back(static_cast<int>(parse_unsigned(name, value)));
+            } else {
+                throw std::runtime_error("Unknown argument '" + name + "'.");
+            }
+        }
+        return settings;
+    } // parse_arguments
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) try {
+
+    const auto settings = parse_arguments(argc, argv);
+
+#if defined(__linux__) || defined(__APPLE__)
+    for (int fd : settings.closed_fds) {
+        if (fcntl(fd, F_GETFD) != -1) {
+            std::cerr << "perfnp_stub: inherited descriptor " << fd << std::endl;
+            return 3;
+        }
+    }
+#else
+    if (!settings.closed_fds.empty()) {
+        throw std::runtime_error("--closed-fd is supported only on POSIX systems.");
+    }
+#endif
+
+    unsigned cpu_ms = settings.cpu_ms;
+    if (settings.jitter_ms > 0) {
+        std::uint64_t state = settings.seed;
+        cpu_ms += static_cast<unsigned>(splitmix64(state) % (settings.jitter_ms + 1));
+    }
+
+    // Touch every page, so that the memory is really resident
+    std::vector<char> memory(static_cast<size_t>(settings.memory_mb) * 1024 * 1024);
+    for (size_t i = 0; i < memory.size(); i += 4096) {
+        memory[i] = static_cast<char>(i);
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    std::vector<pid_t> children;
+    for (unsigned c = 0; c < settings.children; ++c) {
+        pid_t child = fork();
+        if (child == -1) {
+            throw std::runtime_error("fork() failed: errno " + std::to_string(errno));
+        }
+        if (child == 0) {
+            work(settings, cpu_ms, false);
+            _exit(0);
+        }
+        children.push_back(child);
+    }
+#else
+    if (settings.children > 0) {
+        throw std::runtime_error("--children is supported only on POSIX systems.");
+    }
+#endif
+
+    work(settings, cpu_ms, true);
+
+#if defined(__linux__) || defined(__APPLE__)
+    for (pid_t child : children) {
+        int status;
+        waitpid(child, &status, 0);
+    }
+#endif
+
+    if (settings.signal != 0) {
+        std::cout.flush();
+        std::raise(settings.signal);
+    }
+    return settings.exit_code;
+
+} catch (const std::exception& ex) {
+    std::cerr << "perfnp_stub: " << ex.what() << std::endl;
+    return 125;
+}
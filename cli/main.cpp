@@ -8,95 +8,794 @@
 #include <perfnp/config.hpp>
 #include <perfnp/sql_database.hpp>
 #include <perfnp/dataset.hpp>
+#include <perfnp/cache.hpp>
+#include <perfnp/calibration.hpp>
+#include <perfnp/cluster.hpp>
+#include <perfnp/compare.hpp>
+#include <perfnp/gate.hpp>
+#include <perfnp/interrupt.hpp>
+#include <perfnp/monitor.hpp>
+#include <perfnp/staging.hpp>
+#include <perfnp/trace.hpp>
+#include <algorithm>
+#include <csignal>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <utility>
 #include <fstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace perfnp;
 
-int main(int argc, char* argv[]) try {
+namespace {
 
-    // Prepare the experiment
-
-    bool resume = false;
-    std::string first_parameter(argv[1]);
-    nlohmann::json config_json;
-    if (argc <= 1) {
-        config_json = nlohmann::json::parse(std::cin);
-    } else if (argc == 2 && first_parameter != "-r") {
-        std::ifstream input(argv[1]);
-        config_json = nlohmann::json::parse(input);
-    } else if (argc == 3) {
-        if (first_parameter == "-r") {
-            resume = true;
-            std::cout << "Resume ON!" << std::endl;
+    //! Exit code of `perfnp gate` if a regression was detected
+    const int EXIT_REGRESSION = 2;
+
+    //! Exit code of an interrupted run, as of a shell killed by the signal
+    int exit_code_of_interruption()
+    {
+        return 128 + (interrupt_signal() != 0 ? interrupt_signal() : SIGINT);
+    } // exit_code_of_interruption
+
+
+
+    //! Prints a censoring-aware runtime, 0 means "not within the timeout"
+    std::string format_runtime(unsigned runtime, unsigned timeout)
+    {
+        if (runtime == 0) {
+            return ">" + std::to_string(timeout) + "s";
         }
-        std::ifstream input(argv[2]);
-        config_json = nlohmann::json::parse(input);
-    }
-    Config config(std::move(config_json));
+        return std::to_string(runtime) + "s";
+    } // format_runtime
 
 
-    auto jobs = combine_command_lines(config);
-    std::cout << "Jobs to execute: " << jobs.size() << std::endl;
 
-    // Open the CSV log file if needed
+    //! Options of a run given on the command-line
+    struct RunOptions {
 
-    auto csv_output_filename = config.logging_job_csv_file();
-    std::ofstream csv_output_file;
-    if (csv_output_filename == "-") {
-        print_job_csv_header(std::cout);
-    } else if (csv_output_filename.is_empty()) {
-        csv_output_file.open(*csv_output_filename);
-        print_job_csv_header(csv_output_file);
-    }
+        //! Skip the jobs finished by the previous run (`-r`)
+        bool resume;
 
-    sql_database db("perfnp.sqlite");
-    auto run_id = db.new_run_started();
-    db.save_config_and_command_read_from_file(run_id, config);
+        //! Part of the sweep executed by this process (`--shard i/N`)
+        Shard shard;
 
-    if (resume) {
-        db.remove_finished_jobs(jobs, config);
-    }
+        //! Jobs are executed by remote workers (`perfnp serve`)
+        bool serve;
 
-    // Run the experiment!
-    auto dataset = execute_all_runs(jobs, config.timeout(),
-        [&](const CmdWithArgs& cwa, unsigned timeout, ExecResult result)
+        //! Where the coordinator listens (`--listen host:port`)
+        CoordinatorSettings coordinator;
+
+        //! Command, which continues an interrupted run
+        std::string resume_command;
+
+        RunOptions()
+        : resume(false)
+        , serve(false)
+        , resume_command("perfnp -r")
+        {
+            coordinator.port = 7878;
+        }
+
+        //! Every shard writes a database of its own
+        std::string database() const {
+            if (!shard.enabled()) {
+                return "perfnp.sqlite";
+            }
+            return "perfnp-shard-" + std::to_string(shard.index + 1)
+                + "-of-" + std::to_string(shard.count) + ".sqlite";
+        }
+    }; // RunOptions
+
+
+
+    //! Parses the command-line and reads the configuration
+    Config read_config(const std::vector<std::string>& args, RunOptions& options)
+    {
+        const std::string usage = options.serve
+            ? "Usage: perfnp serve [--listen host:port] [-r] [--shard i/N[:hashed]] [config.json]"
+            : "Usage: perfnp [-r] [--shard i/N[:hashed]] [config.json]";
+
+        const bool serve = options.serve;
+        const std::string resume_command = options.resume_command;
+        options = RunOptions();
+        options.serve = serve;
+        options.resume_command = resume_command;
+        std::vector<std::string> files;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "-r") {
+                options.resume = true;
+            } else if (args[i] == "--shard") {
+                if (i + 1 == args.size()) {
+                    throw std::runtime_error(usage);
+                }
+                options.shard = Shard::parse(args[++i]);
+            } else if (args[i] == "--listen" && serve) {
+                if (i + 1 == args.size()) {
+                    throw std::runtime_error(usage);
+                }
+                parse_endpoint(args[++i], options.coordinator.host,
+                    options.coordinator.port);
+            } else {
+                files.push_back(args[i]);
+            }
+        }
+
+        if (files.empty()) {
+            return Config::parse(std::cin);
+        } else if (files.size() == 1) {
+            std::ifstream input(files[0]);
+            return Config::parse(input);
+        } else {
+            throw std::runtime_error(usage);
+        }
+    } // read_config
+
+
+
+    /*!
+     * Key of the instance of every result, for the primal gaps.
+     *
+     * An instance is given by the configured parameters, or by the
+     * input files of the job (i.e. its command-line without the solver
+     * flags). Empty if the job indices are unknown.
+     */
+    std::vector<unsigned long long> instance_keys(const Dataset& dataset,
+        const Config& config)
+    {
+        const auto& job_indices = dataset.job_indices();
+        if (job_indices.empty()) {
+            return {};
+        }
+        if (!config.statistics_instance().empty()) {
+            return dataset.group_keys(config.parameters(),
+                config.statistics_instance(), config.zip_groups());
+        }
+
+        JobSpace space(config);
+        std::unordered_map<std::string, unsigned long long> known;
+        std::vector<unsigned long long> keys;
+        keys.reserve(job_indices.size());
+        for (auto index : job_indices) {
+            std::string files;
+            for (const auto& file : input_files(space.at(index))) {
+                files += file + '\0';
+            }
+            keys.push_back(known.insert(
+                std::make_pair(files, known.size())).first->second);
+        }
+        return keys;
+    } // instance_keys
+
+
+
+    //! Prints all statistics of the finished experiment
+    void print_statistics(std::ostream& out, const Dataset& dataset,
+        const Config& config, size_t jobs)
+    {
+        if (dataset.number_of_all_successful_runs() > 0) {
+            out << "Median runtime:  "
+                << dataset.median_runtime_of_all_runs() << "s +- "
+                << dataset.mad_runtime_of_all_runs() << "s from "
+                << jobs << " jobs" << std::endl;
+
+            out << "Successful runs: "
+                << dataset.median_runtime_of_successful_runs() << "s +- "
+                << dataset.mad_runtime_of_all_successful_runs() << "s from "
+                << dataset.number_of_all_successful_runs() << " jobs" << std::endl;
+        } else {
+            out << "There were no successful runs." << std::endl;
+        }
+
+        if (jobs > 0) {
+            out << "Time to solve (Kaplan-Meier, 95% CI):";
+            for (unsigned percent = 25; percent <= 75; percent += 25) {
+                auto quantile = dataset.runtime_quantile(percent / 100.0);
+                out << " " << percent << "%: "
+                    << format_runtime(quantile.value, config.timeout()) << " ["
+                    << format_runtime(quantile.lower, config.timeout()) << ", "
+                    << format_runtime(quantile.upper, config.timeout()) << "]"
+                    << (percent < 75 ? "," : "");
+            }
+            out << std::endl;
+        }
+
+        auto score = dataset.score(config.statistics_par_k());
+        out << "PAR-" << score.k << " score:     "
+            << score.par_k << "s, solved " << score.solved
+            << " of " << score.attempted << " jobs" << std::endl;
+
+        if (jobs > 0) {
+            auto bootstrap = dataset.bootstrap(score.k);
+            out << "Bootstrap (95% CI):"
+                << " median " << bootstrap.median.value << "s ["
+                << bootstrap.median.lower << ", " << bootstrap.median.upper << "],"
+                << " mean " << bootstrap.mean.value << "s ["
+                << bootstrap.mean.lower << ", " << bootstrap.mean.upper << "],"
+                << " PAR-" << bootstrap.k << " " << bootstrap.par_k.value << "s ["
+                << bootstrap.par_k.lower << ", " << bootstrap.par_k.upper << "],"
+                << " success rate " << bootstrap.success_rate.value << " ["
+                << bootstrap.success_rate.lower << ", "
+                << bootstrap.success_rate.upper << "]" << std::endl;
+        }
+
+        // With grouping, the scores and the cactus plots
+        // are given for every configuration separately
+        auto group_by = config.statistics_group_by();
+        std::vector<GroupStatistics> groups;
+        if (!group_by.empty()) {
+            groups = dataset.group_by(config.parameters(), group_by,
+                score.k, config.zip_groups());
+            print_group_table(out, group_by, groups, score.k);
+        }
+
+        auto cactus_filename = config.logging_cactus_csv_file();
+        if (!cactus_filename.empty()) {
+            std::ofstream cactus_file;
+            if (cactus_filename != "-") {
+                cactus_file.open(cactus_filename);
+            }
+            std::ostream& cactus = cactus_filename == "-" ? out : cactus_file;
+            if (group_by.empty()) {
+                print_cactus_csv(cactus, score);
+            } else {
+                print_group_cactus_csv(cactus, group_by, groups);
+            }
+        }
+
+        for (const auto& metric : dataset.metric_summaries()) {
+            out << "Metric " << metric.name << ": "
+                << metric.median << " (min " << metric.min
+                << ", max " << metric.max << ") from "
+                << metric.count << " jobs" << std::endl;
+        }
+
+        const auto instances = instance_keys(dataset, config);
+        if (!dataset.primal_integrals(instances).empty()) {
+            out << "Primal integral: "
+                << dataset.mean_primal_integral(instances)
+                << "s on average per instance" << std::endl;
+
+            out << "Median primal gap:";
+            for (unsigned quarter = 1; quarter <= 4; ++quarter) {
+                double t = config.timeout() * quarter / 4.0;
+                out << " " << dataset.median_primal_gap_at(t, instances)
+                    << " at " << t << "s" << (quarter < 4 ? "," : "");
+            }
+            out << std::endl;
+        }
+    } // print_statistics
+
+
+
+    /*!
+     * Measures the noise of the machine before the sweep.
+     *
+     * @throws std::runtime_error if the noise is too large and
+     *         the configuration refuses to start in such a case
+     */
+    Calibration calibrate_machine(std::ostream& out,
+        const CalibrationSettings& settings, unsigned workers,
+        const std::vector<int>& cpus)
+    {
+        out << "Calibrating " << workers << " worker slot(s)..." << std::endl;
+        auto calibration = calibrate(workers, settings.repetitions, 1.0, cpus);
+        for (size_t slot = 0; slot < calibration.slots.size(); ++slot) {
+            const auto& measured = calibration.slots[slot];
+            out << "Slot " << slot << ": CV " << measured.cv * 100 << "%,"
+                << " relative speed " << measured.relative_speed;
+            if (measured.cpu >= 0) {
+                out << ", CPU " << measured.cpu;
+            }
+            out << std::endl;
+        }
+
+        if (calibration.cv() > settings.max_cv) {
+            std::string message = "Machine noise (CV "
+                + std::to_string(calibration.cv() * 100) + "%) exceeds the limit "
+                + std::to_string(settings.max_cv * 100) + "%";
+            if (settings.refuse) {
+                throw std::runtime_error(message + ", refusing to start.");
+            }
+            out << "WARNING: " << message << "." << std::endl;
+        }
+        return calibration;
+    } // calibrate_machine
+
+
+
+    //! Executes all jobs of the configuration and saves them as a new run
+    Dataset execute_experiment(std::ostream& out, const Config& config,
+        const RunOptions& options, sql_database& db, long long& run_id)
+    {
+        // A resumed run continues with its pending jobs only,
+        // the jobs finished before are a part of its statistics
+        const long long resumed_run = options.resume ? db.unfinished_run(config) : 0;
+        std::vector<CmdWithArgs> jobs;
+        Dataset resumed(config.timeout(), std::vector<ExecResult>());
+        if (resumed_run != 0) {
+            JobSpace space(config);
+            for (auto index : db.pending_jobs(resumed_run)) {
+                jobs.push_back(space.at(index));
+            }
+            resumed = db.load_dataset(resumed_run, true);
+            out << "Resuming run " << resumed_run << " with "
+                << resumed.score().attempted << " finished jobs" << std::endl;
+        } else {
+            jobs = combine_command_lines(config, options.shard);
+        }
+        out << "Jobs to execute: " << jobs.size() << std::endl;
+        if (options.shard.enabled()) {
+            out << "Shard " << options.shard.to_string() << " of the sweep,"
+                << " saved to " << options.database() << std::endl;
+        }
+        const auto& sample = config.sample();
+        if (sample.enabled()) {
+            out << "Sampled by the " << design_name(sample.design)
+                << " design of " << sample.size << " points (seed "
+                << sample.seed << ")" << std::endl;
+        }
+
+        // Calibrate before the run is created, it may refuse to start;
+        // remote workers have slots of their own, which are not calibrated
+        auto workers = config.workers();
+        auto calibration_settings = config.calibration();
+        if (options.serve) {
+            calibration_settings.enabled = false;
+        }
+        // The slots of a calibrated sweep are pinned to CPUs of their own,
+        // so that the speed of a slot is the speed of its CPU
+        Calibration calibration = Calibration();
+        std::vector<int> cpus;
+        if (calibration_settings.enabled) {
+            cpus = slot_cpus(workers);
+            calibration = calibrate_machine(out, calibration_settings, workers, cpus);
+        }
+
+        if (resumed_run != 0) {
+            run_id = resumed_run;
+            db.set_run_status(run_id, RunStatus::Running);
+        } else {
+            run_id = db.new_run_started();
+            if (calibration_settings.enabled) {
+                db.save_calibration(run_id, calibration);
+            }
+            if (sample.enabled()) {
+                db.save_sample(run_id, sample);
+            }
+            if (options.shard.enabled()) {
+                db.save_shard(run_id, options.shard);
+            }
+            db.save_job_space(run_id, JobSpace(config));
+        }
+
+        // Open the CSV log file if needed
+
+        auto csv_output_filename = config.logging_job_csv_file();
+        std::ofstream csv_output_file;
+        if (csv_output_filename == "-") {
+            print_job_csv_header(out);
+        } else if (csv_output_filename.is_empty()) {
+            csv_output_file.open(*csv_output_filename);
+            print_job_csv_header(csv_output_file);
+        }
+
+        if (resumed_run == 0) {
+            db.save_config_and_command_read_from_file(run_id, config);
+            if (options.resume) {
+                db.remove_finished_jobs(jobs, config);
+            }
+            db.save_pending_jobs(run_id, jobs);
+        }
+
+        // Every job gets its key, so that later runs can reuse it
+        std::unordered_map<unsigned, std::string> cache_keys;
+        const auto binary_hash = hash_executable(config.command());
+        if (!binary_hash.empty()) {
+            for (const auto& job : jobs) {
+                cache_keys[job.job_index()] = job_cache_key(binary_hash, job,
+                    config.timeout(), config.metrics());
+            }
+        } else if (config.cache() != CachePolicy::Never) {
+            out << "WARNING: Cannot read the binary '" << config.command()
+                << "', no results are reused." << std::endl;
+        }
+
+        // Reuse the results of identical jobs executed before
+        Dataset cached(config.timeout(), std::vector<ExecResult>());
+        size_t cached_jobs = 0;
+        if (config.cache() != CachePolicy::Never && !cache_keys.empty()) {
+            const size_t all_jobs = jobs.size();
+            cached = db.reuse_cached_results(run_id, jobs, cache_keys, config.timeout(),
+                config.cache() == CachePolicy::ReuseSameHost ? host_name() : "");
+            cached_jobs = all_jobs - jobs.size();
+            out << "Reused " << cached_jobs << " cached results, "
+                << jobs.size() << " jobs left" << std::endl;
+        }
+
+        // Record the timeline of the slots if needed
+        auto trace_filename = config.logging_trace_file();
+        std::unique_ptr<Tracer> tracer;
+        if (!trace_filename.empty() && !options.serve) {
+            tracer.reset(new Tracer(workers));
+        }
+
+        // Stage the input files ahead of the jobs if needed
+        std::unique_ptr<InputStager> stager;
+        auto page_cache = config.page_cache();
+        if (page_cache.enabled() && !options.serve) {
+            stager.reset(new InputStager(jobs, page_cache));
+            out << "Staging " << stager->input_files() << " input file(s)" << std::endl;
+            if (page_cache.mode == PageCacheSettings::Mode::Cold && workers > 1) {
+                out << "WARNING: Dropping the input files from the page cache"
+                    " slows down the jobs running in parallel too." << std::endl;
+            }
+        }
+
+        // Give every slot a working directory of its own if needed
+        std::unique_ptr<ScratchSpace> scratch;
+        if (config.scratch().enabled() && !options.serve) {
+            scratch.reset(new ScratchSpace(config.scratch(), workers));
+            out << "Scratch directory of slot 0: " << scratch->directory(0) << std::endl;
+        }
+
+        // Serve live counters if needed
+        SweepMonitor monitor;
+        std::unique_ptr<MonitorServer> monitor_server;
+        auto monitor_settings = config.monitor();
+        if (monitor_settings.enabled()) {
+            monitor_server.reset(new MonitorServer(monitor, monitor_settings));
+        }
+
+        // Run the experiment!
+        auto metric_patterns = config.metrics();
+        size_t finished_jobs = 0;
+        auto save_result = [&](const CmdWithArgs& cwa, unsigned timeout,
+            const ExecResult& result, unsigned slot)
         {
             if (csv_output_filename == "-") {
-                print_job_csv_line(std::cout, cwa, timeout, result);
+                print_job_csv_line(out, cwa, timeout, result);
             } else if (csv_output_file.is_open()) {
                 print_job_csv_line(csv_output_file, cwa, timeout, result);
             }
 
-            db.on_job_finished(run_id, cwa, timeout, result);
-        });
+            auto key = cache_keys.find(cwa.job_index());
+            db.on_job_finished(run_id, cwa, timeout, result, slot,
+                key != cache_keys.end() ? key->second : std::string());
+            ++finished_jobs;
+        };
+        InterruptGuard interrupt_guard(config.on_interrupt());
+        Dataset dataset(config.timeout(), std::vector<ExecResult>());
+        if (options.serve) {
+            Coordinator coordinator(jobs, config.timeout(),
+                metric_patterns, options.coordinator);
+            out << "Waiting for workers on port " << coordinator.port() << std::endl;
+            dataset = coordinator.run(save_result, &monitor);
+        } else {
+            dataset = execute_all_runs(jobs, config.timeout(), metric_patterns, workers,
+                [&](const CmdWithArgs& cwa, unsigned timeout, ExecResult result, unsigned slot)
+                {
+                    save_result(cwa, timeout, result, slot);
+                }, tracer.get(), &monitor, stager.get(), scratch.get(), cpus);
+        }
+
+        // Cleanup
+
+        if (interrupt_requested()) {
+            db.set_run_status(run_id, RunStatus::Interrupted);
+            out << "Interrupted after " << finished_jobs << " of " << jobs.size()
+                << " jobs, continue by " << options.resume_command << std::endl;
+        } else {
+            db.set_run_status(run_id, RunStatus::Finished);
+        }
+
+        if (csv_output_file.is_open()) {
+            csv_output_file.close();
+        }
+
+        if (tracer && trace_filename == "-") {
+            tracer->write_chrome_trace(out);
+        } else if (tracer) {
+            std::ofstream trace_file(trace_filename);
+            tracer->write_chrome_trace(trace_file);
+        }
+
+        Dataset all_results = resumed;
+        all_results.append(dataset);
+        all_results.append(cached);
+
+        // Statistics of a partial sweep would be misleading
+        if (interrupt_requested()) {
+            return all_results;
+        }
+        print_statistics(out, all_results, config,
+            resumed.score().attempted + finished_jobs + cached_jobs);
+
+        // Only the executed jobs were measured by the calibrated slots,
+        // an unpinned slot has no speed of its own
+        if (calibration_settings.enabled && workers > 1 && finished_jobs > 0) {
+            if (calibration.pinned()) {
+                auto normalized = dataset.normalized_by_slot_speed(
+                    calibration.relative_speeds());
+                out << "Normalized by slot speed: median "
+                    << normalized.median_runtime_of_all_runs() << "s, PAR-"
+                    << config.statistics_par_k() << " "
+                    << normalized.score(config.statistics_par_k()).par_k
+                    << "s" << std::endl;
+            } else {
+                out << "Runtimes are not normalized by slot speed,"
+                    " the slots cannot be pinned to CPUs of their own." << std::endl;
+            }
+        }
+        return all_results;
+    } // execute_experiment
+
+
+
+    //! Runs the experiment given by a configuration file
+    int run_experiment(const std::vector<std::string>& args, bool serve)
+    {
+        RunOptions options;
+        options.serve = serve;
+        if (serve) {
+            options.resume_command = "perfnp serve -r";
+        }
+        Config config = read_config(args, options);
+        if (options.resume) {
+            std::cout << "Resume ON!" << std::endl;
+        }
+
+        sql_database db(options.database());
+        long long run_id;
+        execute_experiment(std::cout, config, options, db, run_id);
+        if (interrupt_requested()) {
+            return exit_code_of_interruption();
+        }
+        return 0;
+    } // run_experiment
+
+
+
+    //! Parses a run ID given on the command-line
+    long long parse_run_id(const std::string& text)
+    {
+        size_t parsed = 0;
+        long long run_id = 0;
+        try {
+            run_id = std::stoll(text, &parsed);
+        } catch (const std::logic_error&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != text.size()) {
+            throw std::runtime_error("'" + text + "' is not a run ID.");
+        }
+        return run_id;
+    } // parse_run_id
+
+
+
+    //! Parses a positive count given on the command-line
+    unsigned parse_count(const std::string& text)
+    {
+        size_t parsed = 0;
+        unsigned long count = 0;
+        try {
+            count = std::stoul(text, &parsed);
+        } catch (const std::logic_error&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != text.size() || count == 0 || count > 65535) {
+            throw std::runtime_error("'" + text + "' is not a positive count.");
+        }
+        return static_cast<unsigned>(count);
+    } // parse_count
+
+
+
+    //! Compares two runs stored in the database
+    int compare_runs(const std::vector<std::string>& args)
+    {
+        if (args.size() != 2 && args.size() != 3) {
+            throw std::runtime_error("Usage: perfnp compare"
+                " <run_a> <run_b> [instances.csv]");
+        }
+
+        auto run_a = parse_run_id(args[0]);
+        auto run_b = parse_run_id(args[1]);
+
+        sql_database db("perfnp.sqlite");
+        for (auto run_id : { run_a, run_b }) {
+            if (!db.has_run(run_id)) {
+                throw std::runtime_error("Run " + std::to_string(run_id)
+                    + " is not present in the database.");
+            }
+        }
+
+        std::ofstream instances_file;
+        if (args.size() == 3) {
+            instances_file.open(args[2]);
+            print_paired_instance_csv_header(instances_file);
+        }
+
+        RunComparator comparator;
+        db.for_each_paired_instance(run_a, run_b,
+            [&](const PairedInstance& instance)
+            {
+                comparator.add(instance);
+                if (instances_file.is_open()) {
+                    print_paired_instance_csv_line(instances_file, instance);
+                }
+            });
+
+        auto result = comparator.compare();
+        std::cout << "Paired instances: " << result.paired << std::endl;
+        if (result.paired == 0) {
+            return 0;
+        }
+
+        std::cout << "Speedup (A/B):    " << result.speedup
+            << " [" << result.speedup_lower << ", " << result.speedup_upper
+            << "] geometric mean, 95% bootstrap CI" << std::endl;
+
+        std::cout << "Wilcoxon test:    W+ = " << result.wilcoxon_w
+            << ", z = " << result.wilcoxon_z
+            << ", p = " << result.p_value << std::endl;
+
+        std::cout << "Solved jobs:      " << result.solved_a
+            << " -> " << result.solved_b << " ("
+            << (result.solved_b >= result.solved_a ? "+" : "-")
+            << (result.solved_b >= result.solved_a
+                ? result.solved_b - result.solved_a
+                : result.solved_a - result.solved_b)
+            << ")" << std::endl;
+        return 0;
+    } // compare_runs
+
+
+
+    /*!
+     * Runs the experiment and compares it against a baseline run.
+     *
+     * The report of the experiment goes to stderr, so that stdout
+     * contains only the JSON verdict.
+     */
+    int gate_run(const std::vector<std::string>& args)
+    {
+        if (args.empty()) {
+            throw std::runtime_error("Usage: perfnp gate"
+                " <baseline_run> [-r] [config.json]");
+        }
+
+        auto baseline_run = parse_run_id(args[0]);
+        RunOptions options;
+        options.resume_command = "perfnp gate " + args[0] + " -r";
+        Config config = read_config(
+            std::vector<std::string>(args.begin() + 1, args.end()), options);
+        auto thresholds = config.gate_thresholds();
+
+        sql_database db("perfnp.sqlite");
+        if (!db.has_run(baseline_run)) {
+            throw std::runtime_error("Baseline run " + std::to_string(baseline_run)
+                + " is not present in the database.");
+        }
+        auto baseline = db.load_dataset(baseline_run);
+
+        // Without an unfinished run, -r would skip the jobs finished
+        // by any earlier run and the gate would judge the rest only
+        if (options.resume && db.unfinished_run(config) == 0) {
+            throw std::runtime_error("There is no interrupted run"
+                " of the configuration to resume.");
+        }
+
+        long long run_id;
+        auto dataset = execute_experiment(std::cerr, config, options, db, run_id);
+        if (interrupt_requested()) {
+            std::cerr << "No verdict on the interrupted run " << run_id << std::endl;
+            return exit_code_of_interruption();
+        }
+        if (dataset.score().attempted == 0) {
+            throw std::runtime_error("No verdict, the run "
+                + std::to_string(run_id) + " has no jobs.");
+        }
+
+        auto verdict = evaluate_gate(baseline, dataset,
+            thresholds, config.statistics_par_k());
+        verdict.baseline_run = baseline_run;
+        verdict.current_run = run_id;
+        print_gate_verdict_json(std::cout, verdict);
+
+        return verdict.passed() ? 0 : EXIT_REGRESSION;
+    } // gate_run
+
 
-    // Cleanup
 
-    if (csv_output_file.is_open()) {
-        csv_output_file.close();
+    //! Executes jobs of a coordinator (`perfnp serve`) on this machine
+    int run_worker_node(const std::vector<std::string>& args)
+    {
+        const std::string usage = "Usage: perfnp work --connect host:port"
+            " [--slots n] [--batch n]";
+
+        WorkerSettings settings;
+        settings.slots = std::max(1u, std::thread::hardware_concurrency());
+        bool connect = false;
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (i + 1 == args.size()) {
+                throw std::runtime_error(usage);
+            }
+            if (args[i] == "--connect") {
+                parse_endpoint(args[++i], settings.host, settings.port);
+                connect = true;
+            } else if (args[i] == "--slots") {
+                settings.slots = parse_count(args[++i]);
+            } else if (args[i] == "--batch") {
+                settings.batch = parse_count(args[++i]);
+            } else {
+                throw std::runtime_error(usage);
+            }
+        }
+        if (!connect) {
+            throw std::runtime_error(usage);
+        }
+
+        auto executed = run_worker(settings);
+        std::cout << "Executed " << executed << " jobs" << std::endl;
+        return 0;
+    } // run_worker_node
+
+
+
+    //! Merges databases of shards into one database
+    int merge_databases(const std::vector<std::string>& args)
+    {
+        if (args.size() < 2) {
+            throw std::runtime_error("Usage: perfnp merge"
+                " <into.sqlite> <shard.sqlite>...");
+        }
+
+        sql_database db(args[0]);
+        for (size_t i = 1; i < args.size(); ++i) {
+            auto runs = db.merge(args[i]);
+            std::cout << "Merged " << args[i] << " into run";
+            for (auto run_id : runs) {
+                std::cout << " " << run_id;
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    } // merge_databases
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) try {
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (!args.empty() && args[0] == "compare") {
+        return compare_runs(std::vector<std::string>(args.begin() + 1, args.end()));
     }
 
-    // Print statistics
+    if (!args.empty() && args[0] == "gate") {
+        return gate_run(std::vector<std::string>(args.begin() + 1, args.end()));
+    }
 
-    if (dataset.number_of_all_successful_runs() > 0) {
-        std::cout << "Median runtime:  "
-            << dataset.median_runtime_of_all_runs() << "s +- "
-            << dataset.mad_runtime_of_all_runs() << "s from "
-            << jobs.size() << " jobs" << std::endl;
+    if (!args.empty() && args[0] == "merge") {
+        return merge_databases(std::vector<std::string>(args.begin() + 1, args.end()));
+    }
 
-        std::cout << "Successful runs: "
-            << dataset.median_runtime_of_successful_runs() << "s +- "
-            << dataset.mad_runtime_of_all_successful_runs() << "s from "
-            << dataset.number_of_all_successful_runs() << " jobs" << std::endl;
-    } else {
-        std::cout << "There were no successful runs." << std::endl;
+    if (!args.empty() && args[0] == "serve") {
+        return run_experiment(std::vector<std::string>(args.begin() + 1, args.end()), true);
     }
 
+    if (!args.empty() && args[0] == "work") {
+        return run_worker_node(std::vector<std::string>(args.begin() + 1, args.end()));
+    }
+
+    return run_experiment(args, false);
+
 } catch (const nlohmann::json::parse_error& ex) {
     std::cerr << "ERROR: Configuration file is not JSON." << std::endl;
     std::cerr << ex.what() << std::endl;
@@ -0,0 +1,150 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/anytime.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Size of one point in the blob: 4B time + 8B value
+    const size_t POINT_BLOB_SIZE = 12;
+
+    //! Appends an unsigned integer in the little-endian order
+    void append_little_endian(std::string& out, std::uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i) {
+            out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    } // append_little_endian
+
+    //! Reads an unsigned integer in the little-endian order
+    std::uint64_t read_little_endian(const char* data, size_t bytes)
+    {
+        std::uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint64_t>(
+                static_cast<unsigned char>(data[i])) << (8 * i);
+        }
+        return value;
+    } // read_little_endian
+
+} // anonymous namespace
+
+
+
+double perfnp::primal_gap(double value, double reference)
+{
+    if (value == reference) {
+        return 0.0;
+    }
+    if (value * reference < 0) {
+        return 1.0;
+    }
+    return std::fabs(value - reference)
+        / std::max(std::fabs(value), std::fabs(reference));
+} // primal_gap
+
+
+
+bool Trajectory::add(std::uint32_t time_in_ms, double value)
+{
+    if (!m_points.empty() && !is_better(value, m_points.back().value)) {
+        return false;
+    }
+
+    TrajectoryPoint point;
+    point.time_in_ms = time_in_ms;
+    point.value = value;
+    m_points.push_back(point);
+    return true;
+} // Trajectory::add
+
+
+
+double Trajectory::gap_at(double t, double reference) const
+{
+    auto after = std::upper_bound(m_points.begin(), m_points.end(), t * 1000.0,
+        [](double time_in_ms, const TrajectoryPoint& point) {
+            return time_in_ms < point.time_in_ms;
+        });
+
+    if (after == m_points.begin()) {
+        return 1.0;
+    }
+    return primal_gap((after - 1)->value, reference);
+} // Trajectory::gap_at
+
+
+
+double Trajectory::primal_integral(double horizon, double reference) const
+{
+    double integral = 0.0;
+    double previous_time = 0.0;
+    double gap = 1.0;
+
+    for (const auto& point : m_points) {
+        double time = point.time_in_ms / 1000.0;
+        if (time >= horizon) {
+            break;
+        }
+        integral += gap * (time - previous_time);
+        gap = primal_gap(point.value, reference);
+        previous_time = time;
+    }
+
+    if (horizon > previous_time) {
+        integral += gap * (horizon - previous_time);
+    }
+    return integral;
+} // Trajectory::primal_integral
+
+
+
+std::string Trajectory::to_blob() const
+{
+    std::string blob;
+    blob.reserve(m_points.size() * POINT_BLOB_SIZE);
+
+    for (const auto& point : m_points) {
+        std::uint64_t value_bits;
+        static_assert(sizeof(value_bits) == sizeof(point.value),
+            "double must have 64 bits");
+        std::memcpy(&value_bits, &point.value, sizeof(value_bits));
+
+        append_little_endian(blob, point.time_in_ms, 4);
+        append_little_endian(blob, value_bits, 8);
+    }
+    return blob;
+} // Trajectory::to_blob
+
+
+
+Trajectory Trajectory::from_blob(bool minimize, const std::string& blob)
+{
+    if (blob.size() % POINT_BLOB_SIZE != 0) {
+        throw std::runtime_error("Trajectory blob has "
+            + std::to_string(blob.size()) + " bytes, which is"
+            " not a multiple of " + std::to_string(POINT_BLOB_SIZE) + ".");
+    }
+
+    Trajectory out(minimize);
+    out.m_points.reserve(blob.size() / POINT_BLOB_SIZE);
+
+    for (size_t i = 0; i < blob.size(); i += POINT_BLOB_SIZE) {
+        TrajectoryPoint point;
+        point.time_in_ms = static_cast<std::uint32_t>(
+            read_little_endian(blob.data() + i, 4));
+        std::uint64_t value_bits = read_little_endian(blob.data() + i + 4, 8);
+        std::memcpy(&point.value, &value_bits, sizeof(value_bits));
+        out.m_points.push_back(point);
+    }
+    return out;
+} // Trajectory::from_blob
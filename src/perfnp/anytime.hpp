@@ -0,0 +1,128 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_ANYTIME_H_
+#define PERFNP_ANYTIME_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Incumbent value found by an anytime solver at some time.
+ */
+struct TrajectoryPoint {
+
+    //! Time since the start of the job, in milliseconds
+    std::uint32_t time_in_ms;
+
+    //! Value of the incumbent
+    double value;
+
+    //! Equality operator compares all fields
+    bool operator==(const TrajectoryPoint& rhs) const {
+        return time_in_ms == rhs.time_in_ms
+            && value == rhs.value;
+    }
+}; // TrajectoryPoint
+
+
+
+/*!
+ * Sequence of improving incumbents found by one job.
+ *
+ * Only strict improvements (in the direction given by the
+ * objective sense) are kept, therefore the trajectory
+ * is both time-ordered and monotone.
+ */
+class Trajectory {
+
+    //! Is a smaller value better?
+    bool m_minimize;
+
+    //! Improving incumbents in the order of their discovery
+    std::vector<TrajectoryPoint> m_points;
+
+public:
+    //! Create an empty trajectory
+    explicit Trajectory(bool minimize = true)
+    : m_minimize(minimize)
+    {}
+
+    //! Is a smaller value better?
+    bool minimize() const {
+        return m_minimize;
+    }
+
+    //! Improving incumbents in the order of their discovery
+    const std::vector<TrajectoryPoint>& points() const {
+        return m_points;
+    }
+
+    //! Has no incumbent been found?
+    bool empty() const {
+        return m_points.empty();
+    }
+
+    /*!
+     * Records a new incumbent if it improves the last one.
+     *
+     * @return true if the value was an improvement
+     */
+    bool add(std::uint32_t time_in_ms, double value);
+
+    /*!
+     * Is value `a` better than value `b`?
+     */
+    bool is_better(double a, double b) const {
+        return m_minimize ? a < b : a > b;
+    }
+
+    /*!
+     * Primal gap of the incumbent at time `t` (in seconds).
+     *
+     * The gap is 1 until the first incumbent is found.
+     *
+     * @param reference the best known value (e.g. the optimum)
+     */
+    double gap_at(double t, double reference) const;
+
+    /*!
+     * Primal integral up to the given horizon (in seconds).
+     *
+     * It is the integral of the primal gap over [0, horizon].
+     * It is small if good solutions are found early.
+     *
+     * @param reference the best known value (e.g. the optimum)
+     */
+    double primal_integral(double horizon, double reference) const;
+
+    //! Packs the points into a compact little-endian byte string
+    std::string to_blob() const;
+
+    //! Unpacks points created by \ref to_blob
+    static Trajectory from_blob(bool minimize, const std::string& blob);
+
+    //! Equality operator compares all fields
+    bool operator==(const Trajectory& rhs) const {
+        return m_minimize == rhs.m_minimize
+            && m_points == rhs.m_points;
+    }
+}; // Trajectory
+
+
+
+/*!
+ * Primal gap of a value relative to the reference value.
+ *
+ * The gap is 0 for the reference, 1 if the signs differ and
+ * |value - reference| / max(|value|, |reference|) otherwise.
+ */
+double primal_gap(double value, double reference);
+
+} // perfnp
+#endif // PERFNP_ANYTIME_H_
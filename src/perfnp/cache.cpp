@@ -0,0 +1,254 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/cache.hpp"
+#include "perfnp/staging.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+    //! Round constants of SHA-256 (FIPS 180-4)
+    const std::uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    std::uint32_t rotr(std::uint32_t x, unsigned n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    //! Incremental SHA-256, so that a large binary is never loaded at once
+    class Sha256 {
+        std::uint32_t m_state[8];
+        unsigned char m_block[64];
+        size_t m_block_size;
+        std::uint64_t m_length;
+
+        void compress()
+        {
+            std::uint32_t w[64];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = std::uint32_t(m_block[4 * i]) << 24
+                    | std::uint32_t(m_block[4 * i + 1]) << 16
+                    | std::uint32_t(m_block[4 * i + 2]) << 8
+                    | std::uint32_t(m_block[4 * i + 3]);
+            }
+            for (int i = 16; i < 64; ++i) {
+                auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            std::uint32_t v[8];
+            for (int i = 0; i < 8; ++i) {
+                v[i] = m_state[i];
+            }
+            for (int i = 0; i < 64; ++i) {
+                auto s1 = rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25);
+                auto choice = (v[4] & v[5]) ^ (~v[4] & v[6]);
+                auto t1 = v[7] + s1 + choice + K[i] + w[i];
+                auto s0 = rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22);
+                auto majority = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+                auto t2 = s0 + majority;
+                v[7] = v[6];
+                v[6] = v[5];
+                v[5] = v[4];
+                v[4] = v[3] + t1;
+                v[3] = v[2];
+                v[2] = v[1];
+                v[1] = v[0];
+                v[0] = t1 + t2;
+            }
+            for (int i = 0; i < 8; ++i) {
+                m_state[i] += v[i];
+            }
+            m_block_size = 0;
+        } // compress
+
+    public:
+        Sha256()
+        : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}
+        , m_block_size(0)
+        , m_length(0)
+        {}
+
+        void update(const char* data, size_t size)
+        {
+            m_length += size;
+            for (size_t i = 0; i < size; ++i) {
+                m_block[m_block_size++] = static_cast<unsigned char>(data[i]);
+                if (m_block_size == sizeof(m_block)) {
+                    compress();
+                }
+            }
+        } // update
+
+        std::string hex_digest()
+        {
+            const std::uint64_t bits = m_length * 8;
+            m_block[m_block_size++] = 0x80;
+            if (m_block_size > 56) {
+                while (m_block_size < 64) {
+                    m_block[m_block_size++] = 0;
+                }
+                compress();
+            }
+            while (m_block_size < 56) {
+                m_block[m_block_size++] = 0;
+            }
+            for (int i = 7; i >= 0; --i) {
+                m_block[m_block_size++] = static_cast<unsigned char>(bits >> (8 * i));
+            }
+            compress();
+
+            static const char digits[] = "0123456789abcdef";
+            std::string hex;
+            for (auto word : m_state) {
+                for (int shift = 28; shift >= 0; shift -= 4) {
+                    hex += digits[(word >> shift) & 0xf];
+                }
+            }
+            return hex;
+        } // hex_digest
+    }; // Sha256
+
+    //! Path of the binary executed for the command, like execvp() finds it
+    std::string find_executable(const std::string& command)
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        if (command.find('/') != std::string::npos) {
+            return command;
+        }
+        const char* path = std::getenv("PATH");
+        std::istringstream directories(path != nullptr ? path : "/bin:/usr/bin");
+        std::string directory;
+        while (std::getline(directories, directory, ':')) {
+            std::string candidate = (directory.empty() ? "." : directory) + "/" + command;
+            struct stat info;
+            if (stat(candidate.c_str(), &info) == 0 && S_ISREG(info.st_mode)
+                && access(candidate.c_str(), X_OK) == 0) {
+                return candidate;
+            }
+        }
+#endif
+        return command;
+    } // find_executable
+
+    //! Size and modification time of the file, empty if unknown
+    std::string file_version(const std::string& path)
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            return "";
+        }
+#if defined(__APPLE__)
+        const auto& modified = info.st_mtimespec;
+#else
+        const auto& modified = info.st_mtim;
+#endif
+        return std::to_string(info.st_size) + " " + std::to_string(modified.tv_sec)
+            + "." + std::to_string(modified.tv_nsec);
+#else
+        (void)path;
+        return "";
+#endif
+    } // file_version
+
+} // anonymous namespace
+
+
+
+std::string perfnp::sha256_hex(const std::string& data)
+{
+    Sha256 sha;
+    sha.update(data.data(), data.size());
+    return sha.hex_digest();
+} // sha256_hex
+
+
+
+std::string perfnp::hash_executable(const std::string& command)
+{
+    std::ifstream binary(find_executable(command), std::ios::binary);
+    if (!binary) {
+        return "";
+    }
+
+    Sha256 sha;
+    char buffer[1 << 16];
+    while (binary.read(buffer, sizeof(buffer)) || binary.gcount() > 0) {
+        sha.update(buffer, static_cast<size_t>(binary.gcount()));
+    }
+    if (binary.bad()) {
+        return "";
+    }
+    return sha.hex_digest();
+} // hash_executable
+
+
+
+std::string perfnp::job_cache_key(const std::string& binary_hash,
+    const CmdWithArgs& cwa, unsigned timeout,
+    const std::vector<MetricPattern>& patterns)
+{
+    // The hash has a fixed length and the timeout has no newline,
+    // so that different jobs never concatenate to the same text
+    std::string job = binary_hash + "\n" + std::to_string(timeout)
+        + "\n" + cwa.escape_for_native_shell();
+
+    // Jobs without environment and working directory keep their old keys
+    if (!cwa.environment().empty() || !cwa.working_directory().empty()) {
+        job += '\0' + cwa.working_directory();
+        for (const auto& variable : cwa.environment()) {
+            job += '\0' + variable;
+        }
+    }
+
+    // An instance rewritten under the same name is another job
+    for (const auto& file : input_files(cwa)) {
+        job += "\n" + file + '\0' + file_version(file);
+    }
+
+    // Patterns start with a zero byte, which no path contains
+    for (const auto& pattern : patterns) {
+        job += std::string("\n") + '\0' + std::to_string(static_cast<int>(pattern.kind()))
+            + std::to_string(static_cast<int>(pattern.incumbent()))
+            + pattern.name() + '\0' + pattern.pattern();
+    }
+    return sha256_hex(job);
+} // job_cache_key
+
+
+
+std::string perfnp::host_name()
+{
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name) - 1) != 0) {
+        return "";
+    }
+    return name;
+} // host_name
@@ -0,0 +1,67 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_CACHE_H_
+#define PERFNP_CACHE_H_
+
+#include "perfnp/cmd_line.hpp"
+#include "perfnp/metrics.hpp"
+
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+//! Which results of earlier runs may replace the execution of a job
+enum class CachePolicy {
+    //! Every job is executed
+    Never,
+
+    //! Results of an identical job from any host are reused
+    Reuse,
+
+    //! Results of an identical job are reused only from the same host
+    ReuseSameHost
+};
+
+//! SHA-256 digest of the data as 64 lowercase hexadecimal digits
+std::string sha256_hex(const std::string& data);
+
+/*!
+ * Hash of the content of the executed binary.
+ *
+ * A command without a slash is looked up in the PATH the same way
+ * execvp() does, so the hash belongs to the binary actually executed.
+ *
+ * @return SHA-256 of the binary, empty if it cannot be read
+ */
+std::string hash_executable(const std::string& command);
+
+/*!
+ * Content-addressed key of a job in the result cache.
+ *
+ * Jobs with the same key execute the same binary with the same
+ * command-line, environment variables, working directory and timeout,
+ * therefore their results are interchangeable.
+ *
+ * The input files of the job (see input_files()) take part by their
+ * size and modification time, not by their content. An instance
+ * rewritten in place gets a new key, unless its size and timestamp
+ * are restored as well. The metric patterns are a part of the key,
+ * because a reused result carries only the metrics extracted by
+ * the patterns of its own run.
+ *
+ * @param binary_hash hash of the binary, see hash_executable()
+ * @param patterns patterns applied to the output of the job
+ */
+std::string job_cache_key(const std::string& binary_hash,
+    const CmdWithArgs& cwa, unsigned timeout,
+    const std::vector<MetricPattern>& patterns = std::vector<MetricPattern>());
+
+//! Name of this host, empty if unknown
+std::string host_name();
+
+} // perfnp
+#endif // PERFNP_CACHE_H_
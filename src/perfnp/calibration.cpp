@@ -0,0 +1,234 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/calibration.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace perfnp;
+using namespace std::chrono;
+
+namespace {
+
+    //! Iterations of the CPU-bound kernel for the work scale 1
+    const double CPU_ITERATIONS = 25e6;
+
+    //! Buffer of the memory-bound kernel, in 32-bit elements (32 MiB)
+    const size_t MEMORY_ELEMENTS = 8 * 1024 * 1024;
+
+    //! Steps of the memory-bound kernel for the work scale 1
+    const double MEMORY_STEPS = 1e6;
+
+    //! The result of kernels is stored here, so they are not optimized out
+    volatile std::uint64_t kernel_sink;
+
+    //! Integer hashing, which stays in registers
+    void cpu_kernel(std::uint64_t iterations)
+    {
+        std::uint64_t z = 0;
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            z += 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        }
+        kernel_sink = z;
+    } // cpu_kernel
+
+    //! Random pointer chase, every step is a cache miss
+    void memory_kernel(const std::vector<std::uint32_t>& cycle, std::uint64_t steps)
+    {
+        std::uint32_t position = 0;
+        for (std::uint64_t i = 0; i < steps; ++i) {
+            position = cycle[position];
+        }
+        kernel_sink = position;
+    } // memory_kernel
+
+    //! Single random cycle over all elements (Sattolo's algorithm)
+    std::vector<std::uint32_t> make_cycle(size_t size, std::uint64_t seed)
+    {
+        std::vector<std::uint32_t> cycle(size);
+        for (size_t i = 0; i < size; ++i) {
+            cycle[i] = static_cast<std::uint32_t>(i);
+        }
+        for (size_t i = size - 1; i > 0; --i) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            size_t j = static_cast<size_t>((seed >> 33) % i);
+            std::swap(cycle[i], cycle[j]);
+        }
+        return cycle;
+    } // make_cycle
+
+    //! Time of the function call, in seconds
+    template<typename Function>
+    double measure(Function function)
+    {
+        auto start = steady_clock::now();
+        function();
+        return duration<double>(steady_clock::now() - start).count();
+    } // measure
+
+    //! Median of the values, which are reordered
+    double median_of(std::vector<double>& values)
+    {
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        if (values.size() % 2 != 0) {
+            return *middle;
+        }
+        return (*middle + *std::max_element(values.begin(), middle)) / 2;
+    } // median_of
+
+    //! Pins the calling thread to the CPU
+    void pin_thread(int cpu)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            throw std::runtime_error("Calibration cannot pin a slot to CPU "
+                + std::to_string(cpu) + ".");
+        }
+#else
+        throw std::runtime_error("Calibration cannot pin a slot to CPU "
+            + std::to_string(cpu) + " on this platform.");
+#endif
+    } // pin_thread
+
+    //! Sample standard deviation divided by the mean
+    double coefficient_of_variation(const std::vector<double>& values)
+    {
+        double mean = 0.0;
+        for (double value : values) {
+            mean += value;
+        }
+        mean /= values.size();
+
+        double variance = 0.0;
+        for (double value : values) {
+            variance += (value - mean) * (value - mean);
+        }
+        variance /= values.size() - 1;
+        return mean > 0.0 ? std::sqrt(variance) / mean : 0.0;
+    } // coefficient_of_variation
+
+} // anonymous namespace
+
+
+
+Calibration perfnp::calibrate(unsigned workers, unsigned repetitions,
+    double work_scale, const std::vector<int>& cpus)
+{
+    if (workers == 0) {
+        throw std::runtime_error("Calibration needs at least one worker slot.");
+    }
+    if (repetitions < 2) {
+        throw std::runtime_error("Calibration needs at least 2 repetitions,"
+            " but " + std::to_string(repetitions) + " were requested.");
+    }
+    if (!(work_scale > 0.0)) {
+        throw std::runtime_error("Work scale of the calibration must be positive.");
+    }
+    if (!cpus.empty() && cpus.size() != workers) {
+        throw std::runtime_error("Calibration needs a CPU for every worker slot.");
+    }
+
+    const auto cpu_iterations = static_cast<std::uint64_t>(CPU_ITERATIONS * work_scale) + 1;
+    const auto memory_steps = static_cast<std::uint64_t>(MEMORY_STEPS * work_scale) + 1;
+
+    Calibration out;
+    out.repetitions = repetitions;
+    out.slots.resize(workers);
+
+    std::mutex failure_mutex;
+    std::exception_ptr failure;
+
+    auto work = [&](unsigned slot) {
+        try {
+            out.slots[slot].cpu = cpus.empty() ? -1 : cpus[slot];
+            if (!cpus.empty()) {
+                pin_thread(cpus[slot]);
+            }
+            auto cycle = make_cycle(MEMORY_ELEMENTS, slot + 1);
+            std::vector<double> cpu_times;
+            std::vector<double> memory_times;
+            for (unsigned r = 0; r < repetitions; ++r) {
+                cpu_times.push_back(measure([&]() { cpu_kernel(cpu_iterations); }));
+                memory_times.push_back(measure([&]() { memory_kernel(cycle, memory_steps); }));
+            }
+
+            auto& result = out.slots[slot];
+            result.cv = std::max(coefficient_of_variation(cpu_times),
+                coefficient_of_variation(memory_times));
+            result.cpu_time = median_of(cpu_times);
+            result.memory_time = median_of(memory_times);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            failure = std::current_exception();
+        }
+    };
+
+    // A pinned slot has a thread of its own, perfnp itself stays unpinned
+    std::vector<std::thread> threads;
+    for (unsigned slot = cpus.empty() ? 1 : 0; slot < workers; ++slot) {
+        threads.emplace_back(work, slot);
+    }
+    if (cpus.empty()) {
+        work(0);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // The speed is relative to the fastest slot
+    double fastest = 0.0;
+    for (const auto& slot : out.slots) {
+        double total = slot.cpu_time + slot.memory_time;
+        fastest = fastest == 0.0 ? total : std::min(fastest, total);
+    }
+    for (auto& slot : out.slots) {
+        slot.relative_speed = fastest / (slot.cpu_time + slot.memory_time);
+    }
+    return out;
+} // calibrate
+
+
+
+std::vector<int> perfnp::slot_cpus(unsigned workers)
+{
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return {};
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE && cpus.size() < workers; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.size() < workers) {
+        return {};
+    }
+    return cpus;
+} // slot_cpus
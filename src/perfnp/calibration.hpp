@@ -0,0 +1,149 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_CALIBRATION_H_
+#define PERFNP_CALIBRATION_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Noise and speed of one worker slot measured by the reference kernels.
+ */
+struct SlotCalibration {
+
+    //! Median time of the CPU-bound kernel, in seconds
+    double cpu_time;
+
+    //! Median time of the memory-bound kernel, in seconds
+    double memory_time;
+
+    //! Coefficient of variation of the kernel times (the larger of the two)
+    double cv;
+
+    //! Speed relative to the fastest slot, in (0,1]
+    double relative_speed;
+
+    //! CPU the slot is pinned to, -1 if it is not pinned
+    int cpu;
+}; // SlotCalibration
+
+
+
+/*!
+ * Machine noise measured before the sweep, see \ref calibrate.
+ */
+struct Calibration {
+
+    //! Number of repetitions of each kernel in each slot
+    unsigned repetitions;
+
+    //! Measurements of every worker slot
+    std::vector<SlotCalibration> slots;
+
+    //! The largest coefficient of variation among the slots
+    double cv() const {
+        double out = 0.0;
+        for (const auto& slot : slots) {
+            out = slot.cv > out ? slot.cv : out;
+        }
+        return out;
+    }
+
+    //! The smallest relative speed among the slots
+    double min_relative_speed() const {
+        double out = 1.0;
+        for (const auto& slot : slots) {
+            out = slot.relative_speed < out ? slot.relative_speed : out;
+        }
+        return out;
+    }
+
+    /*!
+     * Is every slot pinned to a CPU of its own?
+     *
+     * Only then the speed of a slot is a property of its CPU,
+     * which the jobs of the slot share (see slot_cpus()).
+     */
+    bool pinned() const {
+        for (const auto& slot : slots) {
+            if (slot.cpu < 0) {
+                return false;
+            }
+        }
+        return !slots.empty();
+    }
+
+    //! Relative speed of every slot, see Dataset::normalized_by_slot_speed
+    std::vector<double> relative_speeds() const {
+        std::vector<double> out;
+        for (const auto& slot : slots) {
+            out.push_back(slot.relative_speed);
+        }
+        return out;
+    }
+}; // Calibration
+
+
+
+/*!
+ * Settings of the calibration run before the sweep.
+ */
+struct CalibrationSettings {
+
+    //! Should the calibration run at all?
+    bool enabled;
+
+    //! Number of repetitions of each kernel in each slot
+    unsigned repetitions;
+
+    //! The largest acceptable coefficient of variation
+    double max_cv;
+
+    //! Refuse to start the sweep if the noise is too large (otherwise warn)
+    bool refuse;
+
+    //! Calibration is disabled by default
+    CalibrationSettings()
+    : enabled(false)
+    , repetitions(5)
+    , max_cv(0.05)
+    , refuse(false)
+    {}
+}; // CalibrationSettings
+
+
+
+/*!
+ * Measures the jitter of the machine.
+ *
+ * A CPU-bound kernel (integer hashing) and a memory-bound kernel
+ * (a random pointer chase over a buffer larger than usual caches)
+ * are repeated in every worker slot. All slots run concurrently,
+ * so that they compete for the machine as the jobs of the sweep do.
+ * If the slots have CPUs, the thread of every slot is pinned to its
+ * CPU, where the jobs of the slot are pinned too (see ExecBin::set_cpu).
+ *
+ * @param workers number of worker slots
+ * @param repetitions number of repetitions of each kernel, at least 2
+ * @param work_scale scales the amount of work of both kernels,
+ *        1 takes roughly 0.1s per repetition on a current CPU
+ * @param cpus CPU of every slot (see slot_cpus()), empty if not pinned
+ */
+Calibration calibrate(unsigned workers, unsigned repetitions = 5,
+    double work_scale = 1.0, const std::vector<int>& cpus = std::vector<int>());
+
+/*!
+ * CPU of every worker slot, the first CPUs perfnp may run on.
+ *
+ * @return empty if there are fewer allowed CPUs than slots,
+ *         or if pinning is not supported (only Linux is)
+ */
+std::vector<int> slot_cpus(unsigned workers);
+
+} // perfnp
+#endif // PERFNP_CALIBRATION_H_
@@ -0,0 +1,847 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/cluster.hpp"
+#include "perfnp/interrupt.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+using nlohmann::json;
+
+namespace {
+
+    //! Metric pattern as sent to the workers
+    json pattern_to_json(const MetricPattern& pattern)
+    {
+        const char* incumbent = "no";
+        if (pattern.incumbent() == MetricPattern::Incumbent::Minimize) {
+            incumbent = "minimize";
+        } else if (pattern.incumbent() == MetricPattern::Incumbent::Maximize) {
+            incumbent = "maximize";
+        }
+        return json{
+            {"name", pattern.name()},
+            {"kind", pattern.kind() == MetricPattern::Kind::Regex ? "regex" : "prefix"},
+            {"pattern", pattern.pattern()},
+            {"incumbent", incumbent}
+        };
+    } // pattern_to_json
+
+    MetricPattern pattern_from_json(const json& j)
+    {
+        const auto incumbent = j.at("incumbent").get<std::string>();
+        return MetricPattern(j.at("name").get<std::string>(),
+            j.at("kind").get<std::string>() == "regex"
+                ? MetricPattern::Kind::Regex : MetricPattern::Kind::Prefix,
+            j.at("pattern").get<std::string>(),
+            incumbent == "minimize" ? MetricPattern::Incumbent::Minimize
+                : incumbent == "maximize" ? MetricPattern::Incumbent::Maximize
+                : MetricPattern::Incumbent::No);
+    } // pattern_from_json
+
+    //! Result of a job as sent to the coordinator
+    json result_to_json(unsigned index, unsigned slot, const ExecResult& result)
+    {
+        json metrics = json::array();
+        for (const auto& metric : result.metrics()) {
+            metrics.push_back({ metric.name(), metric.value() });
+        }
+        json points = json::array();
+        for (const auto& point : result.trajectory().points()) {
+            points.push_back({ point.time_in_ms, point.value });
+        }
+        return json{
+            {"type", "result"},
+            {"index", index},
+            {"slot", slot},
+            {"exit_code", result.exit_code()},
+            {"runtime", result.runtime()},
+            {"metrics", metrics},
+            {"trajectory", {
+                {"minimize", result.trajectory().minimize()},
+                {"points", points}
+            }}
+        };
+    } // result_to_json
+
+    ExecResult result_from_json(const json& j)
+    {
+        std::vector<MetricValue> metrics;
+        for (const auto& metric : j.at("metrics")) {
+            metrics.emplace_back(metric.at(0).get<std::string>(),
+                metric.at(1).get<double>());
+        }
+        const auto& trajectory_json = j.at("trajectory");
+        Trajectory trajectory(trajectory_json.at("minimize").get<bool>());
+        for (const auto& point : trajectory_json.at("points")) {
+            trajectory.add(point.at(0).get<std::uint32_t>(), point.at(1).get<double>());
+        }
+        return ExecResult(j.at("exit_code").get<int>(),
+            j.at("runtime").get<unsigned>(), std::move(metrics), std::move(trajectory));
+    } // result_from_json
+
+} // anonymous namespace
+
+
+
+void perfnp::parse_endpoint(const std::string& endpoint, std::string& host,
+    unsigned& port)
+{
+    const auto colon = endpoint.rfind(':');
+    const std::string digits = colon == std::string::npos
+        ? std::string() : endpoint.substr(colon + 1);
+    if (digits.empty() || digits.size() > 5
+            || digits.find_first_not_of("0123456789") != std::string::npos
+            || std::stoul(digits) > 65535) {
+        throw std::runtime_error("'" + endpoint + "' is not an endpoint host:port.");
+    }
+
+    host = endpoint.substr(0, colon);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+    port = static_cast<unsigned>(std::stoul(digits));
+} // parse_endpoint
+
+
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+    //! Longest accepted message, a longer line is a protocol error
+    const std::size_t MAX_MESSAGE_LENGTH = 64 * 1024 * 1024;
+
+    //! A peer does not follow the protocol
+    struct ProtocolError : std::runtime_error {
+        explicit ProtocolError(const std::string& what)
+        : std::runtime_error(what)
+        {}
+    }; // ProtocolError
+
+    //! Exception with the description of errno
+    std::runtime_error socket_error(const std::string& what)
+    {
+        return std::runtime_error("Cluster: " + what
+            + " failed: " + std::strerror(errno));
+    } // socket_error
+
+    //! Resolves a TCP endpoint, the result is freed by freeaddrinfo()
+    addrinfo* resolve(const std::string& host, unsigned port, bool passive)
+    {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+        addrinfo* found = nullptr;
+        const auto service = std::to_string(port);
+        const int error = getaddrinfo(host.empty() ? nullptr : host.c_str(),
+            service.c_str(), &hints, &found);
+        if (error != 0) {
+            throw std::runtime_error("Cluster: address '" + host + ":" + service
+                + "' cannot be resolved: " + gai_strerror(error));
+        }
+        return found;
+    } // resolve
+
+    //! Sends the message as one line, false if the peer disappeared
+    bool send_message(int fd, const json& message)
+    {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        const auto data = message.dump() + '\n';
+        size_t sent = 0;
+        while (sent < data.size()) {
+            auto n = send(fd, data.data() + sent, data.size() - sent, flags);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    } // send_message
+
+    //! Appends the received data to the buffer, false on the end of the stream
+    bool receive(int fd, std::string& buffer)
+    {
+        char chunk[4096];
+        for (;;) {
+            auto n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+            return buffer.size() <= MAX_MESSAGE_LENGTH;
+        }
+    } // receive
+
+    //! Takes the first complete line out of the buffer
+    bool take_line(std::string& buffer, std::string& line)
+    {
+        const auto end = buffer.find('\n');
+        if (end == std::string::npos) {
+            return false;
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        return true;
+    } // take_line
+
+
+
+    //! A worker connected to the coordinator
+    struct Client {
+
+        //! Socket of the connection, -1 once it is closed
+        int fd;
+
+        //! Received data without a complete line yet
+        std::string input;
+
+        //! Has the worker introduced itself?
+        bool welcomed;
+
+        //! Global number of the first slot of the worker
+        unsigned slot_base;
+
+        //! Number of slots of the worker
+        unsigned slots;
+
+        //! When the jobs of the silent worker are given to others
+        std::chrono::steady_clock::time_point expiry;
+
+        //! Positions of the jobs leased to the worker
+        std::set<size_t> leased;
+    }; // Client
+
+
+
+    //! Request-response connection to the coordinator, shared by threads
+    class Connection {
+
+        //! Socket of the connection, -1 once the coordinator has gone
+        int m_fd;
+
+        //! Received data without a complete line yet
+        std::string m_input;
+
+        //! Only one request is on the way at any time
+        std::mutex m_mutex;
+
+        //! Closes the connection, returns null as the reply
+        json lost()
+        {
+            close(m_fd);
+            m_fd = -1;
+            return json();
+        }
+
+    public:
+        Connection(const std::string& host, unsigned port)
+        : m_fd(-1)
+        {
+            addrinfo* found = resolve(host, port, false);
+            int error = 0;
+            for (auto ai = found; ai != nullptr && m_fd == -1; ai = ai->ai_next) {
+                int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (fd == -1) {
+                    error = errno;
+                    continue;
+                }
+                if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                    m_fd = fd;
+                } else {
+                    error = errno;
+                    close(fd);
+                }
+            }
+            freeaddrinfo(found);
+            if (m_fd == -1) {
+                errno = error;
+                throw socket_error("connect(" + host + ":" + std::to_string(port) + ")");
+            }
+
+            // Jobs do not inherit the connection
+            fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+        }
+
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        ~Connection()
+        {
+            if (m_fd != -1) {
+                close(m_fd);
+            }
+        }
+
+        //! Sends the message and waits for the reply, null if the coordinator has gone
+        json request(const json& message)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_fd == -1) {
+                return json();
+            }
+            if (!send_message(m_fd, message)) {
+                return lost();
+            }
+            std::string line;
+            while (!take_line(m_input, line)) {
+                if (!receive(m_fd, m_input)) {
+                    return lost();
+                }
+            }
+            try {
+                return json::parse(line);
+            } catch (const json::exception&) {
+                return lost();
+            }
+        }
+    }; // Connection
+
+} // anonymous namespace
+
+
+
+Coordinator::Coordinator(const std::vector<CmdWithArgs>& jobs, unsigned timeout,
+    std::vector<MetricPattern> metric_patterns,
+    const CoordinatorSettings& settings)
+: m_jobs(jobs)
+, m_timeout(timeout)
+, m_metric_patterns(std::move(metric_patterns))
+, m_settings(settings)
+, m_listen_fd(-1)
+{
+    if (settings.port > 65535) {
+        throw std::runtime_error("Cluster port "
+            + std::to_string(settings.port) + " is out of range.");
+    }
+
+    addrinfo* found = resolve(settings.host, settings.port, true);
+    int error = 0;
+    for (auto ai = found; ai != nullptr && m_listen_fd == -1; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1) {
+            error = errno;
+            continue;
+        }
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) {
+            m_listen_fd = fd;
+        } else {
+            error = errno;
+            close(fd);
+        }
+    }
+    freeaddrinfo(found);
+    if (m_listen_fd == -1) {
+        errno = error;
+        throw socket_error("bind(" + settings.host + ":"
+            + std::to_string(settings.port) + ")");
+    }
+
+    // Jobs inherit neither the listening socket nor the clients
+    fcntl(m_listen_fd, F_SETFD, FD_CLOEXEC);
+} // Coordinator::Coordinator
+
+
+
+Coordinator::~Coordinator()
+{
+    close(m_listen_fd);
+} // Coordinator::~Coordinator
+
+
+
+unsigned Coordinator::port() const
+{
+    sockaddr_storage address;
+    socklen_t length = sizeof(address);
+    if (getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address),
+            &length) == -1) {
+        throw socket_error("getsockname()");
+    }
+    if (address.ss_family == AF_INET6) {
+        return ntohs(reinterpret_cast<sockaddr_in6*>(&address)->sin6_port);
+    }
+    return ntohs(reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+} // Coordinator::port
+
+
+
+Dataset Coordinator::run(ResultCallback callback, SweepMonitor* monitor)
+{
+    typedef std::chrono::steady_clock Clock;
+    enum class JobState : char { Pending, Leased, Done };
+
+    const auto count = m_jobs.size();
+    const auto lease = std::chrono::seconds(std::max(1u, m_settings.lease));
+    std::vector<JobState> states(count, JobState::Pending);
+    std::deque<size_t> pending;
+    std::unordered_map<unsigned, size_t> positions;
+    for (size_t i = 0; i < count; ++i) {
+        pending.push_back(i);
+        positions[m_jobs[i].job_index()] = i;
+    }
+
+    std::vector<ExecResult> results(count, ExecResult(0, 1));
+    std::vector<unsigned> job_indices(count);
+    std::vector<unsigned> slots(count);
+    size_t finished = 0;
+    if (monitor) {
+        monitor->set_planned(count);
+    }
+
+    json welcome = {
+        {"type", "welcome"},
+        {"timeout", m_timeout},
+        {"heartbeat", m_settings.heartbeat},
+        {"metrics", json::array()},
+        {"environment", json::array()}
+    };
+    for (const auto& pattern : m_metric_patterns) {
+        welcome["metrics"].push_back(pattern_to_json(pattern));
+    }
+    // Names of the variables set by the jobs, so that the workers
+    // prepare their environment only once
+    std::set<std::string> variable_names;
+    for (const auto& cwa : m_jobs) {
+        for (const auto& variable : cwa.environment()) {
+            variable_names.insert(variable.substr(0, variable.find('=')));
+        }
+    }
+    for (const auto& name : variable_names) {
+        welcome["environment"].push_back(name);
+    }
+    const json ok = { {"type", "ok"} };
+
+    std::vector<Client> clients;
+    unsigned next_worker = 0;
+    unsigned next_slot = 0;
+
+    // Jobs of a lost worker go first to the others
+    auto release = [&](Client& client) {
+        for (auto position : client.leased) {
+            states[position] = JobState::Pending;
+            pending.push_front(position);
+            if (monitor) {
+                monitor->job_abandoned();
+            }
+        }
+        client.leased.clear();
+        close(client.fd);
+        client.fd = -1;
+    };
+
+    auto lease_jobs = [&](Client& client, size_t requested) -> json {
+        size_t workers = 0;
+        for (const auto& other : clients) {
+            workers += other.fd != -1 && other.welcomed;
+        }
+
+        // Share the last jobs among all workers
+        size_t batch = std::min<size_t>(requested, std::max(1u, m_settings.max_batch));
+        batch = std::min(batch, std::max<size_t>(1, pending.size() / std::max<size_t>(1, workers)));
+
+        json jobs = json::array();
+        while (jobs.size() < batch && !pending.empty()) {
+            const auto position = pending.front();
+            pending.pop_front();
+            states[position] = JobState::Leased;
+            client.leased.insert(position);
+            if (monitor) {
+                monitor->job_started();
+            }
+            const auto& cwa = m_jobs[position];
+            jobs.push_back({
+                {"index", cwa.job_index()},
+                {"command", cwa.command()},
+                {"arguments", cwa.arguments()},
+                {"environment", cwa.environment()},
+                {"working_directory", cwa.working_directory()}
+            });
+        }
+        return json{ {"type", "jobs"}, {"jobs", jobs} };
+    };
+
+    auto handle = [&](Client& client, const json& message) -> json {
+        client.expiry = Clock::now() + lease;
+        const auto type = message.at("type").get<std::string>();
+
+        if (type == "hello") {
+            client.welcomed = true;
+            client.slots = std::max(1u, message.at("slots").get<unsigned>());
+            client.slot_base = next_slot;
+            next_slot += client.slots;
+            json reply = welcome;
+            reply["worker"] = next_worker++;
+            return reply;
+        }
+        if (!client.welcomed) {
+            throw ProtocolError("hello expected");
+        }
+
+        if (type == "get") {
+            if (finished == count) {
+                return json{ {"type", "done"} };
+            }
+            if (pending.empty()) {
+                return json{ {"type", "wait"} };
+            }
+            return lease_jobs(client, message.at("max").get<size_t>());
+        }
+
+        if (type == "result") {
+            // Only the worker holding the lease reports the job
+            auto found = positions.find(message.at("index").get<unsigned>());
+            if (found == positions.end() || client.leased.count(found->second) == 0) {
+                return ok;
+            }
+            const auto slot = message.at("slot").get<unsigned>();
+            if (slot >= client.slots) {
+                throw ProtocolError("slot out of range");
+            }
+            auto result = result_from_json(message);
+
+            const auto position = found->second;
+            const auto& cwa = m_jobs[position];
+            client.leased.erase(position);
+            states[position] = JobState::Done;
+            ++finished;
+            if (monitor) {
+                monitor->job_finished(result, m_timeout, 0);
+                monitor->result_queued();
+            }
+            callback(cwa, m_timeout, result, client.slot_base + slot);
+            if (monitor) {
+                monitor->result_written();
+            }
+
+            results[position] = std::move(result);
+            job_indices[position] = cwa.job_index();
+            slots[position] = client.slot_base + slot;
+            return ok;
+        }
+
+        if (type == "heartbeat") {
+            return ok;
+        }
+        throw ProtocolError("unknown message '" + type + "'");
+    };
+
+    try {
+        while (finished < count && !interrupt_requested()) {
+            std::vector<pollfd> fds(1, pollfd{ m_listen_fd, POLLIN, 0 });
+            for (const auto& client : clients) {
+                fds.push_back(pollfd{ client.fd, POLLIN, 0 });
+            }
+            if (poll(fds.data(), fds.size(), 1000) == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw socket_error("poll()");
+            }
+
+            for (size_t i = 0; i < clients.size(); ++i) {
+                auto& client = clients[i];
+                if (fds[i + 1].revents == 0) {
+                    continue;
+                }
+                if (!receive(client.fd, client.input)) {
+                    release(client);
+                    continue;
+                }
+
+                // A worker breaking the protocol is treated as lost
+                std::string line;
+                while (client.fd != -1 && take_line(client.input, line)) {
+                    json reply;
+                    try {
+                        reply = handle(client, json::parse(line));
+                    } catch (const ProtocolError&) {
+                        release(client);
+                        break;
+                    } catch (const json::exception&) {
+                        release(client);
+                        break;
+                    }
+                    if (!send_message(client.fd, reply)) {
+                        release(client);
+                    }
+                }
+            }
+
+            // Jobs of silent workers are given to others
+            const auto now = Clock::now();
+            for (auto& client : clients) {
+                if (client.fd != -1 && client.expiry < now) {
+                    release(client);
+                }
+            }
+            clients.erase(std::remove_if(clients.begin(), clients.end(),
+                [](const Client& client) { return client.fd == -1; }),
+                clients.end());
+
+            if ((fds[0].revents & POLLIN) != 0) {
+                int fd = accept(m_listen_fd, nullptr, nullptr);
+                if (fd != -1) {
+                    fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    Client client;
+                    client.fd = fd;
+                    client.welcomed = false;
+                    client.slot_base = 0;
+                    client.slots = 0;
+                    client.expiry = Clock::now() + lease;
+                    clients.push_back(std::move(client));
+                }
+            }
+        }
+    } catch (...) {
+        for (const auto& client : clients) {
+            close(client.fd);
+        }
+        throw;
+    }
+
+    // The workers end, when the coordinator disconnects
+    for (const auto& client : clients) {
+        close(client.fd);
+    }
+
+    // An interrupted sweep keeps the finished jobs only
+    if (finished < count) {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (states[i] == JobState::Done) {
+                results[kept] = std::move(results[i]);
+                job_indices[kept] = job_indices[i];
+                slots[kept] = slots[i];
+                ++kept;
+            }
+        }
+        results.erase(results.begin() + kept, results.end());
+        job_indices.resize(kept);
+        slots.resize(kept);
+    }
+
+    return Dataset(m_timeout, std::move(results),
+        std::move(job_indices), std::move(slots));
+} // Coordinator::run
+
+
+
+std::size_t perfnp::run_worker(const WorkerSettings& settings)
+{
+    const unsigned slots = std::max(1u, settings.slots);
+    const unsigned batch = settings.batch != 0 ? settings.batch : 2 * slots;
+    const std::string endpoint = settings.host + ":" + std::to_string(settings.port);
+
+    Connection connection(settings.host, settings.port);
+    char name[256] = "";
+    gethostname(name, sizeof(name) - 1);
+    auto welcome = connection.request({
+        {"type", "hello"},
+        {"name", name},
+        {"slots", slots}
+    });
+    if (!welcome.is_object() || welcome.value("type", "") != "welcome") {
+        throw std::runtime_error("Cluster: coordinator " + endpoint
+            + " did not accept the worker.");
+    }
+    const auto timeout = welcome.at("timeout").get<unsigned>();
+    const auto heartbeat = std::chrono::seconds(
+        std::max(1u, welcome.at("heartbeat").get<unsigned>()));
+    std::vector<MetricPattern> metric_patterns;
+    for (const auto& pattern : welcome.at("metrics")) {
+        metric_patterns.push_back(pattern_from_json(pattern));
+    }
+    const auto variable_names = welcome.value("environment", std::vector<std::string>());
+    const EnvironmentTemplate environment(variable_names);
+
+    // Slots share a queue of the leased jobs
+    std::mutex queue_mutex;
+    std::deque<json> queue;
+    bool coordinator_done = false;
+    std::atomic<std::size_t> executed(0);
+    std::exception_ptr failure;
+
+    auto work = [&](unsigned slot) {
+        try {
+            for (;;) {
+                json job;
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    while (queue.empty() && !coordinator_done) {
+                        auto reply = connection.request({ {"type", "get"}, {"max", batch} });
+                        const auto type = reply.is_object()
+                            ? reply.value("type", "") : std::string();
+                        if (type == "jobs" && !reply.at("jobs").empty()) {
+                            for (const auto& leased : reply.at("jobs")) {
+                                queue.push_back(leased);
+                            }
+                        } else if (type == "jobs" || type == "wait") {
+                            lock.unlock();
+                            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                            lock.lock();
+                        } else {
+                            coordinator_done = true;
+                        }
+                    }
+                    if (queue.empty()) {
+                        return;
+                    }
+                    job = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                ExecBin exec(job.at("command").get<std::string>(),
+                    job.at("arguments").get<std::vector<std::string>>(), timeout);
+                if (!metric_patterns.empty()) {
+                    exec.set_metric_patterns(metric_patterns);
+                }
+                const auto variables = job.value("environment", std::vector<std::string>());
+                if (!variable_names.empty()) {
+                    exec.set_environment(environment.envp(variables));
+                }
+                const auto working_directory = job.value("working_directory", std::string());
+                if (!working_directory.empty()) {
+                    exec.set_working_directory(working_directory);
+                }
+                auto result = exec.execute();
+                ++executed;
+
+                auto reply = connection.request(result_to_json(
+                    job.at("index").get<unsigned>(), slot, result));
+                if (reply.is_null()) {
+                    return;
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            coordinator_done = true;
+            queue.clear();
+        }
+    };
+
+    // Heartbeats renew the leases while the jobs run
+    std::mutex stop_mutex;
+    std::condition_variable stop_condition;
+    bool stopped = false;
+    std::thread heartbeats([&] {
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        while (!stop_condition.wait_for(lock, heartbeat, [&] { return stopped; })) {
+            lock.unlock();
+            auto reply = connection.request({ {"type", "heartbeat"} });
+            lock.lock();
+            if (reply.is_null()) {
+                return;
+            }
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (unsigned slot = 1; slot < slots; ++slot) {
+        threads.emplace_back(work, slot);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopped = true;
+    }
+    stop_condition.notify_one();
+    heartbeats.join();
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return executed;
+} // run_worker
+#endif
+
+
+
+#if defined(_WIN32)
+Coordinator::Coordinator(const std::vector<CmdWithArgs>& jobs, unsigned timeout,
+    std::vector<MetricPattern> metric_patterns,
+    const CoordinatorSettings& settings)
+: m_jobs(jobs)
+, m_timeout(timeout)
+, m_metric_patterns(std::move(metric_patterns))
+, m_settings(settings)
+, m_listen_fd(-1)
+{
+    throw std::runtime_error("The cluster coordinator"
+        " is not supported on Windows.");
+} // Coordinator::Coordinator
+
+
+
+Coordinator::~Coordinator()
+{
+} // Coordinator::~Coordinator
+
+
+
+unsigned Coordinator::port() const
+{
+    return 0;
+} // Coordinator::port
+
+
+
+Dataset Coordinator::run(ResultCallback, SweepMonitor*)
+{
+    return Dataset(m_timeout, std::vector<ExecResult>());
+} // Coordinator::run
+
+
+
+std::size_t perfnp::run_worker(const WorkerSettings&)
+{
+    throw std::runtime_error("The cluster worker"
+        " is not supported on Windows.");
+} // run_worker
+#endif
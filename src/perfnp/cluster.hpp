@@ -0,0 +1,177 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_CLUSTER_H_
+#define PERFNP_CLUSTER_H_
+
+#include "perfnp/cmd_line.hpp"
+#include "perfnp/dataset.hpp"
+#include "perfnp/exec.hpp"
+#include "perfnp/metrics.hpp"
+#include "perfnp/monitor.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Splits an endpoint `host:port`.
+ *
+ * An empty host (e.g. ":7878") stands for all interfaces.
+ *
+ * @throw std::runtime_error if there is no valid port
+ */
+void parse_endpoint(const std::string& endpoint, std::string& host,
+    unsigned& port);
+
+
+
+/*!
+ * Settings of the coordinator of a multi-node sweep.
+ */
+struct CoordinatorSettings {
+
+    //! Address to listen on, empty for all interfaces
+    std::string host;
+
+    //! TCP port to listen on, 0 for any free port
+    unsigned port;
+
+    //! Seconds between heartbeats of the workers
+    unsigned heartbeat;
+
+    //! Seconds after the last message of a worker, when its jobs are given to others
+    unsigned lease;
+
+    //! The largest number of jobs given to a worker at once
+    unsigned max_batch;
+
+    //! Heartbeats every 5 seconds, six of them may be lost
+    CoordinatorSettings()
+    : port(0)
+    , heartbeat(5)
+    , lease(30)
+    , max_batch(64)
+    {}
+}; // CoordinatorSettings
+
+
+
+/*!
+ * Coordinator of a sweep executed by remote workers.
+ *
+ * The coordinator owns the jobs and the results, workers connect to
+ * it over TCP (see \ref run_worker) and pull batches of jobs. The
+ * protocol is line-based, every line is a JSON message and every
+ * message of a worker gets exactly one reply:
+ *
+ *  - `hello` (name, slots) is answered by `welcome` with the worker ID,
+ *    the timeout, the metric patterns and the heartbeat period,
+ *  - `get` (max) is answered by `jobs`, by `wait` if all remaining
+ *    jobs are leased to other workers, or by `done`,
+ *  - `result` (index, exit code, runtime, metrics, trajectory, slot)
+ *    and `heartbeat` are answered by `ok`.
+ *
+ * Every message of a worker renews the lease of its jobs. The jobs of
+ * a worker which disconnects or stays silent longer than the lease
+ * are given to other workers; the first result of a job is kept.
+ * All sockets are served by the thread calling run(), so the callback
+ * (e.g. the database) is never called concurrently. POSIX only.
+ */
+class Coordinator {
+public:
+    //! Called as `callback(cwa, timeout, result, slot)` for every job
+    typedef std::function<void(const CmdWithArgs&, unsigned,
+        const ExecResult&, unsigned)> ResultCallback;
+
+private:
+    //! Jobs of the sweep, must outlive the coordinator
+    const std::vector<CmdWithArgs>& m_jobs;
+
+    //! Limit of every job, in seconds
+    unsigned m_timeout;
+
+    //! Patterns extracting metrics, sent to the workers
+    std::vector<MetricPattern> m_metric_patterns;
+
+    CoordinatorSettings m_settings;
+
+    //! Listening socket
+    int m_listen_fd;
+
+public:
+    /*!
+     * Starts listening, the workers may connect before run().
+     *
+     * @throw std::runtime_error if the address cannot be used
+     */
+    Coordinator(const std::vector<CmdWithArgs>& jobs, unsigned timeout,
+        std::vector<MetricPattern> metric_patterns,
+        const CoordinatorSettings& settings);
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    ~Coordinator();
+
+    //! The port the coordinator listens on
+    unsigned port() const;
+
+    /*!
+     * Serves the workers until all jobs have finished.
+     *
+     * Slots of the workers are numbered globally, the first worker
+     * has slots from 0, the next one continues after them.
+     * Results in the dataset are in the order of the jobs.
+     * An interrupted coordinator (see \ref InterruptGuard) stops
+     * serving at once and the dataset has only the finished jobs.
+     */
+    Dataset run(ResultCallback callback, SweepMonitor* monitor = nullptr);
+}; // Coordinator
+
+
+
+/*!
+ * Settings of a worker of a multi-node sweep.
+ */
+struct WorkerSettings {
+
+    //! Host of the coordinator
+    std::string host;
+
+    //! Port of the coordinator
+    unsigned port;
+
+    //! Number of jobs executed in parallel
+    unsigned slots;
+
+    //! Number of jobs requested at once, 0 for twice the slots
+    unsigned batch;
+
+    WorkerSettings()
+    : port(0)
+    , slots(1)
+    , batch(0)
+    {}
+}; // WorkerSettings
+
+/*!
+ * Executes jobs of a coordinator until there are none left.
+ *
+ * Jobs are executed by ExecBin in parallel slots and every result is
+ * sent back as soon as it is known; a heartbeat keeps the leases of
+ * the running jobs. The worker ends when the coordinator has no more
+ * jobs or when it disconnects.
+ *
+ * @return number of executed jobs
+ * @throw std::runtime_error if the coordinator cannot be reached
+ */
+std::size_t run_worker(const WorkerSettings& settings);
+
+} // perfnp
+#endif // PERFNP_CLUSTER_H_
@@ -27,6 +27,12 @@ class CmdWithArgs {
     //! List of arguments for the command
     std::vector<std::string> m_arguments;
 
+    //! Variables set for the command as `NAME=value`, the rest is inherited
+    std::vector<std::string> m_environment;
+
+    //! Working directory of the command, empty for the one of perfnp
+    std::string m_working_directory;
+
 public:
     CmdWithArgs(
         unsigned job_index,
@@ -37,6 +43,19 @@ public:
     , m_arguments(std::move(arguments))
     {}
 
+    CmdWithArgs(
+        unsigned job_index,
+        std::string command,
+        std::vector<std::string> arguments,
+        std::vector<std::string> environment,
+        std::string working_directory)
+    : m_run_index(job_index)
+    , m_command(std::move(command))
+    , m_arguments(std::move(arguments))
+    , m_environment(std::move(environment))
+    , m_working_directory(std::move(working_directory))
+    {}
+
     //! Index of this run (see combin.hpp)
     unsigned job_index() const
     {
@@ -55,6 +74,18 @@ public:
         return m_arguments;
     }
 
+    //! Variables set for the command as `NAME=value`, the rest is inherited
+    const std::vector<std::string>& environment() const
+    {
+        return m_environment;
+    }
+
+    //! Working directory of the command, empty for the one of perfnp
+    const std::string& working_directory() const
+    {
+        return m_working_directory;
+    }
+
     /*!
      * Returns a native-shell-friendly string in UTF-8.
      *
@@ -74,7 +105,9 @@ public:
     bool operator==(const CmdWithArgs& rhs) const {
         return m_run_index == rhs.m_run_index
             && m_command == rhs.m_command
-            && m_arguments == rhs.m_arguments;
+            && m_arguments == rhs.m_arguments
+            && m_environment == rhs.m_environment
+            && m_working_directory == rhs.m_working_directory;
     }
 
     bool operator!=(const CmdWithArgs& rhs) const {
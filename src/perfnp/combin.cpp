@@ -4,68 +4,24 @@
 // https://opensource.org/licenses/MIT
 
 #include "perfnp/combin.hpp"
+#include "perfnp/cache.hpp"
 #include "perfnp/config.hpp"
+#include "perfnp/sample.hpp"
 
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 using namespace perfnp;
 
-namespace { // hide the combine method
-
-// function to print combinations that contain
-// one element from each of the given arrays
-std::vector<std::vector<std::string>> combine(
-	const std::vector<std::vector<std::string>>& input)
-{
-	std::vector<std::vector<std::string>> output; // return value
-	const size_t n = input.size(); // number of arrays
-
-    if (n == 0) {
-        return {};
-    }
-
-	// keeps track of next element in each of the n arrays
-	std::vector<size_t> indices(n, 0);
-
-	while (1) {
-
-		// print current combination
-		std::vector<std::string> vector_string_temp;
-		for (int i = 0; i < n; i++) {
-			// std::cout << arr[i][indices[i]] << " ";
-			vector_string_temp.push_back(input[i][indices[i]]);
-		}
-
-		output.push_back(vector_string_temp);
-
-		// find the rightmost array that has more elements left
-		// after the current element in that array
-		size_t next = n - 1;
-		while (next >= 0 && (indices[next] + 1 >= input[next].size())) {
-			if (next > 0) {
-				next--; // proceed to the next array
-			} else {
-				// no such array is found so no more combinations left
-				return output;
-			}
-		}
-
-		// if found move to next element in that array
-		indices[next]++;
-
-		// for all arrays to the right of this
-		// array current index again points to
-		// first element
-		for (size_t i = next + 1; i < n; i++) {
-			indices[i] = 0;
-		}
-	}
-} // combine
+namespace {
 
 void replace(std::string& haystack,
        const std::string& needle,
-       const std::string& replacement)
+       const char* replacement)
 {
     std::size_t pos;
     while ((pos = haystack.find(needle)) != std::string::npos) {
@@ -80,35 +36,307 @@ void replace(std::string& haystack,
 
 
 
-std::vector<CmdWithArgs> perfnp::combine_command_lines(const Config& config)
+JobSpace::JobSpace(const Config& config)
+: m_config(config)
+, m_size(1)
 {
-    auto command = config.command();
-    auto arguments = config.arguments();
-	auto parameters = config.parameters();
+    const auto& parameters = config.parameters();
+    std::vector<std::size_t> leaders(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        leaders[i] = i;
+    }
+    for (const auto& group : config.zip_groups()) {
+        for (auto member : group) {
+            leaders[member] = group.front();
+        }
+    }
 
-    if (parameters.empty()) {
-        return { CmdWithArgs(0, command, arguments.values()) };
+    // Zipped parameters have the same number of values,
+    // the group takes a single digit of the index
+    m_axis_of.resize(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        if (leaders[i] == i) {
+            m_axis_of[i] = m_axes.size();
+            m_axes.push_back(i);
+            m_members.emplace_back();
+        } else {
+            m_axis_of[i] = m_axis_of[leaders[i]];
+        }
+        m_members[m_axis_of[i]].push_back(i);
     }
 
-    std::vector<CmdWithArgs> out;
+    for (size_t axis = 0; axis < m_axes.size(); ++axis) {
+        const unsigned long long radix = axis_size(axis);
+        if (radix != 0 && m_size > std::numeric_limits<unsigned long long>::max() / radix) {
+            throw std::runtime_error("The parameters have too many combinations.");
+        }
+        m_size *= radix;
+    }
+
+    // A constraint is checked once all parameters up to its last one
+    // have their values, i.e. at the last dimension led by one of them
+    m_checks.resize(m_axes.size());
+    for (const auto& constraint : config.constraints()) {
+        if (m_axes.empty()) {
+            break;
+        }
+        const auto known = std::upper_bound(m_axes.begin(), m_axes.end(),
+            constraint.last_parameter()) - m_axes.begin();
+        m_checks[static_cast<size_t>(known) - 1].push_back(&constraint);
+    }
+
+    m_complete = config.constraints().empty();
+}
+
+
+
+std::vector<std::size_t> JobSpace::digits_of(unsigned long long index) const
+{
+    std::vector<std::size_t> digits(m_axes.size());
+    for (size_t axis = m_axes.size(); axis-- > 0;) {
+        digits[axis] = static_cast<size_t>(index % axis_size(axis));
+        index /= axis_size(axis);
+    }
+    return digits;
+}
+
+
+
+unsigned long long JobSpace::index_of_digits(const std::vector<std::size_t>& digits) const
+{
+    unsigned long long index = 0;
+    for (size_t axis = 0; axis < m_axes.size(); ++axis) {
+        index = index * axis_size(axis) + digits[axis];
+    }
+    return index;
+}
+
+
+
+bool JobSpace::increment(std::vector<std::size_t>& digits, std::size_t& level) const
+{
+    std::fill(digits.begin() + level + 1, digits.end(), 0);
+    while (++digits[level] == axis_size(level)) {
+        digits[level] = 0;
+        if (level == 0) {
+            return false;
+        }
+        --level;
+    }
+    return true;
+}
+
+
+
+std::size_t JobSpace::axis_size(std::size_t axis) const
+{
+    return m_config.parameters()[m_axes[axis]].size();
+}
+
+
+
+unsigned long long JobSpace::index_of(const std::vector<std::size_t>& axis_values) const
+{
+    return index_of_digits(axis_values);
+}
+
+
+
+unsigned long long JobSpace::next(unsigned long long from) const
+{
+    if (from >= m_size || m_complete) {
+        return std::min(from, m_size);
+    }
+
+    const auto& parameters = m_config.parameters();
+    auto digits = digits_of(from);
+
+    // Depth-first search from the digits of `from`, every level
+    // is valid with respect to the constraints above it
+    std::vector<std::string> values(parameters.size());
+    size_t level = 0;
+    while (level < m_axes.size()) {
+        for (auto member : m_members[level]) {
+            values[member] = parameters[member].value(digits[level]);
+        }
+        bool satisfied = true;
+        for (const auto* constraint : m_checks[level]) {
+            if (!(*constraint)(values)) {
+                satisfied = false;
+                break;
+            }
+        }
+        if (satisfied) {
+            ++level;
+        } else if (!increment(digits, level)) {
+            return m_size;
+        }
+    }
+    return index_of_digits(digits);
+}
+
 
-    std::vector<std::vector<std::string>> param_values;
-    for (const auto parameter : parameters) {
-        param_values.push_back(parameter.values());
+
+CmdWithArgs JobSpace::at(unsigned long long index) const
+{
+    if (index >= m_size) {
+        throw std::out_of_range("Job index " + std::to_string(index)
+            + " is out of " + std::to_string(m_size) + " jobs.");
+    }
+    if (index > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("Job index " + std::to_string(index)
+            + " is too large.");
+    }
+
+    const auto& parameters = m_config.parameters();
+
+    // The last dimension changes the fastest (mixed-radix job index)
+    const auto digits = digits_of(index);
+    std::vector<std::string> values(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        values[i] = parameters[i].value(digits[m_axis_of[i]]);
     }
 
-    std::vector<std::vector<std::string>> combinations = combine(param_values);
-    for (const auto& combination : combinations) {
-        assert(combination.size() == parameters.size());
+    auto substitute = [&](std::string text) {
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            replace(text, "%" + parameters[i].name() + "%", values[i].c_str());
+        }
+        return text;
+    };
+
+    std::vector<std::string> substituted;
+    for (const auto& argument : m_config.arguments().values()) {
+        substituted.emplace_back(substitute(argument));
+    }
+    if (m_config.environment().empty() && m_config.working_directory().empty()) {
+        return CmdWithArgs(static_cast<unsigned>(index), m_config.command(),
+            std::move(substituted));
+    }
+
+    std::vector<std::string> environment;
+    for (const auto& variable : m_config.environment()) {
+        environment.emplace_back(variable.first + "=" + substitute(variable.second));
+    }
+    return CmdWithArgs(static_cast<unsigned>(index), m_config.command(),
+        std::move(substituted), std::move(environment),
+        substitute(m_config.working_directory()));
+}
+
+
 
-        std::vector<std::string> substituted;
-        for (std::string argument : arguments.values()) {
-            for (size_t i = 0; i < parameters.size(); ++i) {
-                replace(argument, "%" + parameters[i].name() + "%", combination[i]);
+
+std::string JobSpace::digest() const
+{
+    // Every value is ended by a zero, a count precedes every list
+    std::string layout;
+    for (const auto& parameter : m_config.parameters()) {
+        layout += parameter.name() + '\0' + std::to_string(parameter.size()) + '\0';
+        for (std::size_t v = 0; v < parameter.size(); ++v) {
+            layout += parameter.value(v) + '\0';
+        }
+    }
+    for (const auto& members : m_members) {
+        layout += std::to_string(members.size()) + '\0';
+        for (auto member : members) {
+            layout += std::to_string(member) + '\0';
+        }
+    }
+    return sha256_hex(layout);
+}
+
+
+
+Shard Shard::parse(const std::string& text)
+{
+    const std::string usage = "Shard '" + text
+        + "' is not given as i/N or i/N:hashed with 1 <= i <= N.";
+
+    Shard shard;
+    auto body = text;
+    auto colon = text.find(':');
+    if (colon != std::string::npos) {
+        if (text.substr(colon + 1) != "hashed") {
+            throw std::runtime_error(usage);
+        }
+        shard.policy = Policy::Hashed;
+        body = text.substr(0, colon);
+    }
+
+    auto slash = body.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 == body.size()
+            || body.find_first_not_of("0123456789/") != std::string::npos
+            || body.find('/', slash + 1) != std::string::npos) {
+        throw std::runtime_error(usage);
+    }
+
+    unsigned long index = 0;
+    unsigned long count = 0;
+    try {
+        index = std::stoul(body.substr(0, slash));
+        count = std::stoul(body.substr(slash + 1));
+    } catch (const std::logic_error&) {
+        throw std::runtime_error(usage);
+    }
+    if (index < 1 || index > count || count > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error(usage);
+    }
+    shard.index = static_cast<unsigned>(index - 1);
+    shard.count = static_cast<unsigned>(count);
+    return shard;
+}
+
+
+
+bool Shard::takes(unsigned long long position, unsigned long long job_index) const
+{
+    if (policy == Policy::Strided) {
+        return position % count == index;
+    }
+
+    // SplitMix64 finalizer, neighbouring indices get unrelated hashes
+    std::uint64_t z = job_index + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return z % count == index;
+}
+
+
+
+std::string Shard::to_string() const
+{
+    return std::to_string(index + 1) + "/" + std::to_string(count)
+        + (policy == Policy::Hashed ? ":hashed" : "");
+}
+
+
+
+std::vector<CmdWithArgs> perfnp::combine_command_lines(const Config& config,
+    const Shard& shard)
+{
+    JobSpace space(config);
+    if (space.size() > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("The parameters have "
+            + std::to_string(space.size()) + " combinations, more than"
+            " a sweep can run.");
+    }
+
+    std::vector<CmdWithArgs> out;
+    unsigned long long position = 0;
+    const auto& sample = config.sample();
+    if (sample.enabled()) {
+        for (auto i : sample_job_indices(space, sample)) {
+            if (shard.takes(position++, i)) {
+                out.emplace_back(space.at(i));
             }
-            substituted.emplace_back(std::move(argument));
         }
-        out.emplace_back(CmdWithArgs(out.size(), command, std::move(substituted)));
+        return out;
+    }
+
+    for (auto i = space.next(0); i < space.size(); i = space.next(i + 1)) {
+        if (shard.takes(position++, i)) {
+            out.emplace_back(space.at(i));
+        }
     }
     return out;
 }
@@ -17,7 +17,173 @@
 
 namespace perfnp {
 
-std::vector<CmdWithArgs> combine_command_lines(const Config& config);
+/*!
+ * All jobs given by the combinations of the parameter values.
+ *
+ * A job is built from its index only when it is needed, so that
+ * large parameter spaces do not have to be held in memory.
+ * The index is mixed-radix with a digit for every dimension (see
+ * axes()), the last dimension changes the fastest. A zip group is
+ * a single digit, so zipping two lists of n values gives n jobs.
+ *
+ * Constraints of the configuration leave gaps in the indices, so that
+ * an index always decodes to the same values. The gaps are skipped by
+ * next(), which assigns the dimensions one by one and checks every
+ * constraint as soon as its parameters are known, so a violated
+ * constraint skips all combinations of the remaining dimensions at once.
+ */
+class JobSpace {
+
+    //! Configuration with the command, arguments and parameters
+    const Config& m_config;
+
+    //! Number of all combinations, including the skipped ones
+    unsigned long long m_size;
+
+    //! Parameters which are not zipped to an earlier one (dimensions)
+    std::vector<std::size_t> m_axes;
+
+    //! Dimension of every parameter
+    std::vector<std::size_t> m_axis_of;
+
+    //! Parameters of every dimension
+    std::vector<std::vector<std::size_t>> m_members;
+
+    //! Constraints checked when the given dimension gets its value
+    std::vector<std::vector<const Constraint*>> m_checks;
+
+    //! Are all combinations jobs?
+    bool m_complete;
+
+    //! Values of the dimensions (digits) of the index
+    std::vector<std::size_t> digits_of(unsigned long long index) const;
+
+    //! Index given by the digits
+    unsigned long long index_of_digits(const std::vector<std::size_t>& digits) const;
+
+    //! Increments the digit at the level, carries to the lower levels
+    bool increment(std::vector<std::size_t>& digits, std::size_t& level) const;
+
+public:
+    /*!
+     * @throw std::runtime_error if the number of jobs overflows
+     */
+    explicit JobSpace(const Config& config);
+
+    //! Number of indices, i.e. one past the largest job index
+    unsigned long long size() const {
+        return m_size;
+    }
+
+    /*!
+     * The smallest job index which is not smaller than `from`.
+     *
+     * @return size() if there is no such job
+     */
+    unsigned long long next(unsigned long long from) const;
+
+    /*!
+     * Independent dimensions of the space, as indices of parameters.
+     *
+     * A zip group is a single dimension, given by its first parameter.
+     */
+    const std::vector<std::size_t>& axes() const {
+        return m_axes;
+    }
+
+    //! Number of values along the dimension
+    std::size_t axis_size(std::size_t axis) const;
+
+    /*!
+     * Index of the combination given by a value of every dimension.
+     *
+     * The index may still be excluded by a constraint, see contains().
+     */
+    unsigned long long index_of(const std::vector<std::size_t>& axis_values) const;
+
+    //! Is the index a job, not skipped by zip groups nor constraints?
+    bool contains(unsigned long long index) const {
+        return index < m_size && next(index) == index;
+    }
+
+    /*!
+     * Command line of the job with the given index.
+     *
+     * The parameters are substituted to the arguments, to the values
+     * of the environment variables and to the working directory.
+     *
+     * @throw std::out_of_range if the index is not smaller than size()
+     */
+    CmdWithArgs at(unsigned long long index) const;
+
+    /*!
+     * Hash of what the job indices mean.
+     *
+     * It covers the names and the values of all parameters in their
+     * order and the zip groups, but not the command. Runs with equal
+     * digests have jobs with equal parameter values under equal indices.
+     */
+    std::string digest() const;
+}; // JobSpace
+
+/*!
+ * Part of a sweep executed by one of several independent processes.
+ *
+ * The shards of a sweep are disjoint and together they cover all jobs.
+ * A strided shard takes every N-th job, so the shards have the same
+ * number of jobs. A hashed shard takes the jobs whose hashed index
+ * falls into it, so neighbouring jobs (e.g. the slow runs of one
+ * instance) are spread over all shards and a job stays in its shard
+ * even if other jobs are added or removed.
+ */
+struct Shard {
+
+    //! How are the jobs split?
+    enum class Policy { Strided, Hashed };
+
+    //! Index of this shard, from 0
+    unsigned index;
+
+    //! Number of all shards
+    unsigned count;
+
+    //! How are the jobs split?
+    Policy policy;
+
+    //! The whole sweep by default
+    Shard()
+    : index(0)
+    , count(1)
+    , policy(Policy::Strided)
+    {}
+
+    /*!
+     * Parses `i/N` or `i/N:hashed`, where `i` counts from 1.
+     *
+     * @throw std::runtime_error if the text is not a valid shard
+     */
+    static Shard parse(const std::string& text);
+
+    //! Is the sweep split at all?
+    bool enabled() const {
+        return count > 1;
+    }
+
+    //! Is the job, given by its position among all jobs, in this shard?
+    bool takes(unsigned long long position, unsigned long long job_index) const;
+
+    //! The shard as given on the command-line, e.g. "2/4"
+    std::string to_string() const;
+}; // Shard
+
+/*!
+ * Command lines of all jobs of the shard, ordered by the job index.
+ *
+ * Only the sampled jobs are returned if the configuration asks
+ * for a sample (see \ref sample_job_indices).
+ */
+std::vector<CmdWithArgs> combine_command_lines(const Config& config,
+    const Shard& shard = Shard());
 
 } // perfnp
 
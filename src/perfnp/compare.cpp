@@ -0,0 +1,163 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/compare.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace perfnp;
+
+namespace {
+
+    //! SplitMix64 generator, small and fast
+    std::uint64_t splitmix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    } // splitmix64
+
+
+
+    //! Arithmetic mean, 0 for no values
+    double mean_of(const std::vector<double>& values)
+    {
+        if (values.empty()) {
+            return 0.0;
+        }
+        double sum = 0.0;
+        for (double value : values) {
+            sum += value;
+        }
+        return sum / values.size();
+    } // mean_of
+
+
+
+    //! Wilcoxon signed-rank test with the normal approximation
+    void wilcoxon_signed_rank(const std::vector<double>& differences,
+        RunComparison& out)
+    {
+        // Zero differences are dropped (Wilcoxon's method)
+        std::vector<double> nonzero;
+        for (double d : differences) {
+            if (d != 0.0) {
+                nonzero.push_back(d);
+            }
+        }
+        std::sort(nonzero.begin(), nonzero.end(),
+            [](double a, double b) { return std::fabs(a) < std::fabs(b); });
+
+        const double n = static_cast<double>(nonzero.size());
+        double w_plus = 0.0;
+        double tie_correction = 0.0;
+
+        for (size_t i = 0; i < nonzero.size(); ) {
+            size_t j = i;
+            while (j < nonzero.size()
+                    && std::fabs(nonzero[j]) == std::fabs(nonzero[i])) {
+                ++j;
+            }
+
+            // Tied absolute values share the average rank
+            const double ties = static_cast<double>(j - i);
+            const double rank = (i + 1 + j) / 2.0;
+            for (size_t k = i; k < j; ++k) {
+                if (nonzero[k] > 0) {
+                    w_plus += rank;
+                }
+            }
+            tie_correction += ties * ties * ties - ties;
+            i = j;
+        }
+
+        const double mean = n * (n + 1) / 4;
+        const double variance = n * (n + 1) * (2 * n + 1) / 24
+            - tie_correction / 48;
+
+        out.wilcoxon_w = w_plus;
+        if (variance <= 0.0) {
+            out.wilcoxon_z = 0.0;
+            out.p_value = 1.0;
+            return;
+        }
+
+        // Continuity correction towards the mean
+        double deviation = w_plus - mean;
+        if (deviation > 0.5) {
+            deviation -= 0.5;
+        } else if (deviation < -0.5) {
+            deviation += 0.5;
+        } else {
+            deviation = 0.0;
+        }
+
+        out.wilcoxon_z = deviation / std::sqrt(variance);
+        out.p_value = std::erfc(std::fabs(out.wilcoxon_z) / std::sqrt(2.0));
+    } // wilcoxon_signed_rank
+
+} // anonymous namespace
+
+
+
+void RunComparator::add(const PairedInstance& instance)
+{
+    m_solved_a += instance.solved_a;
+    m_solved_b += instance.solved_b;
+
+    // Runtimes are at least 1s, unless there was no timeout
+    if (instance.runtime_a > 0 && instance.runtime_b > 0) {
+        m_log_speedups.push_back(std::log(
+            instance.runtime_a / instance.runtime_b));
+    }
+} // RunComparator::add
+
+
+
+RunComparison RunComparator::compare(double confidence,
+    unsigned resamples, std::uint64_t seed) const
+{
+    if (confidence <= 0.0 || confidence >= 1.0) {
+        throw std::runtime_error("Confidence level "
+            + std::to_string(confidence) + " is not in (0,1).");
+    }
+
+    RunComparison out;
+    out.paired = m_log_speedups.size();
+    out.solved_a = m_solved_a;
+    out.solved_b = m_solved_b;
+    out.speedup = std::exp(mean_of(m_log_speedups));
+    out.speedup_lower = out.speedup;
+    out.speedup_upper = out.speedup;
+
+    // Percentile bootstrap of the mean log-speedup
+    const size_t n = m_log_speedups.size();
+    if (n > 1 && resamples > 0) {
+        std::uint64_t state = seed;
+        std::vector<double> means(resamples);
+        for (unsigned r = 0; r < resamples; ++r) {
+            double sum = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                sum += m_log_speedups[splitmix64(state) % n];
+            }
+            means[r] = sum / n;
+        }
+
+        // Only two order statistics are needed, so select them
+        const double alpha = (1.0 - confidence) / 2;
+        auto lower = static_cast<size_t>(alpha * (resamples - 1));
+        auto upper = static_cast<size_t>((1.0 - alpha) * (resamples - 1) + 0.5);
+        std::nth_element(means.begin(), means.begin() + lower, means.end());
+        out.speedup_lower = std::exp(means[lower]);
+        std::nth_element(means.begin() + lower, means.begin() + upper, means.end());
+        out.speedup_upper = std::exp(means[upper]);
+    }
+
+    wilcoxon_signed_rank(m_log_speedups, out);
+    return out;
+} // RunComparator::compare
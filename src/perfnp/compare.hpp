@@ -0,0 +1,118 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_COMPARE_H_
+#define PERFNP_COMPARE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Results of one instance (i.e. job index) in two runs.
+ *
+ * If the instance was executed several times in a run,
+ * the runtimes are averaged. Failed jobs count as the timeout.
+ */
+struct PairedInstance {
+
+    //! Command line of the instance in the run A
+    std::string command;
+
+    //! Mean runtime in the run A, in seconds
+    double runtime_a;
+
+    //! Mean runtime in the run B, in seconds
+    double runtime_b;
+
+    //! Number of successful jobs in the run A
+    unsigned solved_a;
+
+    //! Number of successful jobs in the run B
+    unsigned solved_b;
+}; // PairedInstance
+
+
+
+/*!
+ * Statistical comparison of two runs on a common set of instances.
+ *
+ * Speedup is the ratio runtime_a / runtime_b, i.e. values
+ * above 1 mean that the run B is faster.
+ */
+struct RunComparison {
+
+    //! Number of instances present in both runs
+    std::size_t paired;
+
+    //! Number of successful jobs in the run A
+    std::size_t solved_a;
+
+    //! Number of successful jobs in the run B
+    std::size_t solved_b;
+
+    //! Geometric mean of the speedups
+    double speedup;
+
+    //! Lower bound of the bootstrap confidence interval of the speedup
+    double speedup_lower;
+
+    //! Upper bound of the bootstrap confidence interval of the speedup
+    double speedup_upper;
+
+    //! Wilcoxon signed-rank statistic (sum of ranks of speedups above 1)
+    double wilcoxon_w;
+
+    //! Normal approximation of the Wilcoxon statistic
+    double wilcoxon_z;
+
+    //! Two-sided p-value of the Wilcoxon signed-rank test
+    double p_value;
+}; // RunComparison
+
+
+
+/*!
+ * Accumulates paired instances and compares the two runs.
+ *
+ * Only the log-speedup of every instance is kept in memory,
+ * so the instances can be streamed from the database.
+ */
+class RunComparator {
+
+    //! Logarithm of the speedup of every instance
+    std::vector<double> m_log_speedups;
+
+    //! Number of successful jobs in the run A
+    std::size_t m_solved_a;
+
+    //! Number of successful jobs in the run B
+    std::size_t m_solved_b;
+
+public:
+    RunComparator()
+    : m_solved_a(0)
+    , m_solved_b(0)
+    {}
+
+    //! Adds the next paired instance
+    void add(const PairedInstance& instance);
+
+    /*!
+     * Compares the runs using all instances added so far.
+     *
+     * @param confidence confidence level of the interval, e.g. 0.95
+     * @param resamples number of bootstrap resamples
+     * @param seed seed of the random generator, for reproducibility
+     */
+    RunComparison compare(double confidence = 0.95,
+        unsigned resamples = 10000, std::uint64_t seed = 0) const;
+}; // RunComparator
+
+} // perfnp
+#endif // PERFNP_COMPARE_H_
@@ -4,195 +4,1090 @@
 // https://opensource.org/licenses/MIT
 
 #include "config.hpp"
+#include "perfnp/sources.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
+#include <utility>
 
 using namespace perfnp;
 using namespace std;
 
+namespace {
 
-unsigned Config::timeout() const
+    using nlohmann::json;
+
+    //! Error in the field at the given path of the configuration
+    std::runtime_error field_error(const std::string& path,
+        const std::string& problem)
+    {
+        return std::runtime_error("Configuration JSON's \""
+            + path + "\" field " + problem + ".");
+    } // field_error
+
+    //! Path of an item of an array
+    std::string item_path(const std::string& path, size_t index)
+    {
+        return path + "[" + std::to_string(index) + "]";
+    } // item_path
+
+    //! Member of an object, null if it is not present
+    const json* find_member(const json& object, const char* name)
+    {
+        auto it = object.find(name);
+        return it == object.end() ? nullptr : &*it;
+    } // find_member
+
+    //! Member, which must be an object if it is present
+    const json* find_object(const json& object, const char* name,
+        const std::string& path)
+    {
+        auto j_object = find_member(object, name);
+        if (j_object != nullptr && !j_object->is_object()) {
+            throw field_error(path, "is not an object");
+        }
+        return j_object;
+    } // find_object
+
+    //! String value of the field
+    std::string parse_string(const json& j_string, const std::string& path)
+    {
+        if (!j_string.is_string()) {
+            throw field_error(path, "is not a string, but "
+                + j_string.dump() + " was found instead");
+        }
+        return j_string.get<std::string>();
+    } // parse_string
+
+    //! Array of strings
+    std::vector<std::string> parse_strings(const json& j_array,
+        const std::string& path)
+    {
+        if (!j_array.is_array()) {
+            throw field_error(path, "is not an array");
+        }
+        std::vector<std::string> out;
+        out.reserve(j_array.size());
+        for (size_t i = 0; i < j_array.size(); ++i) {
+            out.push_back(parse_string(j_array[i], item_path(path, i)));
+        }
+        return out;
+    } // parse_strings
+
+    //! Positive integer with the default value if it is missing
+    unsigned parse_positive(const json* j_value, const std::string& path,
+        unsigned default_value)
+    {
+        if (j_value == nullptr) {
+            return default_value;
+        }
+        if (!j_value->is_number_unsigned() || j_value->get<unsigned>() == 0) {
+            throw field_error(path, "is not a positive integer");
+        }
+        return j_value->get<unsigned>();
+    } // parse_positive
+
+
+
+    //! Integers given by `[first, last]` or `[first, last, step]`
+    Parameter parse_range(std::string name, const json& j_range,
+        const std::string& path)
+    {
+        if (!j_range.is_array() || j_range.size() < 2 || j_range.size() > 3) {
+            throw field_error(path, "is not an array of 2 or 3 integers");
+        }
+        long long bounds[3] = { 0, 0, 1 };
+        for (size_t k = 0; k < j_range.size(); ++k) {
+            if (!j_range[k].is_number_integer()) {
+                throw field_error(item_path(path, k), "is not an integer");
+            }
+            bounds[k] = j_range[k].get<long long>();
+        }
+        if (bounds[2] == 0) {
+            throw field_error(item_path(path, 2), "must not be 0");
+        }
+        if ((bounds[2] > 0) ? bounds[0] > bounds[1] : bounds[0] < bounds[1]) {
+            throw field_error(path, "must have at least 1 value");
+        }
+        return Parameter::range(std::move(name), bounds[0], bounds[1], bounds[2]);
+    } // parse_range
+
+
+
+    std::vector<Parameter> parse_parameters(const json& j_parameters,
+        const std::shared_ptr<StringArena>& arena,
+        std::map<std::size_t, std::vector<StringArena::Id>>& streamed)
+    {
+        if (!j_parameters.is_array()) {
+            throw field_error("parameters", "is not an array");
+        }
+        if (j_parameters.empty()) {
+            throw field_error("parameters", "is an empty array");
+        }
+
+        std::vector<Parameter> v_parameters;
+        v_parameters.reserve(j_parameters.size());
+        for (size_t i = 0; i < j_parameters.size(); ++i) {
+            const auto& j_param = j_parameters[i];
+            const auto path = item_path("parameters", i);
+            if (!j_param.is_object()) {
+                throw field_error(path, "is not an object");
+            }
+
+            auto j_name = find_member(j_param, "name");
+            if (j_name == nullptr) {
+                throw field_error(path + ".name", "is missing");
+            }
+            auto s_name = parse_string(*j_name, path + ".name");
+            if (s_name.empty()) {
+                throw field_error(path + ".name", "is empty");
+            }
+
+            auto j_values = find_member(j_param, "values");
+            auto j_glob = find_member(j_param, "glob");
+            auto j_file = find_member(j_param, "file");
+            auto j_range = find_member(j_param, "range");
+            const int sources = (j_values != nullptr) + (j_glob != nullptr)
+                + (j_file != nullptr) + (j_range != nullptr);
+            if (sources != 1) {
+                throw field_error(path, "must have exactly one of \"values\","
+                    " \"glob\", \"file\" and \"range\" fields");
+            }
+
+            if (j_range != nullptr) {
+                v_parameters.push_back(parse_range(std::move(s_name),
+                    *j_range, path + ".range"));
+                continue;
+            }
+
+            std::vector<StringArena::Id> ids;
+            std::string values_path = path + ".values";
+            auto it_streamed = streamed.find(i);
+            if (it_streamed != streamed.end()) {
+                ids = std::move(it_streamed->second);
+            } else if (j_glob != nullptr) {
+                values_path = path + ".glob";
+                auto pattern = parse_string(*j_glob, values_path);
+                for (const auto& match : expand_glob(pattern)) {
+                    ids.push_back(arena->intern(match));
+                }
+            } else if (j_file != nullptr) {
+                values_path = path + ".file";
+                ids = read_manifest(parse_string(*j_file, values_path), *arena);
+            } else {
+                if (!j_values->is_array()) {
+                    throw field_error(values_path, "is not an array");
+                }
+                ids.reserve(j_values->size());
+                for (size_t v = 0; v < j_values->size(); ++v) {
+                    const auto& j_value = (*j_values)[v];
+                    if (!j_value.is_string()) {
+                        throw field_error(item_path(values_path, v),
+                            "is not a string, but " + j_value.dump()
+                            + " was found instead");
+                    }
+                    ids.push_back(arena->intern(
+                        j_value.get_ref<const std::string&>()));
+                }
+            }
+            if (ids.empty()) {
+                throw field_error(values_path,
+                    "must have at least 1 value");
+            }
+
+            v_parameters.emplace_back(std::move(s_name), arena, std::move(ids));
+        }
+        return v_parameters;
+    } // parse_parameters
+
+
+
+    std::vector<std::vector<std::size_t>> parse_zip(const json& j_zip,
+        const std::vector<Parameter>& parameters)
+    {
+        if (!j_zip.is_array()) {
+            throw field_error("zip", "is not an array");
+        }
+
+        std::vector<bool> zipped(parameters.size(), false);
+        std::vector<std::vector<std::size_t>> groups;
+        for (size_t g = 0; g < j_zip.size(); ++g) {
+            const auto path = item_path("zip", g);
+            auto names = parse_strings(j_zip[g], path);
+            if (names.size() < 2) {
+                throw field_error(path, "must name at least 2 parameters");
+            }
+
+            std::vector<std::size_t> group;
+            for (size_t n = 0; n < names.size(); ++n) {
+                auto it = std::find_if(parameters.begin(), parameters.end(),
+                    [&](const Parameter& p) { return p.name() == names[n]; });
+                if (it == parameters.end()) {
+                    throw field_error(item_path(path, n),
+                        "names an unknown parameter '" + names[n] + "'");
+                }
+                const auto index = static_cast<std::size_t>(it - parameters.begin());
+                if (zipped[index]) {
+                    throw field_error(item_path(path, n), "names the parameter '"
+                        + names[n] + "', which is already zipped");
+                }
+                if (it->size() != parameters[group.empty() ? index : group[0]].size()) {
+                    throw field_error(path, "has parameters with different"
+                        " numbers of values");
+                }
+                zipped[index] = true;
+                group.push_back(index);
+            }
+            std::sort(group.begin(), group.end());
+            groups.push_back(std::move(group));
+        }
+        return groups;
+    } // parse_zip
+
+
+
+    std::vector<Constraint> parse_constraints(const json& j_constraints,
+        const std::vector<Parameter>& parameters)
+    {
+        auto expressions = parse_strings(j_constraints, "constraints");
+        if (!expressions.empty() && parameters.empty()) {
+            throw field_error("constraints", "needs parameters");
+        }
+
+        std::vector<std::string> names;
+        for (const auto& parameter : parameters) {
+            names.push_back(parameter.name());
+        }
+
+        std::vector<Constraint> constraints;
+        for (size_t i = 0; i < expressions.size(); ++i) {
+            try {
+                constraints.emplace_back(std::move(expressions[i]), names);
+            } catch (const std::runtime_error& ex) {
+                std::string reason = ex.what();
+                if (!reason.empty() && reason.back() == '.') {
+                    reason.pop_back();
+                }
+                throw field_error(item_path("constraints", i),
+                    "is invalid: " + reason);
+            }
+        }
+        return constraints;
+    } // parse_constraints
+
+
+
+    std::vector<MetricPattern> parse_metrics(const json& j_metrics)
+    {
+        if (!j_metrics.is_array()) {
+            throw field_error("metrics", "is not an array");
+        }
+
+        std::vector<MetricPattern> v_metrics;
+        for (size_t i = 0; i < j_metrics.size(); ++i) {
+            const auto& j_metric = j_metrics[i];
+            const auto path = item_path("metrics", i);
+            if (!j_metric.is_object()) {
+                throw field_error(path, "is not an object");
+            }
+
+            auto j_name = find_member(j_metric, "name");
+            if (j_name == nullptr) {
+                throw field_error(path + ".name", "is missing");
+            }
+            auto name = parse_string(*j_name, path + ".name");
+
+            auto j_regex = find_member(j_metric, "regex");
+            auto j_prefix = find_member(j_metric, "prefix");
+            if ((j_regex == nullptr) == (j_prefix == nullptr)) {
+                throw field_error(path, "must have exactly one"
+                    " of \"regex\" and \"prefix\" fields");
+            }
+
+            auto kind = j_regex != nullptr
+                ? MetricPattern::Kind::Regex
+                : MetricPattern::Kind::Prefix;
+            auto pattern = j_regex != nullptr
+                ? parse_string(*j_regex, path + ".regex")
+                : parse_string(*j_prefix, path + ".prefix");
+
+            auto incumbent = MetricPattern::Incumbent::No;
+            auto j_incumbent = find_member(j_metric, "incumbent");
+            if (j_incumbent != nullptr) {
+                if (*j_incumbent == "minimize") {
+                    incumbent = MetricPattern::Incumbent::Minimize;
+                } else if (*j_incumbent == "maximize") {
+                    incumbent = MetricPattern::Incumbent::Maximize;
+                } else {
+                    throw field_error(path + ".incumbent", "must be"
+                        " either \"minimize\" or \"maximize\"");
+                }
+            }
+
+            v_metrics.emplace_back(std::move(name), kind,
+                std::move(pattern), incumbent);
+        }
+
+        auto incumbents = std::count_if(v_metrics.begin(), v_metrics.end(),
+            [](const MetricPattern& metric) {
+                return metric.incumbent() != MetricPattern::Incumbent::No;
+            });
+        if (incumbents > 1) {
+            throw field_error("metrics", "has more than one incumbent");
+        }
+
+        return v_metrics;
+    } // parse_metrics
+
+
+
+    //! File name in `logging.<section>.<format>`, empty if not configured
+    std::string parse_logging_file(const json* j_logging,
+        const char* section, const char* format, bool& present)
+    {
+        present = false;
+        if (j_logging == nullptr) {
+            return "";
+        }
+
+        const auto path = std::string("logging.") + section;
+        auto j_section = find_object(*j_logging, section, path);
+        if (j_section == nullptr) {
+            return "";
+        }
+
+        auto j_file = find_member(*j_section, format);
+        if (j_file == nullptr) {
+            return "";
+        }
+        present = true;
+        return parse_string(*j_file, path + "." + format);
+    } // parse_logging_file
+
+
+
+    GateThresholds parse_gate(const json& j_gate)
+    {
+        GateThresholds thresholds;
+
+        std::pair<const char*, double*> limits[] = {
+            { "median_slowdown", &thresholds.median_slowdown },
+            { "solved_drop", &thresholds.solved_drop },
+            { "par_k_increase", &thresholds.par_k_increase },
+        };
+
+        for (const auto& limit : limits) {
+            auto j_limit = find_member(j_gate, limit.first);
+            if (j_limit == nullptr) {
+                continue;
+            }
+            if (!j_limit->is_number() || j_limit->get<double>() < 0) {
+                throw field_error(std::string("gate.") + limit.first,
+                    "is not a non-negative number");
+            }
+            *limit.second = j_limit->get<double>();
+        }
+
+        return thresholds;
+    } // parse_gate
+
+
+
+    CalibrationSettings parse_calibration(const json& j_calibration)
+    {
+        CalibrationSettings settings;
+        settings.enabled = true;
+
+        auto j_repetitions = find_member(j_calibration, "repetitions");
+        if (j_repetitions != nullptr) {
+            if (!j_repetitions->is_number_unsigned() || j_repetitions->get<unsigned>() < 2) {
+                throw field_error("calibration.repetitions",
+                    "is not an integer greater than 1");
+            }
+            settings.repetitions = j_repetitions->get<unsigned>();
+        }
+
+        auto j_max_cv = find_member(j_calibration, "max_cv");
+        if (j_max_cv != nullptr) {
+            if (!j_max_cv->is_number() || j_max_cv->get<double>() <= 0) {
+                throw field_error("calibration.max_cv", "is not a positive number");
+            }
+            settings.max_cv = j_max_cv->get<double>();
+        }
+
+        auto j_on_noise = find_member(j_calibration, "on_noise");
+        if (j_on_noise != nullptr) {
+            if (*j_on_noise == "refuse") {
+                settings.refuse = true;
+            } else if (*j_on_noise != "warn") {
+                throw field_error("calibration.on_noise",
+                    "must be \"warn\" or \"refuse\"");
+            }
+        }
+
+        return settings;
+    } // parse_calibration
+
+
+
+    SampleSettings parse_sample(const json& j_sample)
+    {
+        SampleSettings settings;
+
+        auto j_design = find_member(j_sample, "design");
+        if (j_design == nullptr) {
+            throw field_error("sample.design", "is missing");
+        }
+        auto design = parse_string(*j_design, "sample.design");
+        if (design == "random") {
+            settings.design = SampleSettings::Design::Random;
+        } else if (design == "latin_hypercube") {
+            settings.design = SampleSettings::Design::LatinHypercube;
+        } else if (design == "sobol") {
+            settings.design = SampleSettings::Design::Sobol;
+        } else {
+            throw field_error("sample.design", "must be \"random\","
+                " \"latin_hypercube\" or \"sobol\"");
+        }
+
+        auto j_size = find_member(j_sample, "size");
+        if (j_size == nullptr) {
+            throw field_error("sample.size", "is missing");
+        }
+        settings.size = parse_positive(j_size, "sample.size", 0);
+
+        auto j_seed = find_member(j_sample, "seed");
+        if (j_seed != nullptr) {
+            if (!j_seed->is_number_unsigned()) {
+                throw field_error("sample.seed", "is not a non-negative integer");
+            }
+            settings.seed = j_seed->get<std::uint64_t>();
+        }
+
+        return settings;
+    } // parse_sample
+
+
+
+    PageCacheSettings parse_page_cache(const json& j_page_cache)
+    {
+        PageCacheSettings settings;
+
+        auto j_mode = find_member(j_page_cache, "mode");
+        if (j_mode == nullptr) {
+            throw field_error("page_cache.mode", "is missing");
+        }
+        auto mode = parse_string(*j_mode, "page_cache.mode");
+        if (mode == "warm") {
+            settings.mode = PageCacheSettings::Mode::Warm;
+        } else if (mode == "pin") {
+            settings.mode = PageCacheSettings::Mode::Pin;
+        } else if (mode == "cold") {
+            settings.mode = PageCacheSettings::Mode::Cold;
+        } else if (mode != "off") {
+            throw field_error("page_cache.mode",
+                "must be \"off\", \"warm\", \"pin\" or \"cold\"");
+        }
+
+        settings.ahead = parse_positive(find_member(j_page_cache, "ahead"),
+            "page_cache.ahead", settings.ahead);
+        return settings;
+    } // parse_page_cache
+
+
+
+    ScratchSettings parse_scratch(const json& j_scratch)
+    {
+        ScratchSettings settings;
+
+        auto j_directory = find_member(j_scratch, "directory");
+        if (j_directory == nullptr) {
+            throw field_error("scratch.directory", "is missing");
+        }
+        settings.directory = parse_string(*j_directory, "scratch.directory");
+        if (settings.directory.empty()) {
+            throw field_error("scratch.directory", "is empty");
+        }
+
+        auto j_inputs = find_member(j_scratch, "inputs");
+        if (j_inputs != nullptr) {
+            auto inputs = parse_string(*j_inputs, "scratch.inputs");
+            if (inputs == "none") {
+                settings.inputs = ScratchSettings::Inputs::None;
+            } else if (inputs == "copy") {
+                settings.inputs = ScratchSettings::Inputs::Copy;
+            } else if (inputs != "link") {
+                throw field_error("scratch.inputs",
+                    "must be \"link\", \"copy\" or \"none\"");
+            }
+        }
+
+        auto j_archive = find_member(j_scratch, "archive");
+        if (j_archive != nullptr) {
+            settings.archive = parse_string(*j_archive, "scratch.archive");
+        }
+        return settings;
+    } // parse_scratch
+
+
+
+    MonitorSettings parse_monitor(const json& j_monitor)
+    {
+        MonitorSettings settings;
+
+        auto j_socket = find_member(j_monitor, "socket");
+        if (j_socket != nullptr) {
+            settings.socket = parse_string(*j_socket, "monitor.socket");
+            if (settings.socket.empty()) {
+                throw field_error("monitor.socket", "is empty");
+            }
+        }
+
+        auto j_port = find_member(j_monitor, "port");
+        if (j_port != nullptr) {
+            if (!j_port->is_number_unsigned() || j_port->get<unsigned>() == 0
+                    || j_port->get<unsigned>() > 65535) {
+                throw field_error("monitor.port", "is not a port number");
+            }
+            settings.port = j_port->get<unsigned>();
+        }
+
+        if (settings.socket.empty() == (settings.port == 0)) {
+            throw field_error("monitor",
+                "must have exactly one of \"socket\" and \"port\" fields");
+        }
+        return settings;
+    } // parse_monitor
+
+} // anonymous namespace
+
+
+
+Parameter::Parameter(std::string name, const std::vector<std::string>& values)
+: m_name(std::move(name))
 {
-    if (m_json.find("timeout") == m_json.end()) {
-        throw std::runtime_error("Configuration JSON"
-            " does not have the \"timeout\" field.");
+    auto arena = std::make_shared<StringArena>();
+    m_values.reserve(values.size());
+    for (const auto& value : values) {
+        m_values.push_back(arena->intern(value));
     }
+    m_arena = std::move(arena);
+}
+
 
-    if (!m_json.at("timeout").is_number()) {
-        throw std::runtime_error("Configuration JSON's"
-            " \"timeout\" field is not a number.");
+
+Parameter Parameter::range(std::string name, long long first,
+    long long last, long long step)
+{
+    if (step == 0 || (step > 0 && first > last) || (step < 0 && first < last)) {
+        throw std::runtime_error("Range of the parameter '" + name
+            + "' from " + std::to_string(first) + " to " + std::to_string(last)
+            + " by " + std::to_string(step) + " is empty or endless.");
     }
 
-    return m_json.at("timeout").get<unsigned>();
+    Parameter out;
+    out.m_name = std::move(name);
+    out.m_first = first;
+    out.m_step = step;
+    // Computed in unsigned arithmetic, which cannot overflow here
+    const unsigned long long distance = step > 0
+        ? static_cast<unsigned long long>(last) - static_cast<unsigned long long>(first)
+        : static_cast<unsigned long long>(first) - static_cast<unsigned long long>(last);
+    const unsigned long long magnitude = step > 0
+        ? static_cast<unsigned long long>(step)
+        : 0ull - static_cast<unsigned long long>(step);
+    out.m_count = static_cast<std::size_t>(distance / magnitude + 1);
+    return out;
 }
 
 
 
-std::string Config::command() const {
-    if (m_json.find("command") == m_json.end()) {
-        throw std::runtime_error("Configuration JSON"
-            " does not have the \"command\" field.");
+std::vector<std::string> Parameter::values() const
+{
+    std::vector<std::string> out;
+    out.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        out.push_back(value(i));
     }
+    return out;
+}
+
 
-    if (!m_json.at("command").is_string()) {
-        throw std::runtime_error("Configuration JSON's"
-            " \"command\" field is not a string.");
+
+bool Parameter::operator==(const Parameter& rhs) const
+{
+    if (m_name != rhs.m_name || size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < size(); ++i) {
+        if (value(i) != rhs.value(i)) {
+            return false;
+        }
     }
+    return true;
+}
+
+
 
-    return m_json.at("command").get<std::string>();
+Config::Config(const nlohmann::json& json)
+: m_json(json)
+, m_streamed(false)
+{
+    StreamedValues none;
+    validate(std::make_shared<StringArena>(), none);
 }
 
 
 
-Arguments Config::arguments() const {
-    if (m_json.find("arguments") == m_json.end()) {
-        throw std::runtime_error("Configuration JSON"
-            " does not have the \"arguments\" field.");
+Config::Config(nlohmann::json&& json)
+: m_json(std::move(json))
+, m_streamed(false)
+{
+    StreamedValues none;
+    validate(std::make_shared<StringArena>(), none);
+}
+
+
+
+Config::Config(nlohmann::json&& json, const std::shared_ptr<StringArena>& arena,
+    StreamedValues streamed)
+: m_json(std::move(json))
+, m_streamed(!streamed.empty())
+{
+    validate(arena, streamed);
+}
+
+
+
+void Config::validate(const std::shared_ptr<StringArena>& arena,
+    StreamedValues& streamed)
+{
+    if (!m_json.is_object()) {
+        throw std::runtime_error("Configuration JSON is not an object.");
+    }
+
+    auto j_timeout = find_member(m_json, "timeout");
+    m_has_timeout = j_timeout != nullptr;
+    m_timeout = 0;
+    if (m_has_timeout) {
+        if (!j_timeout->is_number()) {
+            throw field_error("timeout", "is not a number");
+        }
+        m_timeout = j_timeout->get<unsigned>();
+    }
+
+    auto j_command = find_member(m_json, "command");
+    m_has_command = j_command != nullptr;
+    if (m_has_command) {
+        m_command = parse_string(*j_command, "command");
+    }
+
+    auto j_arguments = find_member(m_json, "arguments");
+    m_has_arguments = j_arguments != nullptr;
+    if (m_has_arguments) {
+        m_arguments = Arguments(parse_strings(*j_arguments, "arguments"));
+    }
+
+    auto j_environment = find_object(m_json, "environment", "environment");
+    if (j_environment != nullptr) {
+        for (auto variable = j_environment->begin(); variable != j_environment->end(); ++variable) {
+            const auto path = "environment." + variable.key();
+            if (variable.key().empty() || variable.key().find('=') != std::string::npos) {
+                throw field_error(path, "is not a name of a variable");
+            }
+            m_environment.emplace_back(variable.key(), parse_string(variable.value(), path));
+        }
     }
 
-    const auto& j_arguments = m_json.at("arguments");
+    auto j_working_directory = find_member(m_json, "working_directory");
+    if (j_working_directory != nullptr) {
+        m_working_directory = parse_string(*j_working_directory, "working_directory");
+    }
+
+    auto j_parameters = find_member(m_json, "parameters");
+    if (j_parameters != nullptr) {
+        m_parameters = parse_parameters(*j_parameters, arena, streamed);
+    }
+
+    auto j_zip = find_member(m_json, "zip");
+    if (j_zip != nullptr) {
+        m_zip_groups = parse_zip(*j_zip, m_parameters);
+    }
+
+    auto j_constraints = find_member(m_json, "constraints");
+    if (j_constraints != nullptr) {
+        m_constraints = parse_constraints(*j_constraints, m_parameters);
+    }
+
+    auto j_sample = find_object(m_json, "sample", "sample");
+    if (j_sample != nullptr) {
+        m_sample = parse_sample(*j_sample);
+    }
 
-    if (!j_arguments.is_array()) {
-        throw std::runtime_error("Configuration JSON's"
-            " \"arguments\" field is not an array.");
+    auto j_metrics = find_member(m_json, "metrics");
+    if (j_metrics != nullptr) {
+        m_metrics = parse_metrics(*j_metrics);
     }
 
-    std::vector<std::string> v_arguments;
+    bool present = false;
+    auto j_logging = find_object(m_json, "logging", "logging");
+    m_job_csv_file = parse_logging_file(j_logging, "job", "csv", m_has_job_csv_file);
+    m_cactus_csv_file = parse_logging_file(j_logging, "cactus", "csv", present);
+    m_trace_file = parse_logging_file(j_logging, "trace", "json", present);
 
-    for (auto index = 0; index < j_arguments.size(); index++) {
-        const auto& j_item = j_arguments.at(index);
+    m_par_k = 2;
+    auto j_statistics = find_object(m_json, "statistics", "statistics");
+    if (j_statistics != nullptr) {
+        m_par_k = parse_positive(find_member(*j_statistics, "par_k"),
+            "statistics.par_k", 2);
 
-        if (!j_item.is_string()) {
-        throw std::runtime_error(std::string("Configuration JSON's"
-            " \"arguments\" array must contain strings, but '")
-            + j_item.dump() + "' was found instead.");
+        auto j_group_by = find_member(*j_statistics, "group_by");
+        if (j_group_by != nullptr) {
+            m_group_by = parse_strings(*j_group_by, "statistics.group_by");
+        }
+
+        auto j_instance = find_member(*j_statistics, "instance");
+        if (j_instance != nullptr) {
+            m_instance = parse_strings(*j_instance, "statistics.instance");
+        }
+    }
+
+    auto j_gate = find_object(m_json, "gate", "gate");
+    if (j_gate != nullptr) {
+        m_gate_thresholds = parse_gate(*j_gate);
+    }
+
+    m_workers = parse_positive(find_member(m_json, "workers"), "workers", 1);
+
+    m_on_interrupt = InterruptPolicy::Kill;
+    auto j_on_interrupt = find_member(m_json, "on_interrupt");
+    if (j_on_interrupt != nullptr) {
+        if (*j_on_interrupt == "finish") {
+            m_on_interrupt = InterruptPolicy::Finish;
+        } else if (*j_on_interrupt != "kill") {
+            throw field_error("on_interrupt", "must be \"kill\" or \"finish\"");
+        }
+    }
+
+    m_cache = CachePolicy::Never;
+    auto j_cache = find_member(m_json, "cache");
+    if (j_cache != nullptr) {
+        if (*j_cache == "reuse") {
+            m_cache = CachePolicy::Reuse;
+        } else if (*j_cache == "reuse_same_host") {
+            m_cache = CachePolicy::ReuseSameHost;
+        } else if (*j_cache != "never") {
+            throw field_error("cache",
+                "must be \"never\", \"reuse\" or \"reuse_same_host\"");
         }
-        v_arguments.push_back(j_item.get<std::string>());
     }
 
-    return Arguments(v_arguments);
+    auto j_calibration = find_object(m_json, "calibration", "calibration");
+    if (j_calibration != nullptr) {
+        m_calibration = parse_calibration(*j_calibration);
+    }
+
+    auto j_page_cache = find_object(m_json, "page_cache", "page_cache");
+    if (j_page_cache != nullptr) {
+        m_page_cache = parse_page_cache(*j_page_cache);
+    }
+
+    auto j_scratch = find_object(m_json, "scratch", "scratch");
+    if (j_scratch != nullptr) {
+        m_scratch = parse_scratch(*j_scratch);
+    }
+
+    auto j_monitor = find_object(m_json, "monitor", "monitor");
+    if (j_monitor != nullptr) {
+        m_monitor = parse_monitor(*j_monitor);
+    }
 }
 
 
 
-std::vector<Parameter> Config::parameters() const {
+unsigned Config::timeout() const
+{
+    if (!m_has_timeout) {
+        throw std::runtime_error("Configuration JSON"
+            " does not have the \"timeout\" field.");
+    }
+    return m_timeout;
+}
+
+
 
-    if (m_json.find("parameters") == m_json.end()) {
-        return {};
+const std::string& Config::command() const
+{
+    if (!m_has_command) {
+        throw std::runtime_error("Configuration JSON"
+            " does not have the \"command\" field.");
     }
+    return m_command;
+}
+
 
-    if (!m_json.at("parameters").is_array()) {
-        throw std::runtime_error("Configuration JSON's"
-            " \"parameters\" field is not an array.");
+
+const Arguments& Config::arguments() const
+{
+    if (!m_has_arguments) {
+        throw std::runtime_error("Configuration JSON"
+            " does not have the \"arguments\" field.");
     }
+    return m_arguments;
+}
+
 
-    if (m_json.at("parameters").empty()) {
-        throw std::runtime_error("Configuration JSON's"
-            " \"parameters\" array is empty.");
+
+Optional<std::string> Config::logging_job_csv_file() const
+{
+    if (!m_has_job_csv_file) {
+        return Optional<std::string>::empty();
     }
+    return Optional<std::string>::make(std::string(m_job_csv_file));
+}
+
+
+
+namespace {
+
+    /*!
+     * SAX handler, which builds the JSON tree of a configuration
+     * except the values of parameters, which are interned.
+     *
+     * An empty array is left in the tree instead of the values.
+     * It follows nlohmann::detail::json_sax_dom_parser otherwise.
+     */
+    class ConfigSaxHandler {
 
-    std::vector<Parameter> retval;
+        //! The tree being built
+        json& m_root;
 
-    std::vector<Parameter> v_parameters;
-    for (const auto& j_param : m_json.at("parameters")) {
+        //! Arrays and objects being built
+        std::vector<json*> m_stack;
 
-        // Name
+        //! Place for the next value of the innermost object
+        json* m_object_element;
 
-        if (j_param.find("name") == j_param.end()) {
-            throw std::runtime_error("Configuration JSON's"
-                " \"parameters\"[] has not an \"name\" field.");
+        //! The root "parameters" array, if it is being built
+        json* m_parameters;
+
+        //! Last key of the innermost object
+        std::string m_key;
+
+        //! Storage of the values
+        StringArena& m_arena;
+
+        //! Values of parameters, indexed by the parameter
+        std::map<std::size_t, std::vector<StringArena::Id>>& m_streamed;
+
+        //! Values being streamed, null outside of a values array
+        std::vector<StringArena::Id>* m_values;
+
+        //! Index of the parameter, whose values are streamed
+        std::size_t m_parameter;
+
+        //! Only strings may appear among the values
+        void check_not_streaming(const std::string& found)
+        {
+            if (m_values != nullptr) {
+                throw field_error(item_path(item_path("parameters", m_parameter)
+                    + ".values", m_values->size()), "is not a string, but "
+                    + found + " was found instead");
+            }
         }
 
-        const auto& j_name = j_param.at("name");
+        //! Adds a scalar, array or object to the tree
+        json* add(json&& value)
+        {
+            if (m_stack.empty()) {
+                m_root = std::move(value);
+                return &m_root;
+            }
+            if (m_stack.back()->is_array()) {
+                m_stack.back()->push_back(std::move(value));
+                return &m_stack.back()->back();
+            }
+            *m_object_element = std::move(value);
+            return m_object_element;
+        }
+
+    public:
+        ConfigSaxHandler(json& root, StringArena& arena,
+            std::map<std::size_t, std::vector<StringArena::Id>>& streamed)
+        : m_root(root)
+        , m_object_element(nullptr)
+        , m_parameters(nullptr)
+        , m_arena(arena)
+        , m_streamed(streamed)
+        , m_values(nullptr)
+        , m_parameter(0)
+        {}
+
+        bool null() {
+            check_not_streaming("null");
+            add(json());
+            return true;
+        }
+
+        bool boolean(bool value) {
+            check_not_streaming(value ? "true" : "false");
+            add(json(value));
+            return true;
+        }
+
+        bool number_integer(json::number_integer_t value) {
+            check_not_streaming(std::to_string(value));
+            add(json(value));
+            return true;
+        }
+
+        bool number_unsigned(json::number_unsigned_t value) {
+            check_not_streaming(std::to_string(value));
+            add(json(value));
+            return true;
+        }
 
-        if (!j_name.is_string()) {
-            throw std::runtime_error("Configuration JSON's"
-                " \"parameters\"[].\"name\" is not a string.");
+        bool number_float(json::number_float_t value, const std::string& text) {
+            check_not_streaming(text);
+            add(json(value));
+            return true;
         }
 
-        std::string s_name = j_name.get<std::string>();
+        bool string(std::string& value) {
+            if (m_values != nullptr) {
+                m_values->push_back(m_arena.intern(value));
+            } else {
+                add(json(std::move(value)));
+            }
+            return true;
+        }
 
-        if (s_name.empty()) {
-            throw std::runtime_error("One parameter's "
-                "name in the configuration JSON is empty.");
+        template<typename Binary>
+        bool binary(Binary&) {
+            throw std::runtime_error("Configuration JSON contains binary data.");
         }
 
-        if (j_param.find("values") == j_param.end()) {
-            throw std::runtime_error("Configuration JSON's"
-                " \"parameters\"[] has not the \"values\" field.");
+        bool start_object(std::size_t) {
+            check_not_streaming("an object");
+            m_stack.push_back(add(json(json::value_t::object)));
+            return true;
         }
 
-        const auto& j_values = j_param.at("values");
+        bool key(std::string& name) {
+            m_key = name;
+            m_object_element = &(*m_stack.back())[name];
+            return true;
+        }
 
-        if (!j_values.is_array()) {
-            throw std::runtime_error("Configuration JSON's"
-                " \"parameters\"[].\"values\" is not an array.");
+        bool end_object() {
+            m_stack.pop_back();
+            return true;
         }
 
-        std::vector<std::string> s_values;
-        for (const auto& j_value : j_values) {
-            if (!j_value.is_string()) {
-                throw std::runtime_error(std::string(
-                    "Parameters in the configuration JSON take"
-                    " string values, but variable '") + s_name
-                    + "' got '" + j_value.dump() + "' instead.");
+        bool start_array(std::size_t) {
+            check_not_streaming("an array");
+
+            // Stream "values" of objects in the root "parameters" array
+            if (m_parameters != nullptr && m_stack.size() == 3
+                    && m_stack[1] == m_parameters && m_stack[2]->is_object()
+                    && m_key == "values") {
+                add(json(json::value_t::array));
+                m_parameter = m_parameters->size() - 1;
+                m_values = &m_streamed[m_parameter];
+                m_values->clear();
+                return true;
             }
-            s_values.push_back(j_value.get<std::string>());
+
+            json* array = add(json(json::value_t::array));
+            if (m_stack.size() == 1 && m_root.is_object() && m_key == "parameters") {
+                m_parameters = array;
+            }
+            m_stack.push_back(array);
+            return true;
         }
 
-        if (s_values.empty()) {
-            throw std::runtime_error("Parameters in the"
-                " configuration JSON must have at least 1 value.");
+        bool end_array() {
+            if (m_values != nullptr) {
+                m_values = nullptr;
+            } else {
+                m_stack.pop_back();
+            }
+            return true;
         }
 
-        v_parameters.push_back(Parameter(j_name, s_values));
-    }
+        template<typename Exception>
+        bool parse_error(std::size_t, const std::string&, const Exception& ex) {
+            throw std::runtime_error(ex.what());
+        }
+    }; // ConfigSaxHandler
 
-    return v_parameters;
-}
 
 
+    //! Writes the JSON with the values of the parameters
+    void write_streamed(std::ostream& os, const json& root,
+        const std::vector<Parameter>& parameters)
+    {
+        os << '{';
+        bool first = true;
+        for (auto it = root.begin(); it != root.end(); ++it) {
+            os << (first ? "" : ",") << json(it.key()) << ':';
+            first = false;
+            if (it.key() != "parameters") {
+                os << it.value();
+                continue;
+            }
 
-Optional<std::string> Config::logging_job_csv_file() const
-{
-    auto j_logging = m_json.find("logging");
-    if (j_logging == m_json.end()) {
-        return Optional<std::string>::empty();
-    }
-    if (!j_logging->is_object()) {
-        throw std::runtime_error("The 'logging' field in the"
-                        " configuration json is not an object.");
-    }
+            os << '[';
+            for (size_t i = 0; i < it.value().size(); ++i) {
+                const auto& j_param = it.value()[i];
+                os << (i == 0 ? "" : ",") << '{';
+                bool first_member = true;
+                for (auto member = j_param.begin(); member != j_param.end(); ++member) {
+                    os << (first_member ? "" : ",") << json(member.key()) << ':';
+                    first_member = false;
+                    if (member.key() != "values") {
+                        os << member.value();
+                        continue;
+                    }
+                    os << '[';
+                    for (size_t v = 0; v < parameters[i].size(); ++v) {
+                        os << (v == 0 ? "" : ",") << json(parameters[i].value(v));
+                    }
+                    os << ']';
+                }
+                os << '}';
+            }
+            os << ']';
+        }
+        os << '}';
+    } // write_streamed
 
-    auto j_job = j_logging->find("job");
-    if (j_job == j_logging->end()) {
-        return Optional<std::string>::empty();
-    }
-    if (!j_job->is_object()) {
-        throw std::runtime_error("The 'logging.job' field in the"
-                        " configuration json is not an object.");
-    }
+} // anonymous namespace
 
-    auto j_csv = j_job->find("csv");
-    if (j_csv == j_job->end()) {
-        return Optional<std::string>::empty();
-    }
 
-    if (!j_csv->is_string()) {
-        throw std::runtime_error("The 'logging.job.csv' field in the"
-                        " configuration json is not a string.");
-    }
 
-    return Optional<std::string>::make(j_csv->get<std::string>());
+Config Config::parse(std::istream& input)
+{
+    json root;
+    auto arena = std::make_shared<StringArena>();
+    StreamedValues streamed;
+    ConfigSaxHandler handler(root, *arena, streamed);
+    json::sax_parse(input, &handler);
+    return Config(std::move(root), arena, std::move(streamed));
 }
 
 
 
 std::ostream& perfnp::operator<<(std::ostream& os, const Config& cfg)
 {
+    if (cfg.m_streamed) {
+        write_streamed(os, cfg.m_json, cfg.m_parameters);
+        return os;
+    }
     return os << cfg.m_json;
 }
 
@@ -6,51 +6,111 @@
 #ifndef PERFNP_CONFIG_H_
 #define PERFNP_CONFIG_H_
 
+#include "cache.hpp"
+#include "calibration.hpp"
+#include "constraint.hpp"
+#include "gate.hpp"
+#include "interrupt.hpp"
+#include "metrics.hpp"
+#include "monitor.hpp"
 #include "option.hpp"
+#include "sample.hpp"
+#include "staging.hpp"
+#include "string_arena.hpp"
 
 #include <nlohmann/json.hpp>
 
+#include <iosfwd>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace perfnp {
 
 /*!
  * Parameter is a variable with several values it can take.
+ *
+ * The values are interned in a string arena, which may be shared
+ * by all parameters of a configuration. Values of globs and files
+ * are read when the configuration is loaded and the arena holds all
+ * of them until it is destroyed. Integer ranges are not stored at
+ * all, their values are computed when needed.
  */
 class Parameter {
 
     //! Name of the variable
     std::string m_name;
 
-    //! Values the variable can take
-    std::vector<std::string> m_values;
+    //! Storage of the values, null for a range
+    std::shared_ptr<const StringArena> m_arena;
+
+    //! Values the variable can take, interned in the arena
+    std::vector<StringArena::Id> m_values;
+
+    //! The first value of a range
+    long long m_first;
+
+    //! Difference of two consecutive values of a range
+    long long m_step;
+
+    //! Number of values of a range
+    std::size_t m_count;
 
 public:
     //! Default arguments leaves all fields empty
-    Parameter() = default;
+    Parameter()
+    : m_first(0)
+    , m_step(1)
+    , m_count(0)
+    {}
 
-    //! Initialize all fields by the given values
-    explicit Parameter(std::string name, std::vector<std::string> values)
-    : m_name(name)
-    , m_values(values)
+    //! Initialize all fields by the given values, with an arena of its own
+    explicit Parameter(std::string name, const std::vector<std::string>& values);
+
+    //! Initialize all fields by values interned in the arena
+    Parameter(std::string name, std::shared_ptr<const StringArena> arena,
+        std::vector<StringArena::Id> values)
+    : m_name(std::move(name))
+    , m_arena(std::move(arena))
+    , m_values(std::move(values))
+    , m_first(0)
+    , m_step(1)
+    , m_count(0)
     {}
 
+    /*!
+     * Integers from `first` to `last` (inclusive) by `step`.
+     *
+     * @throw std::runtime_error if the step is 0 or goes away from `last`
+     */
+    static Parameter range(std::string name, long long first,
+        long long last, long long step = 1);
+
     //! Name of the variable
     const std::string& name() const {
         return m_name;
     }
 
-    //! Values the variable can take
-    const std::vector<std::string>& values() const {
-        return m_values;
+    //! Number of values the variable can take
+    std::size_t size() const {
+        return m_arena ? m_values.size() : m_count;
     }
 
-    //! Equality operator compares all fields
-    bool operator==(const Parameter& rhs) const {
-        return m_name == rhs.m_name
-            && m_values == rhs.m_values;
+    //! The i-th value
+    std::string value(std::size_t i) const {
+        if (m_arena) {
+            return m_arena->str(m_values[i]);
+        }
+        return std::to_string(m_first + static_cast<long long>(i) * m_step);
     }
+
+    //! Copy of all values the variable can take
+    std::vector<std::string> values() const;
+
+    //! Equality operator compares the names and the values
+    bool operator==(const Parameter& rhs) const;
 };
 
 
@@ -87,39 +147,265 @@ public:
 
 /*!
  * Configuration file contains all the program input
+ *
+ * The whole JSON is validated once by the constructor into typed
+ * fields, so the accessors do no JSON work and the errors name the
+ * offending path (e.g. `parameters[2].values[7]`). The required fields
+ * (timeout, command and arguments) may be missing in a configuration
+ * used only partially, their accessors throw in that case.
  */
 class Config {
 
-    //! Parsed JSON
+    //! Parsed JSON, kept for saving the configuration
     nlohmann::json m_json;
 
+    //! Is the timeout present?
+    bool m_has_timeout;
+
+    //! Time-limit to execute the binary, in seconds
+    unsigned m_timeout;
+
+    //! Is the command present?
+    bool m_has_command;
+
+    //! Absolute or relative path to the executed binary
+    std::string m_command;
+
+    //! Are the arguments present?
+    bool m_has_arguments;
+
+    //! List of arguments given to the binary
+    Arguments m_arguments;
+
+    //! Variables set for every job (names and values), by name
+    std::vector<std::pair<std::string, std::string>> m_environment;
+
+    //! Working directory of every job, empty for the one of perfnp
+    std::string m_working_directory;
+
+    //! List of all parameters and their values
+    std::vector<Parameter> m_parameters;
+
+    //! Groups of parameters taking their values together, by index
+    std::vector<std::vector<std::size_t>> m_zip_groups;
+
+    //! Conditions on the combinations of parameter values
+    std::vector<Constraint> m_constraints;
+
+    //! Design of the sample of jobs, if only a sample is executed
+    SampleSettings m_sample;
+
+    //! Patterns extracting metrics from the standard output of every job
+    std::vector<MetricPattern> m_metrics;
+
+    //! Is the CSV job log configured?
+    bool m_has_job_csv_file;
+
+    //! File name for the CSV job log
+    std::string m_job_csv_file;
+
+    //! File name for the CSV cactus plot, empty if not configured
+    std::string m_cactus_csv_file;
+
+    //! File name for the Chrome trace, empty if not configured
+    std::string m_trace_file;
+
+    //! Penalty factor of the PAR-k score
+    unsigned m_par_k;
+
+    //! Names of parameters, by which the statistics are grouped
+    std::vector<std::string> m_group_by;
+
+    //! Names of parameters, which identify an instance
+    std::vector<std::string> m_instance;
+
+    //! Limits of `perfnp gate`
+    GateThresholds m_gate_thresholds;
+
+    //! Number of jobs executed in parallel
+    unsigned m_workers;
+
+    //! Calibration before the sweep
+    CalibrationSettings m_calibration;
+
+    //! Live monitoring endpoint
+    MonitorSettings m_monitor;
+
+    //! State of the input files in the page cache before their jobs
+    PageCacheSettings m_page_cache;
+
+    //! Private working directories of the worker slots
+    ScratchSettings m_scratch;
+
+    //! What happens with the running jobs on SIGINT or SIGTERM
+    InterruptPolicy m_on_interrupt;
+
+    //! Which results of earlier runs replace the execution of a job
+    CachePolicy m_cache;
+
+    //! Values of parameters streamed to the arena by parse(), by index
+    typedef std::map<std::size_t, std::vector<StringArena::Id>> StreamedValues;
+
+    //! Are the values of some parameters missing in the JSON?
+    bool m_streamed;
+
+    //! Validate the JSON and fill all typed fields
+    void validate(const std::shared_ptr<StringArena>& arena,
+        StreamedValues& streamed);
+
+    //! Create a config file, whose values were streamed by parse()
+    Config(nlohmann::json&& json, const std::shared_ptr<StringArena>& arena,
+        StreamedValues streamed);
+
 public:
 
     //! Create a config file given a JSON input
-    Config(const nlohmann::json& json)
-    : m_json(json)
-    {}
+    Config(const nlohmann::json& json);
 
     //! Create a config file given a JSON input
-    Config(nlohmann::json&& json)
-    : m_json(json)
-    {}
+    Config(nlohmann::json&& json);
+
+    /*!
+     * Reads a config file from the stream.
+     *
+     * The JSON is parsed by SAX events and the values of parameters
+     * go straight to a string arena without building their JSON tree,
+     * so a configuration with a huge list of instances takes about
+     * as much memory as its file.
+     */
+    static Config parse(std::istream& input);
 
     //! Time-limit to execute the binary, in seconds
     unsigned timeout() const;
 
     //! Absolute or relative path to the executed binary
-    std::string command() const;
+    const std::string& command() const;
 
     //! List of arguments given to the binary
-    Arguments arguments() const;
+    const Arguments& arguments() const;
+
+    /*!
+     * Variables set for every job, sorted by their names.
+     *
+     * The values may refer to parameters like the arguments do,
+     * all other variables are inherited from perfnp.
+     */
+    const std::vector<std::pair<std::string, std::string>>& environment() const {
+        return m_environment;
+    }
+
+    /*!
+     * Working directory of every job, empty for the one of perfnp.
+     *
+     * It may refer to parameters like the arguments do.
+     */
+    const std::string& working_directory() const {
+        return m_working_directory;
+    }
 
     //! List of all parameters and their values
-    std::vector<Parameter> parameters() const;
+    const std::vector<Parameter>& parameters() const {
+        return m_parameters;
+    }
+
+    /*!
+     * Groups of parameters (`zip`), which take the i-th values together.
+     *
+     * Every group lists indices of at least two parameters in ascending
+     * order, the parameters of a group have the same number of values.
+     */
+    const std::vector<std::vector<std::size_t>>& zip_groups() const {
+        return m_zip_groups;
+    }
+
+    //! Conditions every combination of parameter values must satisfy
+    const std::vector<Constraint>& constraints() const {
+        return m_constraints;
+    }
+
+    //! Design of the sample of jobs, disabled if all jobs are executed
+    const SampleSettings& sample() const {
+        return m_sample;
+    }
+
+    //! Patterns extracting metrics from the standard output of every job
+    const std::vector<MetricPattern>& metrics() const {
+        return m_metrics;
+    }
 
     //! File name for the CSV job log
     Optional<std::string> logging_job_csv_file() const;
 
+    //! File name for the CSV cactus plot, empty if not configured
+    const std::string& logging_cactus_csv_file() const {
+        return m_cactus_csv_file;
+    }
+
+    //! File name for the Chrome trace of the sweep, empty if not configured
+    const std::string& logging_trace_file() const {
+        return m_trace_file;
+    }
+
+    //! Penalty factor of the PAR-k score (2 unless configured)
+    unsigned statistics_par_k() const {
+        return m_par_k;
+    }
+
+    //! Names of parameters, by which the statistics are grouped
+    const std::vector<std::string>& statistics_group_by() const {
+        return m_group_by;
+    }
+
+    /*!
+     * Names of parameters, which identify an instance.
+     *
+     * Primal gaps are relative to the best incumbent on the instance.
+     * If empty, an instance is given by the input files of the job.
+     */
+    const std::vector<std::string>& statistics_instance() const {
+        return m_instance;
+    }
+
+    //! Limits of `perfnp gate`, missing limits have default values
+    const GateThresholds& gate_thresholds() const {
+        return m_gate_thresholds;
+    }
+
+    //! Number of jobs executed in parallel (1 unless configured)
+    unsigned workers() const {
+        return m_workers;
+    }
+
+    //! Calibration before the sweep, disabled if not configured
+    const CalibrationSettings& calibration() const {
+        return m_calibration;
+    }
+
+    //! Live monitoring endpoint, disabled if not configured
+    const MonitorSettings& monitor() const {
+        return m_monitor;
+    }
+
+    //! State of the input files in the page cache, not staged if not configured
+    const PageCacheSettings& page_cache() const {
+        return m_page_cache;
+    }
+
+    //! Private working directories of the worker slots, disabled if not configured
+    const ScratchSettings& scratch() const {
+        return m_scratch;
+    }
+
+    //! What happens with the running jobs on SIGINT or SIGTERM (killed unless configured)
+    InterruptPolicy on_interrupt() const {
+        return m_on_interrupt;
+    }
+
+    //! Which results of earlier runs replace the execution of a job (none unless configured)
+    CachePolicy cache() const {
+        return m_cache;
+    }
+
     //! Print the JSON to a string
     std::string to_string() const;
 
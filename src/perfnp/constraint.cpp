@@ -0,0 +1,296 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/constraint.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Is the text a number as a whole?
+    bool parse_number(const std::string& text, double& number)
+    {
+        if (text.empty()) {
+            return false;
+        }
+        char* end = nullptr;
+        number = std::strtod(text.c_str(), &end);
+        return end == text.c_str() + text.size();
+    } // parse_number
+
+    //! Recursive descent parser of constraint expressions
+    class Parser {
+
+        const std::string& m_text;
+        const std::vector<std::string>& m_names;
+        std::vector<Constraint::Node>& m_nodes;
+        std::size_t m_pos;
+
+        std::runtime_error error(const std::string& problem) const
+        {
+            return std::runtime_error("Constraint '" + m_text + "' "
+                + problem + " at position " + std::to_string(m_pos) + ".");
+        }
+
+        void skip_spaces()
+        {
+            while (m_pos < m_text.size()
+                    && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                ++m_pos;
+            }
+        }
+
+        //! Consumes the token if it follows
+        bool accept(const char* token)
+        {
+            skip_spaces();
+            const std::string expected(token);
+            if (m_text.compare(m_pos, expected.size(), expected) != 0) {
+                return false;
+            }
+            m_pos += expected.size();
+            return true;
+        }
+
+        std::size_t add(Constraint::Node node)
+        {
+            m_nodes.push_back(std::move(node));
+            return m_nodes.size() - 1;
+        }
+
+        std::size_t binary(Constraint::Kind kind, std::size_t left, std::size_t right)
+        {
+            Constraint::Node node;
+            node.kind = kind;
+            node.left = left;
+            node.right = right;
+            node.op = Constraint::Op::Equal;
+            return add(std::move(node));
+        }
+
+        Constraint::Operand parameter(const std::string& name)
+        {
+            auto it = std::find(m_names.begin(), m_names.end(), name);
+            if (it == m_names.end()) {
+                throw error("refers to an unknown parameter '" + name + "'");
+            }
+            return Constraint::Operand{ true,
+                static_cast<std::size_t>(it - m_names.begin()), "" };
+        }
+
+        Constraint::Operand operand()
+        {
+            skip_spaces();
+            if (m_pos >= m_text.size()) {
+                throw error("misses an operand");
+            }
+
+            const char first = m_text[m_pos];
+            if (first == '"' || first == '\'') {
+                auto end = m_text.find(first, m_pos + 1);
+                if (end == std::string::npos) {
+                    throw error("has an unterminated string");
+                }
+                auto literal = m_text.substr(m_pos + 1, end - m_pos - 1);
+                m_pos = end + 1;
+                return Constraint::Operand{ false, 0, std::move(literal) };
+            }
+
+            if (first == '%') {
+                auto end = m_text.find('%', m_pos + 1);
+                if (end == std::string::npos) {
+                    throw error("has an unterminated parameter reference");
+                }
+                auto name = m_text.substr(m_pos + 1, end - m_pos - 1);
+                auto result = parameter(name);
+                m_pos = end + 1;
+                return result;
+            }
+
+            const bool number = std::isdigit(static_cast<unsigned char>(first))
+                || first == '-' || first == '+' || first == '.';
+            const auto begin = m_pos;
+            while (m_pos < m_text.size()) {
+                const auto c = static_cast<unsigned char>(m_text[m_pos]);
+                if (std::isalnum(c) || c == '_' || (number && (c == '.'
+                        || ((c == '-' || c == '+') && (m_pos == begin
+                            || m_text[m_pos - 1] == 'e' || m_text[m_pos - 1] == 'E'))))) {
+                    ++m_pos;
+                } else {
+                    break;
+                }
+            }
+            if (m_pos == begin) {
+                throw error("misses an operand");
+            }
+
+            auto token = m_text.substr(begin, m_pos - begin);
+            if (number) {
+                double value = 0;
+                if (!parse_number(token, value)) {
+                    m_pos = begin;
+                    throw error("has an invalid number");
+                }
+                return Constraint::Operand{ false, 0, std::move(token) };
+            }
+            return parameter(token);
+        }
+
+        std::size_t comparison()
+        {
+            Constraint::Node node;
+            node.kind = Constraint::Kind::Compare;
+            node.left = node.right = 0;
+            node.lhs = operand();
+
+            if (accept("==")) {
+                node.op = Constraint::Op::Equal;
+            } else if (accept("!=")) {
+                node.op = Constraint::Op::NotEqual;
+            } else if (accept("<=")) {
+                node.op = Constraint::Op::LessEqual;
+            } else if (accept(">=")) {
+                node.op = Constraint::Op::GreaterEqual;
+            } else if (accept("<")) {
+                node.op = Constraint::Op::Less;
+            } else if (accept(">")) {
+                node.op = Constraint::Op::Greater;
+            } else {
+                throw error("misses a comparison operator");
+            }
+
+            node.rhs = operand();
+            return add(std::move(node));
+        }
+
+        std::size_t unary()
+        {
+            if (accept("!")) {
+                auto child = unary();
+                return binary(Constraint::Kind::Not, child, child);
+            }
+            if (accept("(")) {
+                auto inner = disjunction();
+                if (!accept(")")) {
+                    throw error("misses ')'");
+                }
+                return inner;
+            }
+            return comparison();
+        }
+
+        std::size_t conjunction()
+        {
+            auto left = unary();
+            while (accept("&&")) {
+                left = binary(Constraint::Kind::And, left, unary());
+            }
+            return left;
+        }
+
+        std::size_t disjunction()
+        {
+            auto left = conjunction();
+            while (accept("||")) {
+                left = binary(Constraint::Kind::Or, left, conjunction());
+            }
+            return left;
+        }
+
+    public:
+        Parser(const std::string& text, const std::vector<std::string>& names,
+            std::vector<Constraint::Node>& nodes)
+        : m_text(text)
+        , m_names(names)
+        , m_nodes(nodes)
+        , m_pos(0)
+        {}
+
+        //! Parses the whole text, the root is the last node,
+        //! because children are always added before their parent
+        void parse()
+        {
+            disjunction();
+            skip_spaces();
+            if (m_pos != m_text.size()) {
+                throw error("has an unexpected character");
+            }
+        }
+    }; // Parser
+
+} // anonymous namespace
+
+
+
+Constraint::Constraint(std::string expression, const std::vector<std::string>& names)
+: m_expression(std::move(expression))
+, m_last_parameter(0)
+{
+    Parser(m_expression, names, m_nodes).parse();
+
+    for (const auto& node : m_nodes) {
+        if (node.kind != Kind::Compare) {
+            continue;
+        }
+        if (node.lhs.is_parameter) {
+            m_last_parameter = std::max(m_last_parameter, node.lhs.parameter);
+        }
+        if (node.rhs.is_parameter) {
+            m_last_parameter = std::max(m_last_parameter, node.rhs.parameter);
+        }
+    }
+}
+
+
+
+bool Constraint::evaluate(std::size_t index,
+    const std::vector<std::string>& values) const
+{
+    const auto& node = m_nodes[index];
+    switch (node.kind) {
+    case Kind::Or:
+        return evaluate(node.left, values) || evaluate(node.right, values);
+    case Kind::And:
+        return evaluate(node.left, values) && evaluate(node.right, values);
+    case Kind::Not:
+        return !evaluate(node.left, values);
+    case Kind::Compare:
+        break;
+    }
+
+    const auto& lhs = node.lhs.is_parameter ? values[node.lhs.parameter] : node.lhs.literal;
+    const auto& rhs = node.rhs.is_parameter ? values[node.rhs.parameter] : node.rhs.literal;
+
+    int order = 0;
+    double lhs_number = 0;
+    double rhs_number = 0;
+    if (parse_number(lhs, lhs_number) && parse_number(rhs, rhs_number)) {
+        order = lhs_number < rhs_number ? -1 : (rhs_number < lhs_number ? 1 : 0);
+    } else {
+        order = lhs.compare(rhs);
+    }
+
+    switch (node.op) {
+    case Op::Equal:
+        return order == 0;
+    case Op::NotEqual:
+        return order != 0;
+    case Op::Less:
+        return order < 0;
+    case Op::LessEqual:
+        return order <= 0;
+    case Op::Greater:
+        return order > 0;
+    case Op::GreaterEqual:
+        return order >= 0;
+    }
+    return false;
+}
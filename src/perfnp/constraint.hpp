@@ -0,0 +1,104 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_CONSTRAINT_H_
+#define PERFNP_CONSTRAINT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Boolean expression over the values of parameters.
+ *
+ * Only the combinations of values satisfying all constraints are
+ * executed. An expression compares operands by `==`, `!=`, `<`,
+ * `<=`, `>` and `>=`, and combines the comparisons by `!`, `&&`,
+ * `||` and parentheses, e.g.
+ *
+ *     algorithm == "dfs" || flag == ""
+ *     %threads% <= 8 && !(solver == 'cbc' && threads > 1)
+ *
+ * An operand is a parameter name (bare, or between '%' like in the
+ * arguments), a quoted string or a number. Operands are compared
+ * numerically if both are numbers, otherwise as strings.
+ */
+class Constraint {
+public:
+    //! Kind of a node of the expression tree
+    enum class Kind { Or, And, Not, Compare };
+
+    //! Comparison operator
+    enum class Op { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+    //! Parameter reference or a literal
+    struct Operand {
+        bool is_parameter;
+        std::size_t parameter;
+        std::string literal;
+    };
+
+    //! Node of the expression tree, children are indices of nodes
+    struct Node {
+        Kind kind;
+        std::size_t left;
+        std::size_t right;
+        Op op;
+        Operand lhs;
+        Operand rhs;
+    };
+
+private:
+    //! The source text
+    std::string m_expression;
+
+    //! Nodes of the tree, the root is the last one
+    std::vector<Node> m_nodes;
+
+    //! The largest index of a referenced parameter
+    std::size_t m_last_parameter;
+
+    //! Value of the subtree given by the node
+    bool evaluate(std::size_t node, const std::vector<std::string>& values) const;
+
+public:
+    /*!
+     * Parses the expression.
+     *
+     * @param names names of all parameters, in the order of the configuration
+     * @throw std::runtime_error if the expression is invalid
+     *        or if it refers to an unknown parameter
+     */
+    Constraint(std::string expression, const std::vector<std::string>& names);
+
+    //! The source text
+    const std::string& expression() const {
+        return m_expression;
+    }
+
+    /*!
+     * The largest index of a parameter the expression depends on.
+     *
+     * The constraint can be evaluated as soon as all parameters up to
+     * this one have their values, 0 if it refers to no parameter.
+     */
+    std::size_t last_parameter() const {
+        return m_last_parameter;
+    }
+
+    /*!
+     * Is the constraint satisfied by the values?
+     *
+     * @param values values of the parameters, at least up to last_parameter()
+     */
+    bool operator()(const std::vector<std::string>& values) const {
+        return evaluate(m_nodes.size() - 1, values);
+    }
+}; // Constraint
+
+} // perfnp
+#endif // PERFNP_CONSTRAINT_H_
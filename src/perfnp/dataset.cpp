@@ -6,6 +6,10 @@
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
+#include <random>
+#include <stdexcept>
+#include <thread>
 
 using namespace perfnp;
 using namespace std;
@@ -120,8 +124,162 @@ unsigned calculate_number_of_successful_runs(
     return n_success;
 }
 
+/*!
+ * Quantile function of the standard normal distribution.
+ *
+ * Rational approximation by P. J. Acklam,
+ * the relative error is below 1.15e-9.
+ */
+double normal_quantile(double p)
+{
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02,
+        -2.759285104469687e+02, 1.383577518672690e+02,
+        -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02,
+        -1.556989798598866e+02, 6.680131188771972e+01,
+        -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549732539343734e+00,
+        4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01,
+        2.445134137142996e+00, 3.754408661907416e+00 };
+
+    if (p <= 0.0 || p >= 1.0) {
+        throw std::runtime_error("Probability "
+            + std::to_string(p) + " is not in (0,1).");
+    }
+
+    if (p < 0.02425) {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5])
+            / ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    }
+
+    if (p > 1 - 0.02425) {
+        return -normal_quantile(1 - p);
+    }
+
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q
+        / (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+}
+
+double median_of_values(std::vector<double> values)
+{
+    const size_t n = values.size();
+    if (n == 0) {
+        return 0.0;
+    }
+
+    auto upper = values.begin() + n / 2;
+    std::nth_element(values.begin(), upper, values.end());
+    if (n % 2 != 0) {
+        return *upper;
+    }
+
+    auto lower = std::max_element(values.begin(), upper);
+    return (*lower + *upper) / 2;
+}
+
+//! Cactus plot of successful runtimes sorted in the ascending order
+std::vector<CactusPoint> cactus_of(const std::vector<unsigned>& sorted_runtimes)
+{
+    std::vector<CactusPoint> cactus;
+    cactus.reserve(sorted_runtimes.size());
+    unsigned long long cumulative = 0;
+    for (size_t i = 0; i < sorted_runtimes.size(); ++i) {
+        cumulative += sorted_runtimes[i];
+        CactusPoint point;
+        point.solved = i + 1;
+        point.runtime = sorted_runtimes[i];
+        point.cumulative_runtime = cumulative;
+        cactus.push_back(point);
+    }
+    return cactus;
+}
+
 } // anonymous names
 
+perfnp::Dataset::Dataset(unsigned timeout,
+    std::vector<ExecResult> results,
+    std::vector<unsigned> job_indices)
+: m_timeout(timeout)
+, m_results(std::move(results))
+, m_job_indices(std::move(job_indices))
+{
+    if (m_job_indices.size() != m_results.size()) {
+        throw std::runtime_error("Dataset has " + std::to_string(m_results.size())
+            + " results, but " + std::to_string(m_job_indices.size()) + " job indices.");
+    }
+}
+
+perfnp::Dataset::Dataset(unsigned timeout,
+    std::vector<ExecResult> results,
+    std::vector<unsigned> job_indices,
+    std::vector<unsigned> slots)
+: Dataset(timeout, std::move(results), std::move(job_indices))
+{
+    if (slots.size() != m_results.size()) {
+        throw std::runtime_error("Dataset has " + std::to_string(m_results.size())
+            + " results, but " + std::to_string(slots.size()) + " slots.");
+    }
+    m_slots = std::move(slots);
+}
+
+void perfnp::Dataset::append(const Dataset& other)
+{
+    const bool known_indices = m_job_indices.size() == m_results.size()
+        && other.m_job_indices.size() == other.m_results.size();
+    const bool known_slots = m_slots.size() == m_results.size()
+        && other.m_slots.size() == other.m_results.size();
+
+    m_timeout = std::max(m_timeout, other.m_timeout);
+    m_results.insert(m_results.end(), other.m_results.begin(), other.m_results.end());
+    if (known_indices) {
+        m_job_indices.insert(m_job_indices.end(),
+            other.m_job_indices.begin(), other.m_job_indices.end());
+    } else {
+        m_job_indices.clear();
+    }
+    if (known_slots) {
+        m_slots.insert(m_slots.end(), other.m_slots.begin(), other.m_slots.end());
+    } else {
+        m_slots.clear();
+    }
+}
+
+perfnp::Dataset perfnp::Dataset::normalized_by_slot_speed(
+    const std::vector<double>& speeds) const
+{
+    if (m_slots.size() != m_results.size()) {
+        throw std::runtime_error("Worker slots of the runs are not known.");
+    }
+
+    std::vector<ExecResult> results;
+    results.reserve(m_results.size());
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        const auto& result = m_results[i];
+        if (m_slots[i] >= speeds.size()) {
+            throw std::runtime_error("Speed of the slot "
+                + std::to_string(m_slots[i]) + " is not known.");
+        }
+        const double speed = speeds[m_slots[i]];
+        if (!(speed > 0.0 && speed <= 1.0)) {
+            throw std::runtime_error("Speed of the slot "
+                + std::to_string(m_slots[i]) + " is not in (0,1].");
+        }
+
+        unsigned runtime = result.runtime();
+        if (result.exit_code() == 0 && runtime <= m_timeout) {
+            runtime = std::max(1u, static_cast<unsigned>(std::ceil(runtime * speed - 1e-9)));
+        }
+        results.emplace_back(result.exit_code(), runtime,
+            result.metrics(), result.trajectory());
+    }
+    return Dataset(m_timeout, std::move(results), m_job_indices, m_slots);
+}
+
 unsigned perfnp::Dataset::median_runtime_of_all_runs() const
 {
     auto runtimes = calculate_time_all(m_results, m_timeout);
@@ -150,3 +308,711 @@ unsigned perfnp::Dataset::number_of_all_successful_runs() const
     auto number_success = calculate_number_of_successful_runs(m_results, m_timeout);
     return number_success;
 }
+
+std::vector<SurvivalPoint> perfnp::Dataset::runtime_survival(double confidence) const
+{
+    const double z = normal_quantile(0.5 + confidence / 2);
+
+    // Every run is either an event (success) or censored at
+    // its runtime. Sort them by time, once for the whole curve.
+    std::vector<std::pair<unsigned, bool>> observations;
+    observations.reserve(m_results.size());
+    for (const auto& result : m_results) {
+        bool success = result.exit_code() == 0 && result.runtime() <= m_timeout;
+        observations.emplace_back(std::min(result.runtime(), m_timeout), success);
+    }
+    std::sort(observations.begin(), observations.end());
+
+    std::vector<SurvivalPoint> curve;
+    size_t at_risk = observations.size();
+    double survival = 1.0;
+    double greenwood = 0.0;
+
+    for (size_t i = 0; i < observations.size(); ) {
+        const unsigned time = observations[i].first;
+
+        // Censored runs at the same time are at risk of the events
+        size_t events = 0;
+        size_t finished = 0;
+        for (; i < observations.size() && observations[i].first == time; ++i) {
+            events += observations[i].second ? 1 : 0;
+            finished += 1;
+        }
+
+        if (events > 0) {
+            survival *= 1.0 - static_cast<double>(events) / at_risk;
+
+            SurvivalPoint point;
+            point.time = time;
+            point.at_risk = at_risk;
+            point.events = events;
+            point.survival = survival;
+
+            if (events < at_risk) {
+                greenwood += static_cast<double>(events)
+                    / (static_cast<double>(at_risk) * (at_risk - events));
+
+                // log-log transformation keeps the band in [0,1]
+                double se = std::sqrt(greenwood) / std::fabs(std::log(survival));
+                point.lower = std::pow(survival, std::exp(z * se));
+                point.upper = std::pow(survival, std::exp(-z * se));
+            } else {
+                point.lower = 0.0;
+                point.upper = 0.0;
+            }
+            curve.push_back(point);
+        }
+
+        at_risk -= finished;
+    }
+
+    return curve;
+}
+
+perfnp::RuntimeQuantile perfnp::Dataset::runtime_quantile(
+    double fraction, double confidence) const
+{
+    const double target = 1.0 - fraction;
+
+    RuntimeQuantile out;
+    out.value = 0;
+    out.lower = 0;
+    out.upper = 0;
+
+    // The first time, at which the curve (or its band) drops to target
+    for (const auto& point : runtime_survival(confidence)) {
+        if (out.lower == 0 && point.lower <= target) {
+            out.lower = point.time;
+        }
+        if (out.value == 0 && point.survival <= target) {
+            out.value = point.time;
+        }
+        if (out.upper == 0 && point.upper <= target) {
+            out.upper = point.time;
+        }
+    }
+
+    return out;
+}
+
+perfnp::SolverScore perfnp::Dataset::score(unsigned k) const
+{
+    // Runtimes are whole seconds up to the timeout,
+    // so the successful ones are sorted by counting.
+    const bool counting_sort = m_timeout <= (1u << 20);
+    std::vector<size_t> counts(counting_sort ? m_timeout + 1 : 0, 0);
+    std::vector<unsigned> solved_runtimes;
+
+    SolverScore out;
+    out.k = k;
+    out.attempted = m_results.size();
+    out.solved = 0;
+
+    double penalized_sum = 0.0;
+    for (const auto& result : m_results) {
+        if (result.exit_code() == 0 && result.runtime() <= m_timeout) {
+            out.solved += 1;
+            penalized_sum += result.runtime();
+            if (counting_sort) {
+                counts[result.runtime()] += 1;
+            } else {
+                solved_runtimes.push_back(result.runtime());
+            }
+        } else {
+            penalized_sum += static_cast<double>(k) * m_timeout;
+        }
+    }
+
+    out.par_k = out.attempted > 0 ? penalized_sum / out.attempted : 0.0;
+
+    if (counting_sort) {
+        solved_runtimes.reserve(out.solved);
+        for (unsigned runtime = 0; runtime < counts.size(); ++runtime) {
+            solved_runtimes.insert(solved_runtimes.end(), counts[runtime], runtime);
+        }
+    } else {
+        std::sort(solved_runtimes.begin(), solved_runtimes.end());
+    }
+
+    out.cactus = cactus_of(solved_runtimes);
+    return out;
+}
+
+namespace {
+
+//! Increment of the Weyl sequence in SplitMix64
+const std::uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+/*!
+ * Resampling by binomial draws per bin is used, if it needs fewer
+ * draws than resampling run by run. A binomial draw costs about
+ * as much as this many uniform draws (measured with libstdc++).
+ */
+const size_t BINOMIAL_DRAW_COST = 256;
+
+/*!
+ * Counter-based random generator.
+ *
+ * The i-th number of a stream is the SplitMix64 finalizer of the key
+ * and the counter i, so every resample has its own stream without
+ * any state shared among threads.
+ */
+class CounterRandom {
+    std::uint64_t m_key;
+    std::uint64_t m_counter;
+
+public:
+    typedef std::uint64_t result_type;
+
+    CounterRandom(std::uint64_t seed, std::uint64_t stream)
+    : m_key(mix(seed ^ mix(stream + GOLDEN_GAMMA)))
+    , m_counter(0)
+    {}
+
+    static std::uint64_t mix(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+
+    result_type operator()()
+    {
+        return mix(m_key + ++m_counter * GOLDEN_GAMMA);
+    }
+};
+
+//! Maps 32 random bits to [0, n) by a multiplication (Lemire)
+inline size_t uniform_index(std::uint32_t random, size_t n)
+{
+    return static_cast<size_t>((static_cast<std::uint64_t>(random) * n) >> 32);
+}
+
+/*!
+ * Runs binned by their runtime, the failed runs share the last bin.
+ *
+ * A bootstrap resample is fully described by the number of
+ * runs drawn from every bin.
+ */
+struct RuntimeBins {
+    //! Runtime of the bin (failures count as the timeout), ascending
+    std::vector<double> runtimes;
+    //! Penalized runtime of the bin (failures count as k * timeout)
+    std::vector<double> penalized;
+    //! Number of runs in every bin
+    std::vector<unsigned> counts;
+    //! Number of successful bins, i.e. all except the failures
+    size_t successful;
+    //! Bin of every run
+    std::vector<std::uint32_t> bin_of_run;
+};
+
+RuntimeBins make_runtime_bins(const std::vector<ExecResult>& results,
+    unsigned timeout, unsigned k)
+{
+    RuntimeBins bins;
+    for (const auto& result : results) {
+        if (result.exit_code() == 0 && result.runtime() <= timeout) {
+            bins.runtimes.push_back(result.runtime());
+        }
+    }
+    std::sort(bins.runtimes.begin(), bins.runtimes.end());
+    bins.runtimes.erase(std::unique(bins.runtimes.begin(), bins.runtimes.end()),
+        bins.runtimes.end());
+    bins.successful = bins.runtimes.size();
+    bins.penalized = bins.runtimes;
+
+    bins.runtimes.push_back(timeout);
+    bins.penalized.push_back(static_cast<double>(k) * timeout);
+    bins.counts.assign(bins.runtimes.size(), 0);
+
+    bins.bin_of_run.reserve(results.size());
+    for (const auto& result : results) {
+        size_t bin = bins.successful;
+        if (result.exit_code() == 0 && result.runtime() <= timeout) {
+            bin = std::lower_bound(bins.runtimes.begin(),
+                bins.runtimes.begin() + bins.successful,
+                static_cast<double>(result.runtime())) - bins.runtimes.begin();
+        }
+        bins.bin_of_run.push_back(static_cast<std::uint32_t>(bin));
+        ++bins.counts[bin];
+    }
+    return bins;
+}
+
+//! Median, mean, PAR-k and success rate of a resample given by its bin counts
+void evaluate_bins(const RuntimeBins& bins,
+    const std::vector<unsigned>& counts, size_t n, double* out)
+{
+    const size_t lower_rank = (n - 1) / 2;
+    const size_t upper_rank = n / 2;
+    double lower = 0.0;
+    double upper = 0.0;
+    double sum = 0.0;
+    double penalized = 0.0;
+    size_t solved = 0;
+    size_t seen = 0;
+
+    for (size_t b = 0; b < counts.size(); ++b) {
+        const size_t count = counts[b];
+        if (count == 0) {
+            continue;
+        }
+        // The median is selected by walking the histogram
+        if (seen <= lower_rank && lower_rank < seen + count) {
+            lower = bins.runtimes[b];
+        }
+        if (seen <= upper_rank && upper_rank < seen + count) {
+            upper = bins.runtimes[b];
+        }
+        seen += count;
+        sum += count * bins.runtimes[b];
+        penalized += count * bins.penalized[b];
+        if (b < bins.successful) {
+            solved += count;
+        }
+    }
+
+    out[0] = (lower + upper) / 2;
+    out[1] = sum / n;
+    out[2] = penalized / n;
+    out[3] = static_cast<double>(solved) / n;
+}
+
+//! Draws the bin counts of one resample
+void resample_bins(const RuntimeBins& bins, size_t n, bool by_binomials,
+    CounterRandom& random, std::vector<unsigned>& counts)
+{
+    if (by_binomials) {
+        // Multinomial draw as a chain of conditional binomials
+        size_t remaining = n;
+        size_t rest = n;
+        for (size_t b = 0; b < counts.size(); ++b) {
+            if (remaining == 0 || bins.counts[b] == rest) {
+                counts[b] = static_cast<unsigned>(remaining);
+            } else {
+                std::binomial_distribution<unsigned> binomial(
+                    static_cast<unsigned>(remaining),
+                    static_cast<double>(bins.counts[b]) / rest);
+                counts[b] = binomial(random);
+            }
+            remaining -= counts[b];
+            rest -= bins.counts[b];
+        }
+        return;
+    }
+
+    std::fill(counts.begin(), counts.end(), 0);
+    for (size_t i = 0; i < n; i += 2) {
+        const std::uint64_t bits = random();
+        ++counts[bins.bin_of_run[uniform_index(static_cast<std::uint32_t>(bits), n)]];
+        if (i + 1 < n) {
+            ++counts[bins.bin_of_run[uniform_index(static_cast<std::uint32_t>(bits >> 32), n)]];
+        }
+    }
+}
+
+//! Percentile interval of the bootstrap estimates, which are reordered
+Estimate percentile_interval(double value,
+    std::vector<double>& estimates, double confidence)
+{
+    Estimate out;
+    out.value = value;
+    out.lower = value;
+    out.upper = value;
+    if (estimates.empty()) {
+        return out;
+    }
+
+    const double alpha = (1.0 - confidence) / 2;
+    const size_t last = estimates.size() - 1;
+    const auto lower = static_cast<size_t>(std::floor(alpha * last));
+    const auto upper = static_cast<size_t>(std::ceil((1.0 - alpha) * last));
+
+    std::nth_element(estimates.begin(), estimates.begin() + lower, estimates.end());
+    out.lower = estimates[lower];
+    std::nth_element(estimates.begin() + lower, estimates.begin() + upper, estimates.end());
+    out.upper = estimates[upper];
+    return out;
+}
+
+} // anonymous namespace
+
+perfnp::BootstrapStatistics perfnp::Dataset::bootstrap(unsigned k,
+    double confidence, unsigned resamples, std::uint64_t seed,
+    unsigned threads) const
+{
+    if (confidence <= 0.0 || confidence >= 1.0) {
+        throw std::runtime_error("Confidence level "
+            + std::to_string(confidence) + " is not in (0,1).");
+    }
+
+    BootstrapStatistics out;
+    out.k = k;
+    out.resamples = resamples;
+    out.median = out.mean = out.par_k = out.success_rate = Estimate{ 0.0, 0.0, 0.0 };
+
+    const size_t n = m_results.size();
+    if (n == 0) {
+        return out;
+    }
+    if (n > 0xFFFFFFFFull) {
+        throw std::runtime_error("Bootstrap supports at most 2^32 runs.");
+    }
+
+    const RuntimeBins bins = make_runtime_bins(m_results, m_timeout, k);
+    const bool by_binomials = bins.counts.size() * BINOMIAL_DRAW_COST < n;
+
+    double values[4];
+    evaluate_bins(bins, bins.counts, n, values);
+
+    // Estimates of the i-th resample are at [i], [resamples + i], ...
+    std::vector<double> estimates(4 * static_cast<size_t>(resamples));
+    auto work = [&](unsigned begin, unsigned end) {
+        std::vector<unsigned> counts(bins.counts.size());
+        double resampled[4];
+        for (unsigned r = begin; r < end; ++r) {
+            CounterRandom random(seed, r);
+            resample_bins(bins, n, by_binomials, random, counts);
+            evaluate_bins(bins, counts, n, resampled);
+            for (size_t s = 0; s < 4; ++s) {
+                estimates[s * resamples + r] = resampled[s];
+            }
+        }
+    };
+
+    unsigned workers = threads > 0 ? threads : std::thread::hardware_concurrency();
+    workers = std::max(1u, std::min(workers, resamples));
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < workers; ++w) {
+        pool.emplace_back(work,
+            static_cast<unsigned>(static_cast<std::uint64_t>(resamples) * w / workers),
+            static_cast<unsigned>(static_cast<std::uint64_t>(resamples) * (w + 1) / workers));
+    }
+    work(0, static_cast<unsigned>(resamples / workers));
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    Estimate* targets[] = { &out.median, &out.mean, &out.par_k, &out.success_rate };
+    for (size_t s = 0; s < 4; ++s) {
+        std::vector<double> statistic(estimates.begin() + s * resamples,
+            estimates.begin() + (s + 1) * resamples);
+        *targets[s] = percentile_interval(values[s], statistic, confidence);
+    }
+    return out;
+}
+
+std::vector<MetricSummary> perfnp::Dataset::metric_summaries() const
+{
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> values;
+
+    for (const auto& result : m_results) {
+        for (const auto& metric : result.metrics()) {
+            auto it = std::find(names.begin(), names.end(), metric.name());
+            auto index = static_cast<size_t>(it - names.begin());
+            if (it == names.end()) {
+                names.push_back(metric.name());
+                values.emplace_back();
+            }
+            values[index].push_back(metric.value());
+        }
+    }
+
+    std::vector<MetricSummary> out;
+    for (size_t i = 0; i < names.size(); ++i) {
+        const auto& v = values[i];
+        MetricSummary summary;
+        summary.name = names[i];
+        summary.count = v.size();
+        summary.min = *std::min_element(v.begin(), v.end());
+        summary.max = *std::max_element(v.begin(), v.end());
+        summary.median = median_of_values(v);
+        out.push_back(summary);
+    }
+    return out;
+}
+
+bool perfnp::Dataset::best_incumbent(double& value) const
+{
+    bool found = false;
+    for (const auto& result : m_results) {
+        const auto& trajectory = result.trajectory();
+        if (trajectory.empty()) {
+            continue;
+        }
+        double last = trajectory.points().back().value;
+        if (!found || trajectory.is_better(last, value)) {
+            value = last;
+            found = true;
+        }
+    }
+    return found;
+}
+
+namespace {
+
+    /*!
+     * Best incumbent on every instance, in the order of the first run.
+     *
+     * @param[out] instance_of position of the instance of every result
+     * @param[out] found has any run on the instance found an incumbent?
+     */
+    std::vector<double> best_incumbents(const std::vector<ExecResult>& results,
+        const std::vector<unsigned long long>& instances,
+        std::vector<size_t>& instance_of, std::vector<bool>& found)
+    {
+        if (!instances.empty() && instances.size() != results.size()) {
+            throw std::runtime_error("Primal gaps need the instance"
+                " of every result.");
+        }
+
+        std::unordered_map<unsigned long long, size_t> positions;
+        std::vector<double> best;
+        instance_of.resize(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto key = instances.empty() ? 0 : instances[i];
+            auto inserted = positions.insert(std::make_pair(key, best.size()));
+            if (inserted.second) {
+                best.push_back(0.0);
+                found.push_back(false);
+            }
+            const auto instance = inserted.first->second;
+            instance_of[i] = instance;
+
+            const auto& trajectory = results[i].trajectory();
+            if (trajectory.empty()) {
+                continue;
+            }
+            double last = trajectory.points().back().value;
+            if (!found[instance] || trajectory.is_better(last, best[instance])) {
+                best[instance] = last;
+                found[instance] = true;
+            }
+        }
+        return best;
+    } // best_incumbents
+
+    //! Positions of the named parameters
+    std::vector<size_t> selected_parameters(const std::vector<Parameter>& parameters,
+        const std::vector<std::string>& names)
+    {
+        std::vector<size_t> selected;
+        for (const auto& name : names) {
+            auto it = std::find_if(parameters.begin(), parameters.end(),
+                [&](const Parameter& p) { return p.name() == name; });
+            if (it == parameters.end()) {
+                throw std::runtime_error("Results cannot be grouped by '"
+                    + name + "', because there is no such parameter.");
+            }
+            selected.push_back(static_cast<size_t>(it - parameters.begin()));
+        }
+        return selected;
+    } // selected_parameters
+
+} // anonymous namespace
+
+std::vector<double> perfnp::Dataset::primal_integrals(
+    const std::vector<unsigned long long>& instances) const
+{
+    std::vector<size_t> instance_of;
+    std::vector<bool> found;
+    auto best = best_incumbents(m_results, instances, instance_of, found);
+    if (std::find(found.begin(), found.end(), true) == found.end()) {
+        return {};
+    }
+
+    std::vector<double> integrals;
+    integrals.reserve(m_results.size());
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        const auto instance = instance_of[i];
+        integrals.push_back(found[instance]
+            ? m_results[i].trajectory().primal_integral(m_timeout, best[instance])
+            : static_cast<double>(m_timeout));
+    }
+    return integrals;
+}
+
+double perfnp::Dataset::mean_primal_integral(
+    const std::vector<unsigned long long>& instances) const
+{
+    auto integrals = primal_integrals(instances);
+    if (integrals.empty()) {
+        return 0.0;
+    }
+
+    std::vector<size_t> instance_of;
+    std::vector<bool> found;
+    best_incumbents(m_results, instances, instance_of, found);
+    std::vector<double> sums(found.size(), 0.0);
+    std::vector<size_t> counts(found.size(), 0);
+    for (size_t i = 0; i < integrals.size(); ++i) {
+        sums[instance_of[i]] += integrals[i];
+        counts[instance_of[i]] += 1;
+    }
+
+    double sum = 0.0;
+    for (size_t instance = 0; instance < sums.size(); ++instance) {
+        sum += sums[instance] / counts[instance];
+    }
+    return sum / sums.size();
+}
+
+double perfnp::Dataset::median_primal_gap_at(double t,
+    const std::vector<unsigned long long>& instances) const
+{
+    std::vector<size_t> instance_of;
+    std::vector<bool> found;
+    auto best = best_incumbents(m_results, instances, instance_of, found);
+    if (std::find(found.begin(), found.end(), true) == found.end()) {
+        return 1.0;
+    }
+
+    std::vector<double> gaps;
+    gaps.reserve(m_results.size());
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        const auto instance = instance_of[i];
+        gaps.push_back(found[instance]
+            ? m_results[i].trajectory().gap_at(t, best[instance]) : 1.0);
+    }
+    return median_of_values(gaps);
+}
+
+std::vector<unsigned long long> perfnp::Dataset::group_keys(
+    const std::vector<Parameter>& parameters,
+    const std::vector<std::string>& names,
+    const std::vector<std::vector<std::size_t>>& zip_groups) const
+{
+    if (m_job_indices.size() != m_results.size()) {
+        throw std::runtime_error("Results cannot be grouped,"
+            " because their job indices are not known.");
+    }
+
+    // The job index is a mixed-radix number, the last parameter
+    // changes the fastest and a zip group is a single digit
+    // (see JobSpace).
+    std::vector<size_t> leaders(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        leaders[i] = i;
+    }
+    for (const auto& group : zip_groups) {
+        for (auto member : group) {
+            leaders[member] = group.front();
+        }
+    }
+    std::vector<unsigned long long> strides(parameters.size());
+    unsigned long long stride = 1;
+    for (size_t i = parameters.size(); i-- > 0; ) {
+        if (leaders[i] == i) {
+            strides[i] = stride;
+            stride *= parameters[i].size();
+        }
+    }
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        strides[i] = strides[leaders[i]];
+    }
+
+    // The grouping parameters form a smaller mixed-radix group key
+    const auto selected = selected_parameters(parameters, names);
+    std::vector<unsigned long long> keys(m_results.size());
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        unsigned long long key = 0;
+        for (size_t p : selected) {
+            const auto radix = parameters[p].size();
+            key = key * radix + (m_job_indices[i] / strides[p]) % radix;
+        }
+        keys[i] = key;
+    }
+    return keys;
+}
+
+std::vector<GroupStatistics> perfnp::Dataset::group_by(
+    const std::vector<Parameter>& parameters,
+    const std::vector<std::string>& names,
+    unsigned k,
+    const std::vector<std::vector<std::size_t>>& zip_groups) const
+{
+    const auto result_keys = group_keys(parameters, names, zip_groups);
+    const auto selected = selected_parameters(parameters, names);
+    unsigned long long key_space = 1;
+    for (size_t p : selected) {
+        key_space *= parameters[p].size();
+    }
+
+    // Keys are mapped to groups by a plain array, unless
+    // the key space is much larger than the dataset itself.
+    const size_t no_group = static_cast<size_t>(-1);
+    const bool dense = key_space <= std::max<unsigned long long>(
+        m_results.size(), 1u << 16);
+    std::vector<size_t> dense_groups(dense ? key_space : 0, no_group);
+    std::unordered_map<unsigned long long, size_t> sparse_groups;
+
+    std::vector<unsigned long long> keys;
+    std::vector<std::vector<unsigned>> runtimes;
+    std::vector<size_t> solved;
+    std::vector<double> penalized;
+
+    for (size_t i = 0; i < m_results.size(); ++i) {
+        const auto key = result_keys[i];
+        size_t& group = dense ? dense_groups[key]
+            : sparse_groups.insert(std::make_pair(key, no_group)).first->second;
+        if (group == no_group) {
+            group = keys.size();
+            keys.push_back(key);
+            runtimes.emplace_back();
+            solved.push_back(0);
+            penalized.push_back(0.0);
+        }
+
+        const auto& result = m_results[i];
+        if (result.exit_code() == 0 && result.runtime() <= m_timeout) {
+            runtimes[group].push_back(result.runtime());
+            solved[group] += 1;
+            penalized[group] += result.runtime();
+        } else {
+            runtimes[group].push_back(m_timeout);
+            penalized[group] += static_cast<double>(k) * m_timeout;
+        }
+    }
+
+    // Groups are ordered as the values in the configuration
+    std::vector<size_t> order(keys.size());
+    for (size_t g = 0; g < order.size(); ++g) {
+        order[g] = g;
+    }
+    std::sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    std::vector<GroupStatistics> out;
+    out.reserve(order.size());
+    for (size_t g : order) {
+        GroupStatistics group;
+        group.values.resize(selected.size());
+        unsigned long long key = keys[g];
+        for (size_t j = selected.size(); j-- > 0; ) {
+            const auto& parameter = parameters[selected[j]];
+            group.values[j] = parameter.value(key % parameter.size());
+            key /= parameter.size();
+        }
+
+        group.runs = runtimes[g].size();
+        group.solved = solved[g];
+        group.median = findMedian(runtimes[g]);
+        group.mad = medianAbsoluteDeviation(runtimes[g]);
+        group.k = k;
+        group.par_k = penalized[g] / group.runs;
+
+        // Failures count as the timeout, so the successful runs
+        // are the first ones among the sorted runtimes
+        auto& sorted = runtimes[g];
+        std::sort(sorted.begin(), sorted.end());
+        sorted.resize(group.solved);
+        group.cactus = cactus_of(sorted);
+        out.push_back(std::move(group));
+    }
+    return out;
+}
@@ -6,14 +6,211 @@
 #ifndef PERFNP_DATASET_H_
 #define PERFNP_DATASET_H_
 
+#include "perfnp/config.hpp"
 #include "perfnp/exec.hpp"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 
 namespace perfnp {
 
+/*!
+ * Summary of one metric over all runs, which reported it.
+ */
+struct MetricSummary {
+
+    //! Name of the metric
+    std::string name;
+
+    //! Number of runs, which reported the metric
+    size_t count;
+
+    //! Median of the reported values
+    double median;
+
+    //! Smallest reported value
+    double min;
+
+    //! Largest reported value
+    double max;
+}; // MetricSummary
+
+
+
+/*!
+ * One step of the Kaplan-Meier estimate of the runtime distribution.
+ *
+ * Successful runs are events, failed runs (including time-outs)
+ * are right-censored at their runtime (at most the timeout).
+ */
+struct SurvivalPoint {
+
+    //! Runtime in seconds, at which some run succeeded
+    unsigned time;
+
+    //! Number of runs, which have not finished before `time`
+    size_t at_risk;
+
+    //! Number of runs, which succeeded at `time`
+    size_t events;
+
+    //! Estimated probability that a run does not succeed by `time`
+    double survival;
+
+    //! Lower bound of the pointwise confidence band
+    double lower;
+
+    //! Upper bound of the pointwise confidence band
+    double upper;
+}; // SurvivalPoint
+
+
+
+/*!
+ * Censoring-aware runtime quantile with its confidence interval.
+ *
+ * All values are in seconds. Zero means that the value
+ * is not reached before the timeout (a runtime is never 0).
+ */
+struct RuntimeQuantile {
+
+    //! Estimated runtime, in which the given fraction of runs succeeds
+    unsigned value;
+
+    //! Lower bound of the confidence interval
+    unsigned lower;
+
+    //! Upper bound of the confidence interval
+    unsigned upper;
+}; // RuntimeQuantile
+
+
+
+/*!
+ * One point of a cactus plot.
+ */
+struct CactusPoint {
+
+    //! Number of runs solved
+    size_t solved;
+
+    //! Runtime of the slowest of these runs, in seconds
+    unsigned runtime;
+
+    //! Total runtime of these runs, in seconds
+    unsigned long long cumulative_runtime;
+}; // CactusPoint
+
+
+
+/*!
+ * Scores used to rank solvers in the SAT/CSP competitions.
+ */
+struct SolverScore {
+
+    //! Penalty factor of the PAR-k score
+    unsigned k;
+
+    //! Number of all runs
+    size_t attempted;
+
+    //! Number of successful runs
+    size_t solved;
+
+    /*!
+     * Penalized average runtime, in seconds.
+     *
+     * Successful runs count with their runtime,
+     * failed runs count as k times the timeout.
+     */
+    double par_k;
+
+    //! Successful runs sorted by their runtime
+    std::vector<CactusPoint> cactus;
+}; // SolverScore
+
+
+
+/*!
+ * Statistics of the runs, which share values of some parameters.
+ */
+struct GroupStatistics {
+
+    //! Values of the grouping parameters (in the order of grouping)
+    std::vector<std::string> values;
+
+    //! Number of runs in the group
+    size_t runs;
+
+    //! Number of successful runs in the group
+    size_t solved;
+
+    //! Median runtime of all runs (failures count as the timeout)
+    unsigned median;
+
+    //! Median absolute deviation of the runtime of all runs
+    unsigned mad;
+
+    //! Penalty factor of the PAR-k score
+    unsigned k;
+
+    //! Penalized average runtime, see \ref SolverScore
+    double par_k;
+
+    //! Successful runs of the group sorted by their runtime
+    std::vector<CactusPoint> cactus;
+}; // GroupStatistics
+
+
+
+/*!
+ * Point estimate of a statistic with its confidence interval.
+ */
+struct Estimate {
+
+    //! Value of the statistic on the dataset
+    double value;
+
+    //! Lower bound of the confidence interval
+    double lower;
+
+    //! Upper bound of the confidence interval
+    double upper;
+}; // Estimate
+
+
+
+/*!
+ * Percentile-bootstrap confidence intervals of the main statistics.
+ *
+ * Failed runs count as the timeout, except for the PAR-k score,
+ * where they count as k times the timeout.
+ */
+struct BootstrapStatistics {
+
+    //! Penalty factor of the PAR-k score
+    unsigned k;
+
+    //! Number of bootstrap resamples
+    unsigned resamples;
+
+    //! Median runtime of all runs, in seconds
+    Estimate median;
+
+    //! Mean runtime of all runs, in seconds
+    Estimate mean;
+
+    //! Penalized average runtime, in seconds
+    Estimate par_k;
+
+    //! Fraction of successful runs
+    Estimate success_rate;
+}; // BootstrapStatistics
+
+
+
 /*!
  * Dataset contains all data about all runs.
  */
@@ -23,6 +220,10 @@ class Dataset {
     //unsigned m_repetition;
     //! Results of all runs
     std::vector<ExecResult> m_results;
+    //! Job index of every result (see combin.hpp), empty if unknown
+    std::vector<unsigned> m_job_indices;
+    //! Worker slot of every result (see execute_all_runs), empty if unknown
+    std::vector<unsigned> m_slots;
 
 public:
     //! Initialize all fields by the given values
@@ -32,6 +233,40 @@ public:
     , m_results(std::move(results))
     {}
 
+    //! Initialize all fields, the i-th result belongs to the i-th job index
+    Dataset(unsigned timeout, std::vector<ExecResult> results,
+        std::vector<unsigned> job_indices);
+
+    //! Initialize all fields, the i-th result was executed by the i-th slot
+    Dataset(unsigned timeout, std::vector<ExecResult> results,
+        std::vector<unsigned> job_indices, std::vector<unsigned> slots);
+
+    /*!
+     * Appends the results of another dataset, e.g. the reused ones.
+     *
+     * The job indices and the slots are kept only if both datasets
+     * know them, the timeout is the larger of both.
+     */
+    void append(const Dataset& other);
+
+    //! Job index of every result, empty if unknown
+    const std::vector<unsigned>& job_indices() const {
+        return m_job_indices;
+    }
+
+    /*!
+     * Dataset with runtimes normalised by the speed of the worker slots.
+     *
+     * A runtime measured in a slot with the relative speed 0.8
+     * (see \ref Calibration) is multiplied by 0.8 and rounded up
+     * to whole seconds, i.e. it is converted to the fastest slot.
+     * Failures stay failures.
+     *
+     * @param speeds relative speed of every slot, in (0,1]
+     * @throws std::runtime_error if the slots are unknown
+     */
+    Dataset normalized_by_slot_speed(const std::vector<double>& speeds) const;
+
     /*!
      * Median runtime from all runs.
      *
@@ -67,6 +302,154 @@ public:
     unsigned mad_runtime_of_all_successful_runs() const;
     //number of successful runs
     unsigned number_of_all_successful_runs() const;
+
+    /*!
+     * Kaplan-Meier estimate of the runtime distribution.
+     *
+     * Unlike the median of all runs, this estimator is not biased
+     * by failures: a failed run only tells us that it would have
+     * needed more time than it got (i.e. it is right-censored).
+     * The confidence band uses Greenwood's variance with
+     * the log-log transformation.
+     *
+     * @param confidence confidence level of the band, e.g. 0.95
+     * @return one point for every runtime with a success
+     */
+    std::vector<SurvivalPoint> runtime_survival(double confidence = 0.95) const;
+
+    /*!
+     * Runtime, in which the given fraction of runs succeeds.
+     *
+     * The quantile is read from the Kaplan-Meier estimate and its
+     * confidence interval from the band (Brookmeyer-Crowley).
+     *
+     * @param fraction fraction of successful runs, e.g. 0.5 for median
+     * @param confidence confidence level of the interval, e.g. 0.95
+     */
+    RuntimeQuantile runtime_quantile(double fraction,
+        double confidence = 0.95) const;
+
+    /*!
+     * PAR-k score, the number of solved runs and the cactus plot.
+     *
+     * All values come from a single pass over the results and
+     * a single (counting) sort of the successful runtimes.
+     *
+     * @param k penalty factor, e.g. 2 for PAR-2
+     */
+    SolverScore score(unsigned k = 2) const;
+
+    /*!
+     * Percentile-bootstrap confidence intervals of the median,
+     * the mean, the PAR-k score and the success rate.
+     *
+     * Runtimes are whole seconds, so a resample is a histogram
+     * over the distinct runtimes (plus one bin for failures) and
+     * all statistics are read from the histogram without sorting.
+     * The i-th resample is drawn from a counter-based generator
+     * keyed by the seed and i, therefore the result does not depend
+     * on the number of threads.
+     *
+     * @param k penalty factor of the PAR-k score
+     * @param confidence confidence level of the intervals, e.g. 0.95
+     * @param resamples number of bootstrap resamples
+     * @param seed seed of the random generator, for reproducibility
+     * @param threads number of threads, 0 for all hardware threads
+     */
+    BootstrapStatistics bootstrap(unsigned k = 2, double confidence = 0.95,
+        unsigned resamples = 10000, std::uint64_t seed = 0,
+        unsigned threads = 0) const;
+
+    /*!
+     * Statistics of runs grouped by values of the given parameters.
+     *
+     * The values of all parameters are decoded from the job index
+     * (see combine_command_lines). For example, grouping by a solver
+     * flag aggregates each flag across all instances.
+     * The results are processed in a single linear pass.
+     *
+     * @param parameters all parameters of the configuration
+     * @param names names of the grouping parameters
+     * @param k penalty factor of the PAR-k score
+     * @param zip_groups zip groups of the configuration, which share
+     *        a digit of the job index (see JobSpace)
+     * @return groups with at least one run, ordered by their values
+     */
+    std::vector<GroupStatistics> group_by(
+        const std::vector<Parameter>& parameters,
+        const std::vector<std::string>& names,
+        unsigned k = 2,
+        const std::vector<std::vector<std::size_t>>& zip_groups = {}) const;
+
+    /*!
+     * Key of the group of every result, given by the values of the
+     * named parameters (see group_by()).
+     *
+     * Results with equal values have equal keys, e.g. the runs on one
+     * instance when grouped by the instance parameter.
+     */
+    std::vector<unsigned long long> group_keys(
+        const std::vector<Parameter>& parameters,
+        const std::vector<std::string>& names,
+        const std::vector<std::vector<std::size_t>>& zip_groups = {}) const;
+
+    /*!
+     * Summary of every metric extracted from the output.
+     *
+     * Failed runs are included, because an anytime solver
+     * reports a meaningful objective even when it times out.
+     * Metrics are listed in the order of their first appearance.
+     */
+    std::vector<MetricSummary> metric_summaries() const;
+
+    /*!
+     * Best incumbent found by any run.
+     *
+     * This is the reference value of the primal gaps on a single
+     * instance (or on instances with a common optimum).
+     *
+     * @param[out] value the best incumbent, unchanged if none
+     * @return false if no run has found an incumbent
+     */
+    bool best_incumbent(double& value) const;
+
+    /*!
+     * Primal integral of every run up to the timeout.
+     *
+     * The reference value of a run is the best incumbent found by any
+     * run on the same instance, so that the optimum of one instance
+     * never sets the gaps of another one. Runs, which found no
+     * incumbent, have the integral equal to the timeout.
+     *
+     * @param instances key of the instance of every result
+     *        (e.g. from group_keys()), empty if all runs
+     *        are on a single instance
+     * @return empty vector if no run has found an incumbent
+     */
+    std::vector<double> primal_integrals(
+        const std::vector<unsigned long long>& instances = {}) const;
+
+    /*!
+     * Mean primal integral over the instances.
+     *
+     * The integrals are averaged per instance first, so that every
+     * instance has the same weight regardless of its number of runs.
+     *
+     * @param instances see primal_integrals()
+     * @return the mean or 0 if no run has found an incumbent
+     */
+    double mean_primal_integral(
+        const std::vector<unsigned long long>& instances = {}) const;
+
+    /*!
+     * Median primal gap of all runs at the time `t` (in seconds),
+     * each relative to the best incumbent on its instance.
+     *
+     * @param instances see primal_integrals()
+     * @return the median or 1 if no run has found an incumbent
+     */
+    double median_primal_gap_at(double t,
+        const std::vector<unsigned long long>& instances = {}) const;
 }; // Dataset
 } // perfnp
 #endif // PERFNP_DATASET_H_
@@ -4,14 +4,20 @@
 // https://opensource.org/licenses/MIT
 
 #include "perfnp/exec.hpp"
+#include "perfnp/interrupt.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
 
 #if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
 #include <memory>
@@ -24,11 +30,18 @@
 #include <iostream>
 #include <windows.h>
 #include <IntSafe.h>
+#include <thread>
 
 #else
 #error "Unsupported platform."
 #endif
 
+#if defined(__APPLE__)
+extern char** environ;
+#elif defined(_WIN32)
+#define environ _environ
+#endif
+
 using namespace perfnp;
 using namespace std::chrono;
 
@@ -39,6 +52,9 @@ ExecBin::ExecBin(
 : m_binary(binary)
 , m_args(args)
 , m_timeout(timeout)
+, m_metric_patterns(nullptr)
+, m_spawn_latency_us(nullptr)
+, m_cpu(-1)
 {
     if (binary.empty()) {
         throw std::runtime_error("Name of the executable must not be empty.");
@@ -47,9 +63,257 @@ ExecBin::ExecBin(
 
 
 
+EnvironmentTemplate::EnvironmentTemplate(const std::vector<std::string>& variables)
+{
+    std::vector<std::string> names;
+    for (const auto& variable : variables) {
+        names.push_back(variable.substr(0, variable.find('=')) + "=");
+    }
+    for (char** entry = environ; entry != nullptr && *entry != nullptr; ++entry) {
+        const std::string inherited = *entry;
+        const bool replaced = std::any_of(names.begin(), names.end(),
+            [&](const std::string& name) {
+                return inherited.compare(0, name.size(), name) == 0;
+            });
+        if (!replaced) {
+            m_inherited.push_back(inherited);
+        }
+    }
+} // EnvironmentTemplate::EnvironmentTemplate
+
+
+
+std::vector<char*> EnvironmentTemplate::envp(const std::vector<std::string>& variables) const
+{
+    std::vector<char*> pointers;
+    pointers.reserve(m_inherited.size() + variables.size() + 1);
+    for (const auto& variable : m_inherited) {
+        pointers.push_back(const_cast<char*>(variable.c_str()));
+    }
+    for (const auto& variable : variables) {
+        pointers.push_back(const_cast<char*>(variable.c_str()));
+    }
+    pointers.push_back(nullptr);
+    return pointers;
+} // EnvironmentTemplate::envp
+
+
+
 #if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+/**
+ * Closes a file descriptor in the destructor.
+ */
+struct FileDescriptorGuard {
+
+    int m_fd;
+
+    FileDescriptorGuard(int fd)
+        : m_fd(fd) {}
+
+    ~FileDescriptorGuard() {
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+    }
+}; // FileDescriptorGuard
+
+
+
+/**
+ * Creates a pipe, which is closed when any process executes a binary.
+ *
+ * Jobs are forked by several threads at once, so a job started
+ * by another thread must not inherit the writing end. It would keep
+ * the pipe open and the reader would wait for that job as well.
+ * Only the copy made by dup2() in the child stays open.
+ */
+int close_on_exec_pipe(int fds[2])
+{
+#if defined(__linux__)
+    return pipe2(fds, O_CLOEXEC);
+#else
+    if (pipe(fds) == -1) {
+        return -1;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+} // close_on_exec_pipe
+
+
+
+//! Step of the child process between fork() and execvp()
+enum class ChildStep : int {
+    Dup2,
+    Affinity,
+    Chdir,
+    Execvp
+};
+
+//! Failure of the child sent to the parent
+struct ChildFailure {
+    ChildStep step;
+    int error;
+};
+
+/**
+ * Sends the failure of the child to the parent and exits.
+ *
+ * The child of a multi-threaded process may only call
+ * async-signal-safe functions, so it must not throw.
+ */
+[[noreturn]] void exit_child(int fd, ChildStep step)
+{
+    ChildFailure failure;
+    failure.step = step;
+    failure.error = errno;
+    ssize_t written = write(fd, &failure, sizeof(failure));
+    (void)written;
+    _exit(127);
+} // exit_child
+
+/**
+ * Waits until the child executes the binary or reports its failure.
+ *
+ * @return true if the child failed
+ */
+bool read_child_failure(int fd, ChildFailure& failure)
+{
+    for (;;) {
+        ssize_t length = read(fd, &failure, sizeof(failure));
+        if (length == -1 && errno == EINTR) {
+            continue;
+        }
+        return length == static_cast<ssize_t>(sizeof(failure));
+    }
+} // read_child_failure
+
+//! Message of the failure of the child
+std::string describe(const ChildFailure& failure, const std::string& binary,
+    const std::string& working_directory, int cpu)
+{
+    const auto error = std::to_string(failure.error);
+    switch (failure.step) {
+    case ChildStep::Dup2:
+        return "dup2(...) failed: errno=" + error;
+    case ChildStep::Affinity:
+        return "sched_setaffinity(" + std::to_string(cpu)
+            + ") failed: errno=" + error;
+    case ChildStep::Chdir:
+        return "chdir(" + working_directory + ") failed: errno=" + error;
+    default:
+        return "execvp(" + binary + ", ...) failed: errno=" + error;
+    }
+} // describe
+
+
+
+/**
+ * Reads the output of the child until all writers close the pipe.
+ *
+ * If the child has been killed, but a grand-child inherited the pipe,
+ * the writing end might stay open. Therefore we stop reading
+ * when the deadline passes (unless there is no deadline).
+ */
+void scan_pipe(int fd, OutputScanner& scanner,
+    steady_clock::time_point start_time,
+    bool has_deadline, steady_clock::time_point deadline)
+{
+    char buffer[4096];
+    for (;;) {
+        int wait_in_ms = -1;
+        if (has_deadline) {
+            auto remaining = duration_cast<milliseconds>(
+                deadline - steady_clock::now()).count();
+            if (remaining <= 0) {
+                break;
+            }
+            wait_in_ms = static_cast<int>(remaining);
+        }
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, wait_in_ms);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(
+                "poll(...) returned -1: errno="
+                    + std::to_string(errno));
+        } else if (ready == 0) {
+            continue; // the deadline is checked above
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length > 0) {
+            auto elapsed_in_ms = duration_cast<milliseconds>(
+                steady_clock::now() - start_time).count();
+            scanner.feed(buffer, static_cast<size_t>(length),
+                static_cast<std::uint32_t>(elapsed_in_ms));
+        } else if (length == 0) {
+            break; // end of file
+        } else if (errno != EINTR) {
+            throw std::runtime_error(
+                "read(...) returned -1: errno="
+                    + std::to_string(errno));
+        }
+    }
+    scanner.finish();
+} // scan_pipe
+
+} // anonymous namespace
+
+
+
 ExecResult ExecBin::execute() const
 {
+    // A missing directory is reported here, the child cannot throw
+    struct stat directory_info;
+    if (!m_working_directory.empty()
+            && (stat(m_working_directory.c_str(), &directory_info) == -1
+                || !S_ISDIR(directory_info.st_mode))) {
+        throw std::runtime_error("Working directory '" + m_working_directory
+            + "' does not exist.");
+    }
+
+    // Pipe for capturing the standard output
+    int output_pipe[2] = { -1, -1 };
+    if (m_metric_patterns != nullptr && close_on_exec_pipe(output_pipe) == -1) {
+        throw std::runtime_error(
+            "pipe() failed: errno "
+            + std::to_string(errno) );
+    }
+    FileDescriptorGuard read_end_guard(output_pipe[0]);
+    FileDescriptorGuard write_end_guard(output_pipe[1]);
+
+    // Pipe for the failure of the child before the binary starts,
+    // it is closed without any data by a successful execvp()
+    int failure_pipe[2] = { -1, -1 };
+    if (close_on_exec_pipe(failure_pipe) == -1) {
+        throw std::runtime_error(
+            "pipe() failed: errno "
+            + std::to_string(errno) );
+    }
+    FileDescriptorGuard failure_read_guard(failure_pipe[0]);
+    FileDescriptorGuard failure_write_guard(failure_pipe[1]);
+
+    // Arguments for execvp, the child must not allocate memory
+    const char *file = m_binary.c_str();
+    std::unique_ptr<char*[]> argv(new char*[m_args.size() + 2]);
+
+    argv[0] = const_cast<char*>(m_binary.c_str());
+    for (size_t i = 0; i < m_args.size(); ++i) {
+        argv[i + 1] = const_cast<char*>(m_args[i].c_str());
+    }
+    argv[m_args.size() + 1] = NULL;
+
     auto start_time = steady_clock::now();
 
     pid_t child_proc_id = fork();
@@ -59,34 +323,92 @@ ExecResult ExecBin::execute() const
             + std::to_string(errno) );
 
     } else if (child_proc_id == 0) {
-        // Child process
+        // Child process, it shares the locks of the other threads,
+        // so a failure is sent to the parent and the child exits
 
-        // 1) Prepare arguments for execvp
-        const char *file = m_binary.c_str();
-        std::unique_ptr<char*[]> argv(new char*[m_args.size() + 2]);
+        // 1) Redirect the standard output to the pipe
+        if (output_pipe[1] != -1) {
+            if (dup2(output_pipe[1], STDOUT_FILENO) == -1) {
+                exit_child(failure_pipe[1], ChildStep::Dup2);
+            }
+            close(output_pipe[0]);
+            close(output_pipe[1]);
+        }
 
-        argv[0] = const_cast<char*>(m_binary.c_str());
-        for (size_t i = 0; i < m_args.size(); ++i) {
-            argv[i + 1] = const_cast<char*>(m_args[i].c_str());
+        // 2) Signals of the terminal go to perfnp only, which decides
+        //    whether the job is killed (see interrupt.hpp)
+        setpgid(0, 0);
+
+        // 3) Stay on the CPU of the slot
+#if defined(__linux__)
+        if (m_cpu >= 0) {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(m_cpu, &cpu_set);
+            if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == -1) {
+                exit_child(failure_pipe[1], ChildStep::Affinity);
+            }
         }
-        argv[m_args.size() + 1] = NULL;
+#endif
 
-        // 2) Execute the process in the child
-        alarm(m_timeout); // setup the time-out
-        int retval = execvp(file, argv.get());
-        if (retval == -1) {
-            throw std::runtime_error( "execvp("
-                + m_binary + ", ...) failed: errno="
-                + std::to_string(errno) );
-        } else {
-            throw std::runtime_error(
-                "execvp(...) must return -1, but it didn't");
+        // 4) Enter the working directory
+        if (!m_working_directory.empty() && chdir(m_working_directory.c_str()) == -1) {
+            exit_child(failure_pipe[1], ChildStep::Chdir);
+        }
+
+        // 5) Execute the process in the child, execvp() searches
+        //    the PATH of the new environment
+        if (!m_environment.empty()) {
+            environ = const_cast<char**>(m_environment.data());
         }
+        alarm(m_timeout); // setup the time-out
+        execvp(file, argv.get());
+        exit_child(failure_pipe[1], ChildStep::Execvp);
 
     } else {
         // Parent process
+        if (m_spawn_latency_us != nullptr) {
+            *m_spawn_latency_us = duration_cast<microseconds>(
+                steady_clock::now() - start_time).count();
+        }
+        setpgid(child_proc_id, child_proc_id); // whoever comes first
+
+        // 0) The child either executes the binary or reports why not
+        close(failure_pipe[1]);
+        failure_write_guard.m_fd = -1;
+        ChildFailure failure;
+        if (read_child_failure(failure_pipe[0], failure)) {
+            int status;
+            while (waitpid(child_proc_id, &status, 0) == -1 && errno == EINTR) {
+            }
+            throw std::runtime_error(describe(failure,
+                m_binary, m_working_directory, m_cpu));
+        }
+
+        RunningJob running_job(child_proc_id);
+
+        // 1) Scan the output until the child closes it
+        std::vector<MetricValue> metrics;
+        Trajectory trajectory;
+        if (m_metric_patterns != nullptr) {
+            close(output_pipe[1]);
+            write_end_guard.m_fd = -1;
+
+            OutputScanner scanner(*m_metric_patterns);
+            scan_pipe(output_pipe[0], scanner, start_time,
+                m_timeout > 0, start_time + seconds(m_timeout + 1));
+            metrics = scanner.metrics();
+            trajectory = scanner.trajectory();
+        }
+
+        // 2) Wait for the child process, it must not be killed
+        //    by an interruption after it has been reaped
+        siginfo_t info;
+        while (waitid(P_PID, child_proc_id, &info, WEXITED | WNOWAIT) == -1
+                && errno == EINTR) {
+        }
+        running_job.release();
 
-        // 1) Wait for the child process
         int status;
         if (waitpid(child_proc_id, &status, 0) == -1) {
             throw std::runtime_error(
@@ -94,22 +416,24 @@ ExecResult ExecBin::execute() const
                     + std::to_string(errno));
         }
 
-        // 2) Measure elapsed time
+        // 3) Measure elapsed time
         auto elapsed_in_ms = duration_cast<milliseconds>
                 (steady_clock::now() - start_time).count();
         auto elapsed_in_s = elapsed_in_ms / 1000;
-        if (elapsed_in_ms % 1000 > 0) {
+        if (elapsed_in_ms % 1000 > 0 || elapsed_in_s == 0) {
             elapsed_in_s += 1;
         }
 
-        // 3) Child process exited normally
+        // 4) Child process exited normally
         if (WIFEXITED(status)) {
             int exit_code = WEXITSTATUS(status);
-            return ExecResult(exit_code, elapsed_in_s);
+            return ExecResult(exit_code, elapsed_in_s,
+                std::move(metrics), std::move(trajectory));
 
-        // 4) Child exited because of a signal
+        // 5) Child exited because of a signal
         } else if (WIFSIGNALED(status)) {
-            return ExecResult(WTERMSIG(status), elapsed_in_s);
+            return ExecResult(WTERMSIG(status), elapsed_in_s,
+                std::move(metrics), std::move(trajectory));
         } else {
             throw std::runtime_error("cause of death not determined");
         }
@@ -216,6 +540,73 @@ struct HandleGuard {
     }
 }; // HandleGuard
 
+
+
+/**
+ * Reads the standard output of a child process in a separate thread.
+ *
+ * The thread finishes when all processes holding the writing end of
+ * the pipe exit. The destructor waits for the thread on any path.
+ */
+class OutputReader {
+
+    HANDLE m_read_handle;
+
+    std::chrono::steady_clock::time_point m_start_time;
+
+    OutputScanner m_scanner;
+
+    std::thread m_thread;
+
+public:
+    OutputReader(HANDLE read_handle, const std::vector<MetricPattern>& patterns,
+        std::chrono::steady_clock::time_point start_time)
+        : m_read_handle(read_handle)
+        , m_start_time(start_time)
+        , m_scanner(patterns)
+        , m_thread([this]() {
+            char buffer[4096];
+            DWORD length = 0;
+            while (ReadFile(m_read_handle, buffer, sizeof(buffer), &length, NULL)
+                    && length > 0) {
+                auto elapsed_in_ms = duration_cast<milliseconds>(
+                    steady_clock::now() - m_start_time).count();
+                m_scanner.feed(buffer, length,
+                    static_cast<std::uint32_t>(elapsed_in_ms));
+            }
+            m_scanner.finish();
+        }) {}
+
+    ~OutputReader() {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    //! Waits for the end of the output and returns the scanner
+    const OutputScanner& finish() {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        return m_scanner;
+    }
+}; // OutputReader
+
+
+
+/**
+ * Creates the result and adds the output of the child (if captured).
+ */
+ExecResult make_result(int exit_code, unsigned runtime, OutputReader* reader)
+{
+    if (reader == nullptr) {
+        return ExecResult(exit_code, runtime);
+    }
+    const auto& scanner = reader->finish();
+    return ExecResult(exit_code, runtime,
+        scanner.metrics(), scanner.trajectory());
+} // make_result
+
 } // empty namespace
 
 
@@ -229,6 +620,34 @@ ExecResult ExecBin::execute() const
     PROCESS_INFORMATION pi;
     ZeroMemory(&pi, sizeof(pi));
 
+    // Pipe for capturing the standard output
+    HANDLE output_read = NULL;
+    HANDLE output_write = NULL;
+    std::unique_ptr<HandleGuard> output_read_guard;
+    std::unique_ptr<HandleGuard> output_write_guard;
+    if (m_metric_patterns != nullptr) {
+        SECURITY_ATTRIBUTES sa;
+        ZeroMemory(&sa, sizeof(sa));
+        sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+        sa.bInheritHandle = TRUE;
+
+        if (!CreatePipe(&output_read, &output_write, &sa, 0)) {
+            throw std::runtime_error(
+                "CreatePipe failed: ERROR "
+                + std::to_string(GetLastError()));
+        }
+        output_read_guard.reset(new HandleGuard(output_read));
+        output_write_guard.reset(new HandleGuard(output_write));
+
+        // Only the writing end is inherited by the child
+        SetHandleInformation(output_read, HANDLE_FLAG_INHERIT, 0);
+
+        si.dwFlags |= STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = output_write;
+        si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    }
+
     std::wstring command_line;
     ArgvQuote(from_utf8(m_binary), command_line, false);
     for (const auto& arg : m_args) {
@@ -236,6 +655,18 @@ ExecResult ExecBin::execute() const
         ArgvQuote(from_utf8(arg), command_line, false);
     }
 
+    std::wstring working_directory = from_utf8(m_working_directory);
+
+    // Environment block: "NAME=value\0...\0\0"
+    std::wstring environment;
+    for (auto variable : m_environment) {
+        if (variable != nullptr) {
+            environment += from_utf8(variable);
+            environment += L'\0';
+        }
+    }
+    environment += L'\0';
+
     // Do not use/modify/... command_line after this line:
     LPWSTR command_line_buf = const_cast<wchar_t*>(command_line.c_str());
 
@@ -246,10 +677,10 @@ ExecResult ExecBin::execute() const
         command_line_buf, // Command line
         NULL,           // Process handle not inheritable
         NULL,           // Thread handle not inheritable
-        FALSE,          // Set handle inheritance to FALSE
-        CREATE_NO_WINDOW, // Suppress stdout and stderr
-        NULL,           // Use parent's environment block
-        NULL,           // Use parent's starting directory
+        m_metric_patterns != nullptr, // Inherit the pipe if needed
+        CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT, // Suppress stdout and stderr
+        m_environment.empty() ? NULL : &environment[0], // Environment block
+        working_directory.empty() ? NULL : working_directory.c_str(), // Starting directory
         &si,            // Pointer to STARTUPINFO structure
         &pi )           // Pointer to PROCESS_INFORMATION structure
     ) {
@@ -264,6 +695,11 @@ ExecResult ExecBin::execute() const
         }
     }
 
+    if (m_spawn_latency_us != nullptr) {
+        *m_spawn_latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+
     // Close all handles on any path
     HandleGuard hProcessGuard(pi.hProcess);
     HandleGuard hThreadGuard(pi.hThread);
@@ -282,6 +718,14 @@ ExecResult ExecBin::execute() const
             + std::to_string(GetLastError()));
     }
 
+    // Start reading the output, the child holds the only writing end
+    std::unique_ptr<OutputReader> output_reader;
+    if (m_metric_patterns != nullptr) {
+        output_write_guard.reset();
+        output_reader.reset(new OutputReader(
+            output_read, *m_metric_patterns, start_time));
+    }
+
     DWORD timeout = m_timeout; // in s
     timeout = timeout * 1000; // in ms
     if (timeout == 0) { // no time-out
@@ -295,7 +739,7 @@ ExecResult ExecBin::execute() const
     // Calculate the runtime
     auto elapsed_in_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
     auto elapsed_in_s = elapsed_in_ms / 1000;
-    if (elapsed_in_ms % 1000 > 0) {
+    if (elapsed_in_ms % 1000 > 0 || elapsed_in_s == 0) {
         elapsed_in_s += 1;
     }
 
@@ -312,12 +756,12 @@ ExecResult ExecBin::execute() const
                     "TerminateJobObject failed: ERROR "
                     + std::to_string(GetLastError()) );
             }
-            return ExecResult(128, elapsed_in_s);
+            return make_result(128, elapsed_in_s, output_reader.get());
 
         case WAIT_OBJECT_0:
             DWORD error_code;
             if (GetExitCodeProcess(pi.hProcess, &error_code)) {
-                return ExecResult(error_code, elapsed_in_s);
+                return make_result(error_code, elapsed_in_s, output_reader.get());
             } else {
                 throw std::runtime_error(
                     "GetExitCodeProcess failed: ERROR "
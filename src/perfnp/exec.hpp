@@ -6,8 +6,10 @@
 #ifndef PERFNP_CORE_H_
 #define PERFNP_CORE_H_
 
+#include <perfnp/metrics.hpp>
 #include <perfnp/tools.hpp>
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -31,11 +33,29 @@ class ExecResult {
      */
     unsigned m_runtime;
 
+    /*!
+     * Values extracted from the standard output.
+     *
+     * Empty unless the job was executed with metric patterns.
+     */
+    std::vector<MetricValue> m_metrics;
+
+    /*!
+     * Improving incumbents found by an anytime solver.
+     *
+     * Empty unless there is an incumbent metric pattern.
+     */
+    Trajectory m_trajectory;
+
 public:
     //! Initialize all values and check their validity.
-    ExecResult(int exit_code, unsigned runtime)
+    ExecResult(int exit_code, unsigned runtime,
+        std::vector<MetricValue> metrics = std::vector<MetricValue>(),
+        Trajectory trajectory = Trajectory())
     : m_exit_code(exit_code)
     , m_runtime(runtime)
+    , m_metrics(std::move(metrics))
+    , m_trajectory(std::move(trajectory))
     {
         if (runtime == 0) {
             throw std::runtime_error("Runtime was 0,"
@@ -64,6 +84,16 @@ public:
     unsigned runtime() const {
         return m_runtime;
     }
+
+    //! Values extracted from the standard output
+    const std::vector<MetricValue>& metrics() const {
+        return m_metrics;
+    }
+
+    //! Improving incumbents found by an anytime solver
+    const Trajectory& trajectory() const {
+        return m_trajectory;
+    }
 }; // ExecResult
 
 
@@ -86,6 +116,41 @@ class ExecBin {
      */
     unsigned m_timeout;
 
+    /**
+     * Patterns applied to the standard output
+     *
+     * Null means that the output is not captured.
+     */
+    const std::vector<MetricPattern>* m_metric_patterns;
+
+    /**
+     * Where to store the time spent by starting the child
+     *
+     * Null means that the time is not reported.
+     */
+    std::int64_t* m_spawn_latency_us;
+
+    /**
+     * Working directory of the child
+     *
+     * Empty means the working directory of this process.
+     */
+    std::string m_working_directory;
+
+    /**
+     * Null-terminated environment of the child
+     *
+     * Empty means the environment of this process.
+     */
+    std::vector<char*> m_environment;
+
+    /**
+     * CPU the child is pinned to
+     *
+     * Negative means any CPU allowed to this process.
+     */
+    int m_cpu;
+
 public:
 
     /**
@@ -103,9 +168,105 @@ public:
         return m_binary;
     }
 
-    /** Execute the binary */
+    /**
+     * Capture the standard output and extract metrics from it.
+     *
+     * The output is scanned line by line as it arrives and it is
+     * not forwarded to the standard output of this process.
+     * The patterns must outlive this object.
+     */
+    void set_metric_patterns(const std::vector<MetricPattern>& patterns)
+    {
+        m_metric_patterns = &patterns;
+    }
+
+    /**
+     * Report how long starting the child process takes.
+     *
+     * The time of fork() (or CreateProcessW) in microseconds
+     * is stored to the variable by every execution.
+     * The variable must outlive this object.
+     */
+    void set_spawn_latency_output(std::int64_t* latency_us)
+    {
+        m_spawn_latency_us = latency_us;
+    }
+
+    /**
+     * Run the binary in the given working directory.
+     *
+     * A relative path of the binary (with a slash) is resolved
+     * in the new working directory, like any other relative path.
+     */
+    void set_working_directory(const std::string& directory)
+    {
+        m_working_directory = directory;
+    }
+
+    /**
+     * Run the binary with the given environment.
+     *
+     * @param envp null-terminated `NAME=value` strings, which must
+     *        outlive this object (see EnvironmentTemplate)
+     */
+    void set_environment(std::vector<char*> envp)
+    {
+        m_environment = std::move(envp);
+    }
+
+    /**
+     * Pin the child to the CPU (Linux only, see slot_cpus()).
+     *
+     * The child is pinned before the binary starts, so that the whole
+     * job runs on the CPU measured by the calibration of its slot.
+     */
+    void set_cpu(int cpu)
+    {
+        m_cpu = cpu;
+    }
+
+    /**
+     * Execute the binary
+     *
+     * On POSIX, the binary runs in a process group of its own,
+     * so that it does not receive Ctrl+C of the terminal. It is
+     * killed by an interruption of the sweep (see interrupt.hpp).
+     */
     ExecResult execute() const;
 
 }; // ExecBin
+
+
+
+/*!
+ * Environment of the jobs, prebuilt once for the whole sweep.
+ *
+ * The variables inherited from perfnp are copied once, without those
+ * set by the jobs, so the environment of a job is only an array of
+ * pointers to them and to the variables of the job. Spawning a job
+ * therefore copies no strings.
+ */
+class EnvironmentTemplate {
+
+    //! Inherited variables as `NAME=value`
+    std::vector<std::string> m_inherited;
+
+public:
+    /*!
+     * Copies the environment of this process.
+     *
+     * @param variables `NAME=value` or `NAME` of the variables set
+     *        by the jobs, which are not inherited
+     */
+    explicit EnvironmentTemplate(const std::vector<std::string>& variables);
+
+    /*!
+     * Null-terminated environment of a job for ExecBin::set_environment().
+     *
+     * @param variables `NAME=value` strings of the job, all of them
+     *        named in the constructor; they must outlive the result
+     */
+    std::vector<char*> envp(const std::vector<std::string>& variables) const;
+}; // EnvironmentTemplate
 } // perfnp
 #endif // PERFNP_CORE_H_
@@ -0,0 +1,76 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/gate.hpp"
+#include "perfnp/dataset.hpp"
+
+#include <stdexcept>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Relative change from the baseline, in percent
+    double percent_change(double baseline, double current)
+    {
+        if (baseline == 0.0) {
+            return current == 0.0 ? 0.0 : 100.0;
+        }
+        return (current / baseline - 1.0) * 100.0;
+    } // percent_change
+
+    //! Creates a check, which passes if the change is within the limit
+    GateCheck make_check(std::string name, double baseline,
+        double current, double change, double limit)
+    {
+        GateCheck check;
+        check.name = std::move(name);
+        check.baseline = baseline;
+        check.current = current;
+        check.change = change;
+        check.limit = limit;
+        check.passed = change <= limit;
+        return check;
+    } // make_check
+
+} // anonymous namespace
+
+
+
+GateVerdict perfnp::evaluate_gate(const Dataset& baseline,
+    const Dataset& current, const GateThresholds& thresholds, unsigned k)
+{
+    auto baseline_score = baseline.score(k);
+    if (baseline_score.attempted == 0) {
+        throw std::runtime_error("The baseline run has no jobs to compare with.");
+    }
+    auto current_score = current.score(k);
+
+    GateVerdict verdict;
+    verdict.baseline_run = 0;
+    verdict.current_run = 0;
+    verdict.k = k;
+
+    double baseline_median = baseline.median_runtime_of_all_runs();
+    double current_median = current.median_runtime_of_all_runs();
+    verdict.checks.push_back(make_check("median_slowdown",
+        baseline_median, current_median,
+        percent_change(baseline_median, current_median),
+        thresholds.median_slowdown));
+
+    double baseline_solved = static_cast<double>(baseline_score.solved);
+    double current_solved = static_cast<double>(current_score.solved);
+    verdict.checks.push_back(make_check("solved_drop",
+        baseline_solved, current_solved,
+        baseline_solved - current_solved,
+        thresholds.solved_drop));
+
+    verdict.checks.push_back(make_check("par_k_increase",
+        baseline_score.par_k, current_score.par_k,
+        percent_change(baseline_score.par_k, current_score.par_k),
+        thresholds.par_k_increase));
+
+    return verdict;
+} // evaluate_gate
@@ -0,0 +1,112 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_GATE_H_
+#define PERFNP_GATE_H_
+
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+class Dataset;
+
+/*!
+ * Limits of a performance regression, see \ref evaluate_gate.
+ *
+ * Relative limits are in percent of the baseline value.
+ */
+struct GateThresholds {
+
+    //! Maximal increase of the median runtime, in percent
+    double median_slowdown;
+
+    //! Maximal decrease of the number of successful runs
+    double solved_drop;
+
+    //! Maximal increase of the PAR-k score, in percent
+    double par_k_increase;
+
+    //! Default limits tolerate 10% noise, but no lost instance
+    GateThresholds()
+    : median_slowdown(10)
+    , solved_drop(0)
+    , par_k_increase(10)
+    {}
+}; // GateThresholds
+
+
+
+/*!
+ * One criterion of the regression gate.
+ */
+struct GateCheck {
+
+    //! Name of the criterion, e.g. "median_slowdown"
+    std::string name;
+
+    //! Value measured in the baseline run
+    double baseline;
+
+    //! Value measured in the current run
+    double current;
+
+    //! Change from the baseline, in the units of the limit
+    double change;
+
+    //! The largest acceptable change
+    double limit;
+
+    //! Is the change within the limit?
+    bool passed;
+}; // GateCheck
+
+
+
+/*!
+ * Result of the regression gate, passed if all checks passed.
+ */
+struct GateVerdict {
+
+    //! ID of the baseline run in the database
+    long long baseline_run;
+
+    //! ID of the current run in the database
+    long long current_run;
+
+    //! Penalty factor of the compared PAR-k scores
+    unsigned k;
+
+    //! All evaluated criteria
+    std::vector<GateCheck> checks;
+
+    //! Did all checks pass?
+    bool passed() const {
+        for (const auto& check : checks) {
+            if (!check.passed) {
+                return false;
+            }
+        }
+        return true;
+    }
+}; // GateVerdict
+
+
+
+/*!
+ * Compares the current run against the baseline run.
+ *
+ * Checks the median runtime (failures count as the timeout),
+ * the number of successful runs and the PAR-k score.
+ * Both runs should execute the same jobs, e.g. the same
+ * configuration with a different version of the solver.
+ *
+ * @throws std::runtime_error if the baseline has no runs
+ */
+GateVerdict evaluate_gate(const Dataset& baseline, const Dataset& current,
+    const GateThresholds& thresholds, unsigned k = 2);
+
+} // perfnp
+#endif // PERFNP_GATE_H_
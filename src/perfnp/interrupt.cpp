@@ -0,0 +1,179 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/interrupt.hpp"
+
+#include <atomic>
+#include <csignal>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/types.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+    //! No interruption, new jobs must not start, the running jobs were killed
+    enum { RUNNING = 0, STOPPED = 1, KILLED = 2 };
+
+    //! State of the interruption, only lock-free atomics are used by the handler
+    std::atomic<int> g_state(RUNNING);
+
+    //! The first signal, which interrupted the sweep, 0 if none
+    std::atomic<int> g_signal(0);
+
+    //! Does the first signal kill the running jobs?
+    std::atomic<bool> g_kill_on_first_signal(true);
+
+    //! Number of jobs which can be killed, any other job is left to finish
+    const int MAX_RUNNING_JOBS = 4096;
+
+    //! Process IDs of the running jobs, 0 for a free position
+    std::atomic<long> g_running_jobs[MAX_RUNNING_JOBS];
+
+    //! Kills the running jobs with their children
+    void kill_running_jobs()
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        for (auto& job : g_running_jobs) {
+            const long process_id = job.load();
+            if (process_id > 0) {
+                kill(-static_cast<pid_t>(process_id), SIGKILL);
+            }
+        }
+#endif
+    } // kill_running_jobs
+
+    void on_signal(int signal_number)
+    {
+        int none = 0;
+        g_signal.compare_exchange_strong(none, signal_number);
+        request_interrupt(g_kill_on_first_signal.load() || g_state.load() != RUNNING);
+#if defined(_WIN32)
+        std::signal(signal_number, on_signal);
+#endif
+    } // on_signal
+
+#if defined(__linux__) || defined(__APPLE__)
+    //! Handlers replaced by the guard
+    struct sigaction g_previous_sigint;
+    struct sigaction g_previous_sigterm;
+#else
+    void (*g_previous_sigint)(int);
+    void (*g_previous_sigterm)(int);
+#endif
+
+} // anonymous namespace
+
+
+
+InterruptGuard::InterruptGuard(InterruptPolicy policy)
+{
+    reset_interrupt();
+    g_kill_on_first_signal = policy == InterruptPolicy::Kill;
+
+#if defined(__linux__) || defined(__APPLE__)
+    // Restarted system calls keep waitpid() and friends simple
+    struct sigaction action;
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, &g_previous_sigint);
+    sigaction(SIGTERM, &action, &g_previous_sigterm);
+#else
+    g_previous_sigint = std::signal(SIGINT, on_signal);
+    g_previous_sigterm = std::signal(SIGTERM, on_signal);
+#endif
+} // InterruptGuard::InterruptGuard
+
+
+
+InterruptGuard::~InterruptGuard()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    sigaction(SIGINT, &g_previous_sigint, nullptr);
+    sigaction(SIGTERM, &g_previous_sigterm, nullptr);
+#else
+    std::signal(SIGINT, g_previous_sigint);
+    std::signal(SIGTERM, g_previous_sigterm);
+#endif
+} // InterruptGuard::~InterruptGuard
+
+
+
+bool perfnp::interrupt_requested()
+{
+    return g_state.load() != RUNNING;
+} // interrupt_requested
+
+
+
+int perfnp::interrupt_signal()
+{
+    return g_signal.load();
+} // interrupt_signal
+
+
+
+bool perfnp::interrupt_killed_jobs()
+{
+    return g_state.load() == KILLED;
+} // interrupt_killed_jobs
+
+
+
+void perfnp::request_interrupt(bool kill_running)
+{
+    if (kill_running) {
+        g_state = KILLED;
+        kill_running_jobs();
+    } else {
+        int running = RUNNING;
+        g_state.compare_exchange_strong(running, STOPPED);
+    }
+} // request_interrupt
+
+
+
+void perfnp::reset_interrupt()
+{
+    g_state = RUNNING;
+    g_signal = 0;
+} // reset_interrupt
+
+
+
+RunningJob::RunningJob(long process_id)
+: m_position(-1)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    for (int i = 0; i < MAX_RUNNING_JOBS; ++i) {
+        long free = 0;
+        if (g_running_jobs[i].compare_exchange_strong(free, process_id)) {
+            m_position = i;
+            break;
+        }
+    }
+
+    // The handler has either seen the job or the job sees the state
+    if (g_state.load() == KILLED) {
+        kill(-static_cast<pid_t>(process_id), SIGKILL);
+    }
+#else
+    (void)process_id;
+#endif
+} // RunningJob::RunningJob
+
+
+
+void RunningJob::release()
+{
+    if (m_position != -1) {
+        g_running_jobs[m_position] = 0;
+        m_position = -1;
+    }
+} // RunningJob::release
@@ -0,0 +1,103 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_INTERRUPT_H_
+#define PERFNP_INTERRUPT_H_
+
+namespace perfnp {
+
+//! What happens with the running jobs, when a sweep is interrupted
+enum class InterruptPolicy {
+    //! The running jobs are killed and executed again by a resumed run
+    Kill,
+
+    //! The running jobs may finish and their results are saved
+    Finish
+};
+
+/*!
+ * Interrupts the sweep on SIGINT and SIGTERM while it exists.
+ *
+ * The first signal stops starting new jobs, the running jobs are
+ * killed or left to finish by the policy. The second signal kills
+ * them in any case. The previous handlers are restored by the
+ * destructor, the state of the interruption is kept until
+ * reset_interrupt(). Only one guard may exist at a time.
+ */
+class InterruptGuard {
+public:
+    //! Clears the interruption and installs the handlers
+    explicit InterruptGuard(InterruptPolicy policy);
+
+    InterruptGuard(const InterruptGuard&) = delete;
+    InterruptGuard& operator=(const InterruptGuard&) = delete;
+
+    //! Restores the previous handlers
+    ~InterruptGuard();
+}; // InterruptGuard
+
+//! Has the sweep been interrupted, i.e. must no new job start?
+bool interrupt_requested();
+
+/*!
+ * Signal (SIGINT or SIGTERM), which interrupted the sweep.
+ *
+ * @return 0 if there was no signal, e.g. after request_interrupt()
+ */
+int interrupt_signal();
+
+/*!
+ * Have the running jobs been killed by the interruption?
+ *
+ * Results of jobs finishing after that are incomplete.
+ */
+bool interrupt_killed_jobs();
+
+/*!
+ * Interrupts the sweep like a signal does.
+ *
+ * Safe to call from a signal handler.
+ *
+ * @param kill_running kill the running jobs too
+ */
+void request_interrupt(bool kill_running);
+
+//! Forgets the interruption before the next sweep
+void reset_interrupt();
+
+
+
+/*!
+ * Registers a running job, which is killed by the interruption.
+ *
+ * The job is killed with its process group, therefore ExecBin starts
+ * every job in a process group of its own. The registration must end
+ * before the process is reaped, so that the ID of another process is
+ * never killed. Does nothing on Windows, where the jobs share
+ * the console with perfnp and receive Ctrl+C themselves.
+ */
+class RunningJob {
+
+    //! Position in the table of running jobs, -1 if not registered
+    int m_position;
+
+public:
+    //! Registers the process, kills it at once if the jobs were killed
+    explicit RunningJob(long process_id);
+
+    RunningJob(const RunningJob&) = delete;
+    RunningJob& operator=(const RunningJob&) = delete;
+
+    //! Ends the registration
+    ~RunningJob() {
+        release();
+    }
+
+    //! Ends the registration, before the process is reaped
+    void release();
+}; // RunningJob
+
+} // perfnp
+#endif // PERFNP_INTERRUPT_H_
@@ -7,6 +7,7 @@
 #include "perfnp/tools.hpp"
 
 #include <iostream>
+#include <algorithm>
 #include <iomanip>
 #include <vector>
 
@@ -44,3 +45,163 @@ void perfnp::print_job_csv_line(std::ostream& o,
     o << command.escape_for_native_shell();
     o << std::endl;
 } // print_csv_line
+
+
+
+void perfnp::print_cactus_csv(std::ostream& o, const SolverScore& score)
+{
+    // Make sure to revert all stdw and similar
+    tools::StreamFormatGuard sfg(o);
+
+    o << "# PAR-" << score.k << ": " << score.par_k
+      << ", solved " << score.solved
+      << " of " << score.attempted << std::endl;
+
+    o << std::setw(10) << "Solved" << ";";
+    o << std::setw(10) << "Runtime" << ";";
+    o << std::setw(10) << "Cumulative" << std::endl;
+
+    for (const auto& point : score.cactus) {
+        o << std::setw(10) << point.solved << ";";
+        o << std::setw(10) << point.runtime << ";";
+        o << std::setw(10) << point.cumulative_runtime << std::endl;
+    }
+} // print_cactus_csv
+
+
+
+void perfnp::print_group_cactus_csv(std::ostream& o,
+    const std::vector<std::string>& names,
+    const std::vector<GroupStatistics>& groups)
+{
+    // Make sure to revert all stdw and similar
+    tools::StreamFormatGuard sfg(o);
+
+    for (const auto& group : groups) {
+        o << "#";
+        for (size_t i = 0; i < names.size(); ++i) {
+            o << " " << names[i] << "=" << group.values[i];
+        }
+        o << ": PAR-" << group.k << ": " << group.par_k
+          << ", solved " << group.solved
+          << " of " << group.runs << std::endl;
+    }
+
+    for (const auto& name : names) {
+        o << std::setw(10) << name << ";";
+    }
+    o << std::setw(10) << "Solved" << ";";
+    o << std::setw(10) << "Runtime" << ";";
+    o << std::setw(10) << "Cumulative" << std::endl;
+
+    for (const auto& group : groups) {
+        for (const auto& point : group.cactus) {
+            for (const auto& value : group.values) {
+                o << std::setw(10) << value << ";";
+            }
+            o << std::setw(10) << point.solved << ";";
+            o << std::setw(10) << point.runtime << ";";
+            o << std::setw(10) << point.cumulative_runtime << std::endl;
+        }
+    }
+} // print_group_cactus_csv
+
+
+
+void perfnp::print_group_table(std::ostream& o,
+    const std::vector<std::string>& names,
+    const std::vector<GroupStatistics>& groups,
+    unsigned k)
+{
+    // Make sure to revert all stdw and similar
+    tools::StreamFormatGuard sfg(o);
+
+    // Columns of parameter values are as wide as the longest value
+    std::vector<size_t> widths;
+    for (size_t i = 0; i < names.size(); ++i) {
+        size_t width = names[i].size();
+        for (const auto& group : groups) {
+            width = std::max(width, group.values[i].size());
+        }
+        widths.push_back(width);
+    }
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        o << std::left << std::setw(widths[i]) << names[i] << " | ";
+    }
+    o << std::right;
+    o << std::setw(6) << "Runs" << " | ";
+    o << std::setw(6) << "Solved" << " | ";
+    o << std::setw(6) << "Median" << " | ";
+    o << std::setw(6) << "MAD" << " | ";
+    o << std::setw(8) << ("PAR-" + std::to_string(k)) << std::endl;
+
+    for (const auto& group : groups) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            o << std::left << std::setw(widths[i]) << group.values[i] << " | ";
+        }
+        o << std::right;
+        o << std::setw(6) << group.runs << " | ";
+        o << std::setw(6) << group.solved << " | ";
+        o << std::setw(6) << group.median << " | ";
+        o << std::setw(6) << group.mad << " | ";
+        o << std::setw(8) << group.par_k << std::endl;
+    }
+} // print_group_table
+
+
+
+void perfnp::print_paired_instance_csv_header(std::ostream& o)
+{
+    // Make sure to revert all stdw and similar
+    tools::StreamFormatGuard sfg(o);
+
+    o << std::setw(10) << "Runtime A" << ";";
+    o << std::setw(10) << "Runtime B" << ";";
+    o << std::setw(10) << "Speedup" << ";";
+    o << std::setw(8) << "Solved A" << ";";
+    o << std::setw(8) << "Solved B" << ";";
+    o << "Command" << std::endl;
+} // print_paired_instance_csv_header
+
+
+
+void perfnp::print_paired_instance_csv_line(std::ostream& o,
+    const PairedInstance& instance)
+{
+    // Make sure to revert all stdw and similar
+    tools::StreamFormatGuard sfg(o);
+
+    o << std::setw(10) << instance.runtime_a << ";";
+    o << std::setw(10) << instance.runtime_b << ";";
+    o << std::setw(10) << instance.runtime_a / instance.runtime_b << ";";
+    o << std::setw(8) << instance.solved_a << ";";
+    o << std::setw(8) << instance.solved_b << ";";
+    o << instance.command << std::endl;
+} // print_paired_instance_csv_line
+
+
+
+void perfnp::print_gate_verdict_json(std::ostream& o, const GateVerdict& verdict)
+{
+    nlohmann::json j_checks = nlohmann::json::array();
+    for (const auto& check : verdict.checks) {
+        j_checks.push_back({
+            { "name", check.name },
+            { "baseline", check.baseline },
+            { "current", check.current },
+            { "change", check.change },
+            { "limit", check.limit },
+            { "passed", check.passed },
+        });
+    }
+
+    nlohmann::json j_verdict = {
+        { "verdict", verdict.passed() ? "pass" : "fail" },
+        { "baseline_run", verdict.baseline_run },
+        { "current_run", verdict.current_run },
+        { "par_k", verdict.k },
+        { "checks", j_checks },
+    };
+    o << j_verdict.dump(4) << std::endl;
+} // print_gate_verdict_json
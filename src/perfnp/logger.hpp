@@ -9,6 +9,9 @@
 #include "perfnp/combin.hpp"
 #include "perfnp/exec.hpp"
 #include "perfnp/config.hpp"
+#include "perfnp/dataset.hpp"
+#include "perfnp/compare.hpp"
+#include "perfnp/gate.hpp"
 namespace perfnp {
 
 //! Prints the CSV header for \link print_job_csv_line format.
@@ -18,5 +21,29 @@ void print_job_csv_header(std::ostream& o);
 void print_job_csv_line(std::ostream& o,
     const CmdWithArgs& command, unsigned timeout, ExecResult result);
 
+//! Prints the PAR-k score and the cactus plot as CSV.
+void print_cactus_csv(std::ostream& o, const SolverScore& score);
+
+//! Prints the PAR-k score and the cactus plot of every group as CSV.
+void print_group_cactus_csv(std::ostream& o,
+    const std::vector<std::string>& names,
+    const std::vector<GroupStatistics>& groups);
+
+//! Prints a table of grouped statistics, one line per group.
+void print_group_table(std::ostream& o,
+    const std::vector<std::string>& names,
+    const std::vector<GroupStatistics>& groups,
+    unsigned k);
+
+//! Prints the CSV header for \link print_paired_instance_csv_line format.
+void print_paired_instance_csv_header(std::ostream& o);
+
+//! Prints one CSV line for every instance paired by `perfnp compare`.
+void print_paired_instance_csv_line(std::ostream& o,
+    const PairedInstance& instance);
+
+//! Prints the verdict of `perfnp gate` as a single JSON document.
+void print_gate_verdict_json(std::ostream& o, const GateVerdict& verdict);
+
 } // perfnp
 #endif // PERFNP_CORE_H_
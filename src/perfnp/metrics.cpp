@@ -0,0 +1,176 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/metrics.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Parses a number at the beginning of the string, ignores leading spaces
+    bool parse_number(const char* begin, double& value)
+    {
+        char* end = nullptr;
+        double parsed = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    } // parse_number
+
+    //! Index of the only incumbent pattern or the number of patterns
+    size_t find_incumbent(const std::vector<MetricPattern>& patterns)
+    {
+        size_t found = patterns.size();
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            if (patterns[i].incumbent() == MetricPattern::Incumbent::No) {
+                continue;
+            }
+            if (found != patterns.size()) {
+                throw std::runtime_error("Metrics '" + patterns[found].name()
+                    + "' and '" + patterns[i].name() + "' are both incumbents,"
+                    " but at most one incumbent is allowed.");
+            }
+            found = i;
+        }
+        return found;
+    } // find_incumbent
+
+} // anonymous namespace
+
+
+
+MetricPattern::MetricPattern(std::string name, Kind kind,
+    std::string pattern, Incumbent incumbent)
+: m_name(std::move(name))
+, m_kind(kind)
+, m_pattern(std::move(pattern))
+, m_incumbent(incumbent)
+{
+    if (m_name.empty()) {
+        throw std::runtime_error("Name of a metric must not be empty.");
+    }
+
+    if (m_pattern.empty()) {
+        throw std::runtime_error("Pattern of the metric '"
+            + m_name + "' must not be empty.");
+    }
+
+    if (m_kind == Kind::Regex) {
+        try {
+            m_regex = std::regex(m_pattern);
+        } catch (const std::regex_error& ex) {
+            throw std::runtime_error("Pattern of the metric '"
+                + m_name + "' is not a valid regex: " + ex.what());
+        }
+    }
+} // MetricPattern::MetricPattern
+
+
+
+bool MetricPattern::match(const std::string& line, double& value) const
+{
+    if (m_kind == Kind::Prefix) {
+        auto begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos
+                || line.compare(begin, m_pattern.size(), m_pattern) != 0) {
+            return false;
+        }
+        return parse_number(line.c_str() + begin + m_pattern.size(), value);
+    }
+
+    std::smatch match;
+    if (!std::regex_search(line, match, m_regex)) {
+        return false;
+    }
+
+    const auto& group = match.size() > 1 ? match[1] : match[0];
+    return parse_number(group.str().c_str(), value);
+} // MetricPattern::match
+
+
+
+OutputScanner::OutputScanner(const std::vector<MetricPattern>& patterns)
+: m_patterns(patterns)
+, m_values(patterns.size(), 0.0)
+, m_matched(patterns.size(), false)
+, m_incumbent(find_incumbent(patterns))
+, m_trajectory(m_incumbent == patterns.size()
+    || patterns[m_incumbent].incumbent() == MetricPattern::Incumbent::Minimize)
+, m_chunk_time_in_ms(0)
+{}
+
+
+
+void OutputScanner::process_line()
+{
+    if (!m_line.empty() && m_line.back() == '\r') {
+        m_line.pop_back();
+    }
+
+    for (size_t i = 0; i < m_patterns.size(); ++i) {
+        if (m_patterns[i].match(m_line, m_values[i])) {
+            m_matched[i] = true;
+            if (i == m_incumbent) {
+                m_trajectory.add(m_chunk_time_in_ms, m_values[i]);
+            }
+        }
+    }
+
+    m_line.clear();
+} // OutputScanner::process_line
+
+
+
+void OutputScanner::feed(const char* data, std::size_t length,
+    std::uint32_t elapsed_in_ms)
+{
+    m_chunk_time_in_ms = elapsed_in_ms;
+
+    const char* end = data + length;
+    while (data != end) {
+        const char* eol = data;
+        while (eol != end && *eol != '\n') {
+            ++eol;
+        }
+
+        // Keep at most max_line_length bytes of a line
+        std::size_t room = max_line_length - m_line.size();
+        std::size_t chunk = static_cast<std::size_t>(eol - data);
+        m_line.append(data, chunk < room ? chunk : room);
+
+        if (eol == end) {
+            return;
+        }
+        process_line();
+        data = eol + 1;
+    }
+} // OutputScanner::feed
+
+
+
+void OutputScanner::finish()
+{
+    if (!m_line.empty()) {
+        process_line();
+    }
+} // OutputScanner::finish
+
+
+
+std::vector<MetricValue> OutputScanner::metrics() const
+{
+    std::vector<MetricValue> out;
+    for (size_t i = 0; i < m_patterns.size(); ++i) {
+        if (m_matched[i]) {
+            out.emplace_back(m_patterns[i].name(), m_values[i]);
+        }
+    }
+    return out;
+} // OutputScanner::metrics
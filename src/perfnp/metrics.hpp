@@ -0,0 +1,203 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_METRICS_H_
+#define PERFNP_METRICS_H_
+
+#include "perfnp/anytime.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Rule, which extracts a numeric value from one line of output.
+ *
+ * A regex pattern must match a part of the line and its first
+ * capture group (or the whole match if there is no group)
+ * is parsed as a number. A prefix pattern matches lines which
+ * start with the prefix (leading white-space is ignored)
+ * and the rest of the line is parsed as a number.
+ *
+ * An incumbent pattern also records the time of every
+ * improving value, see \ref Trajectory.
+ */
+class MetricPattern {
+public:
+    //! How is the pattern matched against a line
+    enum class Kind { Regex, Prefix };
+
+    //! Is the value an incumbent of an anytime solver?
+    enum class Incumbent { No, Minimize, Maximize };
+
+private:
+    //! Name of the extracted value
+    std::string m_name;
+
+    //! How is the pattern matched against a line
+    Kind m_kind;
+
+    //! Regular expression or the line prefix
+    std::string m_pattern;
+
+    //! Is the value an incumbent of an anytime solver?
+    Incumbent m_incumbent;
+
+    //! Compiled regular expression (only for Kind::Regex)
+    std::regex m_regex;
+
+public:
+    //! Initialize all fields, compile the regex if needed
+    MetricPattern(std::string name, Kind kind, std::string pattern,
+        Incumbent incumbent = Incumbent::No);
+
+    //! Name of the extracted value
+    const std::string& name() const {
+        return m_name;
+    }
+
+    //! How is the pattern matched against a line
+    Kind kind() const {
+        return m_kind;
+    }
+
+    //! Regular expression or the line prefix
+    const std::string& pattern() const {
+        return m_pattern;
+    }
+
+    //! Is the value an incumbent of an anytime solver?
+    Incumbent incumbent() const {
+        return m_incumbent;
+    }
+
+    /*!
+     * Tries to extract the value from a single line.
+     *
+     * @param[in] line one line of output without the line-feed
+     * @param[out] value extracted value, unchanged if not matched
+     * @return true if the line matched and contained a number
+     */
+    bool match(const std::string& line, double& value) const;
+
+    //! Equality operator compares all fields except the compiled regex
+    bool operator==(const MetricPattern& rhs) const {
+        return m_name == rhs.m_name
+            && m_kind == rhs.m_kind
+            && m_pattern == rhs.m_pattern
+            && m_incumbent == rhs.m_incumbent;
+    }
+}; // MetricPattern
+
+
+
+/*!
+ * Named numeric value extracted from the output of a job.
+ */
+class MetricValue {
+
+    //! Name of the pattern, which extracted the value
+    std::string m_name;
+
+    //! The extracted value
+    double m_value;
+
+public:
+    //! Initialize all fields by the given values
+    MetricValue(std::string name, double value)
+    : m_name(std::move(name))
+    , m_value(value)
+    {}
+
+    //! Name of the pattern, which extracted the value
+    const std::string& name() const {
+        return m_name;
+    }
+
+    //! The extracted value
+    double value() const {
+        return m_value;
+    }
+
+    //! Equality operator compares all fields
+    bool operator==(const MetricValue& rhs) const {
+        return m_name == rhs.m_name
+            && m_value == rhs.m_value;
+    }
+}; // MetricValue
+
+
+
+/*!
+ * Splits a stream of output into lines and applies metric patterns.
+ *
+ * The output is consumed in arbitrary chunks as it arrives from
+ * the child process. Only the current (incomplete) line is kept
+ * in memory and lines longer than \ref max_line_length are
+ * truncated. If a pattern matches several lines, the last
+ * value wins (i.e. the final objective of an anytime solver).
+ *
+ * Improving values of the incumbent pattern (at most one)
+ * are timestamped by the arrival time of their chunk.
+ */
+class OutputScanner {
+
+    //! Patterns applied to every line
+    const std::vector<MetricPattern>& m_patterns;
+
+    //! The current line, which has not been terminated yet
+    std::string m_line;
+
+    //! Last value extracted by each pattern
+    std::vector<double> m_values;
+
+    //! Has the corresponding pattern matched at least once?
+    std::vector<bool> m_matched;
+
+    //! Index of the incumbent pattern, or the number of patterns if none
+    std::size_t m_incumbent;
+
+    //! Improving incumbents found so far
+    Trajectory m_trajectory;
+
+    //! Arrival time of the chunk being processed, in milliseconds
+    std::uint32_t m_chunk_time_in_ms;
+
+    //! Apply all patterns to the current line and clear it
+    void process_line();
+
+public:
+    //! Lines are truncated to this many bytes
+    static const std::size_t max_line_length = 64 * 1024;
+
+    //! The patterns must outlive the scanner
+    explicit OutputScanner(const std::vector<MetricPattern>& patterns);
+
+    /*!
+     * Process the next chunk of the output.
+     *
+     * @param elapsed_in_ms time since the start of the job
+     */
+    void feed(const char* data, std::size_t length,
+        std::uint32_t elapsed_in_ms = 0);
+
+    //! Process the last line, which was not terminated by a line-feed
+    void finish();
+
+    //! Values of all patterns, which matched at least once
+    std::vector<MetricValue> metrics() const;
+
+    //! Improving values of the incumbent pattern
+    const Trajectory& trajectory() const {
+        return m_trajectory;
+    }
+}; // OutputScanner
+
+} // perfnp
+#endif // PERFNP_METRICS_H_
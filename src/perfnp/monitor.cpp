@@ -0,0 +1,408 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/monitor.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+    //! Upper bounds of the runtime histogram, in seconds
+    const std::uint64_t RUNTIME_BOUNDS[SweepMonitor::RUNTIME_BUCKETS] = {
+        1, 2, 5, 10, 30, 60, 120, 300, 600, 1800, 3600
+    };
+
+    //! Upper bounds of the spawn latency histogram, in microseconds
+    const std::int64_t SPAWN_BOUNDS_US[SweepMonitor::SPAWN_BUCKETS] = {
+        100, 250, 500, 1000, 2500, 10000, 100000
+    };
+
+    //! Index of the first bucket, whose bound is at least the value
+    template<typename T, std::size_t N>
+    std::size_t bucket_of(const T (&bounds)[N], T value)
+    {
+        std::size_t i = 0;
+        while (i < N && value > bounds[i]) {
+            ++i;
+        }
+        return i;
+    } // bucket_of
+
+    //! Writes a counter or a gauge with its metadata
+    void write_value(std::ostream& o, const char* name, const char* type,
+        const char* help, std::uint64_t value)
+    {
+        const bool counter = std::strcmp(type, "counter") == 0;
+        o << "# TYPE " << name << ' ' << type << '\n'
+          << "# HELP " << name << ' ' << help << '\n'
+          << name << (counter ? "_total " : " ") << value << '\n';
+    } // write_value
+
+    //! Writes a cumulative histogram, the bounds are divided by `scale`
+    template<typename T, std::size_t N>
+    void write_histogram(std::ostream& o, const char* name, const char* help,
+        const T (&bounds)[N], const std::atomic<std::uint64_t> (&buckets)[N + 1],
+        double sum, double scale)
+    {
+        o << "# TYPE " << name << " histogram\n"
+          << "# UNIT " << name << " seconds\n"
+          << "# HELP " << name << ' ' << help << '\n';
+
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i <= N; ++i) {
+            cumulative += buckets[i].load(std::memory_order_relaxed);
+            o << name << "_bucket{le=\"";
+            if (i < N) {
+                o << bounds[i] / scale;
+            } else {
+                o << "+Inf";
+            }
+            o << "\"} " << cumulative << '\n';
+        }
+        o << name << "_sum " << sum << '\n'
+          << name << "_count " << cumulative << '\n';
+    } // write_histogram
+
+} // anonymous namespace
+
+
+
+SweepMonitor::SweepMonitor()
+: m_planned(0)
+, m_running(0)
+, m_completed(0)
+, m_failed(0)
+, m_timed_out(0)
+, m_queue_depth(0)
+, m_runtime_sum(0)
+, m_spawn_sum_us(0)
+{
+    for (auto& bucket : m_runtime_buckets) {
+        bucket.store(0);
+    }
+    for (auto& bucket : m_spawn_buckets) {
+        bucket.store(0);
+    }
+} // SweepMonitor::SweepMonitor
+
+
+
+void SweepMonitor::job_finished(const ExecResult& result, unsigned timeout,
+    std::int64_t spawn_latency_us)
+{
+    const auto relaxed = std::memory_order_relaxed;
+    const bool success = result.exit_code() == 0 && result.runtime() <= timeout;
+    if (!success) {
+        if (result.runtime() >= timeout) {
+            m_timed_out.fetch_add(1, relaxed);
+        } else {
+            m_failed.fetch_add(1, relaxed);
+        }
+    }
+
+    std::uint64_t runtime = result.runtime();
+    m_runtime_buckets[bucket_of(RUNTIME_BOUNDS, runtime)].fetch_add(1, relaxed);
+    m_runtime_sum.fetch_add(runtime, relaxed);
+
+    if (spawn_latency_us < 0) {
+        spawn_latency_us = 0;
+    }
+    m_spawn_buckets[bucket_of(SPAWN_BOUNDS_US, spawn_latency_us)].fetch_add(1, relaxed);
+    m_spawn_sum_us.fetch_add(static_cast<std::uint64_t>(spawn_latency_us), relaxed);
+
+    m_completed.fetch_add(1, relaxed);
+    m_running.fetch_sub(1, relaxed);
+} // SweepMonitor::job_finished
+
+
+
+void SweepMonitor::write_openmetrics(std::ostream& o) const
+{
+    write_value(o, "perfnp_jobs_planned", "gauge",
+        "Number of jobs of the sweep.", planned());
+    write_value(o, "perfnp_jobs_running", "gauge",
+        "Number of jobs being executed.", running());
+    write_value(o, "perfnp_jobs_completed", "counter",
+        "Number of finished jobs.", completed());
+    write_value(o, "perfnp_jobs_failed", "counter",
+        "Number of jobs, which failed before the timeout.", failed());
+    write_value(o, "perfnp_jobs_timed_out", "counter",
+        "Number of jobs, which reached the timeout.", timed_out());
+    write_value(o, "perfnp_db_queue_depth", "gauge",
+        "Number of results waiting to be written.", queue_depth());
+
+    write_histogram(o, "perfnp_job_runtime_seconds",
+        "Runtimes of finished jobs.", RUNTIME_BOUNDS, m_runtime_buckets,
+        static_cast<double>(m_runtime_sum.load(std::memory_order_relaxed)), 1.0);
+    write_histogram(o, "perfnp_spawn_latency_seconds",
+        "Time to start the child process of a job.", SPAWN_BOUNDS_US, m_spawn_buckets,
+        m_spawn_sum_us.load(std::memory_order_relaxed) / 1e6, 1e6);
+
+    o << "# EOF\n";
+} // SweepMonitor::write_openmetrics
+
+
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+    //! Exception with the description of errno
+    std::runtime_error socket_error(const std::string& what)
+    {
+        return std::runtime_error("Monitoring endpoint: " + what
+            + " failed: " + std::strerror(errno));
+    } // socket_error
+
+    //! Sends the whole buffer, gives up if the peer disappears
+    void send_all(int fd, const std::string& data)
+    {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            auto n = send(fd, data.data() + sent, data.size() - sent, flags);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    } // send_all
+
+    //! Reads the request headers, waits at most a second for them
+    void read_request(int fd)
+    {
+        std::string request;
+        char buffer[1024];
+        while (request.size() < 8192
+                && request.find("\r\n\r\n") == std::string::npos
+                && request.find("\n\n") == std::string::npos) {
+            pollfd pfd = { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 1000) <= 0) {
+                return;
+            }
+            auto n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return;
+            }
+            request.append(buffer, static_cast<size_t>(n));
+        }
+    } // read_request
+
+} // anonymous namespace
+
+
+
+MonitorServer::MonitorServer(const SweepMonitor& monitor,
+    const MonitorSettings& settings)
+: m_monitor(monitor)
+, m_listen_fd(-1)
+{
+    m_stop_pipe[0] = m_stop_pipe[1] = -1;
+
+    try {
+        if (!settings.socket.empty()) {
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            if (settings.socket.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Monitoring socket path '"
+                    + settings.socket + "' is too long.");
+            }
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, settings.socket.c_str());
+
+            // Replace a stale socket of a previous sweep, nothing else
+            struct stat info;
+            if (lstat(settings.socket.c_str(), &info) == 0) {
+                if (!S_ISSOCK(info.st_mode)) {
+                    throw std::runtime_error("Monitoring socket path '"
+                        + settings.socket + "' exists and it is not a socket.");
+                }
+                unlink(settings.socket.c_str());
+            }
+
+            m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (m_listen_fd == -1) {
+                throw socket_error("socket()");
+            }
+            if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)) == -1) {
+                throw socket_error("bind(" + settings.socket + ")");
+            }
+            m_socket_path = settings.socket;
+        } else {
+            if (settings.port > 65535) {
+                throw std::runtime_error("Monitoring port "
+                    + std::to_string(settings.port) + " is out of range.");
+            }
+            sockaddr_in address;
+            std::memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(settings.port));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (m_listen_fd == -1) {
+                throw socket_error("socket()");
+            }
+            int reuse = 1;
+            setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)) == -1) {
+                throw socket_error("bind(localhost:"
+                    + std::to_string(settings.port) + ")");
+            }
+        }
+
+        // Jobs inherit neither the socket nor the pipe
+        fcntl(m_listen_fd, F_SETFD, FD_CLOEXEC);
+        if (listen(m_listen_fd, 16) == -1) {
+            throw socket_error("listen()");
+        }
+        if (pipe(m_stop_pipe) == -1) {
+            throw socket_error("pipe()");
+        }
+        fcntl(m_stop_pipe[0], F_SETFD, FD_CLOEXEC);
+        fcntl(m_stop_pipe[1], F_SETFD, FD_CLOEXEC);
+
+        m_thread = std::thread(&MonitorServer::serve, this);
+    } catch (...) {
+        for (int fd : { m_listen_fd, m_stop_pipe[0], m_stop_pipe[1] }) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+        if (!m_socket_path.empty()) {
+            unlink(m_socket_path.c_str());
+        }
+        throw;
+    }
+} // MonitorServer::MonitorServer
+
+
+
+MonitorServer::~MonitorServer()
+{
+    char stop = 0;
+    while (write(m_stop_pipe[1], &stop, 1) == -1 && errno == EINTR) {
+    }
+    m_thread.join();
+
+    close(m_listen_fd);
+    close(m_stop_pipe[0]);
+    close(m_stop_pipe[1]);
+    if (!m_socket_path.empty()) {
+        unlink(m_socket_path.c_str());
+    }
+} // MonitorServer::~MonitorServer
+
+
+
+unsigned MonitorServer::port() const
+{
+    if (!m_socket_path.empty()) {
+        return 0;
+    }
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address),
+            &length) == -1) {
+        throw socket_error("getsockname()");
+    }
+    return ntohs(address.sin_port);
+} // MonitorServer::port
+
+
+
+void MonitorServer::serve()
+{
+    for (;;) {
+        pollfd fds[2] = {
+            { m_listen_fd, POLLIN, 0 },
+            { m_stop_pipe[0], POLLIN, 0 }
+        };
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0) {
+            return;
+        }
+        if ((fds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+
+        int client = accept(m_listen_fd, nullptr, nullptr);
+        if (client == -1) {
+            continue;
+        }
+        read_request(client);
+
+        std::ostringstream body;
+        m_monitor.write_openmetrics(body);
+        const auto text = body.str();
+        send_all(client, "HTTP/1.0 200 OK\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(text.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + text);
+        close(client);
+    }
+} // MonitorServer::serve
+#endif
+
+
+
+#if defined(_WIN32)
+MonitorServer::MonitorServer(const SweepMonitor& monitor,
+    const MonitorSettings&)
+: m_monitor(monitor)
+, m_listen_fd(-1)
+{
+    throw std::runtime_error("The monitoring endpoint"
+        " is not supported on Windows.");
+} // MonitorServer::MonitorServer
+
+
+
+MonitorServer::~MonitorServer()
+{
+} // MonitorServer::~MonitorServer
+
+
+
+unsigned MonitorServer::port() const
+{
+    return 0;
+} // MonitorServer::port
+
+
+
+void MonitorServer::serve()
+{
+} // MonitorServer::serve
+#endif
@@ -0,0 +1,226 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_MONITOR_H_
+#define PERFNP_MONITOR_H_
+
+#include "perfnp/exec.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace perfnp {
+
+/*!
+ * Live counters of a running sweep.
+ *
+ * The scheduler updates the counters from its worker threads and
+ * the monitoring endpoint reads them at any time. All counters are
+ * relaxed atomics, so neither side ever waits for the other one.
+ * A scrape may therefore see e.g. a finished job, whose runtime has
+ * not been added to the sum yet.
+ */
+class SweepMonitor {
+public:
+    //! Upper bounds of the runtime histogram, in seconds
+    static const std::size_t RUNTIME_BUCKETS = 11;
+
+    //! Upper bounds of the spawn latency histogram, in microseconds
+    static const std::size_t SPAWN_BUCKETS = 7;
+
+private:
+    //! Number of jobs of the sweep
+    std::atomic<std::uint64_t> m_planned;
+
+    //! Number of jobs being executed
+    std::atomic<std::uint64_t> m_running;
+
+    //! Number of finished jobs, including the unsuccessful ones
+    std::atomic<std::uint64_t> m_completed;
+
+    //! Number of jobs, which failed before the timeout
+    std::atomic<std::uint64_t> m_failed;
+
+    //! Number of jobs, which reached the timeout
+    std::atomic<std::uint64_t> m_timed_out;
+
+    //! Number of results waiting for or being written by the callback
+    std::atomic<std::uint64_t> m_queue_depth;
+
+    //! Runtimes of finished jobs, the last bucket has no upper bound
+    std::atomic<std::uint64_t> m_runtime_buckets[RUNTIME_BUCKETS + 1];
+
+    //! Sum of the runtimes, in seconds
+    std::atomic<std::uint64_t> m_runtime_sum;
+
+    //! Spawn latencies, the last bucket has no upper bound
+    std::atomic<std::uint64_t> m_spawn_buckets[SPAWN_BUCKETS + 1];
+
+    //! Sum of the spawn latencies, in microseconds
+    std::atomic<std::uint64_t> m_spawn_sum_us;
+
+public:
+    //! All counters are zero
+    SweepMonitor();
+
+    SweepMonitor(const SweepMonitor&) = delete;
+    SweepMonitor& operator=(const SweepMonitor&) = delete;
+
+    //! Sets the number of jobs of the sweep
+    void set_planned(std::uint64_t jobs) {
+        m_planned.store(jobs, std::memory_order_relaxed);
+    }
+
+    //! A worker slot starts a job
+    void job_started() {
+        m_running.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*!
+     * A job has finished.
+     *
+     * A job timed out if it was not successful and its runtime
+     * reached the timeout, otherwise an unsuccessful job failed.
+     *
+     * @param spawn_latency_us time the child process took to start
+     */
+    void job_finished(const ExecResult& result, unsigned timeout,
+        std::int64_t spawn_latency_us);
+
+    //! A started job will be executed again (e.g. its worker was lost)
+    void job_abandoned() {
+        m_running.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    //! A result waits for the callback
+    void result_queued() {
+        m_queue_depth.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! The callback has processed a result
+    void result_written() {
+        m_queue_depth.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    //! Number of jobs of the sweep
+    std::uint64_t planned() const {
+        return m_planned.load(std::memory_order_relaxed);
+    }
+
+    //! Number of jobs being executed
+    std::uint64_t running() const {
+        return m_running.load(std::memory_order_relaxed);
+    }
+
+    //! Number of finished jobs
+    std::uint64_t completed() const {
+        return m_completed.load(std::memory_order_relaxed);
+    }
+
+    //! Number of jobs, which failed before the timeout
+    std::uint64_t failed() const {
+        return m_failed.load(std::memory_order_relaxed);
+    }
+
+    //! Number of jobs, which reached the timeout
+    std::uint64_t timed_out() const {
+        return m_timed_out.load(std::memory_order_relaxed);
+    }
+
+    //! Number of results waiting for or being written by the callback
+    std::uint64_t queue_depth() const {
+        return m_queue_depth.load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * Writes the text exposition in the OpenMetrics format.
+     *
+     * Histograms are cumulative and their count is the sum
+     * of the buckets, so every histogram is self-consistent.
+     */
+    void write_openmetrics(std::ostream& o) const;
+}; // SweepMonitor
+
+
+
+/*!
+ * Settings of the monitoring endpoint.
+ */
+struct MonitorSettings {
+
+    //! Path of a Unix domain socket, empty if not used
+    std::string socket;
+
+    //! TCP port on the loopback interface, 0 if not used
+    unsigned port;
+
+    //! The endpoint is disabled by default
+    MonitorSettings()
+    : port(0)
+    {}
+
+    //! Is there any endpoint to serve?
+    bool enabled() const {
+        return !socket.empty() || port != 0;
+    }
+}; // MonitorSettings
+
+
+
+/*!
+ * Serves the counters of a sweep over HTTP for Prometheus.
+ *
+ * The endpoint listens on a Unix domain socket or on a localhost
+ * TCP port and answers every request by the OpenMetrics exposition
+ * of the monitor. Requests are served one by one by a background
+ * thread, which only reads the counters. Supported on POSIX only.
+ */
+class MonitorServer {
+
+    //! Counters to serve, must outlive the server
+    const SweepMonitor& m_monitor;
+
+    //! Path of the Unix socket to remove, empty for TCP
+    std::string m_socket_path;
+
+    //! Listening socket
+    int m_listen_fd;
+
+    //! Pipe which wakes up and stops the serving thread
+    int m_stop_pipe[2];
+
+    //! The serving thread
+    std::thread m_thread;
+
+    //! Accepts connections until stopped
+    void serve();
+
+public:
+    /*!
+     * Starts listening and serving.
+     *
+     * An existing Unix socket at the path is replaced,
+     * any other existing file is an error.
+     *
+     * @throw std::runtime_error if the endpoint cannot be opened
+     */
+    MonitorServer(const SweepMonitor& monitor, const MonitorSettings& settings);
+
+    MonitorServer(const MonitorServer&) = delete;
+    MonitorServer& operator=(const MonitorServer&) = delete;
+
+    //! Stops serving, closes and removes the socket
+    ~MonitorServer();
+
+    //! Port of the TCP endpoint (useful with port 0), 0 for a Unix socket
+    unsigned port() const;
+}; // MonitorServer
+
+} // perfnp
+#endif // PERFNP_MONITOR_H_
@@ -0,0 +1,314 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/sample.hpp"
+#include "perfnp/combin.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace perfnp;
+
+namespace {
+
+    //! SplitMix64 generator, small and fast
+    std::uint64_t splitmix64(std::uint64_t& state)
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    } // splitmix64
+
+    //! Unbiased random integer in [0, n), the same on every platform
+    std::uint64_t uniform_below(std::uint64_t& state, std::uint64_t n)
+    {
+        const std::uint64_t threshold = (0 - n) % n;
+        for (;;) {
+            const auto bits = splitmix64(state);
+            if (bits >= threshold) {
+                return bits % n;
+            }
+        }
+    } // uniform_below
+
+    //! Value of a dimension of `size` values at the point `u` from [0, 1)
+    std::size_t scale(long double u, std::size_t size)
+    {
+        auto value = static_cast<std::size_t>(u * size);
+        return std::min(value, size - 1);
+    } // scale
+
+    //! Number of combinations of the dimensions, saturated on overflow
+    unsigned long long axes_product(const JobSpace& space)
+    {
+        unsigned long long product = 1;
+        for (size_t axis = 0; axis < space.axes().size(); ++axis) {
+            const unsigned long long size = space.axis_size(axis);
+            if (product > ~0ull / size) {
+                return ~0ull;
+            }
+            product *= size;
+        }
+        return product;
+    } // axes_product
+
+    //! Values of the dimensions given by a mixed-radix number
+    std::vector<std::size_t> axis_values_of(const JobSpace& space,
+        unsigned long long number)
+    {
+        std::vector<std::size_t> values(space.axes().size());
+        for (size_t axis = values.size(); axis-- > 0;) {
+            values[axis] = static_cast<std::size_t>(number % space.axis_size(axis));
+            number /= space.axis_size(axis);
+        }
+        return values;
+    } // axis_values_of
+
+    //! Keeps the distinct indices allowed by the constraints, sorted
+    std::vector<unsigned long long> valid_indices(const JobSpace& space,
+        std::vector<unsigned long long> indices)
+    {
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        indices.erase(std::remove_if(indices.begin(), indices.end(),
+            [&](unsigned long long index) { return !space.contains(index); }),
+            indices.end());
+        return indices;
+    } // valid_indices
+
+
+
+    std::vector<unsigned long long> random_sample(const JobSpace& space,
+        unsigned long long size, std::uint64_t seed)
+    {
+        const auto combinations = axes_product(space);
+        std::uint64_t state = seed;
+
+        // A small space is enumerated and shuffled partially
+        if (combinations / 4 < size) {
+            std::vector<unsigned long long> all;
+            for (auto i = space.next(0); i < space.size(); i = space.next(i + 1)) {
+                all.push_back(i);
+            }
+            const auto count = std::min<unsigned long long>(size, all.size());
+            for (size_t i = 0; i < count; ++i) {
+                std::swap(all[i], all[i + uniform_below(state, all.size() - i)]);
+            }
+            all.resize(static_cast<size_t>(count));
+            std::sort(all.begin(), all.end());
+            return all;
+        }
+
+        // Otherwise repeated draws are rare, constraints are redrawn
+        std::unordered_set<unsigned long long> drawn;
+        std::vector<unsigned long long> out;
+        const unsigned long long max_draws = 1000 * size + 1000;
+        for (unsigned long long draw = 0; out.size() < size; ++draw) {
+            if (draw == max_draws) {
+                throw std::runtime_error("Random sample of "
+                    + std::to_string(size) + " jobs cannot be drawn, the"
+                    " constraints exclude almost all combinations.");
+            }
+            const auto index = space.index_of(
+                axis_values_of(space, uniform_below(state, combinations)));
+            if (drawn.insert(index).second && space.contains(index)) {
+                out.push_back(index);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    } // random_sample
+
+
+
+    std::vector<unsigned long long> latin_hypercube_sample(const JobSpace& space,
+        unsigned long long size, std::uint64_t seed)
+    {
+        const auto dimensions = space.axes().size();
+        const auto points = static_cast<std::size_t>(size);
+        std::uint64_t state = seed;
+
+        // Every dimension is split into `size` strata, which are
+        // assigned to the points by a random permutation
+        std::vector<std::vector<std::size_t>> values(points,
+            std::vector<std::size_t>(dimensions));
+        std::vector<std::size_t> strata(points);
+        for (size_t axis = 0; axis < dimensions; ++axis) {
+            for (size_t i = 0; i < points; ++i) {
+                strata[i] = i;
+            }
+            for (size_t i = points; i > 1; --i) {
+                std::swap(strata[i - 1], strata[uniform_below(state, i)]);
+            }
+            for (size_t i = 0; i < points; ++i) {
+                const long double jitter = std::ldexp(
+                    static_cast<long double>(splitmix64(state) >> 11), -53);
+                values[i][axis] = scale((strata[i] + jitter) / points,
+                    space.axis_size(axis));
+            }
+        }
+
+        std::vector<unsigned long long> indices;
+        indices.reserve(points);
+        for (const auto& point : values) {
+            indices.push_back(space.index_of(point));
+        }
+        return valid_indices(space, std::move(indices));
+    } // latin_hypercube_sample
+
+
+
+    /*!
+     * Primitive polynomials and initial direction numbers of the Sobol
+     * sequence for the dimensions 2 to 21 (Joe and Kuo, new-joe-kuo-6.21201).
+     */
+    struct SobolPolynomial {
+        unsigned degree;
+        unsigned coefficients;
+        std::uint32_t initial[8];
+    };
+
+    const SobolPolynomial SOBOL_POLYNOMIALS[] = {
+        { 1, 0, { 1 } },
+        { 2, 1, { 1, 3 } },
+        { 3, 1, { 1, 3, 1 } },
+        { 3, 2, { 1, 1, 1 } },
+        { 4, 1, { 1, 1, 3, 3 } },
+        { 4, 4, { 1, 3, 5, 13 } },
+        { 5, 2, { 1, 1, 5, 5, 17 } },
+        { 5, 4, { 1, 1, 5, 5, 5 } },
+        { 5, 7, { 1, 1, 7, 11, 19 } },
+        { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } },
+        { 5, 14, { 1, 3, 5, 5, 31 } },
+        { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+        { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+        { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+        { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+        { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+        { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+        { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+        { 7, 4, { 1, 3, 7, 13, 13, 15, 69 } },
+    };
+
+    const std::size_t SOBOL_DIMENSIONS
+        = 1 + sizeof(SOBOL_POLYNOMIALS) / sizeof(SOBOL_POLYNOMIALS[0]);
+
+    //! 32 direction numbers of the dimension
+    std::vector<std::uint32_t> sobol_directions(std::size_t dimension)
+    {
+        std::vector<std::uint32_t> v(32);
+        if (dimension == 0) {
+            for (unsigned k = 0; k < 32; ++k) {
+                v[k] = std::uint32_t(1) << (31 - k);
+            }
+            return v;
+        }
+
+        const auto& polynomial = SOBOL_POLYNOMIALS[dimension - 1];
+        const unsigned s = polynomial.degree;
+        for (unsigned k = 0; k < 32; ++k) {
+            if (k < s) {
+                v[k] = polynomial.initial[k] << (31 - k);
+                continue;
+            }
+            v[k] = v[k - s] ^ (v[k - s] >> s);
+            for (unsigned i = 1; i < s; ++i) {
+                if ((polynomial.coefficients >> (s - 1 - i)) & 1) {
+                    v[k] ^= v[k - i];
+                }
+            }
+        }
+        return v;
+    } // sobol_directions
+
+
+
+    std::vector<unsigned long long> sobol_sample(const JobSpace& space,
+        unsigned long long size, std::uint64_t seed)
+    {
+        const auto dimensions = space.axes().size();
+        if (dimensions > SOBOL_DIMENSIONS) {
+            throw std::runtime_error("Sobol sample supports at most "
+                + std::to_string(SOBOL_DIMENSIONS) + " parameters, "
+                + std::to_string(dimensions) + " are given.");
+        }
+        if (size > (1ull << 32)) {
+            throw std::runtime_error("Sobol sample supports at most 2^32 points.");
+        }
+
+        std::vector<std::vector<std::uint32_t>> directions;
+        std::vector<std::uint32_t> shifts;
+        std::uint64_t state = seed;
+        for (size_t axis = 0; axis < dimensions; ++axis) {
+            directions.push_back(sobol_directions(axis));
+            shifts.push_back(static_cast<std::uint32_t>(splitmix64(state) >> 32));
+        }
+
+        // Point i is the XOR of the directions of the bits of gray(i),
+        // so every point is computed directly from its number
+        std::vector<unsigned long long> indices;
+        std::vector<std::size_t> point(dimensions);
+        for (unsigned long long i = 0; i < size; ++i) {
+            const auto gray = i ^ (i >> 1);
+            for (size_t axis = 0; axis < dimensions; ++axis) {
+                std::uint32_t x = shifts[axis];
+                for (unsigned k = 0; (gray >> k) != 0; ++k) {
+                    if ((gray >> k) & 1) {
+                        x ^= directions[axis][k];
+                    }
+                }
+                point[axis] = scale(std::ldexp(static_cast<long double>(x), -32),
+                    space.axis_size(axis));
+            }
+            indices.push_back(space.index_of(point));
+        }
+        return valid_indices(space, std::move(indices));
+    } // sobol_sample
+
+} // anonymous namespace
+
+
+
+const char* perfnp::design_name(SampleSettings::Design design)
+{
+    switch (design) {
+    case SampleSettings::Design::Full:
+        return "full";
+    case SampleSettings::Design::Random:
+        return "random";
+    case SampleSettings::Design::LatinHypercube:
+        return "latin_hypercube";
+    case SampleSettings::Design::Sobol:
+        return "sobol";
+    }
+    return "";
+} // design_name
+
+
+
+std::vector<unsigned long long> perfnp::sample_job_indices(const JobSpace& space,
+    const SampleSettings& settings)
+{
+    switch (settings.design) {
+    case SampleSettings::Design::Full:
+        break;
+    case SampleSettings::Design::Random:
+        return random_sample(space, settings.size, settings.seed);
+    case SampleSettings::Design::LatinHypercube:
+        return latin_hypercube_sample(space, settings.size, settings.seed);
+    case SampleSettings::Design::Sobol:
+        return sobol_sample(space, settings.size, settings.seed);
+    }
+
+    std::vector<unsigned long long> all;
+    for (auto i = space.next(0); i < space.size(); i = space.next(i + 1)) {
+        all.push_back(i);
+    }
+    return all;
+} // sample_job_indices
@@ -0,0 +1,80 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_SAMPLE_H_
+#define PERFNP_SAMPLE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+class JobSpace;
+
+/*!
+ * Design of a sample of the jobs, executed instead of all of them.
+ */
+struct SampleSettings {
+
+    //! How are the jobs picked?
+    enum class Design {
+        //! All jobs, no sampling
+        Full,
+
+        //! Uniformly, without replacement
+        Random,
+
+        //! Every parameter covers its values evenly (Latin hypercube)
+        LatinHypercube,
+
+        //! Low-discrepancy Sobol sequence with a random digital shift
+        Sobol
+    };
+
+    //! How are the jobs picked?
+    Design design;
+
+    //! Number of sampled points
+    unsigned long long size;
+
+    //! Seed of the random generator, the same seed gives the same sample
+    std::uint64_t seed;
+
+    //! Sampling is disabled by default
+    SampleSettings()
+    : design(Design::Full)
+    , size(0)
+    , seed(0)
+    {}
+
+    //! Is only a sample executed?
+    bool enabled() const {
+        return design != Design::Full;
+    }
+}; // SampleSettings
+
+//! Name of the design as written in the configuration, e.g. "sobol"
+const char* design_name(SampleSettings::Design design);
+
+/*!
+ * Picks job indices by the design, without enumerating the space.
+ *
+ * Parameters of a zip group are sampled as one dimension. The random
+ * design draws exactly `size` jobs (all of them if there are fewer),
+ * redrawing the combinations excluded by constraints. The Latin
+ * hypercube and Sobol designs keep their structure, so their points
+ * excluded by constraints and repeated points are dropped and the
+ * sample may be smaller. The Sobol design supports at most
+ * 21 dimensions.
+ *
+ * @return sorted distinct job indices
+ * @throw std::runtime_error if the design cannot be used
+ */
+std::vector<unsigned long long> sample_job_indices(const JobSpace& space,
+    const SampleSettings& settings);
+
+} // perfnp
+#endif // PERFNP_SAMPLE_H_
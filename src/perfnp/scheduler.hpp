@@ -10,8 +10,20 @@
 #include "perfnp/dataset.hpp"
 #include "perfnp/config.hpp"
 #include "perfnp/exec.hpp"
+#include "perfnp/interrupt.hpp"
+#include "perfnp/monitor.hpp"
+#include "perfnp/staging.hpp"
+#include "perfnp/trace.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 #include <iostream>
 
@@ -20,27 +32,266 @@ namespace perfnp {
 
 /*!
  * Executes all commands and creates a dataset out of the results.
+ *
+ * The commands are executed by `workers` parallel worker slots,
+ * each slot takes the next command once its job has finished.
+ * The callback is called as `callback(cwa, timeout, result, slot)`
+ * and the calls are serialized, so it does not need any locking.
+ * Results in the dataset are in the order of the commands.
+ *
+ * If there is a tracer, every slot records its jobs, timeouts,
+ * waiting for the callback and the callback itself (e.g. the
+ * database flush). The tracer needs at least `workers` slots.
+ * If there is a monitor, its counters follow the progress live.
+ * If there is a stager, it stages the input files of every job before
+ * the job starts (recorded by the tracer as "staging"), outside of
+ * the measured runtime. If there is a scratch space, every slot runs
+ * its jobs in its own working directory, which is prepared as a part
+ * of the staging too; the callback gets the original commands.
+ * The environment variables of the jobs are added to a copy of the
+ * environment of perfnp, which is made once for all jobs. A scratch
+ * directory replaces the working directory of the job.
+ * If there are CPUs of the slots (see slot_cpus()), the jobs of
+ * every slot are pinned to its CPU.
+ *
+ * If there are any metric patterns, the standard output
+ * of every job is captured and scanned for metrics.
+ *
+ * Once the sweep is interrupted (see \ref InterruptGuard), no new job
+ * starts and the dataset has only the finished jobs. Results of the
+ * jobs killed by the interruption are dropped.
  */
-template<typename ResultCallback>
+template<typename SlotResultCallback>
 Dataset execute_all_runs(
     const std::vector<CmdWithArgs>& commands,
     unsigned timeout,
-    ResultCallback callback)
+    const std::vector<MetricPattern>& metric_patterns,
+    unsigned workers,
+    SlotResultCallback callback,
+    Tracer* tracer = nullptr,
+    SweepMonitor* monitor = nullptr,
+    InputStager* stager = nullptr,
+    ScratchSpace* scratch = nullptr,
+    const std::vector<int>& cpus = std::vector<int>())
 {
-    std::vector<ExecResult> results_all;
+    if (tracer != nullptr && tracer->slots() < workers) {
+        throw std::runtime_error("Tracer has fewer slots than the workers.");
+    }
+    if (!cpus.empty() && cpus.size() < workers) {
+        throw std::runtime_error("Some worker slots have no CPU.");
+    }
+
+    std::vector<ExecResult> results_all(commands.size(), ExecResult(0, 1));
+    std::vector<unsigned> job_indices(commands.size());
+    std::vector<unsigned> slots(commands.size());
+    std::vector<char> finished(commands.size(), 0);
+
+    std::atomic<size_t> next_command(0);
+    std::mutex callback_mutex;
+    std::exception_ptr failure;
+    if (monitor) {
+        monitor->set_planned(commands.size());
+    }
+
+    std::set<std::string> variable_names;
+    for (const auto& cwa : commands) {
+        for (const auto& variable : cwa.environment()) {
+            variable_names.insert(variable.substr(0, variable.find('=')));
+        }
+    }
+    const EnvironmentTemplate environment(
+        std::vector<std::string>(variable_names.begin(), variable_names.end()));
+    const bool set_environment = !variable_names.empty();
+
+    auto work = [&](unsigned slot) {
+        try {
+            for (size_t i = next_command++; i < commands.size(); i = next_command++) {
+                if (interrupt_requested()) {
+                    return;
+                }
+                const auto& cwa = commands.at(i);
+                std::unique_ptr<CmdWithArgs> prepared;
+                if (stager || scratch) {
+                    const auto staging_start = tracer ? tracer->now_us() : 0;
+                    if (stager) {
+                        stager->before_job(i);
+                    }
+                    if (scratch) {
+                        prepared.reset(new CmdWithArgs(scratch->prepare(slot, cwa)));
+                    }
+                    if (tracer) {
+                        tracer->complete(slot, "staging", staging_start, cwa.job_index());
+                    }
+                }
+                const auto& executed = prepared ? *prepared : cwa;
+                const auto job_start = tracer ? tracer->now_us() : 0;
+
+                ExecBin my_exec(executed.command(), executed.arguments(), timeout);
+                if (set_environment) {
+                    my_exec.set_environment(environment.envp(executed.environment()));
+                }
+                if (!cpus.empty()) {
+                    my_exec.set_cpu(cpus[slot]);
+                }
+                if (scratch) {
+                    my_exec.set_working_directory(scratch->directory(slot));
+                } else if (!executed.working_directory().empty()) {
+                    my_exec.set_working_directory(executed.working_directory());
+                }
+                if (!metric_patterns.empty()) {
+                    my_exec.set_metric_patterns(metric_patterns);
+                }
+                std::int64_t spawn_latency_us = 0;
+                if (monitor) {
+                    my_exec.set_spawn_latency_output(&spawn_latency_us);
+                    monitor->job_started();
+                }
+                ExecResult my_result = my_exec.execute();
+                if (stager) {
+                    stager->after_job(i);
+                }
+                if (scratch) {
+                    scratch->finish(slot, cwa);
+                }
+                if (interrupt_killed_jobs()) {
+                    if (monitor) {
+                        monitor->job_abandoned();
+                    }
+                    return;
+                }
+                if (monitor) {
+                    monitor->job_finished(my_result, timeout, spawn_latency_us);
+                    monitor->result_queued();
+                }
+
+                if (tracer) {
+                    tracer->complete(slot, "job", job_start,
+                        cwa.job_index(), my_result.exit_code());
+                    if (my_result.exit_code() != 0 && my_result.runtime() >= timeout) {
+                        tracer->instant(slot, "timeout", cwa.job_index());
+                    }
+                }
+
+                const auto wait_start = tracer ? tracer->now_us() : 0;
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                if (failure) {
+                    return;
+                }
+                if (tracer) {
+                    tracer->complete(slot, "writer wait", wait_start, cwa.job_index());
+                }
 
-    for (size_t i=0; i < commands.size(); i++) {
-        const auto& cwa = commands.at(i);
+                const auto flush_start = tracer ? tracer->now_us() : 0;
+                callback(cwa, timeout, my_result, slot);
+                if (tracer) {
+                    tracer->complete(slot, "db flush", flush_start, cwa.job_index());
+                }
+                if (monitor) {
+                    monitor->result_written();
+                }
 
-        ExecBin my_exec(cwa.command(), cwa.arguments(), timeout);
-        ExecResult my_result = my_exec.execute();
+                results_all[i] = std::move(my_result);
+                job_indices[i] = cwa.job_index();
+                slots[i] = slot;
+                finished[i] = 1;
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            next_command = commands.size();
+        }
+    };
+
+    if (workers == 0) {
+        workers = 1;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned slot = 1; slot < workers && slot < commands.size(); ++slot) {
+        threads.emplace_back(work, slot);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // An interrupted sweep keeps the finished jobs only
+    if (std::find(finished.begin(), finished.end(), 0) != finished.end()) {
+        size_t kept = 0;
+        for (size_t i = 0; i < commands.size(); ++i) {
+            if (finished[i]) {
+                results_all[kept] = std::move(results_all[i]);
+                job_indices[kept] = job_indices[i];
+                slots[kept] = slots[i];
+                ++kept;
+            }
+        }
+        results_all.erase(results_all.begin() + kept, results_all.end());
+        job_indices.resize(kept);
+        slots.resize(kept);
+    }
+
+    return Dataset(timeout, std::move(results_all),
+        std::move(job_indices), std::move(slots));
+} // execute_all_runs
+
+
+
+/*!
+ * Calls the wrapped callback without the worker slot.
+ */
+template<typename ResultCallback>
+class IgnoreSlot {
+    ResultCallback m_callback;
 
-        callback(cwa, timeout, my_result);
+public:
+    explicit IgnoreSlot(ResultCallback callback)
+    : m_callback(callback)
+    {}
 
-        results_all.push_back(my_result);
+    void operator()(const CmdWithArgs& cwa, unsigned timeout,
+        ExecResult result, unsigned)
+    {
+        m_callback(cwa, timeout, std::move(result));
     }
+}; // IgnoreSlot
+
+
+
+/*!
+ * Executes all commands one by one and creates a dataset out of the results.
+ *
+ * If there are any metric patterns, the standard output
+ * of every job is captured and scanned for metrics.
+ */
+template<typename ResultCallback>
+Dataset execute_all_runs(
+    const std::vector<CmdWithArgs>& commands,
+    unsigned timeout,
+    const std::vector<MetricPattern>& metric_patterns,
+    ResultCallback callback)
+{
+    return execute_all_runs<>(commands, timeout, metric_patterns, 1,
+        IgnoreSlot<ResultCallback>(callback));
+} // execute_all_runs
+
 
-    return Dataset(timeout, results_all);
+
+/*!
+ * Executes all commands and creates a dataset out of the results.
+ */
+template<typename ResultCallback>
+Dataset execute_all_runs(
+    const std::vector<CmdWithArgs>& commands,
+    unsigned timeout,
+    ResultCallback callback)
+{
+    return execute_all_runs<>(commands, timeout,
+        std::vector<MetricPattern>(), callback);
 } // execute_all_runs
 
 
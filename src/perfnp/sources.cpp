@@ -0,0 +1,324 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/sources.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+using namespace perfnp;
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+    //! Does the segment contain any wildcard?
+    bool has_wildcard(const std::string& segment)
+    {
+        return segment.find_first_of("*?[") != std::string::npos;
+    } // has_wildcard
+
+    //! Joins a directory and a name, "" is the working directory
+    std::string join(const std::string& directory, const std::string& name)
+    {
+        if (directory.empty()) {
+            return name;
+        }
+        if (directory.back() == '/') {
+            return directory + name;
+        }
+        return directory + "/" + name;
+    } // join
+
+    //! Is the entry a directory? Avoids stat() if the type is known.
+    bool is_directory(const dirent* entry, const std::string& path,
+        bool follow_links)
+    {
+#if defined(DT_DIR)
+        if (entry->d_type == DT_DIR) {
+            return true;
+        }
+        if (entry->d_type != DT_UNKNOWN
+                && !(follow_links && entry->d_type == DT_LNK)) {
+            return false;
+        }
+#endif
+        struct stat info;
+        int status = follow_links ? stat(path.c_str(), &info)
+            : lstat(path.c_str(), &info);
+        return status == 0 && S_ISDIR(info.st_mode);
+    } // is_directory
+
+    //! Directory, where the rest of the pattern is matched
+    struct GlobTask {
+        std::string directory;
+        std::size_t segment;
+    };
+
+    /*!
+     * Pattern matched by several threads.
+     *
+     * Every task lists one directory and matches one segment
+     * of the pattern. Subdirectories become new tasks, so large
+     * trees are spread over all threads.
+     */
+    class GlobWalk {
+
+        //! Segments of the pattern after the literal prefix
+        const std::vector<std::string>& m_segments;
+
+        //! Directories waiting to be listed
+        std::deque<GlobTask> m_tasks;
+
+        //! Number of tasks being processed
+        unsigned m_busy;
+
+        //! Matches found by all threads
+        std::vector<std::string> m_matches;
+
+        //! The first error, which stops the walk
+        std::exception_ptr m_failure;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+
+        //! Lists a directory, returns new tasks and matches
+        void process(const GlobTask& task, std::vector<GlobTask>& tasks,
+            std::vector<std::string>& matches)
+        {
+            const auto& segment = m_segments[task.segment];
+            const bool last = task.segment + 1 == m_segments.size();
+            const bool recursive = segment == "**";
+
+            // `**` also matches no directory at all
+            if (recursive && !last) {
+                tasks.push_back(GlobTask{ task.directory, task.segment + 1 });
+            }
+
+            const std::string directory = task.directory.empty() ? "." : task.directory;
+            DIR* dir = opendir(directory.c_str());
+            if (dir == nullptr) {
+                if (errno == ENOENT || errno == ENOTDIR) {
+                    return;
+                }
+                throw std::runtime_error("Cannot read the directory '"
+                    + directory + "': " + std::strerror(errno));
+            }
+            std::unique_ptr<DIR, int (*)(DIR*)> dir_guard(dir, closedir);
+
+            while (dirent* entry = readdir(dir)) {
+                const char* name = entry->d_name;
+                if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+                    continue;
+                }
+
+                const auto path = join(task.directory, name);
+                if (recursive) {
+                    // Hidden entries are matched by explicit patterns only
+                    if (name[0] == '.') {
+                        continue;
+                    }
+                    if (is_directory(entry, path, false)) {
+                        tasks.push_back(GlobTask{ path, task.segment });
+                    }
+                    continue;
+                }
+
+                if (fnmatch(segment.c_str(), name, FNM_PERIOD) != 0) {
+                    continue;
+                }
+                if (last) {
+                    matches.push_back(path);
+                    continue;
+                }
+                if (is_directory(entry, path, true)) {
+                    tasks.push_back(GlobTask{ path, task.segment + 1 });
+                }
+            }
+        }
+
+    public:
+        explicit GlobWalk(const std::vector<std::string>& segments)
+        : m_segments(segments)
+        , m_busy(0)
+        {}
+
+        //! Walks the tree from the directory by the given number of threads
+        std::vector<std::string> run(const std::string& root, unsigned threads)
+        {
+            m_tasks.push_back(GlobTask{ root, 0 });
+
+            std::vector<std::thread> workers;
+            for (unsigned i = 1; i < threads; ++i) {
+                workers.emplace_back(&GlobWalk::work, this);
+            }
+            work();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            if (m_failure) {
+                std::rethrow_exception(m_failure);
+            }
+            return std::move(m_matches);
+        }
+
+        //! Takes tasks until there are none and no thread can add any
+        void work()
+        {
+            std::vector<GlobTask> tasks;
+            std::vector<std::string> matches;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;) {
+                m_wakeup.wait(lock, [this] {
+                    return !m_tasks.empty() || m_busy == 0 || m_failure;
+                });
+                if (m_tasks.empty() || m_failure) {
+                    break;
+                }
+
+                GlobTask task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                ++m_busy;
+                lock.unlock();
+
+                tasks.clear();
+                try {
+                    process(task, tasks, matches);
+                } catch (...) {
+                    lock.lock();
+                    if (!m_failure) {
+                        m_failure = std::current_exception();
+                    }
+                    --m_busy;
+                    break;
+                }
+
+                lock.lock();
+                for (auto& next : tasks) {
+                    m_tasks.push_back(std::move(next));
+                }
+                --m_busy;
+                m_wakeup.notify_all();
+            }
+
+            m_matches.insert(m_matches.end(),
+                std::make_move_iterator(matches.begin()),
+                std::make_move_iterator(matches.end()));
+            m_wakeup.notify_all();
+        }
+    }; // GlobWalk
+
+} // anonymous namespace
+
+
+
+std::vector<std::string> perfnp::expand_glob(const std::string& pattern,
+    unsigned threads)
+{
+    if (pattern.empty()) {
+        throw std::runtime_error("Glob pattern must not be empty.");
+    }
+
+    // Split the pattern, the literal prefix is the root of the walk
+    std::vector<std::string> segments;
+    std::string root = pattern[0] == '/' ? "/" : "";
+    bool literal = true;
+    size_t begin = 0;
+    while (begin <= pattern.size()) {
+        auto end = pattern.find('/', begin);
+        if (end == std::string::npos) {
+            end = pattern.size();
+        }
+        std::string segment = pattern.substr(begin, end - begin);
+        begin = end + 1;
+        if (segment.empty() || segment == ".") {
+            continue;
+        }
+
+        if (literal && !has_wildcard(segment) && begin <= pattern.size()) {
+            root = join(root, segment);
+        } else {
+            literal = false;
+            segments.push_back(segment);
+        }
+    }
+
+    // A pattern without wildcards matches an existing path
+    if (segments.empty()) {
+        struct stat info;
+        if (stat(root.c_str(), &info) == 0) {
+            return { root };
+        }
+        return {};
+    }
+
+    // A trailing `**` matches everything below
+    if (segments.back() == "**") {
+        segments.push_back("*");
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    GlobWalk walk(segments);
+    auto matches = walk.run(root, threads);
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    return matches;
+} // expand_glob
+#endif
+
+
+
+#if defined(_WIN32)
+std::vector<std::string> perfnp::expand_glob(const std::string&, unsigned)
+{
+    throw std::runtime_error("Glob patterns are not supported on Windows.");
+} // expand_glob
+#endif
+
+
+
+std::vector<StringArena::Id> perfnp::read_manifest(const std::string& filename,
+    StringArena& arena)
+{
+    std::ifstream input(filename);
+    if (!input) {
+        throw std::runtime_error("Cannot read the manifest '" + filename + "'.");
+    }
+
+    std::vector<StringArena::Id> ids;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        ids.push_back(arena.intern(line));
+    }
+    if (input.bad()) {
+        throw std::runtime_error("Cannot read the manifest '" + filename + "'.");
+    }
+    return ids;
+} // read_manifest
@@ -0,0 +1,47 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_SOURCES_H_
+#define PERFNP_SOURCES_H_
+
+#include "perfnp/string_arena.hpp"
+
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Finds all paths matching a glob pattern.
+ *
+ * Segments of the pattern (separated by '/') may contain `*`, `?`
+ * and `[...]`, which never match '/' nor a leading dot. A segment
+ * `**` matches any number of directories, including none; symbolic
+ * links to directories are not followed by `**`. Relative patterns
+ * are relative to the working directory.
+ *
+ * Directories are walked by several threads in parallel. The paths
+ * are sorted, so that the job indices do not depend on the walk.
+ * Supported on POSIX only.
+ *
+ * @param threads number of walking threads, 0 for the number of cores
+ * @throw std::runtime_error if a directory cannot be read
+ */
+std::vector<std::string> expand_glob(const std::string& pattern,
+    unsigned threads = 0);
+
+/*!
+ * Interns the lines of a manifest file, one value per line.
+ *
+ * Empty lines and lines starting with '#' are skipped,
+ * line endings of both Unix and Windows are accepted.
+ *
+ * @throw std::runtime_error if the file cannot be read
+ */
+std::vector<StringArena::Id> read_manifest(const std::string& filename,
+    StringArena& arena);
+
+} // perfnp
+#endif // PERFNP_SOURCES_H_
@@ -1,6 +1,7 @@
 #include <cstdio>
 #include <stdint.h>
 #include "perfnp/sql_database.hpp"
+#include "perfnp/cache.hpp"
 #include "perfnp/tools.hpp"
 #include <string>
 #include "base64.h"
@@ -11,6 +12,7 @@
 #include <iomanip>
 #include <vector>
 #include<algorithm>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace perfnp;
@@ -19,6 +21,123 @@ using namespace std;
 namespace perfnp {
 
 
+namespace {
+
+    //! Adds a column to a table created by an older version of perfnp
+    void add_column_if_missing(SQLite::Database& db, const std::string& table,
+        const std::string& column, const std::string& definition)
+    {
+        SQLite::Statement query(db, "PRAGMA table_info(" + table + ")");
+        while (query.executeStep()) {
+            if (query.getColumn(1).getString() == column) {
+                return;
+            }
+        }
+        db.exec("ALTER TABLE " + table + " ADD COLUMN " + column + " " + definition);
+    } // add_column_if_missing
+
+    //! Columns of a table in the given schema, e.g. "main" or "shard"
+    std::vector<std::string> columns_of(SQLite::Database& db,
+        const std::string& schema, const std::string& table)
+    {
+        std::vector<std::string> columns;
+        SQLite::Statement query(db, "PRAGMA " + schema + ".table_info(" + table + ")");
+        while (query.executeStep()) {
+            columns.push_back(query.getColumn(1).getString());
+        }
+        return columns;
+    } // columns_of
+
+    /*!
+     * Copies a table of the attached database `shard` by a single
+     * INSERT ... SELECT, shifting the run and job IDs by the offsets.
+     *
+     * Only the columns present in both databases are copied,
+     * so shards written by an older version can be merged too.
+     */
+    void copy_shifted_table(SQLite::Database& db, const std::string& table,
+        long long run_offset, long long job_offset)
+    {
+        auto target = columns_of(db, "main", table);
+        auto source = columns_of(db, "shard", table);
+
+        std::string columns;
+        std::string values;
+        for (const auto& column : source) {
+            if (std::find(target.begin(), target.end(), column) == target.end()) {
+                continue;
+            }
+            columns += (columns.empty() ? "" : ", ") + column;
+            values += values.empty() ? "" : ", ";
+            if (column == "run_id") {
+                values += "run_id + " + std::to_string(run_offset);
+            } else if (column == "job_id" || column == "cached_from") {
+                values += column + " + " + std::to_string(job_offset);
+            } else {
+                values += column;
+            }
+        }
+        if (columns.empty()) {
+            return;
+        }
+        db.exec("INSERT INTO main." + table + " (" + columns + ") SELECT "
+            + values + " FROM shard." + table);
+    } // copy_shifted_table
+
+    std::string convert_to_base64(std::string data);
+
+    //! Inserts the environment variables of the job
+    void insert_environment(SQLite::Statement& statement,
+        long long job_id, const CmdWithArgs& cwa)
+    {
+        for (const auto& variable : cwa.environment()) {
+            const auto equals = variable.find('=');
+            statement.bind(1, job_id);
+            statement.bind(2, variable.substr(0, equals));
+            statement.bind(3, equals == std::string::npos
+                ? std::string() : variable.substr(equals + 1));
+            statement.exec();
+            statement.reset();
+        }
+    } // insert_environment
+
+    //! Runs the statement with the given run IDs bound to its parameters
+    void exec_for_runs(SQLite::Database& db, const char* sql,
+        long long run_a, long long run_b)
+    {
+        SQLite::Statement statement(db, sql);
+        statement.bind(1, run_a);
+        statement.bind(2, run_b);
+        statement.exec();
+    } // exec_for_runs
+
+    //! Loads the metrics and the trajectory of a saved job
+    void load_output(SQLite::Statement& metric_query,
+        SQLite::Statement& trajectory_query, long long job_id,
+        std::vector<MetricValue>& metrics, Trajectory& trajectory)
+    {
+        metric_query.bind(1, job_id);
+        while (metric_query.executeStep()) {
+            metrics.emplace_back(metric_query.getColumn(0).getString(),
+                metric_query.getColumn(1).getDouble());
+        }
+        metric_query.reset();
+
+        trajectory_query.bind(1, job_id);
+        if (trajectory_query.executeStep()) {
+            auto points = trajectory_query.getColumn(1);
+            trajectory = Trajectory::from_blob(
+                trajectory_query.getColumn(0).getInt() != 0,
+                std::string(static_cast<const char*>(points.getBlob()),
+                    static_cast<size_t>(points.getBytes())));
+        }
+        trajectory_query.reset();
+    } // load_output
+
+} // anonymous namespace
+
+
+
 sql_database::sql_database(const std::string& database_filename)
 : m_db(database_filename, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
 {
@@ -29,6 +148,15 @@ sql_database::sql_database(const std::string& database_filename)
         );
     }
 
+    add_column_if_missing(m_db, "run", "calibration_cv", "REAL");
+    add_column_if_missing(m_db, "run", "calibration_min_speed", "REAL");
+    add_column_if_missing(m_db, "run", "sample_design", "TEXT");
+    add_column_if_missing(m_db, "run", "sample_size", "INTEGER");
+    add_column_if_missing(m_db, "run", "sample_seed", "INTEGER");
+    add_column_if_missing(m_db, "run", "status", "TEXT");
+    add_column_if_missing(m_db, "run", "host", "TEXT");
+    add_column_if_missing(m_db, "run", "job_space", "TEXT");
+
     if (!m_db.tableExists("job")) {
         m_db.exec("CREATE TABLE job ("
             "job_id INTEGER PRIMARY KEY, "
@@ -41,6 +169,13 @@ sql_database::sql_database(const std::string& database_filename)
         );
     }
 
+    add_column_if_missing(m_db, "job", "slot", "INTEGER NOT NULL DEFAULT 0");
+    add_column_if_missing(m_db, "job", "cache_key", "TEXT");
+    add_column_if_missing(m_db, "job", "cached_from", "INTEGER");
+    add_column_if_missing(m_db, "job", "working_directory", "TEXT");
+    m_db.exec("CREATE INDEX IF NOT EXISTS job_by_run ON job(run_id)");
+    m_db.exec("CREATE INDEX IF NOT EXISTS job_by_cache_key ON job(cache_key)");
+
     if (!m_db.tableExists("command")) {
         m_db.exec("CREATE TABLE command ("
             "job_id INTEGER NOT NULL UNIQUE, "
@@ -57,19 +192,140 @@ sql_database::sql_database(const std::string& database_filename)
             "FOREIGN KEY(run_id) REFERENCES run(run_id))"
         );
     }
+
+    if (!m_db.tableExists("job_metric")) {
+        m_db.exec("CREATE TABLE job_metric ("
+            "job_id INTEGER NOT NULL, "
+            "name TEXT NOT NULL, "
+            "value REAL NOT NULL, "
+            "FOREIGN KEY(job_id) REFERENCES job(job_id))"
+        );
+    }
+    m_db.exec("CREATE INDEX IF NOT EXISTS job_metric_by_job ON job_metric(job_id)");
+
+    if (!m_db.tableExists("job_environment")) {
+        m_db.exec("CREATE TABLE job_environment ("
+            "job_id INTEGER NOT NULL, "
+            "name TEXT NOT NULL, "
+            "value TEXT NOT NULL, "
+            "FOREIGN KEY(job_id) REFERENCES job(job_id))"
+        );
+    }
+    m_db.exec("CREATE INDEX IF NOT EXISTS job_environment_by_job ON job_environment(job_id)");
+
+    if (!m_db.tableExists("job_trajectory")) {
+        m_db.exec("CREATE TABLE job_trajectory ("
+            "job_id INTEGER NOT NULL UNIQUE, "
+            "minimize INTEGER NOT NULL, "
+            "points BLOB NOT NULL, "
+            "FOREIGN KEY(job_id) REFERENCES job(job_id))"
+        );
+    }
+
+    if (!m_db.tableExists("calibration")) {
+        m_db.exec("CREATE TABLE calibration ("
+            "run_id INTEGER NOT NULL, "
+            "slot INTEGER NOT NULL, "
+            "cpu_time REAL NOT NULL, "
+            "memory_time REAL NOT NULL, "
+            "cv REAL NOT NULL, "
+            "relative_speed REAL NOT NULL, "
+            "FOREIGN KEY(run_id) REFERENCES run(run_id))"
+        );
+    }
+    add_column_if_missing(m_db, "calibration", "cpu", "INTEGER");
+
+    if (!m_db.tableExists("run_shard")) {
+        m_db.exec("CREATE TABLE run_shard ("
+            "run_id INTEGER NOT NULL, "
+            "shard_index INTEGER NOT NULL, "
+            "shard_count INTEGER NOT NULL, "
+            "policy TEXT NOT NULL, "
+            "FOREIGN KEY(run_id) REFERENCES run(run_id))"
+        );
+    }
+
+    if (!m_db.tableExists("run_pending")) {
+        m_db.exec("CREATE TABLE run_pending ("
+            "run_id INTEGER NOT NULL, "
+            "job_index INTEGER NOT NULL, "
+            "PRIMARY KEY(run_id, job_index), "
+            "FOREIGN KEY(run_id) REFERENCES run(run_id)) WITHOUT ROWID"
+        );
+    }
 }
 
 
 
 long long sql_database::new_run_started() {
-    m_db.exec(std::string("INSERT INTO run "
-        "(run_id, started) VALUES "
-        "(NULL, datetime('now','localtime'))"));
+    SQLite::Statement insert(m_db, "INSERT INTO run "
+        "(run_id, started, status, host) VALUES "
+        "(NULL, datetime('now','localtime'), 'running', ?)");
+    insert.bind(1, host_name());
+    insert.exec();
     return m_db.getLastInsertRowid();
 }
 
 
 
+void sql_database::save_pending_jobs(long long run_id,
+    const std::vector<CmdWithArgs>& jobs)
+{
+    SQLite::Transaction transaction(m_db);
+    SQLite::Statement insert(m_db,
+        "INSERT OR IGNORE INTO run_pending (run_id, job_index) VALUES (?, ?)");
+    for (const auto& job : jobs) {
+        insert.bind(1, run_id);
+        insert.bind(2, job.job_index());
+        insert.exec();
+        insert.reset();
+    }
+    transaction.commit();
+} // save_pending_jobs
+
+
+
+long long sql_database::unfinished_run(const Config& config)
+{
+    SQLite::Statement query(m_db,
+        "SELECT run.run_id FROM run JOIN image ON image.run_id = run.run_id"
+        " WHERE run.status IN ('running', 'interrupted')"
+        " AND image.config_file = ?"
+        " ORDER BY run.run_id DESC LIMIT 1");
+    query.bind(1, convert_to_base64(config.to_string()));
+    if (!query.executeStep()) {
+        return 0;
+    }
+    return query.getColumn(0).getInt64();
+} // unfinished_run
+
+
+
+std::vector<unsigned> sql_database::pending_jobs(long long run_id)
+{
+    std::vector<unsigned> indices;
+    SQLite::Statement query(m_db,
+        "SELECT job_index FROM run_pending WHERE run_id = ? ORDER BY job_index");
+    query.bind(1, run_id);
+    while (query.executeStep()) {
+        indices.push_back(query.getColumn(0).getUInt());
+    }
+    return indices;
+} // pending_jobs
+
+
+
+void sql_database::set_run_status(long long run_id, RunStatus status)
+{
+    SQLite::Statement update(m_db, "UPDATE run SET status = ? WHERE run_id = ?");
+    update.bind(1, status == RunStatus::Running ? "running"
+        : status == RunStatus::Interrupted ? "interrupted" : "finished");
+    update.bind(2, run_id);
+    update.exec();
+} // set_run_status
+
+
+
 std::time_t sql_database::get_time_run_started(long long run_id)
 {
 
@@ -80,14 +336,15 @@ std::time_t sql_database::get_time_run_started(long long run_id)
         throw runtime_error("Requested run is not present in the database");
     }
 
-    std::tm parsed_date_time;
+    std::tm parsed_date_time{};
+    parsed_date_time.tm_isdst = -1;
     {
         std::stringstream stream(query.getColumn("started").getString());
         stream >> std::get_time(&parsed_date_time, "%Y-%m-%d %H:%M:%S");
     }
 
-    std::size_t out = std::mktime(&parsed_date_time);
-    if (out < 0) {
+    std::time_t out = std::mktime(&parsed_date_time);
+    if (out == static_cast<std::time_t>(-1)) {
         throw runtime_error("Started time in the 'run' table has a wrong format.");
     }
 
@@ -180,18 +437,29 @@ void sql_database::remove_finished_jobs(
 }
 
 long long sql_database::on_job_finished(long long run_id,
-    const CmdWithArgs& cwa, unsigned timeout, ExecResult result)
+    const CmdWithArgs& cwa, unsigned timeout, ExecResult result, unsigned slot,
+    const std::string& cache_key)
 {
+    // The job is saved completely or not at all
+    SQLite::Transaction transaction(m_db);
+
     // 1) Insert job
-    std::string output_jobs_info = std::string("INSERT INTO job VALUES (")
-        + "NULL,"
-        + std::to_string(run_id) + ", "
-        + std::to_string(cwa.job_index()) + ", "
-        + std::to_string(timeout) + ", "
-        + std::to_string(result.exit_code()) + ", "
-        + std::to_string(result.runtime()) + ")";
-
-    m_db.exec(output_jobs_info);
+    SQLite::Statement job_stmt(m_db, "INSERT INTO job"
+        " (job_id, run_id, job_index, timeout, exit_code, runtime, slot, cache_key,"
+        " working_directory) VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?)");
+    job_stmt.bind(1, run_id);
+    job_stmt.bind(2, cwa.job_index());
+    job_stmt.bind(3, timeout);
+    job_stmt.bind(4, result.exit_code());
+    job_stmt.bind(5, result.runtime());
+    job_stmt.bind(6, slot);
+    if (!cache_key.empty()) {
+        job_stmt.bind(7, cache_key);
+    }
+    if (!cwa.working_directory().empty()) {
+        job_stmt.bind(8, cwa.working_directory());
+    }
+    job_stmt.exec();
     long long run_primary_key = m_db.getLastInsertRowid();
 
     // 2) Insert command ID
@@ -200,11 +468,260 @@ long long sql_database::on_job_finished(long long run_id,
     commands_stmt.bind(2, cwa.escape_for_native_shell());
     commands_stmt.exec();
 
+    // 3) Insert metrics extracted from the output
+    if (!result.metrics().empty()) {
+        SQLite::Statement metric_stmt(m_db, "INSERT INTO job_metric VALUES (?,?,?)");
+        for (const auto& metric : result.metrics()) {
+            metric_stmt.bind(1, run_primary_key);
+            metric_stmt.bind(2, metric.name());
+            metric_stmt.bind(3, metric.value());
+            metric_stmt.exec();
+            metric_stmt.reset();
+        }
+    }
+
+    // 4) Insert the trajectory of incumbents
+    if (!result.trajectory().empty()) {
+        std::string blob = result.trajectory().to_blob();
+        SQLite::Statement trajectory_stmt(m_db, "INSERT INTO job_trajectory VALUES (?,?,?)");
+        trajectory_stmt.bind(1, run_primary_key);
+        trajectory_stmt.bind(2, result.trajectory().minimize() ? 1 : 0);
+        trajectory_stmt.bind(3, blob.data(), static_cast<int>(blob.size()));
+        trajectory_stmt.exec();
+    }
+
+    // 5) Insert the environment variables set by the job
+    if (!cwa.environment().empty()) {
+        SQLite::Statement environment_stmt(m_db,
+            "INSERT INTO job_environment VALUES (?,?,?)");
+        insert_environment(environment_stmt, run_primary_key, cwa);
+    }
+
+    // 6) The job is no longer pending
+    SQLite::Statement pending_stmt(m_db,
+        "DELETE FROM run_pending WHERE run_id = ? AND job_index = ?");
+    pending_stmt.bind(1, run_id);
+    pending_stmt.bind(2, cwa.job_index());
+    pending_stmt.exec();
+
+    transaction.commit();
     return run_primary_key;
 } // on_job_finished
 
 
 
+Dataset sql_database::reuse_cached_results(long long run_id,
+    std::vector<CmdWithArgs>& jobs,
+    const std::unordered_map<unsigned, std::string>& cache_keys,
+    unsigned timeout, const std::string& host)
+{
+    // Identical jobs of the sweep (e.g. repetitions) share their key
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, std::vector<size_t>> jobs_by_key;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        auto key = cache_keys.find(jobs[i].job_index());
+        if (key == cache_keys.end()) {
+            continue;
+        }
+        auto& group = jobs_by_key[key->second];
+        if (group.empty()) {
+            keys.push_back(key->second);
+        }
+        group.push_back(i);
+    }
+
+    // Copies are never reused again, every result is counted once
+    SQLite::Statement lookup(m_db,
+        "SELECT job.job_id, job.exit_code, job.runtime, job.slot"
+        " FROM job JOIN run ON run.run_id = job.run_id"
+        " WHERE job.cache_key = ? AND job.cached_from IS NULL"
+        " AND job.run_id != ? AND (? = '' OR run.host = ?)"
+        " ORDER BY job.job_id DESC LIMIT ?");
+    SQLite::Statement metric_query(m_db,
+        "SELECT name, value FROM job_metric WHERE job_id = ? ORDER BY rowid");
+    SQLite::Statement trajectory_query(m_db,
+        "SELECT minimize, points FROM job_trajectory WHERE job_id = ?");
+
+    SQLite::Statement job_stmt(m_db, "INSERT INTO job"
+        " (job_id, run_id, job_index, timeout, exit_code, runtime, slot,"
+        " cache_key, cached_from, working_directory)"
+        " VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    SQLite::Statement command_stmt(m_db, "INSERT INTO command VALUES (?,?)");
+    SQLite::Statement metric_stmt(m_db, "INSERT INTO job_metric"
+        " SELECT ?, name, value FROM job_metric WHERE job_id = ? ORDER BY rowid");
+    SQLite::Statement trajectory_stmt(m_db, "INSERT INTO job_trajectory"
+        " SELECT ?, minimize, points FROM job_trajectory WHERE job_id = ?");
+    SQLite::Statement environment_stmt(m_db, "INSERT INTO job_environment VALUES (?,?,?)");
+    SQLite::Statement pending_stmt(m_db,
+        "DELETE FROM run_pending WHERE run_id = ? AND job_index = ?");
+
+    std::vector<ExecResult> results;
+    std::vector<unsigned> job_indices;
+    std::vector<unsigned> slots;
+    std::vector<bool> reused(jobs.size(), false);
+
+    SQLite::Transaction transaction(m_db);
+    for (const auto& key : keys) {
+        const auto& group = jobs_by_key[key];
+        lookup.bind(1, key);
+        lookup.bind(2, run_id);
+        lookup.bind(3, host);
+        lookup.bind(4, host);
+        lookup.bind(5, static_cast<long long>(group.size()));
+
+        for (size_t i = 0; i < group.size() && lookup.executeStep(); ++i) {
+            const auto& cwa = jobs[group[i]];
+            long long cached_job = lookup.getColumn(0).getInt64();
+            int exit_code = lookup.getColumn(1).getInt();
+            unsigned runtime = lookup.getColumn(2).getUInt();
+            unsigned slot = lookup.getColumn(3).getUInt();
+
+            std::vector<MetricValue> metrics;
+            Trajectory trajectory;
+            load_output(metric_query, trajectory_query, cached_job,
+                metrics, trajectory);
+
+            // The copy makes the new run complete on its own
+            job_stmt.bind(1, run_id);
+            job_stmt.bind(2, cwa.job_index());
+            job_stmt.bind(3, timeout);
+            job_stmt.bind(4, exit_code);
+            job_stmt.bind(5, runtime);
+            job_stmt.bind(6, slot);
+            job_stmt.bind(7, key);
+            job_stmt.bind(8, cached_job);
+            if (!cwa.working_directory().empty()) {
+                job_stmt.bind(9, cwa.working_directory());
+            } else {
+                job_stmt.bind(9);
+            }
+            job_stmt.exec();
+            job_stmt.reset();
+            long long job_id = m_db.getLastInsertRowid();
+
+            command_stmt.bind(1, job_id);
+            command_stmt.bind(2, cwa.escape_for_native_shell());
+            command_stmt.exec();
+            command_stmt.reset();
+
+            for (auto statement : { &metric_stmt, &trajectory_stmt }) {
+                statement->bind(1, job_id);
+                statement->bind(2, cached_job);
+                statement->exec();
+                statement->reset();
+            }
+            insert_environment(environment_stmt, job_id, cwa);
+
+            pending_stmt.bind(1, run_id);
+            pending_stmt.bind(2, cwa.job_index());
+            pending_stmt.exec();
+            pending_stmt.reset();
+
+            results.emplace_back(exit_code, runtime,
+                std::move(metrics), std::move(trajectory));
+            job_indices.push_back(cwa.job_index());
+            slots.push_back(slot);
+            reused[group[i]] = true;
+        }
+        lookup.reset();
+    }
+    transaction.commit();
+
+    size_t kept = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!reused[i]) {
+            if (kept != i) {
+                jobs[kept] = std::move(jobs[i]);
+            }
+            ++kept;
+        }
+    }
+    jobs.erase(jobs.begin() + kept, jobs.end());
+
+    return Dataset(timeout, std::move(results),
+        std::move(job_indices), std::move(slots));
+} // reuse_cached_results
+
+
+
+bool sql_database::has_run(long long run_id)
+{
+    SQLite::Statement query(m_db, "SELECT 1 FROM run WHERE run_id = ?");
+    query.bind(1, run_id);
+    return query.executeStep();
+} // has_run
+
+
+
+Dataset sql_database::load_dataset(long long run_id, bool with_output)
+{
+    SQLite::Statement query(m_db, "SELECT job_index, timeout, exit_code, runtime, slot,"
+        " job_id FROM job WHERE run_id = ? ORDER BY job_id");
+    query.bind(1, run_id);
+    SQLite::Statement metric_query(m_db,
+        "SELECT name, value FROM job_metric WHERE job_id = ? ORDER BY rowid");
+    SQLite::Statement trajectory_query(m_db,
+        "SELECT minimize, points FROM job_trajectory WHERE job_id = ?");
+
+    unsigned timeout = 0;
+    std::vector<ExecResult> results;
+    std::vector<unsigned> job_indices;
+    std::vector<unsigned> slots;
+    while (query.executeStep()) {
+        job_indices.push_back(query.getColumn(0).getUInt());
+        timeout = std::max(timeout, query.getColumn(1).getUInt());
+        std::vector<MetricValue> metrics;
+        Trajectory trajectory;
+        if (with_output) {
+            load_output(metric_query, trajectory_query,
+                query.getColumn(5).getInt64(), metrics, trajectory);
+        }
+        results.emplace_back(query.getColumn(2).getInt(), query.getColumn(3).getUInt(),
+            std::move(metrics), std::move(trajectory));
+        slots.push_back(query.getColumn(4).getUInt());
+    }
+    return Dataset(timeout, std::move(results),
+        std::move(job_indices), std::move(slots));
+} // load_dataset
+
+
+
+void sql_database::save_calibration(long long run_id, const Calibration& calibration)
+{
+    SQLite::Transaction transaction(m_db);
+
+    SQLite::Statement run_stmt(m_db, "UPDATE run SET calibration_cv = ?,"
+        " calibration_min_speed = ? WHERE run_id = ?");
+    run_stmt.bind(1, calibration.cv());
+    run_stmt.bind(2, calibration.min_relative_speed());
+    run_stmt.bind(3, run_id);
+    run_stmt.exec();
+
+    SQLite::Statement slot_stmt(m_db, "INSERT INTO calibration"
+        " (run_id, slot, cpu_time, memory_time, cv, relative_speed, cpu)"
+        " VALUES (?,?,?,?,?,?,?)");
+    for (size_t slot = 0; slot < calibration.slots.size(); ++slot) {
+        const auto& measured = calibration.slots[slot];
+        slot_stmt.bind(1, run_id);
+        slot_stmt.bind(2, static_cast<int>(slot));
+        slot_stmt.bind(3, measured.cpu_time);
+        slot_stmt.bind(4, measured.memory_time);
+        slot_stmt.bind(5, measured.cv);
+        slot_stmt.bind(6, measured.relative_speed);
+        if (measured.cpu >= 0) {
+            slot_stmt.bind(7, measured.cpu);
+        } else {
+            slot_stmt.bind(7);
+        }
+        slot_stmt.exec();
+        slot_stmt.reset();
+    }
+
+    transaction.commit();
+} // save_calibration
+
+
+
 void sql_database::read()
 {
     SQLite::Statement m_query1(m_db, "SELECT * FROM `jobs_info`");
@@ -218,3 +735,160 @@ void sql_database::read()
 }
 
 } // perfnp namespace
+
+
+
+void sql_database::save_sample(long long run_id, const SampleSettings& sample)
+{
+    SQLite::Statement run_stmt(m_db, "UPDATE run SET sample_design = ?,"
+        " sample_size = ?, sample_seed = ? WHERE run_id = ?");
+    run_stmt.bind(1, design_name(sample.design));
+    run_stmt.bind(2, static_cast<long long>(sample.size));
+    // SQLite integers are signed, the seed keeps its 64 bits
+    run_stmt.bind(3, static_cast<long long>(sample.seed));
+    run_stmt.bind(4, run_id);
+    run_stmt.exec();
+} // save_sample
+
+
+
+void sql_database::save_shard(long long run_id, const Shard& shard)
+{
+    SQLite::Statement shard_stmt(m_db, "INSERT INTO run_shard VALUES (?,?,?,?)");
+    shard_stmt.bind(1, run_id);
+    shard_stmt.bind(2, shard.index);
+    shard_stmt.bind(3, shard.count);
+    shard_stmt.bind(4, shard.policy == Shard::Policy::Hashed ? "hashed" : "strided");
+    shard_stmt.exec();
+} // save_shard
+
+
+
+void sql_database::save_job_space(long long run_id, const JobSpace& space)
+{
+    SQLite::Statement run_stmt(m_db, "UPDATE run SET job_space = ? WHERE run_id = ?");
+    run_stmt.bind(1, space.digest());
+    run_stmt.bind(2, run_id);
+    run_stmt.exec();
+} // save_job_space
+
+
+
+std::string sql_database::job_space(long long run_id)
+{
+    SQLite::Statement query(m_db, "SELECT job_space FROM run WHERE run_id = ?");
+    query.bind(1, run_id);
+    if (!query.executeStep() || query.getColumn(0).isNull()) {
+        return "";
+    }
+    return query.getColumn(0).getString();
+} // job_space
+
+
+
+std::vector<long long> sql_database::merge(const std::string& shard_filename)
+{
+    {
+        // The shard is opened first, so that a missing file is an error
+        SQLite::Database shard(shard_filename, SQLite::OPEN_READONLY);
+    }
+
+    SQLite::Statement attach(m_db, "ATTACH DATABASE ? AS shard");
+    attach.bind(1, shard_filename);
+    attach.exec();
+
+    std::vector<long long> merged;
+    try {
+        SQLite::Transaction transaction(m_db);
+
+        SQLite::Statement offsets(m_db, "SELECT"
+            " (SELECT COALESCE(MAX(run_id), 0) FROM main.run),"
+            " (SELECT COALESCE(MAX(job_id), 0) FROM main.job)");
+        offsets.executeStep();
+        const long long run_offset = offsets.getColumn(0).getInt64();
+        const long long job_offset = offsets.getColumn(1).getInt64();
+
+        for (const char* table : { "run", "job", "command", "image", "job_metric",
+                "job_environment", "job_trajectory", "calibration", "run_shard", "run_pending" }) {
+            SQLite::Statement exists(m_db, "SELECT 1 FROM shard.sqlite_master"
+                " WHERE type = 'table' AND name = ?");
+            exists.bind(1, table);
+            if (exists.executeStep()) {
+                copy_shifted_table(m_db, table, run_offset, job_offset);
+            }
+        }
+
+        // Shards of one sweep (the same configuration and number of shards)
+        // are folded into the oldest run which does not have the shard yet
+        SQLite::Statement runs(m_db, "SELECT run_id + ? FROM shard.run ORDER BY run_id");
+        runs.bind(1, run_offset);
+        while (runs.executeStep()) {
+            const long long run_id = runs.getColumn(0).getInt64();
+
+            SQLite::Statement sweep(m_db,
+                "SELECT other.run_id FROM run_shard AS mine"
+                " JOIN image AS mine_image ON mine_image.run_id = mine.run_id"
+                " JOIN run_shard AS other ON other.shard_count = mine.shard_count"
+                    " AND other.policy = mine.policy AND other.run_id < mine.run_id"
+                " JOIN image AS other_image ON other_image.run_id = other.run_id"
+                    " AND other_image.config_file = mine_image.config_file"
+                " WHERE mine.run_id = ? AND mine.shard_count > 1"
+                    " AND NOT EXISTS (SELECT 1 FROM run_shard AS taken"
+                        " WHERE taken.run_id = other.run_id"
+                        " AND taken.shard_index = mine.shard_index)"
+                " ORDER BY other.run_id LIMIT 1");
+            sweep.bind(1, run_id);
+            if (!sweep.executeStep()) {
+                merged.push_back(run_id);
+                continue;
+            }
+
+            const long long into = sweep.getColumn(0).getInt64();
+
+            // Every shard numbers the worker slots of its own host from zero,
+            // so the slots of the folded shard follow those of the run
+            SQLite::Statement next_slot(m_db, "SELECT COALESCE(MAX(slot) + 1, 0) FROM"
+                " (SELECT slot FROM job WHERE run_id = ?1"
+                " UNION ALL SELECT slot FROM calibration WHERE run_id = ?1)");
+            next_slot.bind(1, into);
+            next_slot.executeStep();
+            const long long slot_offset = next_slot.getColumn(0).getInt64();
+            for (const char* table : { "job", "calibration" }) {
+                SQLite::Statement renumber(m_db, std::string("UPDATE ") + table
+                    + " SET run_id = ?, slot = slot + ? WHERE run_id = ?");
+                renumber.bind(1, into);
+                renumber.bind(2, slot_offset);
+                renumber.bind(3, run_id);
+                renumber.exec();
+            }
+            exec_for_runs(m_db, "UPDATE run SET"
+                " calibration_cv = (SELECT MAX(calibration_cv) FROM run WHERE run_id IN (?1, ?2)),"
+                " calibration_min_speed = (SELECT MIN(calibration_min_speed) FROM run"
+                    " WHERE run_id IN (?1, ?2))"
+                " WHERE run_id = ?1", into, run_id);
+            exec_for_runs(m_db, "UPDATE run_shard SET run_id = ? WHERE run_id = ?", into, run_id);
+            exec_for_runs(m_db, "UPDATE run_pending SET run_id = ? WHERE run_id = ?", into, run_id);
+            exec_for_runs(m_db, "UPDATE run SET status = (SELECT status FROM run"
+                " WHERE run_id = ?2) WHERE run_id = ?1 AND status = 'finished'", into, run_id);
+            exec_for_runs(m_db, "UPDATE run SET started = MIN(started,"
+                " (SELECT started FROM run WHERE run_id = ?2)) WHERE run_id = ?1", into, run_id);
+            SQLite::Statement image(m_db, "DELETE FROM image WHERE run_id = ?");
+            image.bind(1, run_id);
+            image.exec();
+            SQLite::Statement run(m_db, "DELETE FROM run WHERE run_id = ?");
+            run.bind(1, run_id);
+            run.exec();
+
+            if (std::find(merged.begin(), merged.end(), into) == merged.end()) {
+                merged.push_back(into);
+            }
+        }
+
+        transaction.commit();
+    } catch (...) {
+        m_db.exec("DETACH DATABASE shard");
+        throw;
+    }
+    m_db.exec("DETACH DATABASE shard");
+    return merged;
+} // merge
@@ -1,22 +1,39 @@
 #ifndef PERFNP_SQL_DATABASE_H_
 #define PERFNP_SQL_DATABASE_H_
 
+#include "perfnp/calibration.hpp"
 #include "perfnp/combin.hpp"
+#include "perfnp/compare.hpp"
 #include "perfnp/exec.hpp"
 #include "perfnp/config.hpp"
+#include "perfnp/dataset.hpp"
 
 #include <SQLiteCpp/SQLiteCpp.h>
 #include <SQLiteCpp/Database.h>
 #include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
 
 #include <ctime>
 #include <string>
+#include <unordered_map>
 #include <iostream>
 #include <fstream>
 
 
 namespace perfnp {
 
+//! State of a run saved in the `run` table
+enum class RunStatus {
+    //! The run is executing, or it has crashed
+    Running,
+
+    //! The run was interrupted by a signal
+    Interrupted,
+
+    //! All jobs of the run have finished
+    Finished
+};
+
 class sql_database {
 
     SQLite::Database m_db;
@@ -25,8 +42,30 @@ public:
     //! Create a new database
     sql_database(const std::string& database_filename);
 
+    //! Creates a new run in the Running state
     long long new_run_started();
 
+    //! Sets the state of the run
+    void set_run_status(long long run_id, RunStatus status);
+
+    /*!
+     * Saves the jobs planned by the run.
+     *
+     * Every job stays pending until on_job_finished() saves it,
+     * so an interrupted or crashed run knows its remaining jobs.
+     */
+    void save_pending_jobs(long long run_id, const std::vector<CmdWithArgs>& jobs);
+
+    /*!
+     * The latest run of the configuration, which has not finished.
+     *
+     * @return ID of the run, 0 if there is none
+     */
+    long long unfinished_run(const Config& config);
+
+    //! Indices of the jobs of the run, which have not finished yet
+    std::vector<unsigned> pending_jobs(long long run_id);
+
     std::time_t get_time_run_started(long long run_id);
 
     void save_config_and_command_read_from_file(
@@ -44,12 +83,111 @@ public:
      *
      * The identity of a job is determined by its index.
      * See \ref CmdWithArgs.run_index().
+     *
+     * Runs saved by perfnp 1.1 and older have no pending jobs, this
+     * method resumes them. Newer runs are resumed by unfinished_run().
      */
     void remove_finished_jobs(std::vector<CmdWithArgs>& jobs, const Config& config);
 
+    /*!
+     * Saves a finished job, which was executed by the given worker slot,
+     * in one transaction.
+     *
+     * @param cache_key key of the job in the result cache (see
+     *        job_cache_key()), the job is never reused if empty
+     */
     long long on_job_finished(long long run_id,
-        const CmdWithArgs& cwa, unsigned timeout, ExecResult result);
+        const CmdWithArgs& cwa, unsigned timeout, ExecResult result,
+        unsigned slot = 0, const std::string& cache_key = std::string());
+
+    /*!
+     * Reuses the results of identical jobs executed by other runs.
+     *
+     * The cached results are found by the index of their cache key,
+     * the newest first. Up to as many results as there are jobs with
+     * the key in `jobs` are reused, so that repetitions of a job are
+     * reused separately. The reused results are copied to the run with
+     * the `cached_from` column pointing to the original job, together
+     * with their metrics and trajectories, and their jobs are no longer
+     * pending. Copies are never reused again.
+     *
+     * @param[in,out] jobs the jobs to execute, the reused ones are removed
+     * @param cache_keys cache key of a job by its index, jobs without
+     *        a key are always executed
+     * @param host reuse only the results of runs on this host,
+     *        the results of any host if empty
+     * @return the reused results with the job indices and the slots
+     */
+    Dataset reuse_cached_results(long long run_id,
+        std::vector<CmdWithArgs>& jobs,
+        const std::unordered_map<unsigned, std::string>& cache_keys,
+        unsigned timeout, const std::string& host);
+
+    //! Saves the machine noise measured before the run
+    void save_calibration(long long run_id, const Calibration& calibration);
+
+    //! Saves the design and the seed of the sampled jobs of the run
+    void save_sample(long long run_id, const SampleSettings& sample);
 
+    //! Saves the shard of the sweep executed by the run
+    void save_shard(long long run_id, const Shard& shard);
+
+    //! Saves what the job indices of the run mean, see JobSpace::digest()
+    void save_job_space(long long run_id, const JobSpace& space);
+
+    //! Digest of the job space of the run, empty if it was not saved
+    std::string job_space(long long run_id);
+
+    /*!
+     * Copies all runs of another database into this one.
+     *
+     * The tables are copied in bulk from the attached database, the run
+     * and job IDs are shifted after the largest IDs of this database.
+     * A run of a shard is folded into an earlier run of another shard
+     * of the same sweep (the same configuration, number of shards and
+     * policy), so that the merged shards form a single run.
+     *
+     * @return IDs of the runs which got new jobs
+     * @throw SQLite::Exception if the database cannot be read
+     */
+    std::vector<long long> merge(const std::string& shard_filename);
+
+    //! Is there a run with the given ID?
+    bool has_run(long long run_id);
+
+    /*!
+     * Loads exit codes and runtimes of all jobs of a run.
+     *
+     * The timeout of the dataset is the largest timeout of the jobs.
+     *
+     * @param with_output load the metrics and the trajectories too,
+     *        e.g. for the statistics of a resumed run
+     */
+    Dataset load_dataset(long long run_id, bool with_output = false);
+
+    /*!
+     * Pairs jobs of two runs by their job index.
+     *
+     * The job index gives the values of all parameters (see JobSpace),
+     * so the runs must have the same parameters, values and zip groups,
+     * e.g. one sweep executed with two builds of the solver. Neither
+     * the binary, nor the environment or the working directory take
+     * part in the pairing, because they differ between the builds.
+     * The command line of a paired instance is the one of the run A.
+     *
+     * @throw std::runtime_error if the saved job spaces of the runs
+     *        differ (see save_job_space()), i.e. the same index would
+     *        pair jobs with different parameter values
+     *
+     * The join and the aggregation of repeated jobs is done by SQLite
+     * and the paired instances are streamed to the callback one by one,
+     * so that even huge runs are never loaded to the memory.
+     *
+     * @param callback called as `callback(const PairedInstance&)`
+     */
+    template<typename Callback>
+    void for_each_paired_instance(long long run_a, long long run_b,
+        Callback callback);
 
 
 
@@ -59,5 +197,50 @@ private:
     void read();
 
 }; // sql_database
+
+
+
+template<typename Callback>
+void sql_database::for_each_paired_instance(
+    long long run_a, long long run_b, Callback callback)
+{
+    if (job_space(run_a) != job_space(run_b)) {
+        throw std::runtime_error("Runs " + std::to_string(run_a) + " and "
+            + std::to_string(run_b) + " have different parameters,"
+            " their jobs cannot be paired.");
+    }
+
+    SQLite::Statement query(m_db,
+        "WITH per_instance AS ("
+            " SELECT job.run_id AS run_id, job.job_index AS job_index,"
+            " MIN(command.commands) AS commands,"
+            " AVG(CASE WHEN job.exit_code = 0 AND job.runtime <= job.timeout"
+                " THEN job.runtime ELSE job.timeout END) AS runtime,"
+            " SUM(job.exit_code = 0 AND job.runtime <= job.timeout) AS solved"
+            " FROM job JOIN command ON command.job_id = job.job_id"
+            " WHERE job.run_id IN (?, ?)"
+            " GROUP BY job.run_id, job.job_index"
+        ")"
+        " SELECT a.commands, a.runtime, b.runtime, a.solved, b.solved"
+        " FROM per_instance AS a JOIN per_instance AS b"
+        " ON a.job_index = b.job_index"
+        " WHERE a.run_id = ? AND b.run_id = ?"
+    );
+    query.bind(1, run_a);
+    query.bind(2, run_b);
+    query.bind(3, run_a);
+    query.bind(4, run_b);
+
+    PairedInstance instance;
+    while (query.executeStep()) {
+        instance.command = query.getColumn(0).getString();
+        instance.runtime_a = query.getColumn(1).getDouble();
+        instance.runtime_b = query.getColumn(2).getDouble();
+        instance.solved_a = static_cast<unsigned>(query.getColumn(3).getInt());
+        instance.solved_b = static_cast<unsigned>(query.getColumn(4).getInt());
+        callback(static_cast<const PairedInstance&>(instance));
+    }
+} // for_each_paired_instance
+
 } // perfnp
 #endif // PERFNP_CORE_H_
@@ -0,0 +1,573 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/staging.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+    //! The argument itself and the value of `--option=value`
+    std::vector<std::string> candidate_paths(const std::string& argument)
+    {
+        std::vector<std::string> candidates;
+        if (!argument.empty()) {
+            candidates.push_back(argument);
+        }
+        auto equals = argument.find('=');
+        if (equals != std::string::npos && equals + 1 < argument.size()) {
+            candidates.push_back(argument.substr(equals + 1));
+        }
+        return candidates;
+    } // candidate_paths
+
+    //! Does the path name an existing regular file?
+    bool is_regular_file(const std::string& path)
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+#else
+        (void)path;
+        return false;
+#endif
+    } // is_regular_file
+
+    //! Asks the kernel to read or to drop the whole file
+    void advise(const std::string& path, bool drop)
+    {
+#if defined(__linux__)
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (drop) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        } else {
+            // Unlike the advice, readahead() returns once the file is read
+            struct stat info;
+            if (fstat(fd, &info) == 0) {
+                readahead(fd, 0, static_cast<size_t>(info.st_size));
+            }
+        }
+        close(fd);
+#else
+        // Without the advice, the file is read to warm the cache
+        if (!drop) {
+            std::ifstream file(path, std::ios::binary);
+            char buffer[1 << 16];
+            while (file.read(buffer, sizeof(buffer))) {
+            }
+        }
+#endif
+    } // advise
+
+#if defined(__linux__) || defined(__APPLE__)
+    //! Failure of a file operation with the error number
+    std::runtime_error file_error(const std::string& action,
+        const std::string& path, int error_number)
+    {
+        return std::runtime_error("Cannot " + action + " '" + path
+            + "': errno=" + std::to_string(error_number));
+    } // file_error
+
+    //! Creates the directory and all its missing parents
+    void make_directories(const std::string& path)
+    {
+        for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+            const auto prefix = path.substr(0, slash);
+            if (mkdir(prefix.c_str(), 0700) == -1 && errno != EEXIST) {
+                throw file_error("create", prefix, errno);
+            }
+            if (slash == std::string::npos) {
+                break;
+            }
+        }
+    } // make_directories
+
+    //! Names in the directory except `.` and `..`
+    std::vector<std::string> list_directory(const std::string& path)
+    {
+        std::vector<std::string> names;
+        DIR* directory = opendir(path.c_str());
+        if (directory == nullptr) {
+            throw file_error("open", path, errno);
+        }
+        while (const struct dirent* entry = readdir(directory)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                names.push_back(name);
+            }
+        }
+        closedir(directory);
+        return names;
+    } // list_directory
+
+    //! Removes the content of the directory and the directory too if asked
+    void remove_tree(const std::string& path, bool remove_itself)
+    {
+        for (const auto& name : list_directory(path)) {
+            const auto child = path + "/" + name;
+            struct stat info;
+            if (lstat(child.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+                remove_tree(child, true);
+            } else if (unlink(child.c_str()) == -1 && errno != ENOENT) {
+                throw file_error("remove", child, errno);
+            }
+        }
+        if (remove_itself && rmdir(path.c_str()) == -1 && errno != ENOENT) {
+            throw file_error("remove", path, errno);
+        }
+    } // remove_tree
+
+    //! Copies a regular file with its permissions
+    void copy_file(const std::string& source, const std::string& target)
+    {
+        int input = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (input == -1 || fstat(input, &info) == -1) {
+            const int error_number = errno;
+            if (input != -1) {
+                close(input);
+            }
+            throw file_error("read", source, error_number);
+        }
+        int output = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            info.st_mode & 07777);
+        if (output == -1) {
+            const int error_number = errno;
+            close(input);
+            throw file_error("create", target, error_number);
+        }
+
+        int error_number = 0;
+        char buffer[1 << 16];
+        for (;;) {
+            ssize_t length = read(input, buffer, sizeof(buffer));
+            if (length == 0) {
+                break;
+            } else if (length == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error_number = errno;
+                break;
+            }
+            for (ssize_t written = 0; written < length && error_number == 0; ) {
+                ssize_t chunk = write(output, buffer + written,
+                    static_cast<size_t>(length - written));
+                if (chunk == -1 && errno != EINTR) {
+                    error_number = errno;
+                } else if (chunk > 0) {
+                    written += chunk;
+                }
+            }
+            if (error_number != 0) {
+                break;
+            }
+        }
+        close(input);
+        if (close(output) == -1 && error_number == 0) {
+            error_number = errno;
+        }
+        if (error_number != 0) {
+            throw file_error("copy", source, error_number);
+        }
+    } // copy_file
+
+    //! Copies the directories and the regular files of the tree
+    void copy_tree(const std::string& source, const std::string& target)
+    {
+        if (mkdir(target.c_str(), 0700) == -1 && errno != EEXIST) {
+            throw file_error("create", target, errno);
+        }
+        for (const auto& name : list_directory(source)) {
+            const auto child = source + "/" + name;
+            struct stat info;
+            if (lstat(child.c_str(), &info) == -1) {
+                throw file_error("read", child, errno);
+            }
+            if (S_ISDIR(info.st_mode)) {
+                copy_tree(child, target + "/" + name);
+            } else if (S_ISREG(info.st_mode)) {
+                copy_file(child, target + "/" + name);
+            }
+        }
+    } // copy_tree
+
+    //! Moves the tree, it is copied to another file system
+    void move_tree(const std::string& source, const std::string& target)
+    {
+        if (rename(source.c_str(), target.c_str()) == 0) {
+            return;
+        }
+        if (errno != EXDEV) {
+            throw file_error("move", source, errno);
+        }
+        copy_tree(source, target);
+        remove_tree(source, true);
+    } // move_tree
+#endif
+
+} // anonymous namespace
+
+
+
+std::vector<std::string> perfnp::input_files(const CmdWithArgs& cwa)
+{
+    std::vector<std::string> files;
+    for (const auto& argument : cwa.arguments()) {
+        for (const auto& path : candidate_paths(argument)) {
+            if (is_regular_file(path)) {
+                files.push_back(path);
+                break;
+            }
+        }
+    }
+    return files;
+} // input_files
+
+
+
+InputStager::InputStager(const std::vector<CmdWithArgs>& jobs,
+    const PageCacheSettings& settings)
+: m_settings(settings)
+, m_job_files(jobs.size())
+, m_started(0)
+, m_staged(0)
+, m_stop(false)
+{
+    // Every distinct argument is checked once, the sweep repeats them a lot
+    const std::size_t NOT_A_FILE = static_cast<std::size_t>(-1);
+    std::unordered_map<std::string, std::size_t> known;
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        for (const auto& argument : jobs[i].arguments()) {
+            for (const auto& path : candidate_paths(argument)) {
+                auto found = known.find(path);
+                if (found == known.end()) {
+                    std::size_t position = NOT_A_FILE;
+                    if (is_regular_file(path)) {
+                        position = m_files.size();
+                        m_files.push_back(InputFile{path, 0, false, nullptr, 0});
+                    }
+                    found = known.emplace(path, position).first;
+                }
+                if (found->second != NOT_A_FILE) {
+                    auto& job_files = m_job_files[i];
+                    if (std::find(job_files.begin(), job_files.end(),
+                            found->second) == job_files.end()) {
+                        job_files.push_back(found->second);
+                        ++m_files[found->second].remaining_jobs;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    if ((m_settings.mode == PageCacheSettings::Mode::Warm
+            || m_settings.mode == PageCacheSettings::Mode::Pin) && !m_files.empty()) {
+        m_prefetcher = std::thread(&InputStager::prefetch, this);
+    } else {
+        m_staged = jobs.size();
+    }
+} // InputStager::InputStager
+
+
+
+InputStager::~InputStager()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_changed.notify_all();
+    if (m_prefetcher.joinable()) {
+        m_prefetcher.join();
+    }
+    for (auto& file : m_files) {
+        unpin(file);
+    }
+} // InputStager::~InputStager
+
+
+
+void InputStager::prefetch()
+{
+    for (std::size_t position = 0; position < m_job_files.size(); ++position) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [&] {
+                return m_stop || position < m_started + m_settings.ahead;
+            });
+            if (m_stop) {
+                return;
+            }
+        }
+
+        // Only this thread stages, the slots wait for m_staged
+        for (auto file : m_job_files[position]) {
+            if (!m_files[file].staged) {
+                stage(m_files[file]);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_staged = position + 1;
+        }
+        m_changed.notify_all();
+    }
+} // InputStager::prefetch
+
+
+
+void InputStager::stage(InputFile& file)
+{
+    file.staged = true;
+#if defined(__linux__) || defined(__APPLE__)
+    if (m_settings.mode == PageCacheSettings::Mode::Pin) {
+        int fd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0) {
+            const auto size = static_cast<std::size_t>(info.st_size);
+            void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED) {
+                // mlock() faults all pages in, i.e. it reads the file
+                if (mlock(address, size) == 0) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    file.address = address;
+                    file.size = size;
+                } else {
+                    munmap(address, size);
+                }
+            }
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (file.address != nullptr) {
+            return;
+        }
+    }
+    advise(file.path, false);
+#endif
+} // InputStager::stage
+
+
+
+void InputStager::unpin(InputFile& file)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (file.address != nullptr) {
+        munlock(file.address, file.size);
+        munmap(file.address, file.size);
+        file.address = nullptr;
+    }
+#endif
+} // InputStager::unpin
+
+
+
+void InputStager::before_job(std::size_t position)
+{
+    if (m_settings.mode == PageCacheSettings::Mode::Cold) {
+        for (auto file : m_job_files.at(position)) {
+            advise(m_files[file].path, true);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_started = std::max(m_started, position + 1);
+    m_changed.notify_all();
+    m_changed.wait(lock, [&] {
+        return m_stop || m_staged > position;
+    });
+} // InputStager::before_job
+
+
+
+void InputStager::after_job(std::size_t position)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto file : m_job_files.at(position)) {
+        if (--m_files[file].remaining_jobs == 0) {
+            unpin(m_files[file]);
+        }
+    }
+} // InputStager::after_job
+
+
+
+std::size_t InputStager::pinned_files()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::count_if(m_files.begin(), m_files.end(), [](const InputFile& file) {
+        return file.address != nullptr;
+    });
+} // InputStager::pinned_files
+
+
+
+ScratchSpace::ScratchSpace(const ScratchSettings& settings, unsigned slots)
+: m_settings(settings)
+, m_staged_inputs(std::max(slots, 1u))
+{
+#if defined(__linux__) || defined(__APPLE__)
+    char current_directory[4096];
+    if (getcwd(current_directory, sizeof(current_directory)) == nullptr) {
+        throw file_error("read the working directory", ".", errno);
+    }
+    m_current_directory = current_directory;
+
+    m_root = absolute(m_settings.directory) + "/perfnp-" + std::to_string(getpid());
+    make_directories(m_root);
+    for (unsigned slot = 0; slot < m_staged_inputs.size(); ++slot) {
+        m_directories.push_back(m_root + "/slot-" + std::to_string(slot));
+        if (mkdir(m_directories.back().c_str(), 0700) == -1 && errno != EEXIST) {
+            throw file_error("create", m_directories.back(), errno);
+        }
+    }
+
+    if (!m_settings.archive.empty()) {
+        m_settings.archive = absolute(m_settings.archive);
+        make_directories(m_settings.archive);
+    }
+#else
+    throw std::runtime_error("Scratch directories are not supported on Windows.");
+#endif
+} // ScratchSpace::ScratchSpace
+
+
+
+ScratchSpace::~ScratchSpace()
+{
+#if defined(__linux__) || defined(__APPLE__)
+    try {
+        remove_tree(m_root, true);
+    } catch (const std::runtime_error&) {
+        // Leftovers of a crashed job must not hide the results
+    }
+#endif
+} // ScratchSpace::~ScratchSpace
+
+
+
+std::string ScratchSpace::absolute(const std::string& path) const
+{
+    if (!path.empty() && path[0] == '/') {
+        return path;
+    }
+    return m_current_directory + "/" + path;
+} // ScratchSpace::absolute
+
+
+
+CmdWithArgs ScratchSpace::prepare(unsigned slot, const CmdWithArgs& cwa)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    const auto& directory = m_directories.at(slot);
+    auto& staged = m_staged_inputs[slot];
+    remove_tree(directory, false);
+    staged.clear();
+
+    // Sources of the staged inputs, the same file is staged once
+    std::vector<std::string> sources;
+    std::vector<std::string> arguments;
+    for (const auto& argument : cwa.arguments()) {
+        std::string rewritten = argument;
+        for (const auto& candidate : candidate_paths(argument)) {
+            if (!is_regular_file(candidate)) {
+                continue;
+            }
+
+            auto replacement = absolute(candidate);
+            if (m_settings.inputs != ScratchSettings::Inputs::None) {
+                auto source = std::find(sources.begin(), sources.end(), replacement);
+                if (source != sources.end()) {
+                    replacement = staged[source - sources.begin()];
+                } else {
+                    auto name = candidate.substr(candidate.rfind('/') + 1);
+                    if (std::find(staged.begin(), staged.end(), name) != staged.end()) {
+                        name = std::to_string(staged.size()) + "-" + name;
+                    }
+                    const auto target = directory + "/" + name;
+                    if (m_settings.inputs == ScratchSettings::Inputs::Copy
+                            || link(replacement.c_str(), target.c_str()) == -1) {
+                        copy_file(replacement, target);
+                    }
+                    sources.push_back(replacement);
+                    staged.push_back(name);
+                    replacement = name;
+                }
+            }
+
+            // The candidate is the whole argument or the value after `=`
+            rewritten = argument.substr(0, argument.size() - candidate.size()) + replacement;
+            break;
+        }
+        arguments.push_back(rewritten);
+    }
+
+    auto command = cwa.command();
+    if (command.find('/') != std::string::npos) {
+        command = absolute(command);
+    }
+    return CmdWithArgs(cwa.job_index(), command, arguments,
+        cwa.environment(), cwa.working_directory());
+#else
+    (void)slot;
+    return cwa;
+#endif
+} // ScratchSpace::prepare
+
+
+
+void ScratchSpace::finish(unsigned slot, const CmdWithArgs& cwa)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    const auto& directory = m_directories.at(slot);
+    if (m_settings.archive.empty()) {
+        remove_tree(directory, false);
+        return;
+    }
+
+    // The inputs are kept elsewhere, only the files of the job are archived
+    for (const auto& name : m_staged_inputs[slot]) {
+        unlink((directory + "/" + name).c_str());
+    }
+    m_staged_inputs[slot].clear();
+
+    // Jobs of several runs have the same index
+    auto target = m_settings.archive + "/job-" + std::to_string(cwa.job_index());
+    struct stat info;
+    for (unsigned copy = 2; lstat(target.c_str(), &info) == 0; ++copy) {
+        target = m_settings.archive + "/job-" + std::to_string(cwa.job_index())
+            + "-" + std::to_string(copy);
+    }
+    move_tree(directory, target);
+    if (mkdir(directory.c_str(), 0700) == -1 && errno != EEXIST) {
+        throw file_error("create", directory, errno);
+    }
+#else
+    (void)slot;
+    (void)cwa;
+#endif
+} // ScratchSpace::finish
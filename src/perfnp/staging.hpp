@@ -0,0 +1,277 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_STAGING_H_
+#define PERFNP_STAGING_H_
+
+#include "perfnp/cmd_line.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * State of the input files in the page cache, when their jobs start.
+ */
+struct PageCacheSettings {
+
+    //! What happens with the input files before their jobs?
+    enum class Mode {
+        //! Nothing, the first job reading a file pays for the disk
+        Off,
+
+        //! The files are read ahead into the page cache
+        Warm,
+
+        //! The files are read ahead and locked in the memory
+        Pin,
+
+        //! The files are dropped from the page cache before every job
+        Cold
+    };
+
+    //! What happens with the input files before their jobs?
+    Mode mode;
+
+    //! How many jobs ahead of the scheduler are the files read?
+    unsigned ahead;
+
+    //! Staging is disabled by default
+    PageCacheSettings()
+    : mode(Mode::Off)
+    , ahead(8)
+    {}
+
+    //! Are the input files staged?
+    bool enabled() const {
+        return mode != Mode::Off;
+    }
+}; // PageCacheSettings
+
+
+
+/*!
+ * Brings the input files of the jobs to the same state in the page
+ * cache before every job starts, so that the first repetition does
+ * not pay for the disk inside its measured runtime.
+ *
+ * An input file is an argument (or the value of an `--option=value`
+ * argument), which names an existing regular file. In the Warm and
+ * Pin modes, a prefetching thread reads the files of the next `ahead`
+ * jobs in the order of the scheduler. A pinned file stays locked in
+ * the memory until the last job reading it finishes; if it cannot be
+ * locked (e.g. due to RLIMIT_MEMLOCK), it is only read ahead. In the
+ * Cold mode, the files are dropped before every job, which affects
+ * the jobs running in parallel too, therefore it is meant for a single
+ * worker slot. Does nothing on Windows.
+ */
+class InputStager {
+
+    //! An input file shared by some jobs
+    struct InputFile {
+        std::string path;
+
+        //! Number of the jobs, which have not finished yet
+        std::size_t remaining_jobs;
+
+        //! Has the file been read ahead?
+        bool staged;
+
+        //! Locked mapping of the file, null if not pinned
+        void* address;
+
+        //! Size of the mapping
+        std::size_t size;
+    };
+
+    PageCacheSettings m_settings;
+
+    //! All distinct input files
+    std::vector<InputFile> m_files;
+
+    //! Input files of every job, as positions in m_files
+    std::vector<std::vector<std::size_t>> m_job_files;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+
+    //! Number of the first jobs, which have been started
+    std::size_t m_started;
+
+    //! Number of the first jobs, whose files have been staged
+    std::size_t m_staged;
+
+    //! Is the stager being destroyed?
+    bool m_stop;
+
+    std::thread m_prefetcher;
+
+    //! Reads the files of the jobs ahead of the scheduler
+    void prefetch();
+
+    //! Reads the file to the page cache, locks it in the Pin mode
+    void stage(InputFile& file);
+
+    //! Unlocks the file, if it is pinned
+    void unpin(InputFile& file);
+
+public:
+    /*!
+     * Finds the input files and starts the prefetching thread.
+     *
+     * @param jobs the jobs in the order, in which they are started
+     */
+    InputStager(const std::vector<CmdWithArgs>& jobs,
+        const PageCacheSettings& settings);
+
+    InputStager(const InputStager&) = delete;
+    InputStager& operator=(const InputStager&) = delete;
+
+    //! Stops the prefetching and unlocks all files
+    ~InputStager();
+
+    /*!
+     * Called by a worker slot before the job at the position starts.
+     *
+     * Waits until the files of the job are staged, or drops them
+     * from the page cache in the Cold mode.
+     */
+    void before_job(std::size_t position);
+
+    //! Called by a worker slot after the job at the position has finished
+    void after_job(std::size_t position);
+
+    //! Number of the distinct input files
+    std::size_t input_files() const {
+        return m_files.size();
+    }
+
+    //! Number of the files locked in the memory now
+    std::size_t pinned_files();
+}; // InputStager
+
+/*!
+ * Input files of a job, i.e. the arguments (or the values of
+ * `--option=value` arguments) naming existing regular files.
+ */
+std::vector<std::string> input_files(const CmdWithArgs& cwa);
+
+
+
+/*!
+ * Private working directories of the worker slots.
+ */
+struct ScratchSettings {
+
+    //! How do the input files get to the working directory?
+    enum class Inputs {
+        //! They stay where they are, their paths are made absolute
+        None,
+
+        //! They are hard-linked, or copied if that is not possible
+        Link,
+
+        //! They are copied
+        Copy
+    };
+
+    //! Where the directories are created (e.g. on a tmpfs), disabled if empty
+    std::string directory;
+
+    //! How do the input files get to the working directory?
+    Inputs inputs;
+
+    //! Where the directories of finished jobs are moved, deleted if empty
+    std::string archive;
+
+    //! Scratch directories are disabled by default
+    ScratchSettings()
+    : inputs(Inputs::Link)
+    {}
+
+    //! Do the jobs run in scratch directories?
+    bool enabled() const {
+        return !directory.empty();
+    }
+}; // ScratchSettings
+
+
+
+/*!
+ * Runs every worker slot in a private working directory, so that the
+ * scratch files of parallel jobs never meet on a shared file system.
+ *
+ * The directory of a slot is `<directory>/perfnp-<pid>/slot-<n>`.
+ * Before a job starts, the directory is emptied, the input files
+ * (see input_files()) are linked or copied into it and the arguments
+ * are rewritten to the staged names. The relative path of the binary
+ * and of the inputs, which are not staged, are made absolute. After
+ * the job, its directory is moved to `<archive>/job-<index>`, or
+ * emptied. Staging is done by the slot outside of the measured runtime.
+ * A hard-linked input is the same file as the original one, therefore
+ * a job modifying its input needs the Copy mode. Not supported on
+ * Windows.
+ */
+class ScratchSpace {
+
+    ScratchSettings m_settings;
+
+    //! Absolute path of `<directory>/perfnp-<pid>`
+    std::string m_root;
+
+    //! Working directory of every slot
+    std::vector<std::string> m_directories;
+
+    //! Names of the inputs staged in the directory of every slot
+    std::vector<std::vector<std::string>> m_staged_inputs;
+
+    //! Working directory of perfnp, for the relative paths
+    std::string m_current_directory;
+
+    //! Makes a relative path absolute
+    std::string absolute(const std::string& path) const;
+
+public:
+    /*!
+     * Creates the directories of the slots.
+     *
+     * @throws std::runtime_error if a directory cannot be created
+     */
+    ScratchSpace(const ScratchSettings& settings, unsigned slots);
+
+    ScratchSpace(const ScratchSpace&) = delete;
+    ScratchSpace& operator=(const ScratchSpace&) = delete;
+
+    //! Removes the directories of the slots
+    ~ScratchSpace();
+
+    //! Working directory of the slot
+    const std::string& directory(unsigned slot) const {
+        return m_directories.at(slot);
+    }
+
+    /*!
+     * Prepares the directory of the slot for the job.
+     *
+     * @return the job with the rewritten binary and arguments
+     * @throws std::runtime_error if an input cannot be staged
+     */
+    CmdWithArgs prepare(unsigned slot, const CmdWithArgs& cwa);
+
+    /*!
+     * Archives or empties the directory of the slot after the job.
+     *
+     * @throws std::runtime_error if the directory cannot be archived
+     */
+    void finish(unsigned slot, const CmdWithArgs& cwa);
+}; // ScratchSpace
+
+} // perfnp
+#endif // PERFNP_STAGING_H_
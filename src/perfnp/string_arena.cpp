@@ -0,0 +1,118 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/string_arena.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace perfnp;
+
+namespace {
+
+    //! FNV-1a hash of the characters
+    std::uint64_t hash_of(const char* data, std::size_t length)
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (std::size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    } // hash_of
+
+} // anonymous namespace
+
+
+
+const std::size_t StringArena::BLOCK_SIZE;
+
+
+
+StringArena::StringArena()
+: m_block_free(0)
+, m_table(64, 0)
+{}
+
+
+
+const char* StringArena::store(const char* data, std::size_t length)
+{
+    const std::size_t needed = length + 1;
+    if (needed > m_block_free) {
+        if (needed > BLOCK_SIZE / 4) {
+            // Long strings get a block of their own, which keeps
+            // the free space of the current block
+            std::unique_ptr<char[]> block(new char[needed]);
+            char* copy = block.get();
+            m_blocks.insert(m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1,
+                std::move(block));
+            std::memcpy(copy, data, length);
+            copy[length] = '\0';
+            return copy;
+        }
+        m_blocks.emplace_back(new char[BLOCK_SIZE]);
+        m_block_free = BLOCK_SIZE;
+    }
+
+    char* copy = m_blocks.back().get() + (BLOCK_SIZE - m_block_free);
+    std::memcpy(copy, data, length);
+    copy[length] = '\0';
+    m_block_free -= needed;
+    return copy;
+} // StringArena::store
+
+
+
+void StringArena::grow_table()
+{
+    std::vector<Id> table(m_table.size() * 2, 0);
+    const std::size_t mask = table.size() - 1;
+    for (Id id = 0; id < m_strings.size(); ++id) {
+        std::size_t slot = hash_of(m_strings[id], m_lengths[id]) & mask;
+        while (table[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        table[slot] = id + 1;
+    }
+    m_table.swap(table);
+} // StringArena::grow_table
+
+
+
+StringArena::Id StringArena::intern(const char* data, std::size_t length)
+{
+    if (length > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("String of "
+            + std::to_string(length) + " bytes cannot be interned.");
+    }
+
+    const std::size_t mask = m_table.size() - 1;
+    std::size_t slot = hash_of(data, length) & mask;
+    while (m_table[slot] != 0) {
+        const Id id = m_table[slot] - 1;
+        if (m_lengths[id] == length
+                && std::memcmp(m_strings[id], data, length) == 0) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (m_strings.size() >= std::numeric_limits<Id>::max() - 1) {
+        throw std::runtime_error("String arena is full.");
+    }
+
+    const Id id = static_cast<Id>(m_strings.size());
+    m_strings.push_back(store(data, length));
+    m_lengths.push_back(static_cast<std::uint32_t>(length));
+    m_table[slot] = id + 1;
+
+    // Keep the load factor at most 1/2
+    if (2 * m_strings.size() > m_table.size()) {
+        grow_table();
+    }
+    return id;
+} // StringArena::intern
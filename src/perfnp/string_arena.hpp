@@ -0,0 +1,91 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_STRING_ARENA_H_
+#define PERFNP_STRING_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * Storage of interned strings.
+ *
+ * Every distinct string is stored once, terminated by a zero byte,
+ * in large blocks of characters, and it is identified by a small
+ * integer. Blocks never move, so the strings are never copied as
+ * the arena grows. A string costs its characters plus about 20 bytes,
+ * which makes long lists of values (e.g. hundred thousands of file
+ * names) several times smaller than a vector of std::string.
+ */
+class StringArena {
+public:
+    //! Identifier of an interned string
+    typedef std::uint32_t Id;
+
+private:
+    //! Blocks of characters
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+
+    //! Free characters at the end of the last block
+    std::size_t m_block_free;
+
+    //! The first character of every string
+    std::vector<const char*> m_strings;
+
+    //! Length of every string
+    std::vector<std::uint32_t> m_lengths;
+
+    //! Open-addressing hash table of Id + 1, zero is an empty slot
+    std::vector<Id> m_table;
+
+    //! Copies the characters to a block, returns the copy
+    const char* store(const char* data, std::size_t length);
+
+    //! Doubles the hash table and rehashes all strings
+    void grow_table();
+
+public:
+    //! Size of a block, longer strings get a block of their own
+    static const std::size_t BLOCK_SIZE = 1 << 20;
+
+    //! Empty arena
+    StringArena();
+
+    //! Returns the identifier of the string, adds it if it is new
+    Id intern(const char* data, std::size_t length);
+
+    //! Returns the identifier of the string, adds it if it is new
+    Id intern(const std::string& value) {
+        return intern(value.data(), value.size());
+    }
+
+    //! Zero-terminated characters of the string
+    const char* c_str(Id id) const {
+        return m_strings[id];
+    }
+
+    //! Length of the string
+    std::size_t length(Id id) const {
+        return m_lengths[id];
+    }
+
+    //! Copy of the string
+    std::string str(Id id) const {
+        return std::string(m_strings[id], m_lengths[id]);
+    }
+
+    //! Number of distinct strings
+    std::size_t size() const {
+        return m_strings.size();
+    }
+}; // StringArena
+
+} // perfnp
+#endif // PERFNP_STRING_ARENA_H_
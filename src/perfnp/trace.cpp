@@ -0,0 +1,95 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/trace.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace perfnp;
+
+const int Tracer::NO_EXIT_CODE;
+
+namespace {
+
+    //! Events of a sweep are preallocated up to this count per slot
+    const size_t RESERVED_EVENTS = 1024;
+
+} // anonymous namespace
+
+
+
+Tracer::Tracer(unsigned slots)
+: m_start(std::chrono::steady_clock::now())
+, m_slots(slots > 0 ? slots : 1)
+{
+    for (auto& slot : m_slots) {
+        slot.events.reserve(RESERVED_EVENTS);
+    }
+} // Tracer::Tracer
+
+
+
+void Tracer::complete(unsigned slot, const char* name, std::int64_t start_us,
+    unsigned job_index, int exit_code)
+{
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'X';
+    event.timestamp_us = start_us;
+    event.duration_us = now_us() - start_us;
+    event.job_index = job_index;
+    event.exit_code = exit_code;
+    m_slots.at(slot).events.push_back(event);
+} // Tracer::complete
+
+
+
+void Tracer::instant(unsigned slot, const char* name, unsigned job_index)
+{
+    TraceEvent event;
+    event.name = name;
+    event.phase = 'i';
+    event.timestamp_us = now_us();
+    event.duration_us = 0;
+    event.job_index = job_index;
+    event.exit_code = NO_EXIT_CODE;
+    m_slots.at(slot).events.push_back(event);
+} // Tracer::instant
+
+
+
+void Tracer::write_chrome_trace(std::ostream& o) const
+{
+    // Events are streamed, so that huge sweeps are not built in memory.
+    // Names are string literals without characters to be escaped.
+    o << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (unsigned slot = 0; slot < m_slots.size(); ++slot) {
+        o << (first ? "" : ",")
+          << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << slot
+          << ",\"args\":{\"name\":\"slot " << slot << "\"}}";
+        first = false;
+
+        for (const auto& event : m_slots[slot].events) {
+            o << ",\n{\"name\":\"" << event.name
+              << "\",\"cat\":\"perfnp\",\"ph\":\"" << event.phase
+              << "\",\"pid\":1,\"tid\":" << slot
+              << ",\"ts\":" << event.timestamp_us;
+            if (event.phase == 'X') {
+                o << ",\"dur\":" << event.duration_us;
+            } else {
+                o << ",\"s\":\"t\"";
+            }
+            o << ",\"args\":{\"job\":" << event.job_index;
+            if (event.exit_code != NO_EXIT_CODE) {
+                o << ",\"exit_code\":" << event.exit_code;
+            }
+            o << "}}";
+        }
+    }
+    o << "\n]}" << std::endl;
+} // Tracer::write_chrome_trace
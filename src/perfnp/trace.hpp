@@ -0,0 +1,105 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef PERFNP_TRACE_H_
+#define PERFNP_TRACE_H_
+
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace perfnp {
+
+/*!
+ * One event of the timeline, see \ref Tracer.
+ */
+struct TraceEvent {
+
+    //! Name of the event, must be a string literal
+    const char* name;
+
+    //! Chrome trace phase: 'X' complete event, 'i' instant event
+    char phase;
+
+    //! Start of the event, in microseconds since the start of the tracer
+    std::int64_t timestamp_us;
+
+    //! Duration of a complete event, in microseconds
+    std::int64_t duration_us;
+
+    //! Index of the job, which the event belongs to
+    unsigned job_index;
+
+    //! Exit code of the job, Tracer::NO_EXIT_CODE for other events
+    int exit_code;
+}; // TraceEvent
+
+
+
+/*!
+ * Timeline of the sweep, one track per worker slot.
+ *
+ * Every slot writes only to its own buffer, so recording is
+ * lock-free. The buffers must not be read until all slots
+ * have finished, i.e. the worker threads have been joined.
+ */
+class Tracer {
+
+    //! Events of one slot, padded to avoid false sharing
+    struct SlotBuffer {
+        std::vector<TraceEvent> events;
+        char padding[64];
+    };
+
+    //! Time zero of all timestamps
+    std::chrono::steady_clock::time_point m_start;
+
+    //! One buffer per slot
+    std::vector<SlotBuffer> m_slots;
+
+public:
+    //! Exit code of events, which are not jobs
+    static const int NO_EXIT_CODE = INT_MIN;
+
+    //! Prepares buffers for the given number of slots
+    explicit Tracer(unsigned slots);
+
+    //! Microseconds since the start of the tracer (monotonic)
+    std::int64_t now_us() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_start).count();
+    }
+
+    //! Number of slots
+    unsigned slots() const {
+        return static_cast<unsigned>(m_slots.size());
+    }
+
+    //! Records an event which lasted from `start_us` until now
+    void complete(unsigned slot, const char* name, std::int64_t start_us,
+        unsigned job_index, int exit_code = NO_EXIT_CODE);
+
+    //! Records an instant event happening now
+    void instant(unsigned slot, const char* name, unsigned job_index);
+
+    //! Events of the slot in the order of recording
+    const std::vector<TraceEvent>& events(unsigned slot) const {
+        return m_slots.at(slot).events;
+    }
+
+    /*!
+     * Writes all events in the Chrome trace-event JSON format.
+     *
+     * The file can be opened in chrome://tracing or in Perfetto,
+     * every worker slot is shown as a separate thread.
+     */
+    void write_chrome_trace(std::ostream& o) const;
+}; // Tracer
+
+} // perfnp
+#endif // PERFNP_TRACE_H_
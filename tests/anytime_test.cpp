@@ -0,0 +1,96 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/anytime.hpp"
+
+#include "catch.hpp"
+
+using namespace perfnp;
+
+TEST_CASE("primal_gap")
+{
+    REQUIRE(primal_gap(5, 5) == 0);
+    REQUIRE(primal_gap(0, 0) == 0);
+    REQUIRE(primal_gap(-1, 1) == 1);
+    REQUIRE(primal_gap(10, 8) == Approx(0.2));
+    REQUIRE(primal_gap(8, 10) == Approx(0.2));
+}
+
+TEST_CASE("Trajectory::add")
+{
+    SECTION("minimization keeps only decreasing values")
+    {
+        Trajectory t(true);
+        REQUIRE(t.add(100, 10));
+        REQUIRE_FALSE(t.add(200, 12));
+        REQUIRE_FALSE(t.add(300, 10));
+        REQUIRE(t.add(400, 8));
+        REQUIRE(t.points() == std::vector<TrajectoryPoint>{ {100, 10}, {400, 8} });
+    }
+
+    SECTION("maximization keeps only increasing values")
+    {
+        Trajectory t(false);
+        REQUIRE(t.add(100, 10));
+        REQUIRE_FALSE(t.add(200, 8));
+        REQUIRE(t.add(300, 12));
+        REQUIRE(t.points().size() == 2);
+    }
+}
+
+TEST_CASE("Trajectory::gap_at")
+{
+    Trajectory t(true);
+    t.add(1000, 10);
+    t.add(3000, 8);
+
+    REQUIRE(t.gap_at(0.5, 8) == 1);
+    REQUIRE(t.gap_at(1.0, 8) == Approx(0.2));
+    REQUIRE(t.gap_at(2.9, 8) == Approx(0.2));
+    REQUIRE(t.gap_at(3.0, 8) == 0);
+    REQUIRE(Trajectory().gap_at(100, 8) == 1);
+}
+
+TEST_CASE("Trajectory::primal_integral")
+{
+    Trajectory t(true);
+    t.add(1000, 10);
+    t.add(3000, 8);
+
+    SECTION("the horizon is after the last incumbent")
+    {
+        // gap 1 for 1s, then 0.2 for 2s, then 0 for the rest
+        REQUIRE(t.primal_integral(10, 8) == Approx(1.4));
+    }
+
+    SECTION("the horizon cuts the trajectory")
+    {
+        REQUIRE(t.primal_integral(2, 8) == Approx(1.2));
+    }
+
+    SECTION("no incumbent means the gap of 1 all the time")
+    {
+        REQUIRE(Trajectory().primal_integral(10, 8) == Approx(10));
+    }
+}
+
+TEST_CASE("Trajectory::to_blob")
+{
+    Trajectory t(false);
+    t.add(1, -1.5);
+    t.add(4000000000u, 1e300);
+
+    SECTION("round trip")
+    {
+        auto blob = t.to_blob();
+        REQUIRE(blob.size() == 24);
+        REQUIRE(Trajectory::from_blob(false, blob) == t);
+    }
+
+    SECTION("truncated blob is rejected")
+    {
+        REQUIRE_THROWS_AS(Trajectory::from_blob(false, "abc"), std::runtime_error);
+    }
+}
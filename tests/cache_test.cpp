@@ -0,0 +1,110 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "catch.hpp"
+
+#include <perfnp/cache.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace perfnp;
+
+TEST_CASE("sha256_hex")
+{
+    // Test vectors of FIPS 180-4
+    REQUIRE(sha256_hex("") ==
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    REQUIRE(sha256_hex("abc") ==
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    REQUIRE(sha256_hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    REQUIRE(sha256_hex(std::string(1000000, 'a')) ==
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE("hash_executable")
+{
+    const std::string filename("temporary_binary_for_tests");
+    {
+        std::ofstream binary(filename, std::ios::binary);
+        binary << "abc";
+    }
+    REQUIRE(hash_executable("./" + filename) == sha256_hex("abc"));
+    std::remove(filename.c_str());
+
+    REQUIRE(hash_executable("./" + filename).empty());
+#if defined(__linux__) || defined(__APPLE__)
+    // Found in the PATH like execvp() does
+    REQUIRE(hash_executable("sh").size() == 64);
+#endif
+}
+
+TEST_CASE("job_cache_key")
+{
+    CmdWithArgs job(0, "solver", {"a.cnf", "--seed=1"});
+    auto key = job_cache_key("binary", job, 10);
+    REQUIRE(key.size() == 64);
+
+    // The job index does not matter, everything else does
+    REQUIRE(job_cache_key("binary", CmdWithArgs(7, "solver", {"a.cnf", "--seed=1"}), 10) == key);
+    REQUIRE(job_cache_key("other", job, 10) != key);
+    REQUIRE(job_cache_key("binary", job, 20) != key);
+    REQUIRE(job_cache_key("binary", CmdWithArgs(0, "solver", {"a.cnf --seed=1"}), 10) != key);
+
+    // So do the environment and the working directory
+    auto threads = job_cache_key("binary",
+        CmdWithArgs(0, "solver", {"a.cnf", "--seed=1"}, {"OMP_NUM_THREADS=2"}, ""), 10);
+    REQUIRE(threads != key);
+    REQUIRE(job_cache_key("binary",
+        CmdWithArgs(0, "solver", {"a.cnf", "--seed=1"}, {"OMP_NUM_THREADS=4"}, ""), 10) != threads);
+    REQUIRE(job_cache_key("binary",
+        CmdWithArgs(0, "solver", {"a.cnf", "--seed=1"}, {}, "/tmp"), 10) != key);
+}
+
+TEST_CASE("job_cache_key of metric patterns")
+{
+    CmdWithArgs job(0, "solver", {"a.cnf"});
+    const std::vector<MetricPattern> objective{
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=")
+    };
+    auto key = job_cache_key("binary", job, 10, objective);
+
+    // Jobs without patterns keep their old keys
+    REQUIRE(job_cache_key("binary", job, 10, {}) == job_cache_key("binary", job, 10));
+    REQUIRE(key != job_cache_key("binary", job, 10));
+
+    // A new or changed pattern gives results with other metrics
+    auto more = objective;
+    more.emplace_back("nodes", MetricPattern::Kind::Prefix, "nodes=");
+    REQUIRE(job_cache_key("binary", job, 10, more) != key);
+    REQUIRE(job_cache_key("binary", job, 10, {
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "obj=") }) != key);
+    REQUIRE(job_cache_key("binary", job, 10, {
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=",
+            MetricPattern::Incumbent::Minimize) }) != key);
+}
+
+TEST_CASE("job_cache_key of input files")
+{
+    const std::string filename = "cache_test_instance.cnf";
+    std::remove(filename.c_str());
+    CmdWithArgs job(0, "solver", {"--instance=" + filename});
+    auto missing = job_cache_key("binary", job, 10);
+
+    std::ofstream(filename) << "p cnf 1 1\n1 0\n";
+    auto key = job_cache_key("binary", job, 10);
+    REQUIRE(job_cache_key("binary", job, 10) == key);
+
+#if defined(__linux__) || defined(__APPLE__)
+    // A regenerated instance is another job
+    REQUIRE(key != missing);
+    std::ofstream(filename) << "p cnf 1 2\n1 0\n-1 0\n";
+    REQUIRE(job_cache_key("binary", job, 10) != key);
+#endif
+
+    std::remove(filename.c_str());
+}
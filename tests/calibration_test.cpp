@@ -0,0 +1,63 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/calibration.hpp"
+
+#include "catch.hpp"
+
+using namespace perfnp;
+
+TEST_CASE("calibrate")
+{
+    SECTION("every slot is measured")
+    {
+        auto calibration = calibrate(2, 3, 0.05);
+        REQUIRE(calibration.repetitions == 3);
+        REQUIRE(calibration.slots.size() == 2);
+
+        for (const auto& slot : calibration.slots) {
+            REQUIRE(slot.cpu_time > 0);
+            REQUIRE(slot.memory_time > 0);
+            REQUIRE(slot.cv >= 0);
+            REQUIRE(slot.relative_speed > 0);
+            REQUIRE(slot.relative_speed <= 1);
+        }
+        REQUIRE(calibration.min_relative_speed() <= 1);
+        REQUIRE(calibration.relative_speeds().size() == 2);
+    }
+
+    SECTION("slots are pinned to their CPUs")
+    {
+        auto cpus = slot_cpus(1);
+#if defined(__linux__)
+        REQUIRE(cpus.size() == 1);
+#endif
+        auto calibration = calibrate(1, 2, 0.05, cpus);
+        REQUIRE(calibration.pinned() == !cpus.empty());
+        REQUIRE(calibration.slots[0].cpu == (cpus.empty() ? -1 : cpus[0]));
+
+        REQUIRE_FALSE(calibrate(1, 2, 0.05).pinned());
+        REQUIRE(slot_cpus(1u << 20).empty());
+    }
+
+    SECTION("invalid arguments")
+    {
+        REQUIRE_THROWS_AS(calibrate(2, 3, 0.05, { 0 }), std::runtime_error);
+        REQUIRE_THROWS_AS(calibrate(0), std::runtime_error);
+        REQUIRE_THROWS_AS(calibrate(1, 1), std::runtime_error);
+        REQUIRE_THROWS_AS(calibrate(1, 3, 0.0), std::runtime_error);
+    }
+}
+
+TEST_CASE("Calibration::cv")
+{
+    Calibration calibration;
+    calibration.repetitions = 5;
+    calibration.slots = { { 1.0, 2.0, 0.01, 1.0, 0 }, { 1.2, 2.4, 0.07, 0.8, -1 } };
+    REQUIRE(calibration.cv() == 0.07);
+    REQUIRE_FALSE(calibration.pinned());
+    REQUIRE(calibration.min_relative_speed() == 0.8);
+    REQUIRE(calibration.relative_speeds() == std::vector<double>{ 1.0, 0.8 });
+}
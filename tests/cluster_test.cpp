@@ -0,0 +1,183 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/cluster.hpp"
+
+#include "catch.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+#if defined(__linux__) || defined(__APPLE__)
+    //! Sends one line of the protocol and reads the reply, empty on failure
+    std::string exchange(int fd, const std::string& message)
+    {
+        const auto line = message + "\n";
+        if (send(fd, line.data(), line.size(), 0) != static_cast<ssize_t>(line.size())) {
+            return std::string();
+        }
+        std::string reply;
+        char c;
+        while (recv(fd, &c, 1, 0) == 1 && c != '\n') {
+            reply += c;
+        }
+        return reply;
+    }
+
+    //! Jobs of the sweep, the odd ones fail
+    std::vector<CmdWithArgs> shell_jobs(unsigned count)
+    {
+        std::vector<CmdWithArgs> jobs;
+        for (unsigned i = 0; i < count; ++i) {
+            jobs.emplace_back(i, "sh", std::vector<std::string>{
+                "-c", "exit " + std::to_string(i % 2) });
+        }
+        return jobs;
+    }
+#endif
+
+} // anonymous namespace
+
+TEST_CASE("parse_endpoint")
+{
+    std::string host;
+    unsigned port = 0;
+
+    parse_endpoint("node-7:7878", host, port);
+    REQUIRE(host == "node-7");
+    REQUIRE(port == 7878);
+
+    parse_endpoint(":0", host, port);
+    REQUIRE(host.empty());
+    REQUIRE(port == 0);
+
+    parse_endpoint("[::1]:80", host, port);
+    REQUIRE(host == "::1");
+    REQUIRE(port == 80);
+
+    REQUIRE_THROWS_AS(parse_endpoint("node-7", host, port), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_endpoint("node-7:", host, port), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_endpoint("node-7:65536", host, port), std::runtime_error);
+    REQUIRE_THROWS_AS(parse_endpoint("node-7:http", host, port), std::runtime_error);
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+TEST_CASE("Coordinator")
+{
+    CoordinatorSettings settings;
+    settings.host = "127.0.0.1";
+
+    SECTION("workers on localhost execute every job once")
+    {
+        const auto jobs = shell_jobs(12);
+        Coordinator coordinator(jobs, 10, {}, settings);
+        REQUIRE(coordinator.port() != 0);
+
+        // Catch is not thread-safe, the results are checked afterwards
+        std::vector<std::size_t> executed(3, 0);
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < executed.size(); ++i) {
+            workers.emplace_back([&, i] {
+                WorkerSettings worker;
+                worker.host = "127.0.0.1";
+                worker.port = coordinator.port();
+                worker.slots = 2;
+                worker.batch = 2;
+                executed[i] = run_worker(worker);
+            });
+        }
+
+        std::multiset<unsigned> finished;
+        std::set<unsigned> slots;
+        bool all_exit_codes_match = true;
+        SweepMonitor monitor;
+        auto dataset = coordinator.run(
+            [&](const CmdWithArgs& cwa, unsigned, const ExecResult& result, unsigned slot)
+            {
+                all_exit_codes_match = all_exit_codes_match
+                    && result.exit_code() == static_cast<int>(cwa.job_index() % 2);
+                finished.insert(cwa.job_index());
+                slots.insert(slot);
+            }, &monitor);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        REQUIRE(all_exit_codes_match);
+        REQUIRE(finished == std::multiset<unsigned>{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 });
+        REQUIRE(*slots.rbegin() < 6);
+        REQUIRE(executed[0] + executed[1] + executed[2] == 12);
+        REQUIRE(dataset.number_of_all_successful_runs() == 6);
+        REQUIRE(monitor.completed() == 12);
+        REQUIRE(monitor.running() == 0);
+    }
+
+    SECTION("jobs of a silent worker are given to others")
+    {
+        const auto jobs = shell_jobs(4);
+        settings.heartbeat = 1;
+        settings.lease = 1;
+        Coordinator coordinator(jobs, 10, {}, settings);
+
+        // A worker takes all jobs and never reports them
+        std::string leased;
+        std::size_t executed = 0;
+        std::thread cluster([&] {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address;
+            std::memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(coordinator.port()));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                exchange(fd, R"({"type":"hello","name":"silent","slots":1})");
+                leased = exchange(fd, R"({"type":"get","max":10})");
+
+                WorkerSettings worker;
+                worker.host = "127.0.0.1";
+                worker.port = coordinator.port();
+                executed = run_worker(worker);
+            }
+            close(fd);
+        });
+
+        std::set<unsigned> slots;
+        auto dataset = coordinator.run(
+            [&](const CmdWithArgs&, unsigned, const ExecResult&, unsigned slot)
+            {
+                slots.insert(slot);
+            });
+        cluster.join();
+
+        REQUIRE(nlohmann::json::parse(leased).at("jobs").size() == 4);
+        REQUIRE(executed == 4);
+        REQUIRE(slots == std::set<unsigned>{ 1 });
+        REQUIRE(dataset.number_of_all_successful_runs() == 2);
+    }
+
+    SECTION("port in use")
+    {
+        const auto jobs = shell_jobs(1);
+        Coordinator coordinator(jobs, 10, {}, settings);
+        settings.port = coordinator.port();
+        REQUIRE_THROWS_AS(Coordinator(jobs, 10, {}, settings), std::runtime_error);
+    }
+}
+#endif
@@ -65,3 +65,242 @@ TEST_CASE("combine_command_lines")
         ));
     }
 }
+
+TEST_CASE("JobSpace")
+{
+    Config c(R"({
+        "command" : "solver",
+        "arguments" : ["--seed=%seed%", "%instance%"],
+        "parameters" : [
+            { "name" : "instance", "values" : ["a.cnf", "b.cnf", "c.cnf"] },
+            { "name" : "seed", "range" : [1, 1000, 7] }
+        ]
+    })"_json);
+
+    JobSpace space(c);
+
+    SECTION("size is the product of the parameter sizes")
+    {
+        REQUIRE(space.size() == 3 * 143);
+    }
+
+    SECTION("jobs are decoded from their index")
+    {
+        REQUIRE(space.at(0) == CmdWithArgs(0, "solver", {"--seed=1", "a.cnf"}));
+        REQUIRE(space.at(144) == CmdWithArgs(144, "solver", {"--seed=8", "b.cnf"}));
+        REQUIRE(space.at(428) == CmdWithArgs(428, "solver", {"--seed=995", "c.cnf"}));
+        REQUIRE_THROWS_AS(space.at(429), std::out_of_range);
+    }
+
+    SECTION("jobs match combine_command_lines")
+    {
+        auto all = combine_command_lines(c);
+        REQUIRE(all.size() == space.size());
+        for (unsigned i = 0; i < all.size(); i += 37) {
+            REQUIRE(all[i] == space.at(i));
+        }
+    }
+}
+
+TEST_CASE("JobSpace with environment and working directory")
+{
+    Config c(R"({
+        "command" : "solver",
+        "arguments" : ["%instance%"],
+        "environment" : { "OMP_NUM_THREADS" : "%threads%", "MALLOC_ARENA_MAX" : "2" },
+        "working_directory" : "runs/%threads%",
+        "parameters" : [
+            { "name" : "instance", "values" : ["a.cnf"] },
+            { "name" : "threads", "values" : ["1", "8"] }
+        ]
+    })"_json);
+
+    JobSpace space(c);
+    auto job = space.at(1);
+    REQUIRE(job.arguments() == std::vector<std::string>{"a.cnf"});
+    REQUIRE_THAT(job.environment(), Catch::Matchers::UnorderedEquals(
+        std::vector<std::string>{"OMP_NUM_THREADS=8", "MALLOC_ARENA_MAX=2"}));
+    REQUIRE(job.working_directory() == "runs/8");
+    REQUIRE(!(space.at(0) == job));
+}
+
+TEST_CASE("JobSpace with zip groups and constraints")
+{
+    SECTION("zipped parameters take their values together")
+    {
+        Config c(R"({
+            "command" : "solver",
+            "arguments" : ["%instance%", "--optimum=%optimum%", "%seed%"],
+            "parameters" : [
+                { "name" : "instance", "values" : ["a.cnf", "b.cnf", "c.cnf"] },
+                { "name" : "seed", "values" : ["1", "2"] },
+                { "name" : "optimum", "values" : ["10", "20", "30"] }
+            ],
+            "zip" : [["optimum", "instance"]]
+        })"_json);
+
+        // The zip group is a single digit of the index
+        JobSpace space(c);
+        REQUIRE(space.size() == 6);
+        REQUIRE(space.axes() == std::vector<std::size_t>{0, 1});
+        REQUIRE(space.next(1) == 1);
+        REQUIRE(space.contains(5));
+        REQUIRE(space.index_of({2, 1}) == 5);
+
+        auto jobs = combine_command_lines(c);
+        REQUIRE(jobs.size() == 6);
+        REQUIRE(jobs[0] == CmdWithArgs(0, "solver", {"a.cnf", "--optimum=10", "1"}));
+        REQUIRE(jobs[1] == CmdWithArgs(1, "solver", {"a.cnf", "--optimum=10", "2"}));
+        REQUIRE(jobs[5] == CmdWithArgs(5, "solver", {"c.cnf", "--optimum=30", "2"}));
+    }
+
+    SECTION("a zip group larger than the square root of 2^32 fits a sweep")
+    {
+        Config c(R"({
+            "command" : "solver",
+            "arguments" : ["%instance%", "--optimum=%optimum%"],
+            "parameters" : [
+                { "name" : "instance", "range" : [1, 70000] },
+                { "name" : "optimum", "range" : [100001, 170000] }
+            ],
+            "zip" : [["instance", "optimum"]]
+        })"_json);
+
+        JobSpace space(c);
+        REQUIRE(space.size() == 70000);
+        auto jobs = combine_command_lines(c);
+        REQUIRE(jobs.size() == 70000);
+        REQUIRE(jobs.back() == CmdWithArgs(69999, "solver", {"70000", "--optimum=170000"}));
+    }
+
+    SECTION("violated constraints skip whole subtrees")
+    {
+        Config c(R"({
+            "command" : "solver",
+            "arguments" : ["%algorithm%", "%flag%", "%instance%"],
+            "parameters" : [
+                { "name" : "algorithm", "values" : ["dfs", "bfs", "astar"] },
+                { "name" : "flag", "values" : ["", "--prune"] },
+                { "name" : "instance", "range" : [1, 100] }
+            ],
+            "constraints" : [
+                "flag == '' || algorithm == 'dfs'",
+                "algorithm != 'astar' || instance <= 10"
+            ]
+        })"_json);
+
+        JobSpace space(c);
+        auto jobs = combine_command_lines(c);
+        REQUIRE(jobs.size() == 200 + 100 + 10);
+        REQUIRE(space.next(300) == 400);
+        REQUIRE(space.next(410) == space.size());
+
+        // The same jobs as filtering all combinations
+        size_t matched = 0;
+        for (unsigned long long i = 0; i < space.size(); ++i) {
+            auto job = space.at(i);
+            const auto& args = job.arguments();
+            bool valid = (args[1].empty() || args[0] == "dfs")
+                && (args[0] != "astar" || std::stoi(args[2]) <= 10);
+            if (valid) {
+                REQUIRE(jobs.at(matched++) == job);
+            }
+        }
+        REQUIRE(matched == jobs.size());
+    }
+
+    SECTION("no combination satisfies the constraints")
+    {
+        Config c(R"({
+            "command" : "solver",
+            "arguments" : ["%a%"],
+            "parameters" : [ { "name" : "a", "values" : ["1", "2"] } ],
+            "constraints" : [ "a > 2" ]
+        })"_json);
+
+        REQUIRE(JobSpace(c).next(0) == 2);
+        REQUIRE(combine_command_lines(c).empty());
+    }
+}
+
+TEST_CASE("JobSpace::digest")
+{
+    auto digest = [](const char* command, const char* parameters, const char* zip) {
+        Config c(nlohmann::json::parse(std::string("{ \"command\" : \"") + command
+            + "\", \"arguments\" : [\"%a%\", \"%b%\"], \"parameters\" : "
+            + parameters + (zip[0] ? std::string(", \"zip\" : ") + zip : "") + " }"));
+        return JobSpace(c).digest();
+    };
+    const char* parameters = R"([
+        { "name" : "a", "values" : ["1", "2"] },
+        { "name" : "b", "values" : ["x", "y"] } ])";
+    auto original = digest("solver", parameters, "");
+    REQUIRE(original.size() == 64);
+
+    // Another build of the solver has the same jobs
+    REQUIRE(digest("/opt/new/solver", parameters, "") == original);
+
+    REQUIRE(digest("solver", R"([
+        { "name" : "a", "values" : ["2", "1"] },
+        { "name" : "b", "values" : ["x", "y"] } ])", "") != original);
+    REQUIRE(digest("solver", R"([
+        { "name" : "a", "values" : ["1", "2"] },
+        { "name" : "b", "values" : ["x", "y", "z"] } ])", "") != original);
+    REQUIRE(digest("solver", parameters, R"([["a", "b"]])") != original);
+}
+
+TEST_CASE("Shard")
+{
+    SECTION("parsing")
+    {
+        auto strided = Shard::parse("2/4");
+        REQUIRE(strided.index == 1);
+        REQUIRE(strided.count == 4);
+        REQUIRE(strided.policy == Shard::Policy::Strided);
+        REQUIRE(strided.to_string() == "2/4");
+        REQUIRE(Shard::parse("3/3:hashed").policy == Shard::Policy::Hashed);
+        REQUIRE_FALSE(Shard().enabled());
+
+        for (auto text : { "0/4", "5/4", "1/0", "1", "/4", "1/", "a/4", "1/4:random", "1/2/3" }) {
+            REQUIRE_THROWS_AS(Shard::parse(text), std::runtime_error);
+        }
+    }
+
+    SECTION("shards are disjoint and cover all jobs")
+    {
+        Config c(R"({
+            "command" : "solver",
+            "arguments" : ["%a%", "%b%"],
+            "parameters" : [
+                { "name" : "a", "range" : [1, 10] },
+                { "name" : "b", "range" : [1, 7] }
+            ],
+            "constraints" : ["a != 3"]
+        })"_json);
+        const auto all = combine_command_lines(c);
+
+        for (auto policy : { ":strided", ":hashed" }) {
+            std::vector<unsigned> owners(70, 0);
+            size_t jobs = 0;
+            for (unsigned i = 1; i <= 3; ++i) {
+                auto text = std::to_string(i) + "/3"
+                    + (std::string(policy) == ":hashed" ? policy : "");
+                auto shard = combine_command_lines(c, Shard::parse(text));
+                REQUIRE(!shard.empty());
+                for (const auto& job : shard) {
+                    ++owners.at(job.job_index());
+                }
+                jobs += shard.size();
+
+                // Strided shards are balanced
+                if (std::string(policy) == ":strided") {
+                    REQUIRE(shard.size() == 21);
+                }
+            }
+            REQUIRE(jobs == all.size());
+            for (const auto& job : all) {
+                REQUIRE(owners[job.job_index()] == 1);
+            }
+        }
+    }
+}
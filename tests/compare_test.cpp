@@ -0,0 +1,103 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/compare.hpp"
+
+#include "catch.hpp"
+
+using namespace perfnp;
+
+namespace {
+
+    PairedInstance instance(double runtime_a, double runtime_b,
+        unsigned solved_a = 1, unsigned solved_b = 1)
+    {
+        return PairedInstance{ "solver", runtime_a, runtime_b, solved_a, solved_b };
+    }
+
+} // anonymous namespace
+
+TEST_CASE("RunComparator::compare")
+{
+    SECTION("no instances")
+    {
+        RunComparator comparator;
+        auto result = comparator.compare();
+        REQUIRE(result.paired == 0);
+        REQUIRE(result.speedup == 1);
+        REQUIRE(result.p_value == 1);
+    }
+
+    SECTION("identical runs have no speedup")
+    {
+        RunComparator comparator;
+        for (unsigned i = 1; i <= 20; ++i) {
+            comparator.add(instance(i, i));
+        }
+        auto result = comparator.compare();
+        REQUIRE(result.paired == 20);
+        REQUIRE(result.speedup == Approx(1));
+        REQUIRE(result.speedup_lower == Approx(1));
+        REQUIRE(result.speedup_upper == Approx(1));
+        REQUIRE(result.p_value == 1);
+    }
+
+    SECTION("consistent speedup is significant")
+    {
+        RunComparator comparator;
+        for (unsigned i = 1; i <= 20; ++i) {
+            comparator.add(instance(2 * i + (i % 3), i));
+        }
+        auto result = comparator.compare();
+        REQUIRE(result.speedup > 2);
+        REQUIRE(result.speedup_lower <= result.speedup);
+        REQUIRE(result.speedup_upper >= result.speedup);
+        REQUIRE(result.speedup_lower > 1.5);
+        REQUIRE(result.wilcoxon_w == 20 * 21 / 2);
+        REQUIRE(result.wilcoxon_z > 3);
+        REQUIRE(result.p_value < 0.001);
+    }
+
+    SECTION("slowdown has a negative statistic")
+    {
+        RunComparator comparator;
+        for (unsigned i = 1; i <= 10; ++i) {
+            comparator.add(instance(i, 3 * i + i % 2));
+        }
+        auto result = comparator.compare();
+        REQUIRE(result.speedup < 1);
+        REQUIRE(result.wilcoxon_w == 0);
+        REQUIRE(result.wilcoxon_z < 0);
+        REQUIRE(result.p_value < 0.01);
+    }
+
+    SECTION("solved jobs are counted")
+    {
+        RunComparator comparator;
+        comparator.add(instance(10, 5, 0, 1));
+        comparator.add(instance(4, 4, 2, 2));
+        auto result = comparator.compare();
+        REQUIRE(result.solved_a == 2);
+        REQUIRE(result.solved_b == 3);
+    }
+
+    SECTION("the same seed gives the same interval")
+    {
+        RunComparator comparator;
+        for (unsigned i = 1; i <= 10; ++i) {
+            comparator.add(instance(i + i % 4, i));
+        }
+        auto result1 = comparator.compare(0.9, 1000, 42);
+        auto result2 = comparator.compare(0.9, 1000, 42);
+        REQUIRE(result1.speedup_lower == result2.speedup_lower);
+        REQUIRE(result1.speedup_upper == result2.speedup_upper);
+    }
+
+    SECTION("invalid confidence")
+    {
+        RunComparator comparator;
+        REQUIRE_THROWS(comparator.compare(1.0));
+    }
+}
@@ -7,11 +7,45 @@
 
 #include "catch.hpp"
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 using namespace perfnp;
 using namespace std;
 
 using json = nlohmann::json;
 
+TEST_CASE("Config validation")
+{
+    SECTION("errors name the path of the field")
+    {
+        try {
+            Config c(R"({"parameters":[
+                { "name" : "a", "values" : ["x"] },
+                { "name" : "b", "values" : ["y", 5] }
+            ]})"_json);
+            FAIL("Invalid configuration was accepted.");
+        } catch (const std::runtime_error& ex) {
+            REQUIRE(std::string(ex.what()).find("parameters[1].values[1]")
+                != std::string::npos);
+        }
+    }
+
+    SECTION("configuration is not an object")
+    {
+        REQUIRE_THROWS_AS(Config(R"([1, 2])"_json), std::runtime_error);
+    }
+
+    SECTION("JSON is moved into the config")
+    {
+        auto j = R"({"timeout":10, "command":"sh", "arguments":[]})"_json;
+        Config c(std::move(j));
+        REQUIRE(c.timeout() == 10);
+        REQUIRE(c.to_string() == R"({"arguments":[],"command":"sh","timeout":10})");
+    }
+}
+
 TEST_CASE("Config::timeout")
 {
     SECTION("standard operation")
@@ -28,8 +62,7 @@ TEST_CASE("Config::timeout")
 
     SECTION("field has invalid type")
     {
-        Config c(R"({"timeout":"hello"})"_json);
-        REQUIRE_THROWS_AS(c.timeout(), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"timeout":"hello"})"_json), std::runtime_error);
     }
 }
 
@@ -49,8 +82,7 @@ TEST_CASE("Config::command")
 
     SECTION("field has invalid type")
     {
-        Config c(R"({"command":0})"_json);
-        REQUIRE_THROWS_AS(c.command(), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"command":0})"_json), std::runtime_error);
     }
 }
 
@@ -93,14 +125,12 @@ TEST_CASE("Config::arguments")
 
         SECTION("wrong outer type")
         {
-            Config c(R"({ "arguments" : {} })"_json);
-            REQUIRE_THROWS_AS(c.arguments(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({ "arguments" : {} })"_json), std::runtime_error);
         }
 
         SECTION("wrong inner type")
         {
-            Config c(R"({ "arguments" : [{}] })"_json);
-            REQUIRE_THROWS_AS(c.arguments(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({ "arguments" : [{}] })"_json), std::runtime_error);
         }
     }
 }
@@ -124,14 +154,41 @@ TEST_CASE("Config::parameters")
                 } );
             REQUIRE(c.parameters() == std::vector<Parameter>{expected2});
         }
+
+        SECTION("integer ranges")
+        {
+            Config c(R"({"parameters": [
+                { "name" : "seed", "range" : [1, 1000, 7] },
+                { "name" : "k", "range" : [3, -3, -3] },
+                { "name" : "one", "range" : [5, 5] }
+            ]})"_json);
+
+            const auto& seed = c.parameters()[0];
+            REQUIRE(seed.size() == 143);
+            REQUIRE(seed.value(0) == "1");
+            REQUIRE(seed.value(142) == "995");
+            REQUIRE(c.parameters()[1].values() == std::vector<std::string>{"3", "0", "-3"});
+            REQUIRE(c.parameters()[2].values() == std::vector<std::string>{"5"});
+        }
+
+        SECTION("values listed in a manifest file")
+        {
+            std::ofstream("perfnp_config_manifest.txt")
+                << "# instances\n" << "a.cnf\n" << "b.cnf\n";
+            Config c(R"({"parameters": [
+                { "name" : "instance", "file" : "perfnp_config_manifest.txt" }
+            ]})"_json);
+            std::remove("perfnp_config_manifest.txt");
+
+            REQUIRE(c.parameters()[0].values() == std::vector<std::string>{"a.cnf", "b.cnf"});
+        }
     }
 
     SECTION("corner cases")
     {
         SECTION("no parameters at all")
         {
-            Config c(R"({ "parameters":[] })"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({ "parameters":[] })"_json), std::runtime_error);
         }
     }
 
@@ -139,40 +196,242 @@ TEST_CASE("Config::parameters")
     {
         SECTION("empty name")
         {
-            Config c(R"({"parameters":[
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
                 { "name" : "", "values" : ["a"] }
-            ]})"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+            ]})"_json), std::runtime_error);
         }
 
         SECTION("empty set of value")
         {
-            Config c(R"({"parameters":[
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
                 { "name" : "v", "values" : [] }
-            ]})"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+            ]})"_json), std::runtime_error);
         }
 
         SECTION("invalid type of the map")
         {
-            Config c(R"({ "parameters":{} })"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({ "parameters":{} })"_json), std::runtime_error);
         }
 
         SECTION("invalid type of the values")
         {
-            Config c(R"({"parameters":[
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
                 { "name" : "a", "values" : {} }
-            ]})"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+            ]})"_json), std::runtime_error);
         }
 
         SECTION("invalid type of a value")
         {
-            Config c(R"({"parameters":[
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
                 { "name" : "a", "values" : 123 }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("more than one source of values")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "values" : ["1"], "range" : [1, 2] }
+            ]})"_json), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a" }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("invalid ranges")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "range" : [1] }
+            ]})"_json), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "range" : [1, 2.5] }
+            ]})"_json), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "range" : [1, 5, 0] }
+            ]})"_json), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "range" : [5, 1] }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("missing manifest and glob without matches")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "file" : "perfnp_missing_manifest.txt" }
+            ]})"_json), std::runtime_error);
+#if defined(__linux__) || defined(__APPLE__)
+            REQUIRE_THROWS_AS(Config(R"({"parameters":[
+                { "name" : "a", "glob" : "perfnp_missing_dir/*.cnf" }
+            ]})"_json), std::runtime_error);
+#endif
+        }
+    }
+}
+
+TEST_CASE("Config::zip_groups and Config::constraints")
+{
+    SECTION("positive cases")
+    {
+        Config c(R"({"parameters": [
+                { "name" : "a", "values" : ["1", "2"] },
+                { "name" : "b", "values" : ["x"] },
+                { "name" : "c", "values" : ["3", "4"] }
+            ],
+            "zip" : [["c", "a"]],
+            "constraints" : ["a != 2 || b == 'x'"]
+        })"_json);
+
+        REQUIRE(c.zip_groups() == std::vector<std::vector<size_t>>{ {0, 2} });
+        REQUIRE(c.constraints().size() == 1);
+        REQUIRE(c.constraints()[0].last_parameter() == 1);
+
+        Config plain(R"({"parameters": [ { "name" : "a", "values" : ["1"] } ]})"_json);
+        REQUIRE(plain.zip_groups().empty());
+        REQUIRE(plain.constraints().empty());
+    }
+
+    SECTION("negative cases")
+    {
+        // Parameters with different numbers of values
+        REQUIRE_THROWS_AS(Config(R"({"parameters": [
+                { "name" : "a", "values" : ["1", "2"] },
+                { "name" : "b", "values" : ["x"] }
+            ],
+            "zip" : [["a", "b"]]
+        })"_json), std::runtime_error);
+
+        // A parameter in two groups, an unknown one and a lonely one
+        REQUIRE_THROWS_AS(Config(R"({"parameters": [
+                { "name" : "a", "values" : ["1"] },
+                { "name" : "b", "values" : ["x"] },
+                { "name" : "c", "values" : ["y"] }
+            ],
+            "zip" : [["a", "b"], ["b", "c"]]
+        })"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"parameters": [
+                { "name" : "a", "values" : ["1"] }
+            ],
+            "zip" : [["a", "z"]]
+        })"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"parameters": [
+                { "name" : "a", "values" : ["1"] }
+            ],
+            "zip" : [["a"]]
+        })"_json), std::runtime_error);
+
+        // Invalid expressions name the constraint
+        try {
+            Config(R"({"parameters": [
+                    { "name" : "a", "values" : ["1"] }
+                ],
+                "constraints" : ["a == 1", "z == 1"]
+            })"_json);
+            FAIL("Unknown parameter is accepted");
+        } catch (const std::runtime_error& ex) {
+            REQUIRE(std::string(ex.what()).find("\"constraints[1]\"") != std::string::npos);
+        }
+        REQUIRE_THROWS_AS(Config(R"({"constraints" : ["1 == 1"]})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::sample")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"sample":{"design":"latin_hypercube","size":500,"seed":7}})"_json);
+        REQUIRE(c.sample().enabled());
+        REQUIRE(c.sample().design == SampleSettings::Design::LatinHypercube);
+        REQUIRE(c.sample().size == 500);
+        REQUIRE(c.sample().seed == 7);
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({})"_json);
+        REQUIRE_FALSE(c.sample().enabled());
+    }
+
+    SECTION("negative cases")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"sample":{"design":"grid","size":5}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"sample":{"design":"sobol"}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"sample":{"design":"sobol","size":0}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"sample":{"design":"random","size":5,"seed":-1}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::metrics")
+{
+    SECTION("positive cases")
+    {
+        SECTION("regex and prefix patterns")
+        {
+            Config c(R"({"metrics":[
+                { "name" : "objective", "regex" : "Objective: (.*)$" },
+                { "name" : "nodes", "prefix" : "nodes=" }
+            ]})"_json);
+
+            REQUIRE(c.metrics() == std::vector<MetricPattern>{
+                MetricPattern("objective", MetricPattern::Kind::Regex, "Objective: (.*)$"),
+                MetricPattern("nodes", MetricPattern::Kind::Prefix, "nodes=")
+            });
+        }
+
+        SECTION("incumbent metric")
+        {
+            Config c(R"({"metrics":[
+                { "name" : "obj", "prefix" : "obj=", "incumbent" : "maximize" }
             ]})"_json);
-            REQUIRE_THROWS_AS(c.parameters(), std::runtime_error);
+
+            REQUIRE(c.metrics() == std::vector<MetricPattern>{
+                MetricPattern("obj", MetricPattern::Kind::Prefix, "obj=",
+                    MetricPattern::Incumbent::Maximize)
+            });
+        }
+
+        SECTION("field is missing")
+        {
+            Config c(R"({})"_json);
+            REQUIRE(c.metrics().empty());
+        }
+    }
+
+    SECTION("negative cases")
+    {
+        SECTION("invalid type of the list")
+        {
+            REQUIRE_THROWS_AS(Config(R"({ "metrics" : {} })"_json), std::runtime_error);
+        }
+
+        SECTION("both regex and prefix")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"metrics":[
+                { "name" : "x", "regex" : "a", "prefix" : "b" }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("no pattern")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"metrics":[ { "name" : "x" } ]})"_json), std::runtime_error);
+        }
+
+        SECTION("invalid incumbent sense")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"metrics":[
+                { "name" : "x", "prefix" : "x=", "incumbent" : "best" }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("two incumbents")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"metrics":[
+                { "name" : "x", "prefix" : "x=", "incumbent" : "minimize" },
+                { "name" : "y", "prefix" : "y=", "incumbent" : "minimize" }
+            ]})"_json), std::runtime_error);
+        }
+
+        SECTION("invalid regex")
+        {
+            REQUIRE_THROWS_AS(Config(R"({"metrics":[ { "name" : "x", "regex" : "((" } ]})"_json), std::runtime_error);
         }
     }
 }
@@ -200,18 +459,342 @@ TEST_CASE("Config::csv_output_file")
     {
         SECTION("wrong type 1")
         {
-            Config c(R"({"logging":{"job":{"csv":1}}})"_json);
-            REQUIRE_THROWS_AS(c.logging_job_csv_file(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"logging":{"job":{"csv":1}}})"_json), std::runtime_error);
         }
         SECTION("wrong type 2")
         {
-            Config c(R"({"logging":{"job":[]}})"_json);
-            REQUIRE_THROWS_AS(c.logging_job_csv_file(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"logging":{"job":[]}})"_json), std::runtime_error);
         }
         SECTION("wrong type 3")
         {
-            Config c(R"({"logging":"a"})"_json);
-            REQUIRE_THROWS_AS(c.logging_job_csv_file(), std::runtime_error);
+            REQUIRE_THROWS_AS(Config(R"({"logging":"a"})"_json), std::runtime_error);
         }
     }
 }
+
+TEST_CASE("Config::statistics_par_k")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"statistics":{"par_k":10}})"_json);
+        REQUIRE(c.statistics_par_k() == 10);
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({})"_json);
+        REQUIRE(c.statistics_par_k() == 2);
+    }
+
+    SECTION("value is not a positive integer")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"statistics":{"par_k":0}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"statistics":{"par_k":"2"}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::logging_cactus_csv_file")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"logging":{"cactus":{"csv":"cactus.csv"}}})"_json);
+        REQUIRE(c.logging_cactus_csv_file() == "cactus.csv");
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({"logging":{"job":{"csv":"jobs.csv"}}})"_json);
+        REQUIRE(c.logging_cactus_csv_file().empty());
+    }
+
+    SECTION("wrong type")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"logging":{"cactus":{"csv":1}}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::logging_trace_file")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"logging":{"trace":{"json":"trace.json"}}})"_json);
+        REQUIRE(c.logging_trace_file() == "trace.json");
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({"logging":{"cactus":{"csv":"cactus.csv"}}})"_json);
+        REQUIRE(c.logging_trace_file().empty());
+    }
+
+    SECTION("wrong type")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"logging":{"trace":{"json":true}}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::statistics_group_by")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"statistics":{"group_by":["solver","flag"]}})"_json);
+        REQUIRE(c.statistics_group_by() == std::vector<std::string>{"solver", "flag"});
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({"statistics":{}})"_json);
+        REQUIRE(c.statistics_group_by().empty());
+    }
+
+    SECTION("wrong type")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"statistics":{"group_by":"solver"}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"statistics":{"group_by":[1]}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::statistics_instance")
+{
+    REQUIRE(Config(R"({"statistics":{}})"_json).statistics_instance().empty());
+    REQUIRE(Config(R"({"statistics":{"instance":["graph","seed"]}})"_json).statistics_instance()
+        == std::vector<std::string>{"graph", "seed"});
+    REQUIRE_THROWS_AS(Config(R"({"statistics":{"instance":"graph"}})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::gate_thresholds")
+{
+    SECTION("values are present")
+    {
+        Config c(R"({"gate":{"median_slowdown":5,"solved_drop":1,"par_k_increase":2.5}})"_json);
+        auto thresholds = c.gate_thresholds();
+        REQUIRE(thresholds.median_slowdown == 5);
+        REQUIRE(thresholds.solved_drop == 1);
+        REQUIRE(thresholds.par_k_increase == 2.5);
+    }
+
+    SECTION("missing values have defaults")
+    {
+        Config c(R"({"gate":{"solved_drop":3}})"_json);
+        auto thresholds = c.gate_thresholds();
+        REQUIRE(thresholds.median_slowdown == 10);
+        REQUIRE(thresholds.solved_drop == 3);
+        REQUIRE(thresholds.par_k_increase == 10);
+    }
+
+    SECTION("negative or non-numeric values")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"gate":{"median_slowdown":-1}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"gate":{"par_k_increase":"5"}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"gate":[]})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::workers")
+{
+    SECTION("value is present")
+    {
+        Config c(R"({"workers":4})"_json);
+        REQUIRE(c.workers() == 4);
+    }
+
+    SECTION("value is missing")
+    {
+        Config c(R"({})"_json);
+        REQUIRE(c.workers() == 1);
+    }
+
+    SECTION("value is not a positive integer")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"workers":0})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"workers":"4"})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::calibration")
+{
+    SECTION("calibration is disabled by default")
+    {
+        Config c(R"({})"_json);
+        REQUIRE_FALSE(c.calibration().enabled);
+    }
+
+    SECTION("empty object enables defaults")
+    {
+        Config c(R"({"calibration":{}})"_json);
+        auto settings = c.calibration();
+        REQUIRE(settings.enabled);
+        REQUIRE(settings.repetitions == 5);
+        REQUIRE(settings.max_cv == 0.05);
+        REQUIRE_FALSE(settings.refuse);
+    }
+
+    SECTION("values are present")
+    {
+        Config c(R"({"calibration":{"repetitions":7,"max_cv":0.02,"on_noise":"refuse"}})"_json);
+        auto settings = c.calibration();
+        REQUIRE(settings.repetitions == 7);
+        REQUIRE(settings.max_cv == 0.02);
+        REQUIRE(settings.refuse);
+    }
+
+    SECTION("wrong values")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"calibration":{"repetitions":1}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"calibration":{"max_cv":0}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"calibration":{"on_noise":"ignore"}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"calibration":true})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::monitor")
+{
+    SECTION("not configured")
+    {
+        Config c(R"({"timeout":10})"_json);
+        REQUIRE_FALSE(c.monitor().enabled());
+    }
+
+    SECTION("Unix socket")
+    {
+        Config c(R"({"monitor":{"socket":"/tmp/perfnp.sock"}})"_json);
+        auto settings = c.monitor();
+        REQUIRE(settings.enabled());
+        REQUIRE(settings.socket == "/tmp/perfnp.sock");
+        REQUIRE(settings.port == 0);
+    }
+
+    SECTION("localhost port")
+    {
+        Config c(R"({"monitor":{"port":9464}})"_json);
+        REQUIRE(c.monitor().port == 9464);
+        REQUIRE(c.monitor().socket.empty());
+    }
+
+    SECTION("invalid values")
+    {
+        REQUIRE_THROWS_AS(Config(R"({"monitor":true})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"monitor":{"port":70000}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"monitor":{"socket":""}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"monitor":{}})"_json), std::runtime_error);
+        REQUIRE_THROWS_AS(Config(R"({"monitor":{"socket":"a.sock","port":9464}})"_json), std::runtime_error);
+    }
+}
+
+TEST_CASE("Config::on_interrupt")
+{
+    REQUIRE(Config(R"({})"_json).on_interrupt() == InterruptPolicy::Kill);
+    REQUIRE(Config(R"({"on_interrupt":"kill"})"_json).on_interrupt() == InterruptPolicy::Kill);
+    REQUIRE(Config(R"({"on_interrupt":"finish"})"_json).on_interrupt() == InterruptPolicy::Finish);
+    REQUIRE_THROWS_AS(Config(R"({"on_interrupt":"wait"})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::page_cache")
+{
+    REQUIRE(!Config(R"({})"_json).page_cache().enabled());
+
+    Config config(R"({"page_cache":{"mode":"pin","ahead":3}})"_json);
+    REQUIRE(config.page_cache().mode == PageCacheSettings::Mode::Pin);
+    REQUIRE(config.page_cache().ahead == 3);
+    REQUIRE(Config(R"({"page_cache":{"mode":"cold"}})"_json).page_cache().ahead == 8);
+
+    REQUIRE_THROWS_AS(Config(R"({"page_cache":{}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"page_cache":{"mode":"hot"}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"page_cache":{"mode":"warm","ahead":0}})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::scratch")
+{
+    REQUIRE(!Config(R"({})"_json).scratch().enabled());
+
+    Config config(R"({"scratch":{"directory":"/dev/shm/perfnp","inputs":"copy","archive":"kept"}})"_json);
+    REQUIRE(config.scratch().directory == "/dev/shm/perfnp");
+    REQUIRE(config.scratch().inputs == ScratchSettings::Inputs::Copy);
+    REQUIRE(config.scratch().archive == "kept");
+    REQUIRE(Config(R"({"scratch":{"directory":"s"}})"_json).scratch().inputs
+        == ScratchSettings::Inputs::Link);
+
+    REQUIRE_THROWS_AS(Config(R"({"scratch":{}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"scratch":{"directory":""}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"scratch":{"directory":"s","inputs":"move"}})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::environment and Config::working_directory")
+{
+    Config empty(R"({})"_json);
+    REQUIRE(empty.environment().empty());
+    REQUIRE(empty.working_directory().empty());
+
+    Config config(R"({"environment":{"LD_PRELOAD":"%allocator%"},"working_directory":"w"})"_json);
+    REQUIRE(config.environment().size() == 1);
+    REQUIRE(config.environment()[0].first == "LD_PRELOAD");
+    REQUIRE(config.environment()[0].second == "%allocator%");
+    REQUIRE(config.working_directory() == "w");
+
+    REQUIRE_THROWS_AS(Config(R"({"environment":["A=1"]})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"environment":{"A=B":"1"}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"environment":{"A":1}})"_json), std::runtime_error);
+    REQUIRE_THROWS_AS(Config(R"({"working_directory":3})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::cache")
+{
+    REQUIRE(Config(R"({})"_json).cache() == CachePolicy::Never);
+    REQUIRE(Config(R"({"cache":"never"})"_json).cache() == CachePolicy::Never);
+    REQUIRE(Config(R"({"cache":"reuse"})"_json).cache() == CachePolicy::Reuse);
+    REQUIRE(Config(R"({"cache":"reuse_same_host"})"_json).cache() == CachePolicy::ReuseSameHost);
+    REQUIRE_THROWS_AS(Config(R"({"cache":true})"_json), std::runtime_error);
+}
+
+TEST_CASE("Config::parse")
+{
+    const std::string text = R"({
+        "timeout" : 10,
+        "command" : "solver",
+        "arguments" : ["%instance%", "%seed%"],
+        "parameters" : [
+            { "name" : "instance", "values" : ["a.cnf", "b \"quoted\".cnf", "a.cnf"] },
+            { "values" : ["1", "2"], "name" : "seed" }
+        ],
+        "statistics" : { "group_by" : ["instance"], "par_k" : 10 }
+    })";
+
+    SECTION("streamed values are equal to the parsed ones")
+    {
+        std::istringstream input(text);
+        auto streamed = Config::parse(input);
+        Config parsed(json::parse(text));
+
+        REQUIRE(streamed.parameters() == parsed.parameters());
+        REQUIRE(streamed.parameters()[0].value(1) == "b \"quoted\".cnf");
+        REQUIRE(streamed.parameters()[0].value(2) == "a.cnf");
+        REQUIRE(streamed.statistics_par_k() == 10);
+        REQUIRE(streamed.to_string() == parsed.to_string());
+    }
+
+    SECTION("value of a wrong type")
+    {
+        std::istringstream input(R"({"parameters":[
+            { "name" : "a", "values" : ["x", 1] }
+        ]})");
+        try {
+            Config::parse(input);
+            FAIL("Invalid configuration was accepted.");
+        } catch (const std::runtime_error& ex) {
+            REQUIRE(std::string(ex.what()).find("parameters[0].values[1]")
+                != std::string::npos);
+        }
+    }
+
+    SECTION("invalid JSON")
+    {
+        std::istringstream input(R"({"timeout": )");
+        REQUIRE_THROWS_AS(Config::parse(input), std::runtime_error);
+    }
+
+    SECTION("missing values")
+    {
+        std::istringstream input(R"({"parameters":[ { "name" : "a" } ]})");
+        REQUIRE_THROWS_AS(Config::parse(input), std::runtime_error);
+    }
+}
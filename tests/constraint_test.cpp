@@ -0,0 +1,62 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/constraint.hpp"
+
+#include "catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace perfnp;
+
+TEST_CASE("Constraint")
+{
+    const std::vector<std::string> names = { "solver", "flag", "threads" };
+
+    SECTION("comparisons of parameters and literals")
+    {
+        Constraint c("solver == 'dfs' || flag == \"\"", names);
+        REQUIRE(c.last_parameter() == 1);
+        REQUIRE(c({ "dfs", "--fast", "1" }));
+        REQUIRE(c({ "bfs", "", "1" }));
+        REQUIRE_FALSE(c({ "bfs", "--fast", "1" }));
+    }
+
+    SECTION("numbers are compared numerically")
+    {
+        Constraint c("%threads% <= 8 && threads > 1.5", names);
+        REQUIRE(c.last_parameter() == 2);
+        REQUIRE(c({ "", "", "2" }));
+        REQUIRE(c({ "", "", "8" }));
+        REQUIRE_FALSE(c({ "", "", "10" }));
+        REQUIRE_FALSE(c({ "", "", "1" }));
+
+        Constraint strings("solver < 'b'", names);
+        REQUIRE(strings({ "a10", "", "" }));
+        REQUIRE_FALSE(strings({ "b", "", "" }));
+    }
+
+    SECTION("negation, precedence and parentheses")
+    {
+        Constraint c("!(solver == 'cbc' && threads > 1) && flag != 'x' || solver == 'x'", names);
+        REQUIRE(c({ "cbc", "", "1" }));
+        REQUIRE_FALSE(c({ "cbc", "", "4" }));
+        REQUIRE_FALSE(c({ "glpk", "x", "1" }));
+        REQUIRE(c({ "x", "x", "4" }));
+    }
+
+    SECTION("invalid expressions")
+    {
+        REQUIRE_THROWS_AS(Constraint("", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("solver", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("solver == 'a", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("unknown == 1", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("(solver == 1", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("solver == 1 flag", names), std::runtime_error);
+        REQUIRE_THROWS_AS(Constraint("threads == 1.2.3", names), std::runtime_error);
+    }
+}
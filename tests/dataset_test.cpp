@@ -3,6 +3,7 @@
 // This software is released under the MIT License.
 // https://opensource.org/licenses/MIT
 
+#include "perfnp/combin.hpp"
 #include "perfnp/dataset.hpp"
 #include <nlohmann/json.hpp>
 #include "catch.hpp"
@@ -210,3 +211,513 @@ TEST_CASE("Dataset::number_of_all_successful_runs")
 
     }
 }
+
+TEST_CASE("Dataset::metric_summaries")
+{
+    SECTION("Typical usage")
+    {
+        Dataset d(10, {
+            ExecResult(0, 1, { MetricValue("obj", 4), MetricValue("nodes", 10) }),
+            ExecResult(1, 10, { MetricValue("obj", 2) }),
+            ExecResult(0, 3, { MetricValue("obj", 9) }),
+            ExecResult(0, 3)
+        });
+        auto summaries = d.metric_summaries();
+        REQUIRE(summaries.size() == 2);
+
+        REQUIRE(summaries[0].name == "obj");
+        REQUIRE(summaries[0].count == 3);
+        REQUIRE(summaries[0].median == 4);
+        REQUIRE(summaries[0].min == 2);
+        REQUIRE(summaries[0].max == 9);
+
+        REQUIRE(summaries[1].name == "nodes");
+        REQUIRE(summaries[1].count == 1);
+        REQUIRE(summaries[1].median == 10);
+    }
+
+    SECTION("Even number of values, calculate mean of the middle two")
+    {
+        Dataset d(10, {
+            ExecResult(0, 1, { MetricValue("obj", 4) }),
+            ExecResult(0, 1, { MetricValue("obj", 1) })
+        });
+        REQUIRE(d.metric_summaries().at(0).median == 2.5);
+    }
+
+    SECTION("No metrics lead to an empty summary")
+    {
+        Dataset d(10, { {0,3}, {0,4} });
+        REQUIRE(d.metric_summaries().empty());
+    }
+}
+
+TEST_CASE("Dataset::primal_integrals")
+{
+    Trajectory fast(true);
+    fast.add(1000, 10);
+    fast.add(2000, 8);
+
+    Trajectory slow(true);
+    slow.add(5000, 10);
+
+    SECTION("Reference is the best incumbent of all runs")
+    {
+        Dataset d(10, {
+            ExecResult(0, 3, {}, fast),
+            ExecResult(1, 10, {}, slow),
+            ExecResult(1, 10)
+        });
+
+        double best = 0;
+        REQUIRE(d.best_incumbent(best));
+        REQUIRE(best == 8);
+
+        // fast: 1s with gap 1, 1s with gap 0.2
+        // slow: 5s with gap 1, 5s with gap 0.2
+        // none: 10s with gap 1
+        auto integrals = d.primal_integrals();
+        REQUIRE(integrals.size() == 3);
+        REQUIRE(integrals[0] == Approx(1.2));
+        REQUIRE(integrals[1] == Approx(6));
+        REQUIRE(integrals[2] == Approx(10));
+        REQUIRE(d.mean_primal_integral() == Approx(17.2 / 3));
+
+        REQUIRE(d.median_primal_gap_at(0.5) == 1);
+        REQUIRE(d.median_primal_gap_at(6) == Approx(0.2));
+    }
+
+    SECTION("Every instance has its own reference")
+    {
+        // Instance 0 has the optimum 8, instance 1 has the optimum 100
+        Trajectory large(true);
+        large.add(1000, 200);
+        large.add(5000, 100);
+
+        Dataset d(10, {
+            ExecResult(0, 3, {}, fast),
+            ExecResult(1, 10, {}, slow),
+            ExecResult(0, 6, {}, large),
+            ExecResult(1, 10)
+        });
+        const std::vector<unsigned long long> instances{ 7, 7, 3, 3 };
+
+        // large: 1s with gap 1, 4s with gap 0.5, 5s with gap 0,
+        // it is not measured against the optimum 8 of the other instance
+        auto integrals = d.primal_integrals(instances);
+        REQUIRE(integrals.size() == 4);
+        REQUIRE(integrals[0] == Approx(1.2));
+        REQUIRE(integrals[1] == Approx(6));
+        REQUIRE(integrals[2] == Approx(3));
+        REQUIRE(integrals[3] == Approx(10));
+
+        // Mean of the instance means (3.6 and 6.5)
+        REQUIRE(d.mean_primal_integral(instances) == Approx(5.05));
+        REQUIRE(d.median_primal_gap_at(6, instances) == Approx(0.1));
+
+        // A single reference makes the other instance look bad
+        REQUIRE(d.primal_integrals()[2] > 3);
+        REQUIRE(d.median_primal_gap_at(6) > 0.5);
+
+        REQUIRE_THROWS_AS(d.primal_integrals({ 1, 2 }), std::runtime_error);
+    }
+
+    SECTION("No incumbents lead to empty results")
+    {
+        Dataset d(10, { {0,3}, {0,4} });
+        double best = 42;
+        REQUIRE_FALSE(d.best_incumbent(best));
+        REQUIRE(best == 42);
+        REQUIRE(d.primal_integrals().empty());
+        REQUIRE(d.mean_primal_integral() == 0);
+        REQUIRE(d.median_primal_gap_at(5) == 1);
+    }
+}
+
+TEST_CASE("Dataset::runtime_survival")
+{
+    SECTION("Without censoring, the estimate is the empirical distribution")
+    {
+        Dataset d(10, { {0,2}, {0,4}, {0,4}, {0,8} });
+        auto curve = d.runtime_survival();
+        REQUIRE(curve.size() == 3);
+
+        REQUIRE(curve[0].time == 2);
+        REQUIRE(curve[0].at_risk == 4);
+        REQUIRE(curve[0].events == 1);
+        REQUIRE(curve[0].survival == Approx(0.75));
+
+        REQUIRE(curve[1].time == 4);
+        REQUIRE(curve[1].at_risk == 3);
+        REQUIRE(curve[1].events == 2);
+        REQUIRE(curve[1].survival == Approx(0.25));
+
+        REQUIRE(curve[2].time == 8);
+        REQUIRE(curve[2].survival == 0);
+        REQUIRE(curve[2].lower == 0);
+        REQUIRE(curve[2].upper == 0);
+    }
+
+    SECTION("Failed runs are censored, not counted as events")
+    {
+        // 3 runs: success at 2, crash at 3, time-out
+        Dataset d(10, { {0,2}, {1,3}, {0,20} });
+        auto curve = d.runtime_survival();
+        REQUIRE(curve.size() == 1);
+        REQUIRE(curve[0].survival == Approx(2.0 / 3));
+
+        // The time-out is trimmed to the timeout and it is censored
+        Dataset e(10, { {0,2}, {1,3}, {0,20}, {0,5} });
+        auto curve_e = e.runtime_survival();
+        REQUIRE(curve_e.size() == 2);
+        REQUIRE(curve_e[1].time == 5);
+        REQUIRE(curve_e[1].at_risk == 2);
+        // S(5) = 3/4 * 1/2
+        REQUIRE(curve_e[1].survival == Approx(0.375));
+    }
+
+    SECTION("The band contains the estimate")
+    {
+        Dataset d(10, { {0,1}, {0,2}, {0,3}, {1,4}, {0,5}, {0,6}, {1,10} });
+        for (const auto& point : d.runtime_survival()) {
+            REQUIRE(point.lower <= point.survival);
+            REQUIRE(point.survival <= point.upper);
+            REQUIRE(0 <= point.lower);
+            REQUIRE(point.upper <= 1);
+        }
+    }
+
+    SECTION("No samples lead to an empty curve")
+    {
+        Dataset d(10, {});
+        REQUIRE(d.runtime_survival().empty());
+    }
+}
+
+TEST_CASE("Dataset::runtime_quantile")
+{
+    SECTION("Median is found despite many failures")
+    {
+        // 6 of 10 runs time out, median of all runs is not defined
+        Dataset d(10, { {0,1}, {0,2}, {0,3}, {0,4},
+            {1,10}, {1,10}, {1,10}, {1,10}, {1,10}, {1,10} });
+        REQUIRE(d.runtime_quantile(0.5).value == 0);
+        REQUIRE(d.runtime_quantile(0.25).value == 3);
+        REQUIRE(d.runtime_quantile(0.25).lower <= 3);
+    }
+
+    SECTION("Censoring before the events raises the estimate")
+    {
+        // Early crashes are censored, the remaining runs are all fast
+        Dataset d(10, { {1,1}, {1,1}, {0,5}, {0,6} });
+        auto median = d.runtime_quantile(0.5);
+        REQUIRE(median.value == 5);
+        REQUIRE(median.lower <= median.value);
+    }
+
+    SECTION("No samples lead to a zero result")
+    {
+        Dataset d(10, {});
+        auto median = d.runtime_quantile(0.5);
+        REQUIRE(median.value == 0);
+        REQUIRE(median.lower == 0);
+        REQUIRE(median.upper == 0);
+    }
+}
+
+TEST_CASE("Dataset::score")
+{
+    SECTION("Typical usage")
+    {
+        Dataset d(10, { {0,4}, {1,3}, {0,2}, {0,20}, {0,4} });
+        auto score = d.score(2);
+        REQUIRE(score.k == 2);
+        REQUIRE(score.attempted == 5);
+        REQUIRE(score.solved == 3);
+        // (4 + 20 + 2 + 20 + 4) / 5
+        REQUIRE(score.par_k == Approx(10));
+
+        REQUIRE(score.cactus.size() == 3);
+        REQUIRE(score.cactus[0].solved == 1);
+        REQUIRE(score.cactus[0].runtime == 2);
+        REQUIRE(score.cactus[0].cumulative_runtime == 2);
+        REQUIRE(score.cactus[2].solved == 3);
+        REQUIRE(score.cactus[2].runtime == 4);
+        REQUIRE(score.cactus[2].cumulative_runtime == 10);
+    }
+
+    SECTION("PAR-10 penalizes failures more")
+    {
+        Dataset d(10, { {0,5}, {1,3} });
+        REQUIRE(d.score(10).par_k == Approx(52.5));
+    }
+
+    SECTION("Huge timeouts are sorted by comparison")
+    {
+        Dataset d(4000000u, { {0,3000000u}, {0,5}, {0,70} });
+        auto score = d.score();
+        REQUIRE(score.cactus.size() == 3);
+        REQUIRE(score.cactus[0].runtime == 5);
+        REQUIRE(score.cactus[1].runtime == 70);
+        REQUIRE(score.cactus[2].runtime == 3000000u);
+    }
+
+    SECTION("No samples lead to a zero result")
+    {
+        Dataset d(10, {});
+        auto score = d.score();
+        REQUIRE(score.attempted == 0);
+        REQUIRE(score.solved == 0);
+        REQUIRE(score.par_k == 0);
+        REQUIRE(score.cactus.empty());
+    }
+}
+
+TEST_CASE("Dataset::bootstrap")
+{
+    SECTION("Point estimates")
+    {
+        Dataset d(10, { {0,4}, {1,3}, {0,2}, {0,20}, {0,4} });
+        auto b = d.bootstrap(2, 0.95, 1000);
+        REQUIRE(b.k == 2);
+        REQUIRE(b.resamples == 1000);
+        REQUIRE(b.median.value == 4);
+        // (4 + 10 + 2 + 10 + 4) / 5
+        REQUIRE(b.mean.value == Approx(6));
+        REQUIRE(b.par_k.value == Approx(10));
+        REQUIRE(b.success_rate.value == Approx(0.6));
+
+        for (const auto& e : { b.median, b.mean, b.par_k, b.success_rate }) {
+            REQUIRE(e.lower <= e.value);
+            REQUIRE(e.value <= e.upper);
+        }
+        REQUIRE(b.success_rate.lower >= 0);
+        REQUIRE(b.success_rate.upper <= 1);
+    }
+
+    SECTION("Even number of runs averages the middle runtimes")
+    {
+        Dataset d(10, { {0,2}, {0,3}, {0,5}, {0,6} });
+        REQUIRE(d.bootstrap(2, 0.95, 0).median.value == 4);
+    }
+
+    SECTION("Constant runtimes have degenerate intervals")
+    {
+        Dataset d(10, std::vector<ExecResult>(50, ExecResult(0, 7)));
+        auto b = d.bootstrap();
+        REQUIRE(b.median.lower == 7);
+        REQUIRE(b.median.upper == 7);
+        REQUIRE(b.mean.lower == Approx(7));
+        REQUIRE(b.mean.upper == Approx(7));
+        REQUIRE(b.success_rate.lower == 1);
+    }
+
+    SECTION("Many runs in few bins")
+    {
+        // 30% failures, the normal approximation gives +- 0.028
+        std::vector<ExecResult> results;
+        for (unsigned i = 0; i < 1000; ++i) {
+            results.emplace_back(i % 10 < 3 ? 1 : 0, 1 + i % 4);
+        }
+        Dataset d(5, results);
+        auto b = d.bootstrap(2, 0.95, 2000);
+        REQUIRE(b.success_rate.value == Approx(0.7));
+        REQUIRE(b.success_rate.lower == Approx(0.672).margin(0.01));
+        REQUIRE(b.success_rate.upper == Approx(0.728).margin(0.01));
+    }
+
+    SECTION("Results do not depend on the number of threads")
+    {
+        std::vector<ExecResult> results;
+        for (unsigned i = 0; i < 200; ++i) {
+            results.emplace_back(i % 7 == 0 ? 1 : 0, 1 + (i * 37) % 50);
+        }
+        Dataset d(60, results);
+        auto b1 = d.bootstrap(2, 0.9, 500, 42, 1);
+        auto b3 = d.bootstrap(2, 0.9, 500, 42, 3);
+        REQUIRE(b1.mean.lower == b3.mean.lower);
+        REQUIRE(b1.mean.upper == b3.mean.upper);
+        REQUIRE(b1.median.lower == b3.median.lower);
+        REQUIRE(b1.par_k.upper == b3.par_k.upper);
+
+        auto other = d.bootstrap(2, 0.9, 500, 43, 1);
+        REQUIRE(other.mean.value == b1.mean.value);
+    }
+
+    SECTION("Empty dataset")
+    {
+        Dataset d(10, {});
+        auto b = d.bootstrap();
+        REQUIRE(b.median.value == 0);
+        REQUIRE(b.success_rate.upper == 0);
+    }
+
+    SECTION("Invalid confidence")
+    {
+        Dataset d(10, { {0,4} });
+        REQUIRE_THROWS_AS(d.bootstrap(2, 0.0), std::runtime_error);
+    }
+}
+
+TEST_CASE("Dataset::normalized_by_slot_speed")
+{
+    SECTION("Runtimes are converted to the fastest slot")
+    {
+        Dataset d(10, { {0,10}, {0,5}, {1,4}, {0,1} }, { 0, 1, 2, 3 }, { 0, 1, 1, 1 });
+        auto n = d.normalized_by_slot_speed({ 1.0, 0.5 });
+        auto score = n.score(2);
+        REQUIRE(score.solved == 3);
+        // 10 + 3 + 20 + 1
+        REQUIRE(score.par_k == Approx(34.0 / 4));
+    }
+
+    SECTION("Unknown slots")
+    {
+        Dataset d(10, { {0,10} });
+        REQUIRE_THROWS_AS(d.normalized_by_slot_speed({ 1.0 }), std::runtime_error);
+        Dataset e(10, { {0,10} }, { 0 }, { 1 });
+        REQUIRE_THROWS_AS(e.normalized_by_slot_speed({ 1.0 }), std::runtime_error);
+        REQUIRE_THROWS_AS(e.normalized_by_slot_speed({ 1.0, 0.0 }), std::runtime_error);
+    }
+}
+
+TEST_CASE("Dataset::group_by")
+{
+    // 2 solvers x 3 instances, the last parameter changes the fastest
+    std::vector<Parameter> parameters{
+        Parameter("solver", {"a", "b"}),
+        Parameter("instance", {"i1", "i2", "i3"})
+    };
+
+    Dataset d(10, {
+        {0,1}, {0,2}, {1,3},  // solver a
+        {0,4}, {0,5}, {0,6}   // solver b
+    }, { 0, 1, 2, 3, 4, 5 });
+
+    SECTION("Group by the solver across instances")
+    {
+        auto groups = d.group_by(parameters, {"solver"});
+        REQUIRE(groups.size() == 2);
+
+        REQUIRE(groups[0].values == std::vector<std::string>{"a"});
+        REQUIRE(groups[0].runs == 3);
+        REQUIRE(groups[0].solved == 2);
+        REQUIRE(groups[0].median == 2);
+        REQUIRE(groups[0].mad == 1);
+        REQUIRE(groups[0].par_k == Approx(23.0 / 3));
+
+        REQUIRE(groups[1].values == std::vector<std::string>{"b"});
+        REQUIRE(groups[1].solved == 3);
+        REQUIRE(groups[1].median == 5);
+    }
+
+    SECTION("PAR-k and the cactus plot of every configuration")
+    {
+        auto groups = d.group_by(parameters, {"solver"}, 10);
+        REQUIRE(groups.size() == 2);
+
+        // Same as the scores of the configurations run separately
+        Dataset a(10, { {0,1}, {0,2}, {1,3} });
+        Dataset b(10, { {0,4}, {0,5}, {0,6} });
+        for (size_t g = 0; g < groups.size(); ++g) {
+            auto score = (g == 0 ? a : b).score(10);
+            REQUIRE(groups[g].k == 10);
+            REQUIRE(groups[g].par_k == Approx(score.par_k));
+            REQUIRE(groups[g].solved == score.solved);
+            REQUIRE(groups[g].cactus.size() == score.cactus.size());
+            for (size_t i = 0; i < score.cactus.size(); ++i) {
+                REQUIRE(groups[g].cactus[i].solved == score.cactus[i].solved);
+                REQUIRE(groups[g].cactus[i].runtime == score.cactus[i].runtime);
+                REQUIRE(groups[g].cactus[i].cumulative_runtime
+                    == score.cactus[i].cumulative_runtime);
+            }
+        }
+
+        REQUIRE(groups[0].par_k == Approx(103.0 / 3));
+        REQUIRE(groups[0].cactus.size() == 2);
+        REQUIRE(groups[0].cactus[1].cumulative_runtime == 3);
+        REQUIRE(groups[1].cactus.size() == 3);
+        REQUIRE(groups[1].cactus[2].runtime == 6);
+        REQUIRE(groups[1].cactus[2].cumulative_runtime == 15);
+    }
+
+    SECTION("Group by the instance across solvers")
+    {
+        auto groups = d.group_by(parameters, {"instance"});
+        REQUIRE(groups.size() == 3);
+        REQUIRE(groups[2].values == std::vector<std::string>{"i3"});
+        REQUIRE(groups[2].runs == 2);
+        REQUIRE(groups[2].solved == 1);
+    }
+
+    SECTION("Group by both parameters in any order")
+    {
+        auto groups = d.group_by(parameters, {"instance", "solver"});
+        REQUIRE(groups.size() == 6);
+        REQUIRE(groups[1].values == std::vector<std::string>{"i1", "b"});
+        REQUIRE(groups[1].median == 4);
+    }
+
+    SECTION("Empty grouping aggregates everything")
+    {
+        auto groups = d.group_by(parameters, {});
+        REQUIRE(groups.size() == 1);
+        REQUIRE(groups[0].runs == 6);
+        REQUIRE(groups[0].median == d.median_runtime_of_all_runs());
+    }
+
+    SECTION("Groups without runs are skipped")
+    {
+        Dataset partial(10, { {0,4}, {0,6} }, { 4, 5 });
+        auto groups = partial.group_by(parameters, {"solver"});
+        REQUIRE(groups.size() == 1);
+        REQUIRE(groups[0].values == std::vector<std::string>{"b"});
+    }
+
+    SECTION("Job indices match combine_command_lines")
+    {
+        Config c(R"({
+            "command" : "solve",
+            "arguments" : ["%solver%", "%instance%"],
+            "parameters" : [
+                { "name" : "solver", "values" : ["a", "b"] },
+                { "name" : "instance", "values" : ["i1", "i2", "i3"] }
+            ]
+        })"_json);
+        for (const auto& job : combine_command_lines(c)) {
+            Dataset one(10, { {0,1} }, { job.job_index() });
+            auto groups = one.group_by(c.parameters(), {"solver", "instance"});
+            REQUIRE(groups.at(0).values == job.arguments());
+        }
+    }
+
+    SECTION("Job indices of zip groups match combine_command_lines")
+    {
+        Config c(R"({
+            "command" : "solve",
+            "arguments" : ["%instance%", "%solver%", "%optimum%"],
+            "parameters" : [
+                { "name" : "instance", "values" : ["i1", "i2", "i3"] },
+                { "name" : "solver", "values" : ["a", "b"] },
+                { "name" : "optimum", "values" : ["1", "2", "3"] }
+            ],
+            "zip" : [["instance", "optimum"]]
+        })"_json);
+        for (const auto& job : combine_command_lines(c)) {
+            Dataset one(10, { {0,1} }, { job.job_index() });
+            auto groups = one.group_by(c.parameters(),
+                {"instance", "solver", "optimum"}, 2, c.zip_groups());
+            REQUIRE(groups.at(0).values == job.arguments());
+        }
+    }
+
+    SECTION("Negative cases")
+    {
+        REQUIRE_THROWS_AS(d.group_by(parameters, {"unknown"}), std::runtime_error);
+
+        Dataset unknown(10, { {0,1} });
+        REQUIRE_THROWS_AS(unknown.group_by(parameters, {"solver"}), std::runtime_error);
+
+        REQUIRE_THROWS_AS(Dataset(10, { {0,1} }, {}), std::runtime_error);
+    }
+}
@@ -8,7 +8,16 @@
 #include "catch.hpp"
 
 #include <chrono>
+#include <csignal>
 #include <iostream>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
 
 using namespace perfnp;
 
@@ -43,6 +52,44 @@ TEST_CASE("ExecBin::execute")
         REQUIRE(result.runtime() >= 1);
         REQUIRE(result.runtime() <= 2);
     }
+
+    SECTION("The binary runs in the working directory")
+    {
+        ExecBin eb("sh", { "-c", "test \"$(pwd)\" = /" });
+        eb.set_working_directory("/");
+        REQUIRE(eb.execute().exit_code() == 0);
+    }
+
+#if defined(__linux__)
+    SECTION("The binary runs on the given CPU")
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+        int cpu = 0;
+        while (!CPU_ISSET(cpu, &allowed)) {
+            ++cpu;
+        }
+
+        ExecBin eb("sh", { "-c", "grep -q '^Cpus_allowed_list:[[:space:]]*"
+            + std::to_string(cpu) + "$' /proc/self/status" });
+        eb.set_cpu(cpu);
+        REQUIRE(eb.execute().exit_code() == 0);
+    }
+#endif
+
+    SECTION("The binary gets the environment of the job")
+    {
+        const std::vector<std::string> variables = { "PERFNP_TEST_VARIABLE=42" };
+        EnvironmentTemplate environment({ "PERFNP_TEST_VARIABLE" });
+        ExecBin eb("sh", { "-c", "test \"$PERFNP_TEST_VARIABLE\" = 42 && test -n \"$PATH\"" });
+        eb.set_environment(environment.envp(variables));
+        REQUIRE(eb.execute().exit_code() == 0);
+
+        // The variable is not set in perfnp itself
+        ExecBin inherited("sh", { "-c", "test -z \"$PERFNP_TEST_VARIABLE\"" });
+        REQUIRE(inherited.execute().exit_code() == 0);
+    }
 #endif
 }
 
@@ -69,6 +116,59 @@ TEST_CASE("ExecBin::timeout")
 
 
 
+TEST_CASE("ExecBin::metrics")
+{
+    std::vector<MetricPattern> patterns{
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=")
+    };
+
+    SECTION("Metrics are extracted from the standard output")
+    {
+#if defined(_WIN32)
+        ExecBin eb("cmd", { "/C", "echo objective=5" });
+#elif defined(__linux__) || defined(__APPLE__)
+        ExecBin eb("sh", { "-c", "echo objective=7; echo objective=5" });
+#endif
+        eb.set_metric_patterns(patterns);
+        auto result = eb.execute();
+        REQUIRE(result.exit_code() == 0);
+        REQUIRE(result.metrics() == std::vector<MetricValue>{
+            MetricValue("objective", 5) });
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    SECTION("Incumbents are timestamped as they arrive")
+    {
+        std::vector<MetricPattern> incumbent{
+            MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=",
+                MetricPattern::Incumbent::Minimize)
+        };
+        ExecBin eb("sh", { "-c", "echo objective=7; sleep 1; echo objective=5" });
+        eb.set_metric_patterns(incumbent);
+        auto result = eb.execute();
+
+        const auto& points = result.trajectory().points();
+        REQUIRE(points.size() == 2);
+        REQUIRE(points[0].value == 7);
+        REQUIRE(points[1].value == 5);
+        REQUIRE(points[1].time_in_ms >= points[0].time_in_ms + 900);
+    }
+#endif
+
+    SECTION("Output is not captured without patterns")
+    {
+#if defined(_WIN32)
+        ExecBin eb("cmd", { "/C", "echo objective=5" });
+#elif defined(__linux__) || defined(__APPLE__)
+        ExecBin eb("sh", { "-c", "echo objective=5 > /dev/null" });
+#endif
+        auto result = eb.execute();
+        REQUIRE(result.metrics().empty());
+    }
+}
+
+
+
 TEST_CASE("ExecBin::error_handling")
 {
     SECTION("Empty binary detected") {
@@ -78,4 +178,103 @@ TEST_CASE("ExecBin::error_handling")
     SECTION("Exec-result doesn't accept 0 runtime") {
         REQUIRE_THROWS_AS(ExecResult(1, 0), std::runtime_error);
     }
+
+#if defined(__linux__) || defined(__APPLE__)
+    // A child, which would throw, continues as a copy of the tests
+    const auto pid = getpid();
+
+    SECTION("Missing binary is reported by perfnp") {
+        ExecBin eb("perfnp-test-missing-binary");
+        REQUIRE_THROWS_AS(eb.execute(), std::runtime_error);
+        REQUIRE(getpid() == pid);
+    }
+
+    SECTION("Missing working directory is reported before the fork") {
+        ExecBin eb("sh", { "-c", "exit 0" });
+        eb.set_working_directory("/perfnp-test-missing-directory");
+        REQUIRE_THROWS_AS(eb.execute(), std::runtime_error);
+        REQUIRE(getpid() == pid);
+    }
+#endif
+
+#if defined(__linux__)
+    SECTION("CPU outside of the machine is reported by perfnp") {
+        ExecBin eb("sh", { "-c", "exit 0" });
+        eb.set_cpu(CPU_SETSIZE - 1);
+        REQUIRE_THROWS_AS(eb.execute(), std::runtime_error);
+        REQUIRE(getpid() == pid);
+    }
+#endif
+}
+
+
+
+#if defined(PERFNP_STUB_PATH)
+TEST_CASE("ExecBin::stub")
+{
+    SECTION("Exit code is reported")
+    {
+        ExecBin eb(PERFNP_STUB_PATH, { "--cpu-ms", "5", "--exit-code", "3" }, 10);
+        auto result = eb.execute();
+        REQUIRE(result.exit_code() == 3);
+        REQUIRE(result.runtime() == 1);
+    }
+
+    SECTION("Incumbents are extracted")
+    {
+        std::vector<MetricPattern> patterns{
+            MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=",
+                MetricPattern::Incumbent::Minimize)
+        };
+        ExecBin eb(PERFNP_STUB_PATH, { "--cpu-ms", "20", "--incumbents", "4" }, 10);
+        eb.set_metric_patterns(patterns);
+        auto result = eb.execute();
+        REQUIRE(result.exit_code() == 0);
+        REQUIRE(result.metrics() == std::vector<MetricValue>{
+            MetricValue("objective", 1) });
+        REQUIRE(result.trajectory().points().size() == 4);
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    SECTION("Killed job reports the signal")
+    {
+        ExecBin eb(PERFNP_STUB_PATH, { "--signal", "9" }, 10);
+        REQUIRE(eb.execute().exit_code() == 9);
+    }
+
+    SECTION("Timeout kills the stub")
+    {
+        ExecBin eb(PERFNP_STUB_PATH, { "--sleep-ms", "5000" }, 1);
+        auto result = eb.execute();
+        REQUIRE(result.exit_code() == SIGALRM);
+        REQUIRE(result.runtime() <= 2);
+    }
+
+    SECTION("Jobs do not inherit the output of other jobs")
+    {
+        // The lowest free descriptors are taken by the next pipe,
+        // i.e. by the output of the scanned job
+        int probe[2];
+        REQUIRE(pipe(probe) == 0);
+        close(probe[0]);
+        close(probe[1]);
+
+        std::vector<MetricPattern> patterns{
+            MetricPattern("objective", MetricPattern::Kind::Prefix, "objective=")
+        };
+        ExecBin scanned(PERFNP_STUB_PATH, { "--sleep-ms", "1000" }, 10);
+        scanned.set_metric_patterns(patterns);
+        std::thread scanning([&]() { scanned.execute(); });
+
+        // Started while perfnp reads the output of the scanned job
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        ExecBin checking(PERFNP_STUB_PATH, { "--closed-fd", std::to_string(probe[0]),
+            "--closed-fd", std::to_string(probe[1]) }, 10);
+        auto result = checking.execute();
+        scanning.join();
+
+        REQUIRE(result.exit_code() == 0);
+    }
+#endif
 }
+#endif
@@ -0,0 +1,82 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/gate.hpp"
+#include "perfnp/dataset.hpp"
+
+#include "catch.hpp"
+
+using namespace perfnp;
+
+namespace {
+
+    const GateCheck& find_check(const GateVerdict& verdict, const std::string& name)
+    {
+        for (const auto& check : verdict.checks) {
+            if (check.name == name) {
+                return check;
+            }
+        }
+        throw std::runtime_error("Missing check " + name);
+    }
+
+} // anonymous namespace
+
+TEST_CASE("evaluate_gate")
+{
+    Dataset baseline(10, { ExecResult(0, 4), ExecResult(0, 5), ExecResult(0, 6), ExecResult(1, 2) });
+
+    SECTION("identical runs pass")
+    {
+        auto verdict = evaluate_gate(baseline, baseline, GateThresholds());
+        REQUIRE(verdict.passed());
+        REQUIRE(verdict.checks.size() == 3);
+        REQUIRE(find_check(verdict, "median_slowdown").change == 0);
+        REQUIRE(find_check(verdict, "solved_drop").change == 0);
+        REQUIRE(find_check(verdict, "par_k_increase").change == 0);
+    }
+
+    SECTION("faster run passes")
+    {
+        Dataset current(10, { ExecResult(0, 2), ExecResult(0, 3), ExecResult(0, 3), ExecResult(0, 9) });
+        auto verdict = evaluate_gate(baseline, current, GateThresholds());
+        REQUIRE(verdict.passed());
+        REQUIRE(find_check(verdict, "solved_drop").change == -1);
+    }
+
+    SECTION("slowdown above the limit fails")
+    {
+        Dataset current(10, { ExecResult(0, 5), ExecResult(0, 7), ExecResult(0, 8), ExecResult(1, 2) });
+        GateThresholds thresholds;
+        thresholds.par_k_increase = 100;
+        auto verdict = evaluate_gate(baseline, current, thresholds);
+        REQUIRE_FALSE(verdict.passed());
+        const auto& median = find_check(verdict, "median_slowdown");
+        REQUIRE_FALSE(median.passed);
+        REQUIRE(median.baseline == 6);
+        REQUIRE(median.current == 8);
+        REQUIRE(median.change == Approx(100.0 / 3));
+        REQUIRE(find_check(verdict, "par_k_increase").passed);
+    }
+
+    SECTION("lost instance fails")
+    {
+        Dataset current(10, { ExecResult(0, 4), ExecResult(0, 5), ExecResult(1, 6), ExecResult(1, 2) });
+        auto verdict = evaluate_gate(baseline, current, GateThresholds());
+        REQUIRE_FALSE(find_check(verdict, "solved_drop").passed);
+
+        GateThresholds thresholds;
+        thresholds.solved_drop = 1;
+        thresholds.median_slowdown = 100;
+        thresholds.par_k_increase = 100;
+        REQUIRE(evaluate_gate(baseline, current, thresholds).passed());
+    }
+
+    SECTION("empty baseline")
+    {
+        Dataset empty(10, {});
+        REQUIRE_THROWS_AS(evaluate_gate(empty, baseline, GateThresholds()), std::runtime_error);
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/metrics.hpp"
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace perfnp;
+
+TEST_CASE("MetricPattern::match")
+{
+    SECTION("regex with a capture group")
+    {
+        MetricPattern p("objective", MetricPattern::Kind::Regex,
+            "Objective: *([-+0-9.eE]+)");
+        double value = 0;
+        REQUIRE(p.match("Final Objective: 42.5 (optimal)", value));
+        REQUIRE(value == 42.5);
+    }
+
+    SECTION("regex without a capture group")
+    {
+        MetricPattern p("nodes", MetricPattern::Kind::Regex, "[0-9]+");
+        double value = 0;
+        REQUIRE(p.match("explored 1234 nodes", value));
+        REQUIRE(value == 1234);
+    }
+
+    SECTION("prefix ignores leading white-space")
+    {
+        MetricPattern p("bound", MetricPattern::Kind::Prefix, "bound=");
+        double value = 0;
+        REQUIRE(p.match("  bound=-7", value));
+        REQUIRE(value == -7);
+    }
+
+    SECTION("non-matching lines keep the value")
+    {
+        MetricPattern p("bound", MetricPattern::Kind::Prefix, "bound=");
+        double value = 3;
+        REQUIRE_FALSE(p.match("objective=1", value));
+        REQUIRE_FALSE(p.match("bound=unknown", value));
+        REQUIRE(value == 3);
+    }
+
+    SECTION("invalid patterns are rejected")
+    {
+        REQUIRE_THROWS_AS(MetricPattern("x", MetricPattern::Kind::Regex, "(("),
+            std::runtime_error);
+        REQUIRE_THROWS_AS(MetricPattern("", MetricPattern::Kind::Prefix, "x="),
+            std::runtime_error);
+        REQUIRE_THROWS_AS(MetricPattern("x", MetricPattern::Kind::Prefix, ""),
+            std::runtime_error);
+    }
+}
+
+
+
+TEST_CASE("OutputScanner")
+{
+    std::vector<MetricPattern> patterns{
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "objective="),
+        MetricPattern("nodes", MetricPattern::Kind::Regex, "nodes: ([0-9]+)")
+    };
+    OutputScanner scanner(patterns);
+
+    SECTION("the last value wins")
+    {
+        const char* output = "objective=10\nobjective=8\nobjective=5\n";
+        scanner.feed(output, std::strlen(output));
+        scanner.finish();
+        REQUIRE(scanner.metrics() == std::vector<MetricValue>{
+            MetricValue("objective", 5) });
+    }
+
+    SECTION("lines are split across chunks")
+    {
+        scanner.feed("objec", 5);
+        scanner.feed("tive=1", 6);
+        scanner.feed("2\r\nnodes: 3", 11);
+        scanner.feed("4", 1);
+        scanner.finish();
+        REQUIRE(scanner.metrics() == std::vector<MetricValue>{
+            MetricValue("objective", 12), MetricValue("nodes", 34) });
+    }
+
+    SECTION("overly long lines are truncated")
+    {
+        std::string line = "objective=1" + std::string(
+            OutputScanner::max_line_length, '0') + "\n";
+        scanner.feed(line.c_str(), line.size());
+        scanner.finish();
+        REQUIRE(scanner.metrics().size() == 1);
+    }
+
+    SECTION("no match produces no metric")
+    {
+        scanner.feed("hello\n", 6);
+        scanner.finish();
+        REQUIRE(scanner.metrics().empty());
+    }
+}
+
+
+
+TEST_CASE("OutputScanner::trajectory")
+{
+    std::vector<MetricPattern> patterns{
+        MetricPattern("objective", MetricPattern::Kind::Prefix, "incumbent ",
+            MetricPattern::Incumbent::Minimize)
+    };
+    OutputScanner scanner(patterns);
+
+    SECTION("improving values are timestamped by their chunk")
+    {
+        scanner.feed("incumbent 10\n", 13, 5);
+        scanner.feed("incumbent 12\nincum", 18, 7);
+        scanner.feed("bent 8\n", 7, 9);
+        scanner.finish();
+
+        REQUIRE(scanner.trajectory().points() == std::vector<TrajectoryPoint>{
+            {5, 10}, {9, 8} });
+        REQUIRE(scanner.metrics() == std::vector<MetricValue>{
+            MetricValue("objective", 8) });
+    }
+
+    SECTION("two incumbents are rejected")
+    {
+        patterns.push_back(MetricPattern("bound", MetricPattern::Kind::Prefix,
+            "bound ", MetricPattern::Incumbent::Maximize));
+        REQUIRE_THROWS_AS(OutputScanner(patterns), std::runtime_error);
+    }
+}
@@ -0,0 +1,151 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/monitor.hpp"
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+namespace {
+
+#if defined(__linux__) || defined(__APPLE__)
+    //! Sends a request and reads the whole response
+    std::string scrape(int fd, const sockaddr* address, socklen_t length)
+    {
+        REQUIRE(connect(fd, address, length) == 0);
+        const std::string request = "GET /metrics HTTP/1.0\r\n\r\n";
+        REQUIRE(send(fd, request.data(), request.size(), 0)
+            == static_cast<ssize_t>(request.size()));
+
+        std::string response;
+        char buffer[1024];
+        ssize_t n;
+        while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            response.append(buffer, static_cast<size_t>(n));
+        }
+        close(fd);
+        return response;
+    }
+#endif
+
+} // anonymous namespace
+
+TEST_CASE("SweepMonitor")
+{
+    SweepMonitor monitor;
+    monitor.set_planned(4);
+
+    monitor.job_started();
+    monitor.job_started();
+    REQUIRE(monitor.running() == 2);
+
+    monitor.job_finished(ExecResult(0, 3), 10, 200);
+    monitor.job_finished(ExecResult(1, 2), 10, 50);
+    monitor.job_started();
+    monitor.job_finished(ExecResult(9, 10), 10, 20000);
+    monitor.result_queued();
+    monitor.result_queued();
+    monitor.result_written();
+
+    REQUIRE(monitor.planned() == 4);
+    REQUIRE(monitor.running() == 0);
+    REQUIRE(monitor.completed() == 3);
+    REQUIRE(monitor.failed() == 1);
+    REQUIRE(monitor.timed_out() == 1);
+    REQUIRE(monitor.queue_depth() == 1);
+
+    std::ostringstream out;
+    monitor.write_openmetrics(out);
+    const auto text = out.str();
+
+    REQUIRE(text.find("# TYPE perfnp_jobs_completed counter\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_jobs_completed_total 3\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_jobs_running 0\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_jobs_timed_out_total 1\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_db_queue_depth 1\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_job_runtime_seconds_bucket{le=\"2\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_job_runtime_seconds_bucket{le=\"5\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_job_runtime_seconds_bucket{le=\"+Inf\"} 3\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_job_runtime_seconds_sum 15\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_job_runtime_seconds_count 3\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_spawn_latency_seconds_bucket{le=\"0.0001\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_spawn_latency_seconds_bucket{le=\"0.00025\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_spawn_latency_seconds_bucket{le=\"0.01\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("perfnp_spawn_latency_seconds_count 3\n") != std::string::npos);
+    REQUIRE(text.size() > 6);
+    REQUIRE(text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+TEST_CASE("MonitorServer")
+{
+    SweepMonitor monitor;
+    monitor.set_planned(7);
+
+    SECTION("localhost port")
+    {
+        MonitorServer server(monitor, MonitorSettings());
+        REQUIRE(server.port() != 0);
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(server.port()));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        for (int i = 0; i < 2; ++i) {
+            auto response = scrape(socket(AF_INET, SOCK_STREAM, 0),
+                reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            REQUIRE(response.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+            REQUIRE(response.find("application/openmetrics-text") != std::string::npos);
+            REQUIRE(response.find("perfnp_jobs_planned 7\n") != std::string::npos);
+        }
+    }
+
+    SECTION("Unix socket")
+    {
+        MonitorSettings settings;
+        settings.socket = "perfnp_monitor_test.sock";
+        {
+            MonitorServer server(monitor, settings);
+            REQUIRE(server.port() == 0);
+
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, settings.socket.c_str());
+
+            auto response = scrape(socket(AF_UNIX, SOCK_STREAM, 0),
+                reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            REQUIRE(response.find("# EOF\n") != std::string::npos);
+        }
+        REQUIRE(access(settings.socket.c_str(), F_OK) != 0);
+    }
+
+    SECTION("path is not a socket")
+    {
+        MonitorSettings settings;
+        settings.socket = "perfnp_monitor_test.txt";
+        {
+            std::ofstream file(settings.socket);
+        }
+        REQUIRE_THROWS_AS(MonitorServer(monitor, settings), std::runtime_error);
+        unlink(settings.socket.c_str());
+    }
+}
+#endif
@@ -0,0 +1,184 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/sample.hpp"
+#include "perfnp/combin.hpp"
+#include "perfnp/config.hpp"
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using namespace perfnp;
+
+namespace {
+
+    SampleSettings design(SampleSettings::Design design,
+        unsigned long long size, std::uint64_t seed = 1)
+    {
+        SampleSettings settings;
+        settings.design = design;
+        settings.size = size;
+        settings.seed = seed;
+        return settings;
+    }
+
+    //! Values of the parameter of every job index
+    std::vector<std::size_t> values_of(const std::vector<unsigned long long>& indices,
+        unsigned long long stride, unsigned long long size)
+    {
+        std::vector<std::size_t> values;
+        for (auto index : indices) {
+            values.push_back(static_cast<std::size_t>(index / stride % size));
+        }
+        return values;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("sample_job_indices")
+{
+    // 10^12 combinations, never enumerated
+    Config large(R"({
+        "command" : "solver",
+        "arguments" : ["%a%", "%b%", "%c%"],
+        "parameters" : [
+            { "name" : "a", "range" : [1, 1000000] },
+            { "name" : "b", "range" : [1, 1000] },
+            { "name" : "c", "range" : [1, 1000] }
+        ]
+    })"_json);
+    JobSpace space(large);
+
+    SECTION("random design draws distinct indices reproducibly")
+    {
+        auto settings = design(SampleSettings::Design::Random, 1000, 42);
+        auto indices = sample_job_indices(space, settings);
+        REQUIRE(indices.size() == 1000);
+        REQUIRE(std::is_sorted(indices.begin(), indices.end()));
+        REQUIRE(std::adjacent_find(indices.begin(), indices.end()) == indices.end());
+        REQUIRE(indices.back() < space.size());
+        REQUIRE(sample_job_indices(space, settings) == indices);
+
+        settings.seed = 43;
+        REQUIRE(sample_job_indices(space, settings) != indices);
+    }
+
+    SECTION("random design of a small space takes all its jobs")
+    {
+        Config small(R"({
+            "parameters" : [ { "name" : "a", "values" : ["1", "2", "3"] } ]
+        })"_json);
+        JobSpace small_space(small);
+        auto indices = sample_job_indices(small_space,
+            design(SampleSettings::Design::Random, 10));
+        REQUIRE(indices == std::vector<unsigned long long>{0, 1, 2});
+    }
+
+    SECTION("Latin hypercube covers every stratum of every parameter")
+    {
+        auto indices = sample_job_indices(space,
+            design(SampleSettings::Design::LatinHypercube, 100));
+        REQUIRE(indices.size() == 100);
+
+        // Every tenth of the values of `c` is hit exactly ten times
+        std::vector<unsigned> strata(10, 0);
+        for (auto value : values_of(indices, 1, 1000)) {
+            ++strata[value / 100];
+        }
+        REQUIRE(strata == std::vector<unsigned>(10, 10));
+    }
+
+    SECTION("Sobol points are spread evenly")
+    {
+        Config grid(R"({
+            "parameters" : [
+                { "name" : "a", "range" : [0, 7] },
+                { "name" : "b", "range" : [0, 7] },
+                { "name" : "c", "range" : [0, 63] }
+            ]
+        })"_json);
+        JobSpace grid_space(grid);
+
+        // The first 64 points of the first two dimensions form
+        // a (0, 6, 2)-net, so they hit every cell of the 8x8 grid
+        auto indices = sample_job_indices(grid_space,
+            design(SampleSettings::Design::Sobol, 64, 5));
+        REQUIRE(indices.size() == 64);
+        std::set<unsigned long long> cells;
+        for (auto index : indices) {
+            cells.insert(index / 64);
+        }
+        REQUIRE(cells.size() == 64);
+
+        // Every value of the third dimension is hit once
+        auto values = values_of(indices, 1, 64);
+        REQUIRE(std::set<std::size_t>(values.begin(), values.end()).size() == 64);
+    }
+
+    SECTION("zip groups and constraints are respected")
+    {
+        Config c(R"({
+            "parameters" : [
+                { "name" : "instance", "range" : [1, 100000] },
+                { "name" : "optimum", "range" : [100001, 200000] },
+                { "name" : "seed", "range" : [1, 100] }
+            ],
+            "zip" : [["instance", "optimum"]],
+            "constraints" : ["seed <= 50"]
+        })"_json);
+        JobSpace constrained(c);
+        REQUIRE(constrained.axes() == std::vector<std::size_t>{0, 2});
+
+        for (auto kind : { SampleSettings::Design::Random,
+                SampleSettings::Design::LatinHypercube,
+                SampleSettings::Design::Sobol }) {
+            auto indices = sample_job_indices(constrained, design(kind, 200));
+            REQUIRE(!indices.empty());
+            for (auto index : indices) {
+                REQUIRE(constrained.contains(index));
+            }
+            if (kind == SampleSettings::Design::Random) {
+                REQUIRE(indices.size() == 200);
+            }
+        }
+    }
+
+    SECTION("Sobol design has a limited number of dimensions")
+    {
+        nlohmann::json j = R"({ "parameters" : [] })"_json;
+        for (int i = 0; i < 22; ++i) {
+            j["parameters"].push_back({ {"name", "p" + std::to_string(i)},
+                {"values", {"x", "y"}} });
+        }
+        Config c(std::move(j));
+        REQUIRE_THROWS_AS(sample_job_indices(JobSpace(c),
+            design(SampleSettings::Design::Sobol, 10)), std::runtime_error);
+    }
+}
+
+TEST_CASE("combine_command_lines of a sample")
+{
+    Config c(R"({
+        "command" : "solver",
+        "arguments" : ["%a%", "%b%"],
+        "parameters" : [
+            { "name" : "a", "range" : [1, 10000] },
+            { "name" : "b", "range" : [1, 10000] }
+        ],
+        "sample" : { "design" : "random", "size" : 50, "seed" : 3 }
+    })"_json);
+
+    // Sampled jobs decode to the same command lines as in the full product
+    JobSpace space(c);
+    auto jobs = combine_command_lines(c);
+    REQUIRE(jobs.size() == 50);
+    for (const auto& job : jobs) {
+        REQUIRE(job == space.at(job.job_index()));
+        REQUIRE(job.arguments()[0] == std::to_string(job.job_index() / 10000 + 1));
+    }
+}
@@ -0,0 +1,236 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/scheduler.hpp"
+
+#include "catch.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+TEST_CASE("execute_all_runs")
+{
+#if defined(_WIN32)
+    const std::string shell = "cmd";
+    auto exit_with = [](unsigned code) {
+        return std::vector<std::string>{ "/C", "exit " + std::to_string(code) };
+    };
+#elif defined(__linux__) || defined(__APPLE__)
+    const std::string shell = "sh";
+    auto exit_with = [](unsigned code) {
+        return std::vector<std::string>{ "-c", "exit " + std::to_string(code) };
+    };
+#endif
+
+    std::vector<CmdWithArgs> commands;
+    for (unsigned i = 0; i < 6; ++i) {
+        commands.emplace_back(i, shell, exit_with(i % 2));
+    }
+
+    SECTION("Parallel worker slots execute every command once")
+    {
+        // Catch is not thread-safe, the results are checked afterwards
+        std::multiset<unsigned> executed;
+        std::set<unsigned> slots;
+        bool all_exit_codes_match = true;
+        auto dataset = execute_all_runs(commands, 10, {}, 3,
+            [&](const CmdWithArgs& cwa, unsigned, ExecResult result, unsigned slot)
+            {
+                all_exit_codes_match = all_exit_codes_match
+                    && result.exit_code() == static_cast<int>(cwa.job_index() % 2);
+                executed.insert(cwa.job_index());
+                slots.insert(slot);
+            });
+
+        REQUIRE(all_exit_codes_match);
+        REQUIRE(executed == std::multiset<unsigned>{ 0, 1, 2, 3, 4, 5 });
+        REQUIRE(*slots.rbegin() < 3);
+        REQUIRE(dataset.number_of_all_successful_runs() == 3);
+    }
+
+    SECTION("Monitor follows the jobs")
+    {
+        SweepMonitor monitor;
+        execute_all_runs(commands, 10, {}, 2,
+            [](const CmdWithArgs&, unsigned, ExecResult, unsigned) {},
+            nullptr, &monitor);
+
+        REQUIRE(monitor.planned() == 6);
+        REQUIRE(monitor.completed() == 6);
+        REQUIRE(monitor.failed() == 3);
+        REQUIRE(monitor.timed_out() == 0);
+        REQUIRE(monitor.running() == 0);
+        REQUIRE(monitor.queue_depth() == 0);
+    }
+
+    SECTION("Single slot executes the commands in order")
+    {
+        std::vector<unsigned> executed;
+        execute_all_runs(commands, 10,
+            [&](const CmdWithArgs& cwa, unsigned, ExecResult)
+            {
+                executed.push_back(cwa.job_index());
+            });
+        REQUIRE(executed == std::vector<unsigned>{ 0, 1, 2, 3, 4, 5 });
+    }
+
+    SECTION("Interruption stops starting new jobs")
+    {
+        std::vector<unsigned> executed;
+        auto dataset = execute_all_runs(commands, 10, {}, 1,
+            [&](const CmdWithArgs& cwa, unsigned, ExecResult, unsigned)
+            {
+                executed.push_back(cwa.job_index());
+                if (executed.size() == 2) {
+                    request_interrupt(false);
+                }
+            });
+        REQUIRE(interrupt_signal() == 0);
+        reset_interrupt();
+        REQUIRE(executed == std::vector<unsigned>{ 0, 1 });
+        REQUIRE(dataset.score(2).attempted == 2);
+    }
+
+    SECTION("The interrupting signal is remembered")
+    {
+        {
+            InterruptGuard guard(InterruptPolicy::Finish);
+            std::raise(SIGTERM);
+            std::raise(SIGINT);
+        }
+        REQUIRE(interrupt_requested());
+        REQUIRE(interrupt_signal() == SIGTERM);
+        reset_interrupt();
+        REQUIRE(interrupt_signal() == 0);
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    SECTION("Interruption kills the running jobs")
+    {
+        std::vector<CmdWithArgs> sleeping;
+        for (unsigned i = 0; i < 4; ++i) {
+            sleeping.emplace_back(i, "sh", std::vector<std::string>{ "-c", "sleep 5" });
+        }
+
+        std::thread interrupt([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            request_interrupt(true);
+        });
+        const auto start = std::chrono::steady_clock::now();
+        size_t saved = 0;
+        auto dataset = execute_all_runs(sleeping, 10, {}, 2,
+            [&](const CmdWithArgs&, unsigned, ExecResult, unsigned)
+            {
+                ++saved;
+            });
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        interrupt.join();
+        reset_interrupt();
+
+        REQUIRE(elapsed < std::chrono::seconds(3));
+        REQUIRE(saved == 0);
+        REQUIRE(dataset.score(2).attempted == 0);
+    }
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+    SECTION("The input files are staged before every job")
+    {
+        const std::string input("temporary_input_for_scheduler_tests.cnf");
+        {
+            std::ofstream file(input);
+            file << "p cnf 1 1" << std::endl;
+        }
+        std::vector<CmdWithArgs> staged_commands;
+        for (unsigned i = 0; i < 4; ++i) {
+            staged_commands.emplace_back(i, "true",
+                std::vector<std::string>{ input, "--seed=" + std::to_string(i) });
+        }
+        PageCacheSettings settings;
+        settings.mode = PageCacheSettings::Mode::Pin;
+        settings.ahead = 1;
+        InputStager stager(staged_commands, settings);
+
+        auto dataset = execute_all_runs(staged_commands, 10, {}, 2,
+            [](const CmdWithArgs&, unsigned, ExecResult, unsigned) {},
+            nullptr, nullptr, &stager);
+        std::remove(input.c_str());
+
+        REQUIRE(stager.input_files() == 1);
+        REQUIRE(dataset.number_of_all_successful_runs() == 4);
+        REQUIRE(stager.pinned_files() == 0);
+    }
+
+    SECTION("Every slot runs in its scratch directory")
+    {
+        const std::string input("temporary_input_for_scheduler_tests.cnf");
+        {
+            std::ofstream file(input);
+            file << "p cnf 1 1" << std::endl;
+        }
+        ScratchSettings settings;
+        settings.directory = "temporary_scratch_for_scheduler_tests";
+
+        // The input is staged and the scratch file of another job is gone
+        std::vector<CmdWithArgs> scratch_commands;
+        for (unsigned i = 0; i < 6; ++i) {
+            scratch_commands.emplace_back(i, "sh", std::vector<std::string>{ "-c",
+                "test -f \"$0\" && test ! -f scratch && touch scratch", input });
+        }
+        std::set<std::string> recorded;
+        Dataset dataset(10, {});
+        {
+            ScratchSpace scratch(settings, 2);
+            dataset = execute_all_runs(scratch_commands, 10, {}, 2,
+                [&](const CmdWithArgs& cwa, unsigned, ExecResult, unsigned)
+                {
+                    recorded.insert(cwa.arguments().back());
+                }, nullptr, nullptr, nullptr, &scratch);
+        }
+        std::remove(input.c_str());
+        std::remove(settings.directory.c_str());
+
+        REQUIRE(dataset.number_of_all_successful_runs() == 6);
+        REQUIRE(recorded == std::set<std::string>{ input });
+    }
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+    SECTION("A job, which cannot start, fails the sweep in perfnp only")
+    {
+        auto broken = commands;
+        broken.emplace_back(6, shell, exit_with(0), std::vector<std::string>(),
+            "/perfnp-test-missing-directory");
+        const auto pid = getpid();
+        size_t recorded = 0;
+        REQUIRE_THROWS_AS(execute_all_runs(broken, 10, {}, 2,
+            [&](const CmdWithArgs&, unsigned, ExecResult, unsigned)
+            {
+                ++recorded;
+            }), std::runtime_error);
+        REQUIRE(getpid() == pid);
+        REQUIRE(recorded <= commands.size());
+    }
+#endif
+
+    SECTION("Exceptions of the callback are propagated")
+    {
+        REQUIRE_THROWS_AS(execute_all_runs(commands, 10, {}, 2,
+            [](const CmdWithArgs&, unsigned, ExecResult, unsigned)
+            {
+                throw std::runtime_error("callback failed");
+            }), std::runtime_error);
+    }
+}
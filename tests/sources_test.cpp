@@ -0,0 +1,125 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/sources.hpp"
+
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace perfnp;
+
+#if defined(__linux__) || defined(__APPLE__)
+namespace {
+
+    const std::vector<std::string> TREE_DIRECTORIES = {
+        "perfnp_glob_test",
+        "perfnp_glob_test/sat",
+        "perfnp_glob_test/sat/hard",
+        "perfnp_glob_test/.hidden",
+    };
+
+    const std::vector<std::string> TREE_FILES = {
+        "perfnp_glob_test/a.cnf",
+        "perfnp_glob_test/b.txt",
+        "perfnp_glob_test/.c.cnf",
+        "perfnp_glob_test/sat/d.cnf",
+        "perfnp_glob_test/sat/hard/e.cnf",
+        "perfnp_glob_test/.hidden/f.cnf",
+    };
+
+    //! Small directory tree, removed at the end of the test
+    struct Tree {
+        Tree() {
+            for (const auto& directory : TREE_DIRECTORIES) {
+                mkdir(directory.c_str(), 0755);
+            }
+            for (const auto& file : TREE_FILES) {
+                std::ofstream(file) << "p cnf 0 0\n";
+            }
+        }
+
+        ~Tree() {
+            for (const auto& file : TREE_FILES) {
+                std::remove(file.c_str());
+            }
+            for (auto it = TREE_DIRECTORIES.rbegin(); it != TREE_DIRECTORIES.rend(); ++it) {
+                rmdir(it->c_str());
+            }
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("expand_glob")
+{
+    Tree tree;
+
+    SECTION("wildcards in one directory")
+    {
+        REQUIRE(expand_glob("perfnp_glob_test/*.cnf") == std::vector<std::string>{
+            "perfnp_glob_test/a.cnf"
+        });
+        REQUIRE(expand_glob("perfnp_glob_test/?.*") == std::vector<std::string>{
+            "perfnp_glob_test/a.cnf", "perfnp_glob_test/b.txt"
+        });
+        REQUIRE(expand_glob("perfnp_glob_test/.*.cnf") == std::vector<std::string>{
+            "perfnp_glob_test/.c.cnf"
+        });
+    }
+
+    SECTION("recursive wildcard, sorted by any number of threads")
+    {
+        const std::vector<std::string> expected = {
+            "perfnp_glob_test/a.cnf",
+            "perfnp_glob_test/sat/d.cnf",
+            "perfnp_glob_test/sat/hard/e.cnf",
+        };
+        REQUIRE(expand_glob("perfnp_glob_test/**/*.cnf", 1) == expected);
+        REQUIRE(expand_glob("perfnp_glob_test/**/*.cnf", 4) == expected);
+        REQUIRE(expand_glob("perfnp_glob_test/sat/**").size() == 3);
+    }
+
+    SECTION("no matches")
+    {
+        REQUIRE(expand_glob("perfnp_glob_test/*.xyz").empty());
+        REQUIRE(expand_glob("perfnp_glob_missing/*.cnf").empty());
+        REQUIRE(expand_glob("perfnp_glob_test/a.cnf") == std::vector<std::string>{
+            "perfnp_glob_test/a.cnf"
+        });
+    }
+}
+#endif
+
+TEST_CASE("read_manifest")
+{
+    const std::string filename = "perfnp_manifest_test.txt";
+    std::ofstream(filename, std::ios::binary)
+        << "# instances\n"
+        << "a.cnf\r\n"
+        << "\n"
+        << "dir/b c.cnf\n"
+        << "a.cnf";
+
+    StringArena arena;
+    auto ids = read_manifest(filename, arena);
+    std::remove(filename.c_str());
+
+    REQUIRE(ids.size() == 3);
+    REQUIRE(arena.str(ids[0]) == "a.cnf");
+    REQUIRE(arena.str(ids[1]) == "dir/b c.cnf");
+    REQUIRE(ids[2] == ids[0]);
+
+    REQUIRE_THROWS_AS(read_manifest("perfnp_missing_manifest.txt", arena),
+        std::runtime_error);
+}
@@ -4,9 +4,11 @@
 // https://opensource.org/licenses/MIT
 
 #include "perfnp/sql_database.hpp"
+#include "perfnp/cache.hpp"
 
 #include "catch.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
@@ -52,11 +54,312 @@ TEST_CASE("sql_database::new_run_started")
     SECTION("time is properly saved and loaded")
     {
         sql_database db(TEST_DATABASE_FILENAME);
-        auto start = std::chrono::system_clock::now();
+        auto start = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now());
         auto run_id = db.new_run_started();
-        auto end = std::chrono::system_clock::now();
+        auto end = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now());
+
+        auto started = db.get_time_run_started(run_id);
+        REQUIRE(started >= start);
+        REQUIRE(started <= end);
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::on_job_finished")
+{
+    SECTION("jobs with metrics are saved")
+    {
+        sql_database db(TEST_DATABASE_FILENAME);
+        auto run_id = db.new_run_started();
+        CmdWithArgs cwa(0, "solver", {"instance.txt"});
+        auto id1 = db.on_job_finished(run_id, cwa, 10, ExecResult(0, 1,
+            { MetricValue("objective", 3.5), MetricValue("nodes", 12) }));
+        auto id2 = db.on_job_finished(run_id, cwa, 10, ExecResult(0, 1));
+        REQUIRE(id1 != id2);
+    }
+
+    SECTION("environment and working directory of the job are saved")
+    {
+        long long job_id;
+        {
+            sql_database db(TEST_DATABASE_FILENAME);
+            auto run_id = db.new_run_started();
+            CmdWithArgs cwa(0, "solver", {"instance.txt"},
+                {"OMP_NUM_THREADS=4", "LD_PRELOAD=libjemalloc.so"}, "/tmp");
+            job_id = db.on_job_finished(run_id, cwa, 10, ExecResult(0, 1));
+        }
+
+        SQLite::Database db(TEST_DATABASE_FILENAME);
+        SQLite::Statement variables(db, "SELECT name, value FROM job_environment"
+            " WHERE job_id = ? ORDER BY rowid");
+        variables.bind(1, job_id);
+        REQUIRE(variables.executeStep());
+        REQUIRE(variables.getColumn(0).getString() == "OMP_NUM_THREADS");
+        REQUIRE(variables.getColumn(1).getString() == "4");
+        REQUIRE(variables.executeStep());
+        REQUIRE(variables.getColumn(0).getString() == "LD_PRELOAD");
+        REQUIRE(!variables.executeStep());
+
+        SQLite::Statement job(db, "SELECT working_directory FROM job WHERE job_id = ?");
+        job.bind(1, job_id);
+        REQUIRE(job.executeStep());
+        REQUIRE(job.getColumn(0).getString() == "/tmp");
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::for_each_paired_instance")
+{
+    sql_database db(TEST_DATABASE_FILENAME);
+    auto run_a = db.new_run_started();
+    auto run_b = db.new_run_started();
+    REQUIRE(db.has_run(run_a));
+    REQUIRE_FALSE(db.has_run(run_b + 1));
+
+    CmdWithArgs first(0, "solver", {"first.txt"});
+    CmdWithArgs second(1, "solver", {"second.txt"});
+    CmdWithArgs only_a(2, "solver", {"only_a.txt"});
+
+    db.on_job_finished(run_a, first, 10, ExecResult(0, 4));
+    db.on_job_finished(run_a, first, 10, ExecResult(0, 6));
+    db.on_job_finished(run_a, second, 10, ExecResult(1, 3));
+    db.on_job_finished(run_a, only_a, 10, ExecResult(0, 1));
+    db.on_job_finished(run_b, first, 10, ExecResult(0, 2));
+    db.on_job_finished(run_b, second, 10, ExecResult(0, 5));
+
+    std::vector<PairedInstance> instances;
+    db.for_each_paired_instance(run_a, run_b, [&](const PairedInstance& instance) {
+        instances.push_back(instance);
+    });
+
+    REQUIRE(instances.size() == 2);
+    std::sort(instances.begin(), instances.end(),
+        [](const PairedInstance& a, const PairedInstance& b) {
+            return a.runtime_b < b.runtime_b;
+        });
+
+    REQUIRE(instances[0].command == first.escape_for_native_shell());
+    REQUIRE(instances[0].runtime_a == Approx(5));
+    REQUIRE(instances[0].runtime_b == Approx(2));
+    REQUIRE(instances[0].solved_a == 2);
+    REQUIRE(instances[0].solved_b == 1);
+
+    // Failed jobs count as the timeout
+    REQUIRE(instances[1].runtime_a == Approx(10));
+    REQUIRE(instances[1].solved_a == 0);
+    REQUIRE(instances[1].solved_b == 1);
+
+    SECTION("Runs with different parameters are not paired")
+    {
+        Config two(R"({ "command" : "solver", "arguments" : ["%i%"],
+            "parameters" : [ { "name" : "i", "values" : ["first.txt", "second.txt"] } ] })"_json);
+        Config swapped(R"({ "command" : "solver", "arguments" : ["%i%"],
+            "parameters" : [ { "name" : "i", "values" : ["second.txt", "first.txt"] } ] })"_json);
+        db.save_job_space(run_a, JobSpace(two));
+        db.save_job_space(run_b, JobSpace(swapped));
+        auto nothing = [](const PairedInstance&) {};
+        REQUIRE_THROWS_AS(db.for_each_paired_instance(run_a, run_b, nothing),
+            std::runtime_error);
+
+        db.save_job_space(run_b, JobSpace(two));
+        db.for_each_paired_instance(run_a, run_b, nothing);
+        REQUIRE(db.job_space(run_a) == JobSpace(two).digest());
+    }
+
+    SECTION("Another build of the solver is paired by the job index")
+    {
+        auto run_c = db.new_run_started();
+        CmdWithArgs rebuilt(0, "/opt/solver-2/solver", {"first.txt"},
+            {"OMP_NUM_THREADS=1"}, "/tmp");
+        db.on_job_finished(run_c, rebuilt, 10, ExecResult(0, 3));
+        db.on_job_finished(run_c, CmdWithArgs(5, "solver", {"second.txt"}),
+            10, ExecResult(0, 3));
+
+        instances.clear();
+        db.for_each_paired_instance(run_a, run_c, [&](const PairedInstance& instance) {
+            instances.push_back(instance);
+        });
+
+        REQUIRE(instances.size() == 1);
+        REQUIRE(instances[0].command == first.escape_for_native_shell());
+        REQUIRE(instances[0].runtime_a == Approx(5));
+        REQUIRE(instances[0].runtime_b == Approx(3));
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::load_dataset")
+{
+    sql_database db(TEST_DATABASE_FILENAME);
+    auto run_id = db.new_run_started();
+    auto other_run_id = db.new_run_started();
+
+    db.on_job_finished(run_id, CmdWithArgs(0, "solver", {"a.txt"}), 10, ExecResult(0, 4));
+    db.on_job_finished(other_run_id, CmdWithArgs(0, "solver", {"a.txt"}), 10, ExecResult(0, 1));
+    db.on_job_finished(run_id, CmdWithArgs(1, "solver", {"b.txt"}), 10, ExecResult(2, 3));
+
+    auto dataset = db.load_dataset(run_id);
+    REQUIRE(dataset.number_of_all_successful_runs() == 1);
+    REQUIRE(dataset.score(2).attempted == 2);
+    REQUIRE(dataset.score(2).par_k == Approx(12));
+
+    REQUIRE(db.load_dataset(other_run_id + 1).score(2).attempted == 0);
+
+    SECTION("Metrics and trajectories are loaded on demand")
+    {
+        Trajectory trajectory;
+        trajectory.add(500, 7.0);
+        db.on_job_finished(run_id, CmdWithArgs(2, "solver", {"c.txt"}), 10,
+            ExecResult(0, 3, { MetricValue("cost", 7.0) }, trajectory));
+
+        REQUIRE(db.load_dataset(run_id).metric_summaries().empty());
+        auto with_output = db.load_dataset(run_id, true);
+        REQUIRE(with_output.metric_summaries().size() == 1);
+        REQUIRE(with_output.metric_summaries()[0].count == 1);
+        REQUIRE(with_output.mean_primal_integral() > 0);
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::save_calibration")
+{
+    sql_database db(TEST_DATABASE_FILENAME);
+    auto run_id = db.new_run_started();
+
+    Calibration calibration;
+    calibration.repetitions = 3;
+    calibration.slots = { { 1.0, 2.0, 0.01, 1.0, -1 }, { 1.2, 2.4, 0.07, 0.8, -1 } };
+    db.save_calibration(run_id, calibration);
+
+    db.on_job_finished(run_id, CmdWithArgs(0, "solver", {"a.txt"}), 10, ExecResult(0, 4), 1);
+    db.on_job_finished(run_id, CmdWithArgs(1, "solver", {"b.txt"}), 10, ExecResult(0, 8), 0);
+
+    // Slots are saved with the jobs
+    auto dataset = db.load_dataset(run_id).normalized_by_slot_speed(
+        calibration.relative_speeds());
+    REQUIRE(dataset.score(2).par_k == Approx((4 + 8) / 2.0));
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::save_sample")
+{
+    {
+        sql_database db(TEST_DATABASE_FILENAME);
+        auto run_id = db.new_run_started();
+
+        SampleSettings sample;
+        sample.design = SampleSettings::Design::Sobol;
+        sample.size = 1000;
+        sample.seed = 0xFFFFFFFFFFFFFFFFull;
+        db.save_sample(run_id, sample);
+    }
+
+    SQLite::Database db(TEST_DATABASE_FILENAME);
+    SQLite::Statement query(db, "SELECT sample_design, sample_size, sample_seed FROM run");
+    REQUIRE(query.executeStep());
+    REQUIRE(query.getColumn(0).getString() == "sobol");
+    REQUIRE(query.getColumn(1).getInt64() == 1000);
+    REQUIRE(static_cast<std::uint64_t>(query.getColumn(2).getInt64()) == 0xFFFFFFFFFFFFFFFFull);
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::merge")
+{
+    const std::string shard_files[] = {
+        "temporary_shard_1_for_tests.sqlite",
+        "temporary_shard_2_for_tests.sqlite",
+    };
+    Config c(R"({
+        "command" : "solver",
+        "arguments" : ["%a%"],
+        "parameters" : [ { "name" : "a", "values" : ["1", "2", "3", "4"] } ]
+    })"_json);
+    // Every shard executes half of the jobs in a database of its own
+    for (unsigned i = 0; i < 2; ++i) {
+        sql_database shard_db(shard_files[i]);
+        if (i == 1) {
+            // An unrelated run shifts the IDs of the second shard
+            shard_db.new_run_started();
+        }
+        auto run_id = shard_db.new_run_started();
+        shard_db.save_config_and_command_given_directly(run_id, c, "binary");
+        Shard shard = Shard::parse(std::to_string(i + 1) + "/2");
+        shard_db.save_shard(run_id, shard);
+        // Both hosts calibrate two worker slots of their own
+        Calibration calibration;
+        calibration.slots = { { 1.0, 2.0, 0.01 * (i + 1), 1.0, 0 },
+            { 1.2, 2.4, 0.02, 0.8 - 0.1 * i, 1 } };
+        shard_db.save_calibration(run_id, calibration);
+        unsigned slot = 0;
+        for (const auto& job : combine_command_lines(c, shard)) {
+            ExecResult result(0, job.job_index() + 1,
+                { MetricValue("obj", job.job_index()) });
+            shard_db.on_job_finished(run_id, job, 10, result, slot++ % 2);
+        }
+    }
+
+    {
+        sql_database db(TEST_DATABASE_FILENAME);
+        db.new_run_started();
+        REQUIRE(db.merge(shard_files[0]) == std::vector<long long>{2});
+        REQUIRE(db.merge(shard_files[1]) == std::vector<long long>{3, 2});
+        REQUIRE_THROWS(db.merge("temporary_missing_shard.sqlite"));
+
+        // The shards form one run with all jobs
+        auto dataset = db.load_dataset(2);
+        REQUIRE(dataset.number_of_all_successful_runs() == 4);
+        REQUIRE_FALSE(db.has_run(4));
     }
 
+    SQLite::Database db(TEST_DATABASE_FILENAME);
+    SQLite::Statement jobs(db, "SELECT job.job_index, job_metric.value, command.commands"
+        " FROM job JOIN job_metric USING (job_id) JOIN command USING (job_id)"
+        " WHERE job.run_id = 2 ORDER BY job.job_index");
+    for (int index = 0; index < 4; ++index) {
+        REQUIRE(jobs.executeStep());
+        REQUIRE(jobs.getColumn(0).getInt() == index);
+        REQUIRE(jobs.getColumn(1).getDouble() == index);
+        REQUIRE(jobs.getColumn(2).getString().find(std::to_string(index + 1)) != std::string::npos);
+    }
+    REQUIRE_FALSE(jobs.executeStep());
+    SQLite::Statement counts(db, "SELECT"
+        " (SELECT COUNT(*) FROM run_shard WHERE run_id = 2),"
+        " (SELECT COUNT(*) FROM image)");
+    REQUIRE(counts.executeStep());
+    REQUIRE(counts.getColumn(0).getInt() == 2);
+    REQUIRE(counts.getColumn(1).getInt() == 1);
+
+    // The slots of the second shard are renumbered after those of the first
+    SQLite::Statement calibration(db, "SELECT slot, cpu, relative_speed"
+        " FROM calibration WHERE run_id = 2 ORDER BY slot");
+    for (int slot = 0; slot < 4; ++slot) {
+        REQUIRE(calibration.executeStep());
+        REQUIRE(calibration.getColumn(0).getInt() == slot);
+        REQUIRE(calibration.getColumn(1).getInt() == slot % 2);
+    }
+    REQUIRE_FALSE(calibration.executeStep());
+    SQLite::Statement slots(db, "SELECT slot FROM job WHERE run_id = 2 ORDER BY job_id");
+    for (int slot = 0; slot < 4; ++slot) {
+        REQUIRE(slots.executeStep());
+        REQUIRE(slots.getColumn(0).getInt() == slot);
+    }
+    SQLite::Statement summary(db, "SELECT calibration_cv, calibration_min_speed"
+        " FROM run WHERE run_id = 2");
+    REQUIRE(summary.executeStep());
+    REQUIRE(summary.getColumn(0).getDouble() == Approx(0.02));
+    REQUIRE(summary.getColumn(1).getDouble() == Approx(0.7));
+
+    for (const auto& file : shard_files) {
+        std::remove(file.c_str());
+    }
     std::remove(TEST_DATABASE_FILENAME.c_str());
 }
 
@@ -65,9 +368,9 @@ TEST_CASE("sql_database::remove_finished_jobs")
     Config c(R"({
         "command" : "sleep",
         "arguments" : ["%time%"],
-        "parameters" : {
-            "time" : ["1", "2", "3"]
-        }
+        "parameters" : [
+            { "name" : "time", "values" : ["1", "2", "3"] }
+        ]
     })"_json);
 
     CmdWithArgs exp1(0, "sleep", {"1"});
@@ -77,7 +380,7 @@ TEST_CASE("sql_database::remove_finished_jobs")
     SECTION("if no jobs are in the database") {
         sql_database ts_db(TEST_DATABASE_FILENAME);
 
-        auto run_id = ts_db.new_run_started();
+        ts_db.new_run_started();
         SECTION("and we remove finished jobs")
         {
             std::vector<CmdWithArgs> example{exp1, exp2, exp3};
@@ -166,3 +469,130 @@ TEST_CASE("sql_database::remove_finished_jobs")
         }
     }
 }
+
+TEST_CASE("sql_database::unfinished_run")
+{
+    Config c(R"({
+        "command" : "sleep",
+        "arguments" : ["%time%"],
+        "parameters" : [
+            { "name" : "time", "values" : ["1", "2", "3"] }
+        ]
+    })"_json);
+    std::vector<CmdWithArgs> jobs = {
+        CmdWithArgs(0, "sleep", {"1"}),
+        CmdWithArgs(1, "sleep", {"2"}),
+        CmdWithArgs(2, "sleep", {"3"})
+    };
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+
+    {
+        sql_database db(TEST_DATABASE_FILENAME);
+        REQUIRE(db.unfinished_run(c) == 0);
+
+        auto finished = db.new_run_started();
+        db.save_config_and_command_given_directly(finished, c, "");
+        db.save_pending_jobs(finished, jobs);
+        for (const auto& job : jobs) {
+            db.on_job_finished(finished, job, 10, ExecResult(0, 1));
+        }
+        db.set_run_status(finished, RunStatus::Finished);
+        REQUIRE(db.unfinished_run(c) == 0);
+
+        // The run is interrupted after its second job
+        auto interrupted = db.new_run_started();
+        db.save_config_and_command_given_directly(interrupted, c, "");
+        db.save_pending_jobs(interrupted, jobs);
+        db.on_job_finished(interrupted, jobs[1], 10, ExecResult(0, 1));
+        db.set_run_status(interrupted, RunStatus::Interrupted);
+
+        REQUIRE(db.unfinished_run(c) == interrupted);
+        REQUIRE(db.pending_jobs(interrupted) == std::vector<unsigned>{ 0, 2 });
+        REQUIRE(db.pending_jobs(finished).empty());
+
+        // Runs of other configurations are not resumed
+        Config other(R"({ "command" : "sleep", "arguments" : ["1"] })"_json);
+        REQUIRE(db.unfinished_run(other) == 0);
+    }
+
+    // A crashed run is still running
+    {
+        sql_database db(TEST_DATABASE_FILENAME);
+        auto crashed = db.new_run_started();
+        db.save_config_and_command_given_directly(crashed, c, "");
+        db.save_pending_jobs(crashed, jobs);
+        REQUIRE(db.unfinished_run(c) == crashed);
+        REQUIRE(db.pending_jobs(crashed).size() == 3);
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
+
+TEST_CASE("sql_database::reuse_cached_results")
+{
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+    sql_database db(TEST_DATABASE_FILENAME);
+
+    // Two repetitions of `solver a`, one of `solver b` and an unknown job
+    std::vector<CmdWithArgs> jobs = {
+        CmdWithArgs(0, "solver", {"a"}),
+        CmdWithArgs(1, "solver", {"a"}),
+        CmdWithArgs(2, "solver", {"b"}),
+        CmdWithArgs(3, "solver", {"c"})
+    };
+    std::unordered_map<unsigned, std::string> keys = {
+        { 0, "key-a" }, { 1, "key-a" }, { 2, "key-b" }, { 3, "key-c" }
+    };
+
+    Trajectory trajectory;
+    trajectory.add(500, 7.0);
+    auto old_run = db.new_run_started();
+    db.on_job_finished(old_run, jobs[0], 10,
+        ExecResult(0, 3, { MetricValue("cost", 7.0) }, trajectory), 1, "key-a");
+    db.on_job_finished(old_run, jobs[2], 10, ExecResult(1, 10), 0, "key-b");
+    db.on_job_finished(old_run, jobs[3], 10, ExecResult(0, 2));
+
+    SECTION("results of any host")
+    {
+        auto run = db.new_run_started();
+        db.save_pending_jobs(run, jobs);
+        auto remaining = jobs;
+        auto cached = db.reuse_cached_results(run, remaining, keys, 10, "");
+
+        // Only one result of `solver a` exists, the key of `solver c` is unknown
+        REQUIRE(remaining.size() == 2);
+        REQUIRE(remaining[0].job_index() == 1);
+        REQUIRE(remaining[1].job_index() == 3);
+        REQUIRE(db.pending_jobs(run) == std::vector<unsigned>{ 1, 3 });
+
+        REQUIRE(cached.number_of_all_successful_runs() == 1);
+        REQUIRE(cached.metric_summaries().size() == 1);
+        REQUIRE(cached.mean_primal_integral() > 0);
+
+        auto loaded = db.load_dataset(run);
+        REQUIRE(loaded.score().attempted == 2);
+        REQUIRE(loaded.score().solved == 1);
+
+        // The copies are not reused by the next run
+        auto next_run = db.new_run_started();
+        remaining = jobs;
+        cached = db.reuse_cached_results(next_run, remaining, keys, 10, "");
+        REQUIRE(remaining.size() == 2);
+    }
+
+    SECTION("results of another host are not reused")
+    {
+        auto run = db.new_run_started();
+        auto remaining = jobs;
+        auto cached = db.reuse_cached_results(run, remaining, keys, 10,
+            "another-" + host_name());
+        REQUIRE(remaining.size() == jobs.size());
+        REQUIRE(remaining[0].arguments() == jobs[0].arguments());
+        REQUIRE(cached.score().attempted == 0);
+
+        cached = db.reuse_cached_results(run, remaining, keys, 10, host_name());
+        REQUIRE(remaining.size() == 2);
+    }
+
+    std::remove(TEST_DATABASE_FILENAME.c_str());
+}
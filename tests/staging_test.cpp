@@ -0,0 +1,166 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "catch.hpp"
+
+#include <perfnp/staging.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace perfnp;
+
+namespace {
+
+    //! Creates a small input file, which is removed at the end of the test
+    struct TemporaryFile {
+        std::string path;
+
+        explicit TemporaryFile(std::string name)
+        : path(std::move(name))
+        {
+            std::ofstream file(path);
+            file << std::string(10000, 'x');
+        }
+
+        ~TemporaryFile() {
+            std::remove(path.c_str());
+        }
+    };
+
+} // anonymous namespace
+
+TEST_CASE("input_files")
+{
+    TemporaryFile input("temporary_input_for_tests.cnf");
+
+    CmdWithArgs job(0, "solver", {input.path, "--instance=" + input.path,
+        "--seed=1", "missing.cnf", "."});
+    auto files = input_files(job);
+    REQUIRE(files == std::vector<std::string>{ input.path, input.path });
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+TEST_CASE("InputStager")
+{
+    TemporaryFile a("temporary_input_a_for_tests.cnf");
+    TemporaryFile b("temporary_input_b_for_tests.cnf");
+
+    // Both jobs of `a` and one job of `b`, which also reads `a`
+    std::vector<CmdWithArgs> jobs = {
+        CmdWithArgs(0, "solver", {a.path}),
+        CmdWithArgs(1, "solver", {"--input=" + a.path, "--seed=2"}),
+        CmdWithArgs(2, "solver", {b.path, a.path}),
+        CmdWithArgs(3, "solver", {"--seed=3"})
+    };
+    PageCacheSettings settings;
+    settings.ahead = 1;
+
+    SECTION("warm")
+    {
+        settings.mode = PageCacheSettings::Mode::Warm;
+        InputStager stager(jobs, settings);
+        REQUIRE(stager.input_files() == 2);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            stager.before_job(i);
+            stager.after_job(i);
+        }
+        REQUIRE(stager.pinned_files() == 0);
+    }
+
+    SECTION("pin")
+    {
+        settings.mode = PageCacheSettings::Mode::Pin;
+        InputStager stager(jobs, settings);
+        stager.before_job(0);
+        stager.after_job(0);
+        stager.before_job(1);
+        stager.after_job(1);
+
+        // `a` stays pinned for the last job reading it (unless RLIMIT_MEMLOCK is 0)
+        auto pinned = stager.pinned_files();
+        REQUIRE(pinned <= 1);
+        stager.before_job(2);
+        REQUIRE(stager.pinned_files() <= 2);
+        stager.after_job(2);
+        REQUIRE(stager.pinned_files() == 0);
+    }
+
+    SECTION("cold")
+    {
+        settings.mode = PageCacheSettings::Mode::Cold;
+        InputStager stager(jobs, settings);
+        stager.before_job(2);
+        stager.after_job(2);
+    }
+}
+
+TEST_CASE("ScratchSpace")
+{
+    TemporaryFile input("temporary_input_for_scratch_tests.cnf");
+    CmdWithArgs job(3, "./solver", {input.path, "--instance=" + input.path, "--out=log"});
+
+    ScratchSettings settings;
+    settings.directory = "temporary_scratch_for_tests";
+
+    SECTION("the inputs are staged and the directory is emptied")
+    {
+        ScratchSpace scratch(settings, 2);
+        const auto directory = scratch.directory(1);
+        REQUIRE(directory != scratch.directory(0));
+        REQUIRE(directory[0] == '/');
+
+        auto prepared = scratch.prepare(1, job);
+        REQUIRE(prepared.job_index() == 3);
+        REQUIRE(prepared.command()[0] == '/');
+        REQUIRE(prepared.arguments() == std::vector<std::string>{
+            input.path, "--instance=" + input.path, "--out=log" });
+        REQUIRE(std::ifstream(directory + "/" + input.path).good());
+
+        std::ofstream(directory + "/log") << "scratch";
+        scratch.finish(1, job);
+        REQUIRE(!std::ifstream(directory + "/log").good());
+        REQUIRE(!std::ifstream(directory + "/" + input.path).good());
+    }
+
+    SECTION("inputs, which are not staged, get absolute paths")
+    {
+        settings.inputs = ScratchSettings::Inputs::None;
+        ScratchSpace scratch(settings, 1);
+        auto prepared = scratch.prepare(0, job);
+        REQUIRE(prepared.arguments()[0][0] == '/');
+        REQUIRE(prepared.arguments()[1].find("--instance=/") == 0);
+        REQUIRE(prepared.arguments()[2] == "--out=log");
+        scratch.finish(0, job);
+    }
+
+    SECTION("the directories of finished jobs are archived")
+    {
+        settings.inputs = ScratchSettings::Inputs::Copy;
+        settings.archive = "temporary_archive_for_tests";
+        {
+            ScratchSpace scratch(settings, 1);
+            for (int run = 0; run < 2; ++run) {
+                scratch.prepare(0, job);
+                std::ofstream(scratch.directory(0) + "/log") << "run " << run;
+                scratch.finish(0, job);
+            }
+        }
+        REQUIRE(std::ifstream("temporary_archive_for_tests/job-3/log").good());
+        REQUIRE(std::ifstream("temporary_archive_for_tests/job-3-2/log").good());
+        REQUIRE(!std::ifstream("temporary_archive_for_tests/job-3/" + input.path).good());
+
+        for (const char* path : { "temporary_archive_for_tests/job-3/log",
+                "temporary_archive_for_tests/job-3-2/log", "temporary_archive_for_tests/job-3",
+                "temporary_archive_for_tests/job-3-2", "temporary_archive_for_tests" }) {
+            std::remove(path);
+        }
+    }
+
+    std::remove("temporary_scratch_for_tests");
+}
+#endif
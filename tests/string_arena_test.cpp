@@ -0,0 +1,56 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/string_arena.hpp"
+
+#include "catch.hpp"
+
+#include <cstring>
+
+using namespace perfnp;
+
+TEST_CASE("StringArena")
+{
+    StringArena arena;
+
+    SECTION("equal strings are interned once")
+    {
+        auto a = arena.intern("instance.cnf");
+        auto b = arena.intern("other.cnf");
+        auto c = arena.intern(std::string("instance.cnf"));
+        REQUIRE(a == c);
+        REQUIRE(a != b);
+        REQUIRE(arena.size() == 2);
+        REQUIRE(arena.str(b) == "other.cnf");
+        REQUIRE(std::strcmp(arena.c_str(a), "instance.cnf") == 0);
+        REQUIRE(arena.length(a) == 12);
+    }
+
+    SECTION("empty strings and zero bytes")
+    {
+        auto empty = arena.intern("");
+        auto zero = arena.intern(std::string("a\0b", 3));
+        REQUIRE(arena.length(empty) == 0);
+        REQUIRE(arena.str(zero) == std::string("a\0b", 3));
+        REQUIRE(arena.intern("a") != zero);
+    }
+
+    SECTION("many strings survive growing the arena")
+    {
+        const std::string long_value(StringArena::BLOCK_SIZE, 'x');
+        std::vector<StringArena::Id> ids;
+        for (int i = 0; i < 100000; ++i) {
+            ids.push_back(arena.intern("instance_" + std::to_string(i) + ".cnf"));
+            if (i == 50000) {
+                REQUIRE(arena.str(arena.intern(long_value)) == long_value);
+            }
+        }
+        REQUIRE(arena.size() == 100001);
+        for (int i = 0; i < 100000; i += 997) {
+            REQUIRE(arena.str(ids[i]) == "instance_" + std::to_string(i) + ".cnf");
+            REQUIRE(arena.intern("instance_" + std::to_string(i) + ".cnf") == ids[i]);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2019 Locksley.CZ s.r.o.
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "perfnp/trace.hpp"
+
+#include "catch.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <sstream>
+
+using namespace perfnp;
+using json = nlohmann::json;
+
+TEST_CASE("Tracer records events per slot")
+{
+    Tracer tracer(2);
+    REQUIRE(tracer.slots() == 2);
+
+    auto start = tracer.now_us();
+    tracer.complete(1, "job", start, 7, 3);
+    tracer.instant(1, "timeout", 7);
+    tracer.complete(0, "db flush", start, 2);
+
+    REQUIRE(tracer.events(0).size() == 1);
+    REQUIRE(tracer.events(1).size() == 2);
+
+    const auto& job = tracer.events(1)[0];
+    REQUIRE(job.phase == 'X');
+    REQUIRE(job.job_index == 7);
+    REQUIRE(job.exit_code == 3);
+    REQUIRE(job.timestamp_us == start);
+    REQUIRE(job.duration_us >= 0);
+
+    REQUIRE(tracer.events(1)[1].phase == 'i');
+    REQUIRE(tracer.events(0)[0].exit_code == Tracer::NO_EXIT_CODE);
+    REQUIRE_THROWS(tracer.events(2));
+}
+
+TEST_CASE("Tracer::write_chrome_trace")
+{
+    Tracer tracer(2);
+    auto start = tracer.now_us();
+    tracer.complete(0, "job", start, 0, 0);
+    tracer.complete(1, "writer wait", start, 1);
+    tracer.instant(1, "timeout", 1);
+
+    std::ostringstream out;
+    tracer.write_chrome_trace(out);
+    auto trace = json::parse(out.str());
+
+    REQUIRE(trace["displayTimeUnit"] == "ms");
+    const auto& events = trace["traceEvents"];
+
+    size_t names = 0;
+    size_t jobs = 0;
+    for (const auto& event : events) {
+        if (event["ph"] == "M") {
+            ++names;
+            continue;
+        }
+
+        if (event["name"] == "job") {
+            ++jobs;
+            REQUIRE(event["ph"] == "X");
+            REQUIRE(event["tid"] == 0);
+            REQUIRE(event["ts"].get<std::int64_t>() == start);
+            REQUIRE(event.count("dur") == 1);
+            REQUIRE(event["args"]["exit_code"] == 0);
+        } else if (event["name"] == "writer wait") {
+            REQUIRE(event["tid"] == 1);
+            REQUIRE(event["args"]["job"] == 1);
+            REQUIRE(event["args"].count("exit_code") == 0);
+        } else {
+            REQUIRE(event["name"] == "timeout");
+            REQUIRE(event["ph"] == "i");
+            REQUIRE(event["s"] == "t");
+            REQUIRE(event.count("dur") == 0);
+        }
+    }
+    REQUIRE(names == 2);
+    REQUIRE(jobs == 1);
+    REQUIRE(events.size() == 5);
+}